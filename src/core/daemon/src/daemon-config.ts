@@ -2,6 +2,7 @@ import { existsSync, promises as fs } from "fs";
 import path from "path";
 import { homedir } from "os";
 import type { Workspace } from "./types/index.js";
+import type { AssetPolicy } from "@checkpointvcs/longtail-addon";
 
 export interface DaemonConfigType {
   daemonPort: number;
@@ -33,10 +34,25 @@ export interface DaemonConfigType {
   longtail: {
     targetChunkSize: number;
     targetBlockSize: number;
+    /** Range the block size is tuned in from the measured store latency and
+     * bandwidth, both 0 always uses targetBlockSize. */
+    minTargetBlockSize?: number;
+    maxTargetBlockSize?: number;
     maxChunksPerBlock: number;
     minBlockUsagePercent: number;
     hashingAlgo: string;
+    chunkingAlgo?: string;
     compressionAlgo: string;
+    minCompressionSavingPercent?: number;
+    /** Bytes of file data a submit keeps in memory between indexing and
+     * writing blocks so new chunks are not read twice, 0 reads them again. */
+    readCacheSize?: number;
+    /** Most blocks a pull fetches at once on high latency links, 0 fetches
+     * one per CPU core. */
+    maxFetchDepth?: number;
+    /** Per-file compression/chunk size overrides, first match wins. Changing
+     * a targetChunkSize re-chunks matching files on their next submit. */
+    assetPolicies?: AssetPolicy[];
     enableMmapIndexing: boolean;
     enableMmapBlockStore: boolean;
     enableBlockCache: boolean;
@@ -87,10 +103,26 @@ export class DaemonConfig {
       longtail: {
         targetChunkSize: 32768,
         targetBlockSize: 8388608,
+        minTargetBlockSize: 1048576,
+        maxTargetBlockSize: 33554432,
         maxChunksPerBlock: 1024,
         minBlockUsagePercent: 80,
         hashingAlgo: "blake3",
+        chunkingAlgo: "hpcdc",
         compressionAlgo: "zstd",
+        minCompressionSavingPercent: 5,
+        readCacheSize: 268435456,
+        maxFetchDepth: 64,
+        assetPolicies: [
+          { pattern: ".png", compressionAlgo: "none" },
+          { pattern: ".jpg", compressionAlgo: "none" },
+          { pattern: ".jpeg", compressionAlgo: "none" },
+          { pattern: ".ogg", compressionAlgo: "none" },
+          { pattern: ".mp3", compressionAlgo: "none" },
+          { pattern: ".mp4", compressionAlgo: "none" },
+          { pattern: ".zip", compressionAlgo: "none" },
+          { pattern: ".7z", compressionAlgo: "none" },
+        ],
         enableMmapIndexing: false,
         enableMmapBlockStore: false,
         enableBlockCache: false,
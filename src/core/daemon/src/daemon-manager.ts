@@ -43,6 +43,13 @@ import {
 import { checkSyncStatus, type SyncStatus } from "./util/sync-status.js";
 import { hasConflictMarkers } from "./util/auto-merge.js";
 import { getBinaryExtensions, isBinaryFile } from "./util/binary-extensions.js";
+import {
+  openChangeJournal,
+  getChangeJournalChanges,
+  closeChangeJournal,
+  GetLogLevel,
+  type NativeHandle,
+} from "@checkpointvcs/longtail-addon";
 
 export class DaemonManager {
   private static instance: DaemonManager | null = null;
@@ -65,6 +72,16 @@ export class DaemonManager {
 
   private watchers: Map<string, FSWatcher> = new Map();
 
+  /**
+   * Native change journals, keyed by workspace.id. Used instead of a
+   * recursive `fs.watch()` where available (Linux) and drained into
+   * {@link dirtyFiles} on each refresh.
+   */
+  private changeJournals: Map<
+    string,
+    { journal: NativeHandle; cursor: number }
+  > = new Map();
+
   /** Cached sync status per workspace, keyed by workspace.id */
   private syncStatuses: Map<string, SyncStatus> = new Map();
 
@@ -144,6 +161,8 @@ export class DaemonManager {
     this.stopSyncPolling();
     this.watchers.forEach((watcher) => watcher.close());
     this.watchers.clear();
+    this.changeJournals.forEach(({ journal }) => closeChangeJournal(journal));
+    this.changeJournals.clear();
     closeAllStateStores();
   }
 
@@ -158,6 +177,7 @@ export class DaemonManager {
       watcher.close();
       this.watchers.delete(workspaceId);
     }
+    this.closeWorkspaceChangeJournal(workspaceId);
 
     // Clear all cached state
     this.workspaceStates.delete(workspaceId);
@@ -963,6 +983,8 @@ export class DaemonManager {
       baselineState = this.workspaceStates.get(workspace.id)!;
     }
 
+    this.drainChangeJournal(workspace.id);
+
     // Ensure any dirty ignore/hidden files are processed before choosing the
     // refresh strategy.  The watcher callback is async (fire-and-forget) so
     // its ignore-cache update may still be in-flight when a refresh is
@@ -1392,6 +1414,20 @@ export class DaemonManager {
     const existingWatcher = this.watchers.get(workspace.id);
     if (existingWatcher) {
       existingWatcher.close();
+      this.watchers.delete(workspace.id);
+    }
+    this.closeWorkspaceChangeJournal(workspace.id);
+
+    // Prefer the native change journal, it does not have to walk the
+    // whole workspace from the event loop to set up its watches. Its
+    // changes are picked up by drainChangeJournal().
+    const journal = openChangeJournal({
+      localRootPath: workspace.localPath,
+      logLevel: GetLogLevel("error"),
+    });
+    if (journal) {
+      this.changeJournals.set(workspace.id, { journal, cursor: 0 });
+      return;
     }
 
     const watcher = watch(
@@ -1458,6 +1494,41 @@ export class DaemonManager {
     this.watchers.set(workspace.id, watcher);
   }
 
+  /**
+   * Moves the changes recorded by the workspace's change journal into
+   * {@link dirtyFiles} (or the VCS buffer while an operation is active).
+   * When the journal cannot account for every change since the last read
+   * the cached pending changes are dropped so the next refresh is a full one.
+   */
+  private drainChangeJournal(workspaceId: string): void {
+    const entry = this.changeJournals.get(workspaceId);
+    if (!entry) return;
+
+    const changes = getChangeJournalChanges(entry.journal, entry.cursor);
+    entry.cursor = changes.cursor;
+
+    if (changes.fullScanRequired) {
+      this.workspacePendingChanges.delete(workspaceId);
+      return;
+    }
+
+    const target = this.vcsOperationActive.get(workspaceId)
+      ? this.vcsBufferedEvents.get(workspaceId)
+      : this.dirtyFiles.get(workspaceId);
+    if (!target) return;
+
+    for (const relativePath of changes.paths) {
+      target.add(relativePath);
+    }
+  }
+
+  private closeWorkspaceChangeJournal(workspaceId: string): void {
+    const entry = this.changeJournals.get(workspaceId);
+    if (!entry) return;
+    closeChangeJournal(entry.journal);
+    this.changeJournals.delete(workspaceId);
+  }
+
   /**
    * Gets the set of files that have changed since the last full refresh.
    * Useful for UI to show which files may need attention.
@@ -1569,6 +1640,10 @@ export class DaemonManager {
       setTimeout(resolve, DaemonManager.VCS_GRACE_PERIOD_MS),
     );
 
+    // Changes recorded by a change journal during the operation belong in
+    // the buffer as well
+    this.drainChangeJournal(workspaceId);
+
     this.vcsOperationActive.set(workspaceId, false);
 
     // Replay buffered events into dirtyFiles. reloadWorkspaceState()
@@ -37,6 +37,26 @@ export interface PullMergeResult {
   conflictMerges: string[];
 }
 
+/**
+ * Changelist of the materialized full version index the native pull keeps in
+ * the workspace, null if there is none.
+ */
+async function getMaterializedChangelist(
+  localPath: string,
+): Promise<number | null> {
+  try {
+    const info = JSON.parse(
+      await fs.readFile(
+        path.join(localPath, ".checkpoint", "materialized-version.json"),
+        "utf-8",
+      ),
+    );
+    return typeof info.changelist === "number" ? info.changelist : null;
+  } catch {
+    return null;
+  }
+}
+
 export async function pull(
   workspace: Workspace,
   orgId: string,
@@ -132,9 +152,13 @@ export async function pull(
     (a: any, b: any) => a.number - b.number,
   );
 
-  const versionsToPull: string[] = sortedChangelists.map(
-    (changelist: any) => changelist.versionIndex,
-  );
+  const versionsToPull: { versionIndex: string; number: number }[] =
+    sortedChangelists
+      .filter((changelist: any) => changelist.versionIndex !== "")
+      .map((changelist: any) => ({
+        versionIndex: changelist.versionIndex,
+        number: changelist.number,
+      }));
 
   // Pre-pull: save locally-modified text files for auto-merge.
   // The diff's modified files are the ones the pull will overwrite. If a file is
@@ -191,12 +215,94 @@ export async function pull(
     (daemonConfig.longtail.enableBlockCache ?? true)
       ? path.join(homedir(), ".checkpoint", "cache", "blocks")
       : undefined;
+  // Each pull folds its version onto the materialized full version of the
+  // changelist the workspace is synced to. When the workspace got to its
+  // changelist some other way (a submit, an interrupted pull) the materialized
+  // version is caught up by folding the versions in between without touching
+  // the files. Without it the pull still works, it just indexes more files.
+  let baseChangelist: number | undefined = workspaceState.changelistNumber;
+  const materializedChangelist = await getMaterializedChangelist(
+    workspace.localPath,
+  );
+  if (
+    versionsToPull.length > 0 &&
+    workspaceState.changelistNumber !== 0 &&
+    materializedChangelist !== workspaceState.changelistNumber
+  ) {
+    onStep?.("Materializing workspace version");
+    const fromNumber =
+      materializedChangelist !== null &&
+      materializedChangelist < workspaceState.changelistNumber
+        ? materializedChangelist
+        : 0;
+    const catchUpDiff = await client.changelist.diffChangelists.query({
+      repoId: workspace.repoId,
+      fromNumber,
+      toNumber: workspaceState.changelistNumber,
+      resolveAddedFileIds: false,
+    });
+    const catchUpChangelists = (
+      catchUpDiff.changelistsToPull.length > 0
+        ? await client.changelist.getChangelistsWithNumbers.mutate({
+            repoId: workspace.repoId,
+            numbers: catchUpDiff.changelistsToPull,
+          })
+        : []
+    )
+      .filter((changelist: any) => changelist.versionIndex !== "")
+      .sort((a: any, b: any) => a.number - b.number);
+
+    let catchUpBase = fromNumber;
+    for (let i = 0; i < catchUpChangelists.length; i++) {
+      const changelist: any = catchUpChangelists[i];
+      const isLast = i === catchUpChangelists.length - 1;
+      const handle = pullAsync({
+        versionIndex: changelist.versionIndex,
+        enableMmapIndexing: daemonConfig.longtail.enableMmapIndexing,
+        enableMmapBlockStore: daemonConfig.longtail.enableMmapBlockStore,
+        localRootPath: workspace.localPath,
+        remoteBasePath: `/${orgId}/${workspace.repoId}`,
+        baseChangelist: catchUpBase,
+        changelist: isLast
+          ? workspaceState.changelistNumber
+          : changelist.number,
+        removedPaths: catchUpDiff.removed,
+        materializeOnly: true,
+        ...storageOptions,
+        logLevel: GetLogLevel(resolvedLogLevel),
+      });
+      if (!handle) {
+        throw new Error("Failed to create longtail handle");
+      }
+      const { status } = await pollHandle(handle, {
+        onTokenRefresh: refreshStorageToken,
+        intervalMs: 250,
+      });
+      freeHandle(handle);
+      if (status.error !== 0) {
+        Logger.debug(
+          `Could not materialize version ${changelist.versionIndex}, pulling without a materialized version`,
+        );
+        baseChangelist = undefined;
+        break;
+      }
+      catchUpBase = changelist.number;
+    }
+    if (catchUpChangelists.length === 0) {
+      baseChangelist = undefined;
+    }
+  }
+
   let errored = false;
   let lastStep = "";
-  for (const versionIndex of versionsToPull) {
-    if (versionIndex === "") {
-      continue;
-    }
+  for (let i = 0; i < versionsToPull.length; i++) {
+    const { versionIndex, number: versionChangelist } = versionsToPull[i]!;
+    // Changelists after the last version only remove files, the removals are
+    // folded in with the last version
+    const changelist =
+      i === versionsToPull.length - 1
+        ? changelistResponse.number
+        : versionChangelist;
 
     Logger.debug(
       `Starting longtail pull for version index ${versionIndex} for workspace ${workspace.workspaceName}...`,
@@ -209,6 +315,13 @@ export async function pull(
       localRootPath: workspace.localPath,
       remoteBasePath: `/${orgId}/${workspace.repoId}`,
       cachePath: blockCachePath,
+      maxFetchDepth: daemonConfig.longtail.maxFetchDepth,
+      ...(baseChangelist !== undefined && {
+        baseChangelist,
+        changelist,
+        removedPaths: diff.removed,
+      }),
+      assetPolicies: daemonConfig.longtail.assetPolicies,
       ...storageOptions,
       logLevel: GetLogLevel(resolvedLogLevel),
     });
@@ -253,6 +366,9 @@ export async function pull(
       errored = true;
       break;
     }
+    if (baseChangelist !== undefined) {
+      baseChangelist = changelist;
+    }
   }
 
   // ─── Artifact pull (optional) ──────────────────────────────────
@@ -294,6 +410,8 @@ export async function pull(
           localRootPath: workspace.localPath,
           remoteBasePath: `/${orgId}/${workspace.repoId}`,
           cachePath: blockCachePath,
+          maxFetchDepth: daemonConfig.longtail.maxFetchDepth,
+          assetPolicies: daemonConfig.longtail.assetPolicies,
           ...storageOptions,
           logLevel: GetLogLevel(resolvedLogLevel),
         });
@@ -440,6 +558,8 @@ export async function pull(
 
   if (!errored) {
     // Handle deletions (paths come straight from the diff; no getFiles needed).
+    // Pulls with a materialized version already removed them, this catches the
+    // ones pulled without.
     if (diff.removed.length > 0) {
       onStep?.("Deleting removed files");
       let deletedCount = 0;
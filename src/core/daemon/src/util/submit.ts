@@ -80,10 +80,15 @@ export async function submit(
     message,
     targetChunkSize: daemonConfig.longtail.targetChunkSize,
     targetBlockSize: daemonConfig.longtail.targetBlockSize,
+    minTargetBlockSize: daemonConfig.longtail.minTargetBlockSize,
+    maxTargetBlockSize: daemonConfig.longtail.maxTargetBlockSize,
     maxChunksPerBlock: daemonConfig.longtail.maxChunksPerBlock,
     minBlockUsagePercent: daemonConfig.longtail.minBlockUsagePercent,
     hashingAlgo: daemonConfig.longtail.hashingAlgo,
+    chunkingAlgo: daemonConfig.longtail.chunkingAlgo,
     compressionAlgo: daemonConfig.longtail.compressionAlgo,
+    minCompressionSavingPercent: daemonConfig.longtail.minCompressionSavingPercent,
+    readCacheSize: daemonConfig.longtail.readCacheSize,
     enableMmapIndexing: daemonConfig.longtail.enableMmapIndexing,
     enableMmapBlockStore: daemonConfig.longtail.enableMmapBlockStore,
     localRootPath: workspace.localPath,
@@ -94,6 +99,7 @@ export async function submit(
     keepCheckedOut,
     workspaceId,
     modifications,
+    assetPolicies: daemonConfig.longtail.assetPolicies,
     logLevel: GetLogLevel(resolvedLogLevel),
   };
 
@@ -1,7 +1,16 @@
 import { Router } from "express";
 import config from "@incanta/config";
 import njwt from "njwt";
+import {
+  repackAsync,
+  pollHandle,
+  freeHandle,
+  GetLogLevel,
+  type LongtailLogLevel,
+} from "@checkpointvcs/longtail-addon";
 import { getStorageBackend, usesGateway } from "../storage/backend.js";
+import { buildServerStorageOptions } from "../utils/storage-options.js";
+import { Logger } from "../logging.js";
 
 interface SystemJWTClaims {
   iss: string;
@@ -171,5 +180,127 @@ export function routeSystem(): Router {
     }
   });
 
+  // Rewrites the blocks the given versions (typically the heads of active
+  // branches) use only a small part of into dense new blocks, so pulls of
+  // those versions download less data that they throw away. Old blocks stay
+  // in the store for older versions.
+  router.post("/system/repack", async (req, res) => {
+    const authorizationHeader = req.headers["authorization"];
+    if (!authorizationHeader) {
+      res.status(401).send("Unauthorized: Missing authorization header");
+      return;
+    }
+
+    const [type, token] = authorizationHeader.split(" ");
+
+    if (type !== "Bearer") {
+      res.status(401).send("Unauthorized: Invalid authorization type");
+      return;
+    }
+
+    let claims: SystemJWTClaims;
+    try {
+      const verifiedToken = njwt.verify(
+        token,
+        config.get<string>("storage.jwt.signing-key"),
+      );
+
+      if (!verifiedToken) {
+        res.status(401).send("Unauthorized: Invalid token");
+        return;
+      }
+
+      claims = verifiedToken.body.toJSON() as unknown as SystemJWTClaims;
+    } catch (_error) {
+      console.error("JWT verification failed:", _error);
+      res.status(401).send("Unauthorized: Token verification failed");
+      return;
+    }
+
+    if (!claims.system || claims.iss !== "checkpoint-api") {
+      res.status(403).send("Forbidden: Not a system token");
+      return;
+    }
+
+    if (claims.action !== "repack") {
+      res.status(403).send("Forbidden: Invalid action for this endpoint");
+      return;
+    }
+
+    const body = req.body as {
+      path?: string;
+      versionIndexes?: string[];
+      minBlockUsagePercent?: number;
+    };
+    const path = body.path;
+    if (!path) {
+      res.status(400).send("Bad Request: Missing path");
+      return;
+    }
+
+    if (path !== claims.path) {
+      res.status(403).send("Forbidden: Path mismatch");
+      return;
+    }
+
+    // Blocks belong to a repo, so only /orgId/repoId can be repacked
+    const match = path.match(/^\/[^/]+\/([^/]+)\/?$/);
+    if (!match) {
+      res.status(400).send("Bad Request: Invalid path format");
+      return;
+    }
+    const repoId = match[1];
+
+    const versionIndexes = body.versionIndexes ?? [];
+    if (
+      versionIndexes.length === 0 ||
+      versionIndexes.some((name) => !name.match(/^0x[0-9a-f]+\.lvi$/))
+    ) {
+      res.status(400).send("Bad Request: Invalid versionIndexes");
+      return;
+    }
+
+    try {
+      const handle = repackAsync({
+        remoteBasePath: path.replace(/\/$/, ""),
+        versionIndexNames: versionIndexes,
+        minBlockUsagePercent:
+          body.minBlockUsagePercent ??
+          config.get<number>("longtail.min-block-usage-percent"),
+        targetBlockSize: config.get<number>("longtail.target-block-size"),
+        maxChunksPerBlock: config.get<number>("longtail.max-chunks-per-block"),
+        logLevel: GetLogLevel(
+          config.get<LongtailLogLevel>("longtail.log-level"),
+        ),
+        ...(await buildServerStorageOptions(repoId)),
+      } as Parameters<typeof repackAsync>[0]);
+
+      if (!handle) {
+        throw new Error("Failed to create longtail handle");
+      }
+
+      const { status, result } = await pollHandle(handle, {
+        onStep: (step) => Logger.debug(`[Repack] Current step: ${step}`),
+      });
+
+      freeHandle(handle);
+
+      if (status.error !== 0) {
+        res
+          .status(500)
+          .send(
+            `Failed to repack blocks: ${status.currentStep} (error ${status.error})`,
+          );
+        return;
+      }
+
+      Logger.debug(`[Repack] ${path}: ${JSON.stringify(result)}`);
+      res.status(200).json({ success: true, path, ...result });
+    } catch (error) {
+      console.error("Error repacking blocks:", error);
+      res.status(500).send(`Internal server error: ${error}`);
+    }
+  });
+
   return router;
 }
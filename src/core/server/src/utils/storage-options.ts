@@ -0,0 +1,47 @@
+import config from "@incanta/config";
+import { getR2Endpoint } from "./r2.js";
+
+// Build the backend storage descriptor the addon's server-side store.lsi merge
+// and block repack need, from the configured storage.mode. "local" works on
+// local disk; "s3" covers both s3 mode (shared bucket) and r2 mode (per-repo
+// bucket), both via the addon's S3 adapter with the server's full credentials.
+export async function buildServerStorageOptions(
+  repoId: string,
+): Promise<Record<string, unknown>> {
+  const mode = config.get<string>("storage.mode");
+  if (mode === "local") {
+    return {
+      storageType: "local",
+      localStoragePath: config.get<string>("storage.local.path"),
+    };
+  }
+  if (mode === "s3") {
+    return {
+      storageType: "s3",
+      s3Endpoint: config.get<string>("storage.s3.endpoint"),
+      s3Region: config.get<string>("storage.s3.region"),
+      s3Bucket: config.get<string>("storage.s3.bucket"),
+      s3ForcePathStyle: config.get<boolean>("storage.s3.force-path-style"),
+      s3AccessKeyId: await config.getWithSecrets<string>(
+        "storage.s3.access-key-id",
+      ),
+      s3SecretAccessKey: await config.getWithSecrets<string>(
+        "storage.s3.secret-access-key",
+      ),
+    };
+  }
+  // r2: the addon's S3 adapter pointed at R2, per-repo bucket.
+  return {
+    storageType: "s3",
+    s3Endpoint: getR2Endpoint(),
+    s3Region: "auto",
+    s3Bucket: `checkpoint-${repoId}`,
+    s3ForcePathStyle: false,
+    s3AccessKeyId: await config.getWithSecrets<string>(
+      "storage.r2.access-key-id",
+    ),
+    s3SecretAccessKey: await config.getWithSecrets<string>(
+      "storage.r2.secret-access-key",
+    ),
+  };
+}
@@ -64,6 +64,7 @@ interface LongtailAddonNative {
   submitAsync(options: SubmitAsyncOptions): NativeHandle;
   pullAsync(options: PullAsyncOptions): NativeHandle;
   mergeAsync(options: MergeAsyncOptions): NativeHandle;
+  repackAsync(options: RepackAsyncOptions): NativeHandle;
   readFileFromVersionAsync(
     options: ReadFileFromVersionAsyncOptions,
   ): NativeHandle;
@@ -77,6 +78,13 @@ interface LongtailAddonNative {
   getReadFileData(handle: NativeHandle): Buffer;
   getReadFileSize(handle: NativeHandle): number;
   freeReadFileHandle(handle: NativeHandle): void;
+
+  openChangeJournal(options: OpenChangeJournalOptions): NativeHandle | null;
+  getChangeJournalChanges(
+    journal: NativeHandle,
+    cursor: number,
+  ): ChangeJournalChanges;
+  closeChangeJournal(journal: NativeHandle): void;
 }
 
 // --------------------------------------------------------------------------
@@ -91,12 +99,24 @@ export interface Modification {
   oldPath?: string;
 }
 
+// Per-file override of the compression algorithm and/or target chunk size.
+// pattern is a case-insensitive glob ("Content/**/*.uasset", "*.pak") or a
+// bare extension (".png"); patterns without "/" match the file name only and
+// the first matching policy wins. Versions record the target chunk size
+// submit used for each file and pull chunks local files the same way, pull
+// only uses its policies for versions submitted before that was recorded.
+export interface AssetPolicy {
+  pattern: string;
+  compressionAlgo?: string;
+  targetChunkSize?: number;
+}
+
 // Storage backend selection shared by the async operations. See STORAGE.md.
 //   gateway - the Checkpoint core-server gateway (storage.mode local / s3);
 //             the client streams blobs over HTTP with a Bearer JWT.
 //   s3      - direct S3-compatible access (R2 for clients; any S3 for the
-//             server-side store-index merge).
-//   local   - the server's own disk (store-index merge only).
+//             server-side store-index merge and repack).
+//   local   - the server's own disk (store-index merge and repack only).
 export interface StorageOptions {
   storageType: "gateway" | "s3" | "local";
   // gateway
@@ -122,10 +142,25 @@ export interface SubmitAsyncOptions extends StorageOptions {
   message: string;
   targetChunkSize: number;
   targetBlockSize: number;
+  // Range the block size is tuned in from the measured latency and bandwidth
+  // of the store, both 0 (default) always uses targetBlockSize
+  minTargetBlockSize?: number;
+  maxTargetBlockSize?: number;
   maxChunksPerBlock: number;
   minBlockUsagePercent: number;
   hashingAlgo: string;
+  // hpcdc (default) or fastcdc which gives more evenly sized chunks, pulls use
+  // the chunker recorded in the version index
+  chunkingAlgo?: string;
+  // none, lz4, brotli[_text][_min|_max], zstd[_min|_max|_high|_low] or
+  // zstd_dict[_min|_max|_high|_low] which compresses with a dictionary trained
+  // per repository, helps most for submits of small similar files
   compressionAlgo: string;
+  // Blocks that compress by less than this are stored uncompressed, 0 always compresses
+  minCompressionSavingPercent?: number;
+  // Bytes of the file data read while indexing kept in memory so new chunks are
+  // not read again when writing blocks, 0 (default) reads them again
+  readCacheSize?: number;
   enableMmapIndexing: boolean;
   enableMmapBlockStore: boolean;
   localRootPath: string;
@@ -135,6 +170,7 @@ export interface SubmitAsyncOptions extends StorageOptions {
   keepCheckedOut: boolean;
   workspaceId: string;
   modifications: Modification[];
+  assetPolicies?: AssetPolicy[];
   logLevel: number;
 }
 
@@ -146,6 +182,22 @@ export interface PullAsyncOptions extends StorageOptions {
   remoteBasePath: string;
   logLevel: number;
   cachePath?: string;
+  // Most blocks fetched at once on high latency links, 0 (default) fetches
+  // one per CPU core
+  maxFetchDepth?: number;
+  // Changelist the workspace is synced to and changelist of versionIndex. When
+  // both are set the version is folded onto the materialized full version of
+  // baseChangelist kept in the workspace, files it did not change since then
+  // are skipped, files removed since then are removed or renamed to where the
+  // version moved their content, and the result is kept as the materialized
+  // version of changelist. Changelist 0 is the empty version.
+  baseChangelist?: number;
+  changelist?: number;
+  // Paths removed between baseChangelist and changelist
+  removedPaths?: string[];
+  // Only fold the version onto the materialized version, leave the files as they are
+  materializeOnly?: boolean;
+  assetPolicies?: AssetPolicy[];
 }
 
 export interface MergeAsyncOptions extends StorageOptions {
@@ -154,6 +206,18 @@ export interface MergeAsyncOptions extends StorageOptions {
   logLevel: number;
 }
 
+// Rewrites the chunks the listed versions use out of blocks they use less than
+// minBlockUsagePercent of into new dense blocks and adds those to store.lsi.
+// The handle result is { sparseBlocks, newBlocks, repackedBytes }.
+export interface RepackAsyncOptions extends StorageOptions {
+  remoteBasePath: string;
+  versionIndexNames: string[];
+  minBlockUsagePercent: number;
+  targetBlockSize: number;
+  maxChunksPerBlock: number;
+  logLevel: number;
+}
+
 export interface ReadFileFromVersionAsyncOptions extends StorageOptions {
   filePath: string;
   versionIndexName: string;
@@ -161,6 +225,23 @@ export interface ReadFileFromVersionAsyncOptions extends StorageOptions {
   logLevel: number;
 }
 
+export interface OpenChangeJournalOptions {
+  localRootPath: string;
+  logLevel: number;
+}
+
+export interface ChangeJournalChanges {
+  /** Cursor to pass to the next getChangeJournalChanges call */
+  cursor: number;
+  /**
+   * The journal does not cover every change since the given cursor and
+   * the whole workspace has to be compared; paths is empty in that case.
+   */
+  fullScanRequired: boolean;
+  /** Changed paths relative to the workspace root, using / separators */
+  paths: string[];
+}
+
 export { HandleStatus, NativeHandle };
 
 // --------------------------------------------------------------------------
@@ -220,6 +301,10 @@ export function mergeAsync(options: MergeAsyncOptions): NativeHandle {
   return addon.mergeAsync(options);
 }
 
+export function repackAsync(options: RepackAsyncOptions): NativeHandle {
+  return addon.repackAsync(options);
+}
+
 export function readFileFromVersionAsync(
   options: ReadFileFromVersionAsyncOptions,
 ): NativeHandle {
@@ -265,6 +350,31 @@ export function freeReadFileHandle(handle: NativeHandle): void {
   addon.freeReadFileHandle(handle);
 }
 
+// --------------------------------------------------------------------------
+// Change journal
+// --------------------------------------------------------------------------
+
+/**
+ * Starts recording the changes below a workspace root. Returns null on
+ * platforms without a change journal (currently anything but Linux).
+ */
+export function openChangeJournal(
+  options: OpenChangeJournalOptions,
+): NativeHandle | null {
+  return addon.openChangeJournal(options);
+}
+
+export function getChangeJournalChanges(
+  journal: NativeHandle,
+  cursor: number,
+): ChangeJournalChanges {
+  return addon.getChangeJournalChanges(journal, cursor);
+}
+
+export function closeChangeJournal(journal: NativeHandle): void {
+  addon.closeChangeJournal(journal);
+}
+
 // --------------------------------------------------------------------------
 // High-level polling helper
 // --------------------------------------------------------------------------
@@ -13,6 +13,9 @@
 // plus DLL_EXPORT macro and utility function declarations.
 #include "main.h"
 
+// Opaque journal type from the wrapper's util/change-journal.h
+struct ChangeJournal;
+
 // --------------------------------------------------------------------------
 // Forward declarations for DLL_EXPORT functions defined in the wrapper
 // .cpp files (compiled directly into this addon).
@@ -27,10 +30,15 @@ WrapperAsyncHandle* SubmitAsync(
     const char* Message,
     uint32_t TargetChunkSize,
     uint32_t TargetBlockSize,
+    uint32_t MinTargetBlockSize,
+    uint32_t MaxTargetBlockSize,
     uint32_t MaxChunksPerBlock,
     uint32_t MinBlockUsagePercent,
     const char* HashingAlgo,
+    const char* ChunkingAlgo,
     const char* CompressionAlgo,
+    uint32_t MinCompressionSavingPercent,
+    uint64_t ReadCacheSize,
     bool EnableMmapIndexing,
     bool EnableMmapBlockStore,
     const char* LocalRootPath,
@@ -51,6 +59,8 @@ WrapperAsyncHandle* SubmitAsync(
     const char* WorkspaceId,
     uint32_t NumModifications,
     const Checkpoint::Modification* Modifications,
+    uint32_t NumAssetPolicies,
+    const Checkpoint::AssetPolicy* AssetPolicies,
     int LogLevel);
 
 void FreeHandle(WrapperAsyncHandle* handle);
@@ -69,6 +79,23 @@ WrapperAsyncHandle* MergeAsync(
     size_t additional_store_index_size,
     int LogLevel);
 
+WrapperAsyncHandle* RepackAsync(
+    const char* RemoteBasePath,
+    const char* StorageType,
+    const char* LocalStoragePath,
+    const char* S3Endpoint,
+    const char* S3Region,
+    const char* S3Bucket,
+    const char* S3AccessKeyId,
+    const char* S3SecretAccessKey,
+    const char* S3SessionToken,
+    uint32_t NumVersionIndexes,
+    const char** VersionIndexNames,
+    uint32_t MinBlockUsagePercent,
+    uint32_t TargetBlockSize,
+    uint32_t MaxChunksPerBlock,
+    int LogLevel);
+
 WrapperAsyncHandle* PullAsync(
     const char* VersionIndex,
     bool EnableMmapIndexing,
@@ -86,6 +113,14 @@ WrapperAsyncHandle* PullAsync(
     const char* S3SecretAccessKey,
     const char* S3SessionToken,
     const char* CachePath,
+    uint32_t MaxFetchDepth,
+    int32_t BaseChangelist,
+    int32_t Changelist,
+    uint32_t NumRemovedPaths,
+    const char** RemovedPaths,
+    bool MaterializeOnly,
+    uint32_t NumAssetPolicies,
+    const Checkpoint::AssetPolicy* AssetPolicies,
     int LogLevel);
 
 ReadFileAsyncHandle* ReadFileFromVersionAsync(
@@ -107,6 +142,11 @@ ReadFileAsyncHandle* ReadFileFromVersionAsync(
 void FreeReadFileHandle(ReadFileAsyncHandle* handle);
 void* GetReadFileData(ReadFileAsyncHandle* handle);
 uint64_t GetReadFileSize(ReadFileAsyncHandle* handle);
+
+ChangeJournal* OpenChangeJournal(const char* LocalRootPath, int LogLevel);
+ChangeJournalChanges* GetChangeJournalChanges(ChangeJournal* Journal, uint64_t Cursor);
+void FreeChangeJournalChanges(ChangeJournalChanges* Changes);
+void CloseChangeJournal(ChangeJournal* Journal);
 }
 
 // --------------------------------------------------------------------------
@@ -129,9 +169,15 @@ struct HandleContext {
   // Modification structs for SubmitAsync
   std::vector<Checkpoint::Modification> modifications;
 
+  // Asset policy structs for SubmitAsync and PullAsync
+  std::vector<Checkpoint::AssetPolicy> assetPolicies;
+
   // Buffer data for MergeAsync
   std::vector<uint8_t> bufferData;
 
+  // Version index names for RepackAsync and removed paths for PullAsync, point into strings
+  std::vector<const char*> stringArray;
+
   void Free() {
     if (freed || !nativeHandle) return;
     freed = true;
@@ -153,6 +199,29 @@ static void ContextCleanup(Napi::Env /*env*/, HandleContext* ctx) {
   delete ctx;
 }
 
+// --------------------------------------------------------------------------
+// ChangeJournalContext: owns a change journal until closeChangeJournal is
+// called from JS or the handle is garbage collected.
+// --------------------------------------------------------------------------
+
+struct ChangeJournalContext {
+  ChangeJournal* journal = nullptr;
+
+  void Close() {
+    if (!journal) return;
+    ::CloseChangeJournal(journal);
+    journal = nullptr;
+  }
+
+  ~ChangeJournalContext() {
+    Close();
+  }
+};
+
+static void ChangeJournalCleanup(Napi::Env /*env*/, ChangeJournalContext* ctx) {
+  delete ctx;
+}
+
 // --------------------------------------------------------------------------
 // Helper: add a string to context, return stable c_str() pointer
 // --------------------------------------------------------------------------
@@ -171,6 +240,27 @@ static const char* OptStr(HandleContext* ctx, const Napi::Object& opts,
   return def;
 }
 
+// Optional assetPolicies array: [{ pattern, compressionAlgo?, targetChunkSize? }]
+static void ReadAssetPolicies(HandleContext* ctx, const Napi::Object& opts) {
+  Napi::Value val = opts.Get("assetPolicies");
+  if (!val.IsArray()) {
+    return;
+  }
+  Napi::Array policiesArray = val.As<Napi::Array>();
+  uint32_t numPolicies = policiesArray.Length();
+
+  ctx->assetPolicies.resize(numPolicies);
+  for (uint32_t i = 0; i < numPolicies; ++i) {
+    Napi::Object policy = policiesArray.Get(i).As<Napi::Object>();
+
+    ctx->assetPolicies[i].Pattern = StoreString(ctx, policy.Get("pattern").As<Napi::String>().Utf8Value());
+    ctx->assetPolicies[i].CompressionAlgo = OptStr(ctx, policy, "compressionAlgo", nullptr);
+
+    Napi::Value chunkSizeVal = policy.Get("targetChunkSize");
+    ctx->assetPolicies[i].TargetChunkSize = chunkSizeVal.IsNumber() ? chunkSizeVal.As<Napi::Number>().Uint32Value() : 0;
+  }
+}
+
 // --------------------------------------------------------------------------
 // submitAsync(options: object): External<HandleContext>
 // --------------------------------------------------------------------------
@@ -203,10 +293,39 @@ static Napi::Value NapiSubmitAsync(const Napi::CallbackInfo& info) {
   const char* message = StoreString(ctx, opts.Get("message").As<Napi::String>().Utf8Value());
   uint32_t targetChunkSize = opts.Get("targetChunkSize").As<Napi::Number>().Uint32Value();
   uint32_t targetBlockSize = opts.Get("targetBlockSize").As<Napi::Number>().Uint32Value();
+  uint32_t minTargetBlockSize = 0;
+  {
+    Napi::Value val = opts.Get("minTargetBlockSize");
+    if (val.IsNumber()) {
+      minTargetBlockSize = val.As<Napi::Number>().Uint32Value();
+    }
+  }
+  uint32_t maxTargetBlockSize = 0;
+  {
+    Napi::Value val = opts.Get("maxTargetBlockSize");
+    if (val.IsNumber()) {
+      maxTargetBlockSize = val.As<Napi::Number>().Uint32Value();
+    }
+  }
   uint32_t maxChunksPerBlock = opts.Get("maxChunksPerBlock").As<Napi::Number>().Uint32Value();
   uint32_t minBlockUsagePercent = opts.Get("minBlockUsagePercent").As<Napi::Number>().Uint32Value();
   const char* hashingAlgo = StoreString(ctx, opts.Get("hashingAlgo").As<Napi::String>().Utf8Value());
+  const char* chunkingAlgo = OptStr(ctx, opts, "chunkingAlgo", "hpcdc");
   const char* compressionAlgo = StoreString(ctx, opts.Get("compressionAlgo").As<Napi::String>().Utf8Value());
+  uint32_t minCompressionSavingPercent = 0;
+  {
+    Napi::Value val = opts.Get("minCompressionSavingPercent");
+    if (val.IsNumber()) {
+      minCompressionSavingPercent = val.As<Napi::Number>().Uint32Value();
+    }
+  }
+  uint64_t readCacheSize = 0;
+  {
+    Napi::Value val = opts.Get("readCacheSize");
+    if (val.IsNumber()) {
+      readCacheSize = static_cast<uint64_t>(val.As<Napi::Number>().Int64Value());
+    }
+  }
   bool enableMmapIndexing = opts.Get("enableMmapIndexing").As<Napi::Boolean>().Value();
   bool enableMmapBlockStore = opts.Get("enableMmapBlockStore").As<Napi::Boolean>().Value();
   const char* localRootPath = StoreString(ctx, opts.Get("localRootPath").As<Napi::String>().Utf8Value());
@@ -246,16 +365,20 @@ static Napi::Value NapiSubmitAsync(const Napi::CallbackInfo& info) {
     }
   }
 
+  ReadAssetPolicies(ctx, opts);
+
   WrapperAsyncHandle* handle = ::SubmitAsync(
       branchName, shelfName, artifactForChangelistNum, message,
-      targetChunkSize, targetBlockSize, maxChunksPerBlock, minBlockUsagePercent,
-      hashingAlgo, compressionAlgo,
-      enableMmapIndexing, enableMmapBlockStore,
+      targetChunkSize, targetBlockSize, minTargetBlockSize, maxTargetBlockSize,
+      maxChunksPerBlock, minBlockUsagePercent,
+      hashingAlgo, chunkingAlgo, compressionAlgo, minCompressionSavingPercent,
+      readCacheSize, enableMmapIndexing, enableMmapBlockStore,
       localRootPath, remoteBasePath, backendUrl, apiJwt,
       storageType, gatewayUrl, jwt, jwtExpirationMs,
       s3Endpoint, s3Region, s3Bucket, s3AccessKeyId, s3SecretAccessKey, s3SessionToken,
       keepCheckedOut, workspaceId,
       numMods, ctx->modifications.data(),
+      (uint32_t)ctx->assetPolicies.size(), ctx->assetPolicies.data(),
       logLevel);
 
   if (!handle) {
@@ -301,6 +424,40 @@ static Napi::Value NapiPullAsync(const Napi::CallbackInfo& info) {
   const char* s3SessionToken = OptStr(ctx, opts, "s3SessionToken", "");
   int logLevel = opts.Get("logLevel").As<Napi::Number>().Int32Value();
   const char* cachePath = OptStr(ctx, opts, "cachePath", nullptr);
+  uint32_t maxFetchDepth = 0;
+  {
+    Napi::Value val = opts.Get("maxFetchDepth");
+    if (val.IsNumber()) {
+      maxFetchDepth = val.As<Napi::Number>().Uint32Value();
+    }
+  }
+  int32_t baseChangelist = -1;
+  int32_t changelist = -1;
+  {
+    Napi::Value base = opts.Get("baseChangelist");
+    Napi::Value target = opts.Get("changelist");
+    if (base.IsNumber() && target.IsNumber()) {
+      baseChangelist = base.As<Napi::Number>().Int32Value();
+      changelist = target.As<Napi::Number>().Int32Value();
+    }
+  }
+  {
+    Napi::Value val = opts.Get("removedPaths");
+    if (val.IsArray()) {
+      Napi::Array removedArray = val.As<Napi::Array>();
+      for (uint32_t i = 0; i < removedArray.Length(); i++) {
+        ctx->stringArray.push_back(StoreString(ctx, removedArray.Get(i).As<Napi::String>().Utf8Value()));
+      }
+    }
+  }
+  bool materializeOnly = false;
+  {
+    Napi::Value val = opts.Get("materializeOnly");
+    if (val.IsBoolean()) {
+      materializeOnly = val.As<Napi::Boolean>().Value();
+    }
+  }
+  ReadAssetPolicies(ctx, opts);
 
   WrapperAsyncHandle* handle = ::PullAsync(
       versionIndex,
@@ -308,7 +465,11 @@ static Napi::Value NapiPullAsync(const Napi::CallbackInfo& info) {
       localRootPath, remoteBasePath,
       storageType, gatewayUrl, jwt, jwtExpirationMs,
       s3Endpoint, s3Region, s3Bucket, s3AccessKeyId, s3SecretAccessKey, s3SessionToken,
-      cachePath,
+      cachePath, maxFetchDepth,
+      baseChangelist, changelist,
+      (uint32_t)ctx->stringArray.size(), ctx->stringArray.data(),
+      materializeOnly,
+      (uint32_t)ctx->assetPolicies.size(), ctx->assetPolicies.data(),
       logLevel);
 
   if (!handle) {
@@ -373,6 +534,63 @@ static Napi::Value NapiMergeAsync(const Napi::CallbackInfo& info) {
   return Napi::External<HandleContext>::New(env, ctx, ContextCleanup);
 }
 
+// --------------------------------------------------------------------------
+// repackAsync(options: object): External<HandleContext>
+// --------------------------------------------------------------------------
+static Napi::Value NapiRepackAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object opts = info[0].As<Napi::Object>();
+  auto* ctx = new HandleContext();
+
+  const char* remoteBasePath = StoreString(ctx, opts.Get("remoteBasePath").As<Napi::String>().Utf8Value());
+  // Server-side repack: storageType is "local" or "s3" (never "gateway").
+  const char* storageType = OptStr(ctx, opts, "storageType", "local");
+  const char* localStoragePath = OptStr(ctx, opts, "localStoragePath", "");
+  const char* s3Endpoint = OptStr(ctx, opts, "s3Endpoint", "");
+  const char* s3Region = OptStr(ctx, opts, "s3Region", "");
+  const char* s3Bucket = OptStr(ctx, opts, "s3Bucket", "");
+  const char* s3AccessKeyId = OptStr(ctx, opts, "s3AccessKeyId", "");
+  const char* s3SecretAccessKey = OptStr(ctx, opts, "s3SecretAccessKey", "");
+  const char* s3SessionToken = OptStr(ctx, opts, "s3SessionToken", "");
+  uint32_t minBlockUsagePercent = opts.Get("minBlockUsagePercent").As<Napi::Number>().Uint32Value();
+  uint32_t targetBlockSize = opts.Get("targetBlockSize").As<Napi::Number>().Uint32Value();
+  uint32_t maxChunksPerBlock = opts.Get("maxChunksPerBlock").As<Napi::Number>().Uint32Value();
+  int logLevel = opts.Get("logLevel").As<Napi::Number>().Int32Value();
+
+  Napi::Array namesArray = opts.Get("versionIndexNames").As<Napi::Array>();
+  uint32_t numNames = namesArray.Length();
+  for (uint32_t i = 0; i < numNames; i++) {
+    ctx->stringArray.push_back(StoreString(ctx, namesArray.Get(i).As<Napi::String>().Utf8Value()));
+  }
+
+  WrapperAsyncHandle* handle = ::RepackAsync(
+      remoteBasePath,
+      storageType, localStoragePath,
+      s3Endpoint, s3Region, s3Bucket, s3AccessKeyId, s3SecretAccessKey, s3SessionToken,
+      numNames, ctx->stringArray.data(),
+      minBlockUsagePercent,
+      targetBlockSize,
+      maxChunksPerBlock,
+      logLevel);
+
+  if (!handle) {
+    delete ctx;
+    Napi::Error::New(env, "RepackAsync returned null handle").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  ctx->nativeHandle = handle;
+  ctx->isReadFileHandle = false;
+
+  return Napi::External<HandleContext>::New(env, ctx, ContextCleanup);
+}
+
 // --------------------------------------------------------------------------
 // readFileFromVersionAsync(options: object): External<HandleContext>
 // --------------------------------------------------------------------------
@@ -685,6 +903,93 @@ static Napi::Value NapiFreeReadFileHandle(const Napi::CallbackInfo& info) {
   return NapiFreeHandle(info);
 }
 
+// --------------------------------------------------------------------------
+// openChangeJournal(options: object): External<ChangeJournalContext> | null
+// Returns null when the platform has no change journal (anything but Linux).
+// --------------------------------------------------------------------------
+static Napi::Value NapiOpenChangeJournal(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object opts = info[0].As<Napi::Object>();
+  std::string localRootPath = opts.Get("localRootPath").As<Napi::String>().Utf8Value();
+  int logLevel = opts.Get("logLevel").As<Napi::Number>().Int32Value();
+
+  ChangeJournal* journal = ::OpenChangeJournal(localRootPath.c_str(), logLevel);
+  if (!journal) {
+    return env.Null();
+  }
+
+  auto* ctx = new ChangeJournalContext();
+  ctx->journal = journal;
+  return Napi::External<ChangeJournalContext>::New(env, ctx, ChangeJournalCleanup);
+}
+
+// --------------------------------------------------------------------------
+// getChangeJournalChanges(journal, cursor): { cursor, fullScanRequired, paths }
+// --------------------------------------------------------------------------
+static Napi::Value NapiGetChangeJournalChanges(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 2 || !info[0].IsExternal() || !info[1].IsNumber()) {
+    Napi::TypeError::New(env, "Expected (journal, cursor) arguments")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  auto* ctx = info[0].As<Napi::External<ChangeJournalContext>>().Data();
+  if (!ctx || !ctx->journal) {
+    Napi::Error::New(env, "Change journal is invalid or already closed")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  uint64_t cursor = static_cast<uint64_t>(info[1].As<Napi::Number>().Int64Value());
+  ChangeJournalChanges* changes = ::GetChangeJournalChanges(ctx->journal, cursor);
+  if (!changes) {
+    Napi::Error::New(env, "GetChangeJournalChanges failed")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Array paths = Napi::Array::New(env, changes->NumPaths);
+  for (uint32_t i = 0; i < changes->NumPaths; ++i) {
+    paths.Set(i, Napi::String::New(env, changes->Paths[i]));
+  }
+
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("cursor", Napi::Number::New(env, static_cast<double>(changes->Cursor)));
+  result.Set("fullScanRequired", Napi::Boolean::New(env, changes->FullScanRequired != 0));
+  result.Set("paths", paths);
+  ::FreeChangeJournalChanges(changes);
+
+  return result;
+}
+
+// --------------------------------------------------------------------------
+// closeChangeJournal(journal): void
+// --------------------------------------------------------------------------
+static Napi::Value NapiCloseChangeJournal(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsExternal()) {
+    Napi::TypeError::New(env, "Expected journal (External) argument")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  auto* ctx = info[0].As<Napi::External<ChangeJournalContext>>().Data();
+  if (ctx) {
+    ctx->Close();
+  }
+
+  return env.Undefined();
+}
+
 // --------------------------------------------------------------------------
 // Module initialization
 // --------------------------------------------------------------------------
@@ -692,6 +997,7 @@ static Napi::Object Init(Napi::Env env, Napi::Object exports) {
   exports.Set("submitAsync", Napi::Function::New(env, NapiSubmitAsync));
   exports.Set("pullAsync", Napi::Function::New(env, NapiPullAsync));
   exports.Set("mergeAsync", Napi::Function::New(env, NapiMergeAsync));
+  exports.Set("repackAsync", Napi::Function::New(env, NapiRepackAsync));
   exports.Set("readFileFromVersionAsync", Napi::Function::New(env, NapiReadFileFromVersionAsync));
   exports.Set("getHandleStatus", Napi::Function::New(env, NapiGetHandleStatus));
   exports.Set("getHandleResult", Napi::Function::New(env, NapiGetHandleResult));
@@ -701,6 +1007,9 @@ static Napi::Object Init(Napi::Env env, Napi::Object exports) {
   exports.Set("getReadFileData", Napi::Function::New(env, NapiGetReadFileData));
   exports.Set("getReadFileSize", Napi::Function::New(env, NapiGetReadFileSize));
   exports.Set("freeReadFileHandle", Napi::Function::New(env, NapiFreeReadFileHandle));
+  exports.Set("openChangeJournal", Napi::Function::New(env, NapiOpenChangeJournal));
+  exports.Set("getChangeJournalChanges", Napi::Function::New(env, NapiGetChangeJournalChanges));
+  exports.Set("closeChangeJournal", Napi::Function::New(env, NapiCloseChangeJournal));
 
   return exports;
 }
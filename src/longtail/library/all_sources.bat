@@ -15,7 +15,12 @@ set FILESTORAGE_SRC=%BASE_DIR%lib\*.c
 
 set FSBLOCKSTORE_SRC=%BASE_DIR%lib\fsblockstore\*.c
 
+set FASTCDCCHUNKER_SRC=%BASE_DIR%lib\fastcdcchunker\*.c
+
 set HPCDCCHUNKER_SRC=%BASE_DIR%lib\hpcdcchunker\*.c
+set HPCDCCHUNKER_SSE=%BASE_DIR%lib\hpcdcchunker\simd\longtail_hpcdcchunker_sse41.c
+set HPCDCCHUNKER_AVX2=%BASE_DIR%lib\hpcdcchunker\simd\longtail_hpcdcchunker_avx2.c
+set HPCDCCHUNKER_AVX512=%BASE_DIR%lib\hpcdcchunker\simd\longtail_hpcdcchunker_avx512.c
 
 set LRUBLOCKSTORE_SRC=%BASE_DIR%lib\lrublockstore\*.c
 
@@ -24,6 +29,9 @@ set MEMSTORAGE_SRC=%BASE_DIR%lib\memstorage\*.c
 set MEMTRACER_SRC=%BASE_DIR%lib\memtracer\*.c
 
 set MEOWHASH_SRC=%BASE_DIR%lib\meowhash\*.c
+set XXHASH_SRC=%BASE_DIR%lib\xxhash\*.c
+
+set PREFETCHBLOCKSTORE_SRC=%BASE_DIR%lib\prefetchblockstore\*.c
 
 set RATELIMITEDPROGRESS_SRC=%BASE_DIR%lib\ratelimitedprogress\*.c
 
@@ -53,14 +61,14 @@ set BROTLI_SRC=%BASE_DIR%lib\brotli\*.c
 set BROTLI_THIRDPARTY_SRC=%BASE_DIR%lib\brotli\ext\common\*.c %BASE_DIR%lib\brotli\ext\dec\*.c %BASE_DIR%lib\brotli\ext\enc\*.c
 
 set ZSTD_SRC=%BASE_DIR%lib\zstd\*.c
-set ZSTD_THIRDPARTY_SRC=%BASE_DIR%lib\zstd\ext\common\*.c %BASE_DIR%lib\zstd\ext\compress\*.c %BASE_DIR%lib\zstd\ext\decompress\*.c
+set ZSTD_THIRDPARTY_SRC=%BASE_DIR%lib\zstd\ext\common\*.c %BASE_DIR%lib\zstd\ext\compress\*.c %BASE_DIR%lib\zstd\ext\decompress\*.c %BASE_DIR%lib\zstd\ext\dictBuilder\*.c
 set ZSTD_THIRDPARTY_GCC_SRC=%BASE_DIR%lib\zstd\ext\decompress\*.S
 
-set SRC=%BASE_DIR%src\*.c %LIB_SRC% %ARCHIVEBLOCKSTORE_SRC% %ATOMICCANCEL_SRC% %BLOCKSTORESTORAGE_SRC% %COMPRESSBLOCKSTORE_SRC% %CACHEBLOCKSTORE_SRC% %SHAREBLOCKSTORE_SRC% %FILESTORAGE_SRC% %FSBLOCKSTORE_SRC% %HPCDCCHUNKER_SRC% %LRUBLOCKSTORE_SRC% %MEMSTORAGE_SRC% %MEMTRACER_SRC% %RATELIMITEDPROGRESS_SRC% %COMPRESSION_REGISTRY_SRC% %HASH_REGISTRY_SRC% %BIKESHED_SRC% %BLAKE2_SRC% %BLAKE3_SRC% %MEOWHASH_SRC% %LZ4_SRC% %BROTLI_SRC% %ZSTD_SRC%
+set SRC=%BASE_DIR%src\*.c %LIB_SRC% %ARCHIVEBLOCKSTORE_SRC% %ATOMICCANCEL_SRC% %BLOCKSTORESTORAGE_SRC% %COMPRESSBLOCKSTORE_SRC% %CACHEBLOCKSTORE_SRC% %SHAREBLOCKSTORE_SRC% %FILESTORAGE_SRC% %FSBLOCKSTORE_SRC% %FASTCDCCHUNKER_SRC% %HPCDCCHUNKER_SRC% %LRUBLOCKSTORE_SRC% %MEMSTORAGE_SRC% %MEMTRACER_SRC% %PREFETCHBLOCKSTORE_SRC% %RATELIMITEDPROGRESS_SRC% %COMPRESSION_REGISTRY_SRC% %HASH_REGISTRY_SRC% %BIKESHED_SRC% %BLAKE2_SRC% %BLAKE3_SRC% %MEOWHASH_SRC% %XXHASH_SRC% %LZ4_SRC% %BROTLI_SRC% %ZSTD_SRC%
 set THIRDPARTY_SRC=%LIB_THIRDPARTY_SRC% %BLAKE3_THIRDPARTY_SRC% %LZ4_THIRDPARTY_SRC% %BROTLI_THIRDPARTY_SRC% %ZSTD_THIRDPARTY_SRC%
-set THIRDPARTY_SSE=%BLAKE2_THIRDPARTY_SSE% %BLAKE3_THIRDPARTY_SSE%
+set THIRDPARTY_SSE=%BLAKE2_THIRDPARTY_SSE% %BLAKE3_THIRDPARTY_SSE% %HPCDCCHUNKER_SSE%
 set THIRDPARTY_SSE42=%BLAKE3_THIRDPARTY_SSE42%
-set THIRDPARTY_SRC_AVX2=%BLAKE3_THIRDPARTY_AVX2%
-set THIRDPARTY_SRC_AVX512=%BLAKE3_THIRDPARTY_AVX512%
+set THIRDPARTY_SRC_AVX2=%BLAKE3_THIRDPARTY_AVX2% %HPCDCCHUNKER_AVX2%
+set THIRDPARTY_SRC_AVX512=%BLAKE3_THIRDPARTY_AVX512% %HPCDCCHUNKER_AVX512%
 set THIRDPARTY_SRC_NEON=%BLAKE3_THIRDPARTY_NEON%
 set THIRDPARTY_GCC_SRC=%ZSTD_THIRDPARTY_GCC_SRC%
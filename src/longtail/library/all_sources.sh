@@ -17,7 +17,12 @@ FILESTORAGE_SRC="${BASE_DIR}lib/*.c"
 
 FSBLOCKSTORAGE_SRC="${BASE_DIR}lib/fsblockstore/*.c"
 
+FASTCDCCHUNKER_SRC="${BASE_DIR}lib/fastcdcchunker/*.c"
+
 HPCDCCHUNKER_SRC="${BASE_DIR}lib/hpcdcchunker/*.c"
+HPCDCCHUNKER_SSE="${BASE_DIR}lib/hpcdcchunker/simd/longtail_hpcdcchunker_sse41.c"
+HPCDCCHUNKER_AVX2="${BASE_DIR}lib/hpcdcchunker/simd/longtail_hpcdcchunker_avx2.c"
+HPCDCCHUNKER_AVX512="${BASE_DIR}lib/hpcdcchunker/simd/longtail_hpcdcchunker_avx512.c"
 
 LRUBLOCKSTORE_SRC="${BASE_DIR}lib/lrublockstore/*.c"
 
@@ -26,6 +31,9 @@ MEMSTORAGE_SRC="${BASE_DIR}lib/memstorage/*.c"
 MEMTRACER_SRC="${BASE_DIR}lib/memtracer/*.c"
 
 MEOWHASH_SRC="${BASE_DIR}lib/meowhash/*.c"
+XXHASH_SRC="${BASE_DIR}lib/xxhash/*.c"
+
+PREFETCHBLOCKSTORE_SRC="${BASE_DIR}lib/prefetchblockstore/*.c"
 
 RATELIMITEDPROGRESS_SRC="${BASE_DIR}lib/ratelimitedprogress/*.c"
 
@@ -55,14 +63,14 @@ BROTLI_SRC="${BASE_DIR}lib/brotli/*.c"
 BROTLI_THIRDPARTY_SRC="${BASE_DIR}lib/brotli/ext/common/*.c ${BASE_DIR}lib/brotli/ext/dec/*.c ${BASE_DIR}lib/brotli/ext/enc/*.c"
 
 ZSTD_SRC="${BASE_DIR}lib/zstd/*.c"
-ZSTD_THIRDPARTY_SRC="${BASE_DIR}lib/zstd/ext/common/*.c ${BASE_DIR}lib/zstd/ext/compress/*.c ${BASE_DIR}lib/zstd/ext/decompress/*.c"
+ZSTD_THIRDPARTY_SRC="${BASE_DIR}lib/zstd/ext/common/*.c ${BASE_DIR}lib/zstd/ext/compress/*.c ${BASE_DIR}lib/zstd/ext/decompress/*.c ${BASE_DIR}lib/zstd/ext/dictBuilder/*.c"
 ZSTD_THIRDPARTY_GCC_SRC="${BASE_DIR}lib/zstd/ext/decompress/*.S"
 
-export SRC="${BASE_DIR}src/*.c $LIB_SRC $ARCHIVEBLOCKSTORE_SRC $ATOMICCANCEL_SRC $BLOCKSTORESTORAGE_SRC $COMPRESSBLOCKSTORE_SRC $CACHEBLOCKSTORE_SRC $SHAREBLOCKSTORE_SRC $FILESTORAGE_SRC $FSBLOCKSTORAGE_SRC $HPCDCCHUNKER_SRC $LRUBLOCKSTORE_SRC $MEMSTORAGE_SRC $MEMTRACER_SRC $RATELIMITEDPROGRESS_SRC $COMPRESSION_REGISTRY_SRC $HASH_REGISTRY_SRC $BIKESHED_SRC $BLAKE2_SRC $BLAKE3_SRC $MEOWHASH_SRC $LZ4_SRC $BROTLI_SRC $ZSTD_SRC"
+export SRC="${BASE_DIR}src/*.c $LIB_SRC $ARCHIVEBLOCKSTORE_SRC $ATOMICCANCEL_SRC $BLOCKSTORESTORAGE_SRC $COMPRESSBLOCKSTORE_SRC $CACHEBLOCKSTORE_SRC $SHAREBLOCKSTORE_SRC $FILESTORAGE_SRC $FSBLOCKSTORAGE_SRC $FASTCDCCHUNKER_SRC $HPCDCCHUNKER_SRC $LRUBLOCKSTORE_SRC $MEMSTORAGE_SRC $MEMTRACER_SRC $PREFETCHBLOCKSTORE_SRC $RATELIMITEDPROGRESS_SRC $COMPRESSION_REGISTRY_SRC $HASH_REGISTRY_SRC $BIKESHED_SRC $BLAKE2_SRC $BLAKE3_SRC $MEOWHASH_SRC $XXHASH_SRC $LZ4_SRC $BROTLI_SRC $ZSTD_SRC"
 export THIRDPARTY_SRC="$LIB_THIRDPARTY_SRC $BLAKE3_THIRDPARTY_SRC $LZ4_THIRDPARTY_SRC $BROTLI_THIRDPARTY_SRC $ZSTD_THIRDPARTY_SRC"
-export THIRDPARTY_SSE="$BLAKE2_THIRDPARTY_SSE $BLAKE3_THIRDPARTY_SSE"
+export THIRDPARTY_SSE="$BLAKE2_THIRDPARTY_SSE $BLAKE3_THIRDPARTY_SSE $HPCDCCHUNKER_SSE"
 export THIRDPARTY_SSE42="$BLAKE3_THIRDPARTY_SSE42"
-export THIRDPARTY_SRC_AVX2="$BLAKE3_THIRDPARTY_AVX2"
-export THIRDPARTY_SRC_AVX512="$BLAKE3_THIRDPARTY_AVX512"
+export THIRDPARTY_SRC_AVX2="$BLAKE3_THIRDPARTY_AVX2 $HPCDCCHUNKER_AVX2"
+export THIRDPARTY_SRC_AVX512="$BLAKE3_THIRDPARTY_AVX512 $HPCDCCHUNKER_AVX512"
 export THIRDPARTY_SRC_NEON="$BLAKE3_THIRDPARTY_NEON"
 export THIRDPARTY_GCC_SRC="$ZSTD_THIRDPARTY_GCC_SRC"
@@ -25,6 +25,7 @@ mkdir dist\include\lib\brotli
 mkdir dist\include\lib\cacheblockstore
 mkdir dist\include\lib\compressblockstore
 mkdir dist\include\lib\compressionregistry
+mkdir dist\include\lib\fastcdcchunker
 mkdir dist\include\lib\filestorage
 mkdir dist\include\lib\fsblockstore
 mkdir dist\include\lib\hpcdcchunker
@@ -34,8 +35,10 @@ mkdir dist\include\lib\lz4
 mkdir dist\include\lib\memstorage
 mkdir dist\include\lib\memtracer
 mkdir dist\include\lib\meowhash
+mkdir dist\include\lib\prefetchblockstore
 mkdir dist\include\lib\ratelimitedprogress
 mkdir dist\include\lib\shareblockstore
+mkdir dist\include\lib\xxhash
 mkdir dist\include\lib\zstd
 copy src\*.h dist\include\src
 copy lib\longtail_platform.h dist\include\lib
@@ -49,6 +52,7 @@ copy lib\brotli\*.h dist\include\lib\brotli
 copy lib\cacheblockstore\*.h dist\include\lib\cacheblockstore
 copy lib\compressblockstore\*.h dist\include\lib\compressblockstore
 copy lib\compressionregistry\*.h dist\include\lib\compressionregistry
+copy lib\fastcdcchunker\*.h dist\include\lib\fastcdcchunker
 copy lib\filestorage\*.h dist\include\lib\filestorage
 copy lib\fsblockstore\*.h dist\include\lib\fsblockstore
 copy lib\hpcdcchunker\*.h dist\include\lib\hpcdcchunker
@@ -59,5 +63,7 @@ copy lib\memstorage\*.h dist\include\lib\memstorage
 copy lib\memtracer\*.h dist\include\lib\memtracer
 copy lib\meowhash\*.h dist\include\lib\meowhash
 copy lib\shareblockstore\*.h dist\include\lib\shareblockstore
+copy lib\xxhash\*.h dist\include\lib\xxhash
+copy lib\prefetchblockstore\*.h dist\include\lib\prefetchblockstore
 copy lib\ratelimitedprogress\*.h dist\include\lib\ratelimitedprogress
 copy lib\zstd\*.h dist\include\lib\zstd
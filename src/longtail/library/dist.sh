@@ -34,6 +34,7 @@ mkdir dist/include/lib/brotli
 mkdir dist/include/lib/cacheblockstore
 mkdir dist/include/lib/compressblockstore
 mkdir dist/include/lib/compressionregistry
+mkdir dist/include/lib/fastcdcchunker
 mkdir dist/include/lib/filestorage
 mkdir dist/include/lib/fsblockstore
 mkdir dist/include/lib/hpcdcchunker
@@ -43,8 +44,10 @@ mkdir dist/include/lib/lz4
 mkdir dist/include/lib/memstorage
 mkdir dist/include/lib/memtracer
 mkdir dist/include/lib/meowhash
+mkdir dist/include/lib/prefetchblockstore
 mkdir dist/include/lib/ratelimitedprogress
 mkdir dist/include/lib/shareblockstore
+mkdir dist/include/lib/xxhash
 mkdir dist/include/lib/zstd
 cp src/*.h dist/include/src
 cp lib/longtail_platform.h dist/include/lib
@@ -58,6 +61,7 @@ cp lib/brotli/*.h dist/include/lib/brotli
 cp lib/cacheblockstore/*.h dist/include/lib/cacheblockstore
 cp lib/compressblockstore/*.h dist/include/lib/compressblockstore
 cp lib/compressionregistry/*.h dist/include/lib/compressionregistry
+cp lib/fastcdcchunker/*.h dist/include/lib/fastcdcchunker
 cp lib/filestorage/*.h dist/include/lib/filestorage
 cp lib/fsblockstore/*.h dist/include/lib/fsblockstore
 cp lib/hpcdcchunker/*.h dist/include/lib/hpcdcchunker
@@ -67,6 +71,8 @@ cp lib/lz4/*.h dist/include/lib/lz4
 cp lib/memstorage/*.h dist/include/lib/memstorage
 cp lib/memtracer/*.h dist/include/lib/memtracer
 cp lib/meowhash/*.h dist/include/lib/meowhash
+cp lib/prefetchblockstore/*.h dist/include/lib/prefetchblockstore
 cp lib/ratelimitedprogress/*.h dist/include/lib/ratelimitedprogress
 cp lib/shareblockstore/*.h dist/include/lib/shareblockstore
+cp lib/xxhash/*.h dist/include/lib/xxhash
 cp lib/zstd/*.h dist/include/lib/zstd
@@ -1,6 +1,7 @@
 #include "longtail_blake3.h"
 
 #include "ext/blake3.h"
+#include "ext/blake3_impl.h"
 #include <errno.h>
 
 const uint32_t LONGTAIL_BLAKE3_HASH_TYPE = (((uint32_t)'b') << 24) + (((uint32_t)'l') << 16) + (((uint32_t)'k') << 8) + ((uint32_t)'3');
@@ -101,6 +102,192 @@ static int Blake3Hash_HashBuffer(struct Longtail_HashAPI* hash_api, uint32_t len
     return 0;
 }
 
+// Chaining value of the last BLAKE3 chunk of an input, the only chunk that may be partial
+static void Blake3ChunkCV(const uint8_t* data, size_t length, uint64_t chunk_counter, uint8_t root_flag, uint8_t out_cv[BLAKE3_OUT_LEN])
+{
+    uint32_t cv[8];
+    memcpy(cv, IV, sizeof(cv));
+    uint8_t flags = CHUNK_START;
+    do
+    {
+        uint8_t block[BLAKE3_BLOCK_LEN];
+        size_t block_len = length < BLAKE3_BLOCK_LEN ? length : BLAKE3_BLOCK_LEN;
+        memcpy(block, data, block_len);
+        memset(&block[block_len], 0, BLAKE3_BLOCK_LEN - block_len);
+        data += block_len;
+        length -= block_len;
+        if (length == 0)
+        {
+            flags |= CHUNK_END | root_flag;
+        }
+        blake3_compress_in_place(cv, block, (uint8_t)block_len, chunk_counter, flags);
+        flags = 0;
+    } while (length > 0);
+    store_cv_words(out_cv, cv);
+}
+
+static void Blake3ParentCV(const uint8_t* left_cv, const uint8_t* right_cv, uint8_t root_flag, uint8_t out_cv[BLAKE3_OUT_LEN])
+{
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    memcpy(block, left_cv, BLAKE3_OUT_LEN);
+    memcpy(&block[BLAKE3_OUT_LEN], right_cv, BLAKE3_OUT_LEN);
+    uint32_t cv[8];
+    memcpy(cv, IV, sizeof(cv));
+    blake3_compress_in_place(cv, block, BLAKE3_BLOCK_LEN, 0, PARENT | root_flag);
+    store_cv_words(out_cv, cv);
+}
+
+// Merges the chaining values of chunk_count (> 1) chunks the way the BLAKE3 tree does,
+// the left subtree holds the largest power of two chunks that leaves at least one chunk to the right
+static void Blake3SubtreeCV(const uint8_t* chunk_cvs, uint64_t chunk_count, uint8_t root_flag, uint8_t out_cv[BLAKE3_OUT_LEN])
+{
+    uint64_t left_count = round_down_to_power_of_2(chunk_count - 1);
+    uint8_t left_cv[BLAKE3_OUT_LEN];
+    uint8_t right_cv[BLAKE3_OUT_LEN];
+    const uint8_t* left = &chunk_cvs[0];
+    const uint8_t* right = &chunk_cvs[left_count * BLAKE3_OUT_LEN];
+    if (left_count > 1)
+    {
+        Blake3SubtreeCV(left, left_count, 0, left_cv);
+        left = left_cv;
+    }
+    if (chunk_count - left_count > 1)
+    {
+        Blake3SubtreeCV(right, chunk_count - left_count, 0, right_cv);
+        right = right_cv;
+    }
+    Blake3ParentCV(left, right, root_flag, out_cv);
+}
+
+static uint64_t Blake3ChunkCount(uint32_t length)
+{
+    return length == 0 ? 1u : (((uint64_t)length + BLAKE3_CHUNK_LEN - 1) / BLAKE3_CHUNK_LEN);
+}
+
+// Hashes many buffers at once. All full BLAKE3 chunks with the same chunk index are
+// compressed together across the buffers with the widest SIMD implementation available,
+// so buffers smaller than the SIMD degree times the BLAKE3 chunk size still fill the lanes.
+// Larger buffers fill the lanes on their own and are hashed one at a time.
+static int Blake3Hash_HashBuffers(struct Longtail_HashAPI* hash_api, uint32_t count, const uint32_t* lengths, const void* const* datas, uint64_t* out_hashes)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(count, "%u"),
+        LONGTAIL_LOGFIELD(lengths, "%p"),
+        LONGTAIL_LOGFIELD(datas, "%p"),
+        LONGTAIL_LOGFIELD(out_hashes, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, hash_api, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, count == 0 || lengths, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, count == 0 || datas, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, count == 0 || out_hashes, return EINVAL)
+
+    const uint64_t batch_max_length = (uint64_t)blake3_simd_degree() * BLAKE3_CHUNK_LEN;
+
+    uint64_t total_chunk_count = 0;
+    uint64_t max_chunk_count = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (lengths[i] >= batch_max_length)
+        {
+            int err = Blake3Hash_HashBuffer(hash_api, lengths[i], datas[i], &out_hashes[i]);
+            if (err)
+            {
+                return err;
+            }
+            continue;
+        }
+        uint64_t chunk_count = Blake3ChunkCount(lengths[i]);
+        total_chunk_count += chunk_count;
+        max_chunk_count = chunk_count > max_chunk_count ? chunk_count : max_chunk_count;
+    }
+    if (total_chunk_count == 0)
+    {
+        return 0;
+    }
+
+    size_t work_mem_size =
+        sizeof(uint64_t) * count +
+        sizeof(const uint8_t*) * count +
+        BLAKE3_OUT_LEN * (size_t)total_chunk_count +
+        BLAKE3_OUT_LEN * (size_t)count;
+    void* work_mem = Longtail_Alloc("Blake3Hash_HashBuffers", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    // Chunk chaining values of the batched buffers, buffer i starts at chunk_cv_offsets[i]
+    uint64_t* chunk_cv_offsets = (uint64_t*)work_mem;
+    const uint8_t** inputs = (const uint8_t**)&chunk_cv_offsets[count];
+    uint8_t* chunk_cvs = (uint8_t*)&inputs[count];
+    uint8_t* batch_cvs = &chunk_cvs[BLAKE3_OUT_LEN * total_chunk_count];
+
+    uint64_t chunk_cv_offset = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        chunk_cv_offsets[i] = chunk_cv_offset;
+        if (lengths[i] < batch_max_length)
+        {
+            chunk_cv_offset += Blake3ChunkCount(lengths[i]);
+        }
+    }
+
+    // All chunks but the last of each buffer are full, compress chunk n of all buffers together
+    for (uint64_t chunk_index = 0; chunk_index + 1 < max_chunk_count; ++chunk_index)
+    {
+        const uint64_t min_length = (chunk_index + 1) * BLAKE3_CHUNK_LEN + 1;
+        uint32_t input_count = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (lengths[i] >= min_length && lengths[i] < batch_max_length)
+            {
+                inputs[input_count++] = &((const uint8_t*)datas[i])[chunk_index * BLAKE3_CHUNK_LEN];
+            }
+        }
+        blake3_hash_many(inputs, input_count, BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN, IV, chunk_index, false, 0, CHUNK_START, CHUNK_END, batch_cvs);
+        input_count = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (lengths[i] >= min_length && lengths[i] < batch_max_length)
+            {
+                memcpy(&chunk_cvs[(chunk_cv_offsets[i] + chunk_index) * BLAKE3_OUT_LEN], &batch_cvs[input_count++ * BLAKE3_OUT_LEN], BLAKE3_OUT_LEN);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (lengths[i] >= batch_max_length)
+        {
+            continue;
+        }
+        const uint8_t* data = (const uint8_t*)datas[i];
+        uint64_t chunk_count = Blake3ChunkCount(lengths[i]);
+        uint8_t root_cv[BLAKE3_OUT_LEN];
+        if (chunk_count == 1)
+        {
+            Blake3ChunkCV(data, lengths[i], 0, ROOT, root_cv);
+        }
+        else
+        {
+            uint8_t* cvs = &chunk_cvs[chunk_cv_offsets[i] * BLAKE3_OUT_LEN];
+            uint64_t last_chunk_start = (chunk_count - 1) * BLAKE3_CHUNK_LEN;
+            Blake3ChunkCV(&data[last_chunk_start], (size_t)(lengths[i] - last_chunk_start), chunk_count - 1, 0, &cvs[(chunk_count - 1) * BLAKE3_OUT_LEN]);
+            Blake3SubtreeCV(cvs, chunk_count, ROOT, root_cv);
+        }
+        memcpy(&out_hashes[i], root_cv, sizeof(uint64_t));
+    }
+
+    Longtail_Free(work_mem);
+    return 0;
+}
+
 static void Blake3Hash_Dispose(struct Longtail_API* hash_api)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -124,6 +311,7 @@ static void Blake3Hash_Init(struct Blake3HashAPI* hash_api)
     hash_api->m_Blake3HashAPI.Hash = Blake3Hash_Hash;
     hash_api->m_Blake3HashAPI.EndContext = Blake3Hash_EndContext;
     hash_api->m_Blake3HashAPI.HashBuffer = Blake3Hash_HashBuffer;
+    hash_api->m_Blake3HashAPI.HashBuffers = Blake3Hash_HashBuffers;
 }
 
 struct Longtail_HashAPI* Longtail_CreateBlake3HashAPI()
@@ -555,24 +555,34 @@ static int BlockStoreStorageAPI_ReadFile(
     {
         uint32_t chunk_index = chunk_indexes[c];
         TLongtail_Hash chunk_hash = chunk_hashes[chunk_index];
-        const uint32_t* block_index_ptr = LongtailPrivate_LookupTable_Get(block_store_fs->m_ChunkHashToBlockIndexLookup, chunk_hash);
-        LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, EINVAL)
-        uint32_t block_index = *block_index_ptr;
-        TLongtail_Hash block_hash = block_hashes[block_index];
-        uint32_t* chunk_range_index = LongtailPrivate_LookupTable_PutUnique(block_range_map, block_hash, (uint32_t)arrlen(chunk_ranges));
-        if (chunk_range_index)
+        uint32_t chunk_size = chunk_sizes[chunk_index];
+        if (Longtail_IsZeroChunk(version_index, chunk_index))
         {
-            chunk_ranges[*chunk_range_index].m_ChunkEnd = c + 1;
+            // Zero chunks are not stored in any block
+            uint64_t zero_start = seek_asset_pos < start ? start : seek_asset_pos;
+            uint64_t zero_end = seek_asset_pos + chunk_size > read_end ? read_end : seek_asset_pos + chunk_size;
+            memset(&buffer[zero_start - start], 0, (size_t)(zero_end - zero_start));
         }
         else
         {
-            struct BlockStoreStorageAPI_ChunkRange range = {block_hash, seek_asset_pos, c, c + 1};
-            arrput(chunk_ranges, range);
+            const uint32_t* block_index_ptr = LongtailPrivate_LookupTable_Get(block_store_fs->m_ChunkHashToBlockIndexLookup, chunk_hash);
+            LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, EINVAL)
+            uint32_t block_index = *block_index_ptr;
+            TLongtail_Hash block_hash = block_hashes[block_index];
+            uint32_t* chunk_range_index = LongtailPrivate_LookupTable_PutUnique(block_range_map, block_hash, (uint32_t)arrlen(chunk_ranges));
+            if (chunk_range_index)
+            {
+                chunk_ranges[*chunk_range_index].m_ChunkEnd = c + 1;
+            }
+            else
+            {
+                struct BlockStoreStorageAPI_ChunkRange range = {block_hash, seek_asset_pos, c, c + 1};
+                arrput(chunk_ranges, range);
+            }
         }
         block_store_file->m_SeekChunkOffset = c;
         block_store_file->m_SeekAssetPos = seek_asset_pos;
 
-        uint32_t chunk_size = chunk_sizes[chunk_index];
         seek_asset_pos += chunk_size;
         if (seek_asset_pos >= read_end)
         {
@@ -590,7 +600,13 @@ static int BlockStoreStorageAPI_ReadFile(
     }
 
     uint32_t block_count = (uint32_t)arrlen(chunk_ranges);
-    LONGTAIL_FATAL_ASSERT(ctx, block_count > 0, return EINVAL);
+    if (block_count == 0)
+    {
+        // The whole range is covered by zero chunks
+        Longtail_Free(block_range_map);
+        arrfree(chunk_ranges);
+        return 0;
+    }
 
     struct Longtail_JobAPI* job_api = block_store_fs->m_JobAPI;
 
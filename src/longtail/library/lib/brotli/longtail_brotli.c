@@ -166,6 +166,7 @@ static void BrotliCompressionAPI_Init(struct BrotliCompressionAPI* compression_a
     compression_api->m_BrotliCompressionAPI.GetMaxCompressedSize = BrotliCompressionAPI_GetMaxCompressedSize;
     compression_api->m_BrotliCompressionAPI.Compress = BrotliCompressionAPI_Compress;
     compression_api->m_BrotliCompressionAPI.Decompress = BrotliCompressionAPI_Decompress;
+    compression_api->m_BrotliCompressionAPI.CompressWithWorkers = 0;
 }
 
 struct Longtail_CompressionAPI* Longtail_CreateBrotliCompressionAPI()
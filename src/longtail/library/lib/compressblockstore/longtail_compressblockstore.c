@@ -7,11 +7,14 @@
 #include <inttypes.h>
 #include <string.h>
 
+struct OnPutBackingStoreAsync_API;
+
 struct CompressBlockStoreAPI
 {
     struct Longtail_BlockStoreAPI m_BlockStoreAPI;
     struct Longtail_BlockStoreAPI* m_BackingBlockStore;
     struct Longtail_CompressionRegistryAPI* m_CompressionRegistryAPI;
+    uint32_t m_MinSavingPercent;
     struct Longtail_BlockStore_Stats m_Stats;
 
     TLongtail_Atomic64 m_StatU64[Longtail_BlockStoreAPI_StatU64_Count];
@@ -20,6 +23,18 @@ struct CompressBlockStoreAPI
     struct Longtail_AsyncFlushAPI** m_PendingAsyncFlushAPIs;
 
     TLongtail_Atomic32 m_PendingRequestCount;
+
+    uint32_t m_WorkerCount;
+    HLongtail_Thread* m_WorkerThreads;
+    HLongtail_Sema m_PutQueueSlotsSema;
+    HLongtail_Sema m_PutQueueReadySema;
+    HLongtail_Sema m_WorkerSlotsSema;
+    struct OnPutBackingStoreAsync_API** m_PutQueue;
+    uint32_t m_PutQueueCapacity;
+    uint32_t m_PutQueueHead;
+    uint32_t m_PutQueueTail;
+    uint32_t m_PutQueueCount;
+    int32_t volatile m_Stop;
 };
 
 static void CompressBlockStore_CompleteRequest(struct CompressBlockStoreAPI* compressblockstore_api)
@@ -64,14 +79,146 @@ static int CompressedStoredBlock_Dispose(struct Longtail_StoredBlock* stored_blo
     return 0;
 }
 
+#define LONGTAIL_COMPRESSBLOCKSTORE_SAMPLE_COUNT 4
+#define LONGTAIL_COMPRESSBLOCKSTORE_SAMPLE_SIZE  16384
+
+// Trial compresses a few evenly spaced samples of the block data, much cheaper than compressing
+// the whole block when the content is already compressed (images, audio, video, archives)
+static int IsBlockDataCompressible(
+    struct Longtail_CompressionAPI* compression_api,
+    uint32_t compression_settings,
+    const char* data,
+    uint32_t data_size,
+    uint32_t min_saving_percent,
+    int* out_is_compressible)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(compression_api, "%p"),
+        LONGTAIL_LOGFIELD(compression_settings, "%u"),
+        LONGTAIL_LOGFIELD(data, "%p"),
+        LONGTAIL_LOGFIELD(data_size, "%u"),
+        LONGTAIL_LOGFIELD(min_saving_percent, "%u"),
+        LONGTAIL_LOGFIELD(out_is_compressible, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    if (data_size < LONGTAIL_COMPRESSBLOCKSTORE_SAMPLE_COUNT * LONGTAIL_COMPRESSBLOCKSTORE_SAMPLE_SIZE * 2)
+    {
+        // Small blocks are cheap enough to just compress
+        *out_is_compressible = 1;
+        return 0;
+    }
+
+    size_t max_compressed_sample_size = compression_api->GetMaxCompressedSize(compression_api, compression_settings, LONGTAIL_COMPRESSBLOCKSTORE_SAMPLE_SIZE);
+    char* compressed_sample = (char*)Longtail_Alloc("CompressBlockStore", max_compressed_sample_size);
+    if (!compressed_sample)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+
+    uint64_t sampled_size = 0;
+    uint64_t compressed_size = 0;
+    uint32_t sample_stride = (data_size - LONGTAIL_COMPRESSBLOCKSTORE_SAMPLE_SIZE) / (LONGTAIL_COMPRESSBLOCKSTORE_SAMPLE_COUNT - 1);
+    for (uint32_t s = 0; s < LONGTAIL_COMPRESSBLOCKSTORE_SAMPLE_COUNT; ++s)
+    {
+        size_t compressed_sample_size;
+        int err = compression_api->Compress(
+            compression_api,
+            compression_settings,
+            &data[s * sample_stride],
+            compressed_sample,
+            LONGTAIL_COMPRESSBLOCKSTORE_SAMPLE_SIZE,
+            max_compressed_sample_size,
+            &compressed_sample_size);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "compression_api->Compress() failed with %d", err)
+            Longtail_Free(compressed_sample);
+            return err;
+        }
+        sampled_size += LONGTAIL_COMPRESSBLOCKSTORE_SAMPLE_SIZE;
+        compressed_size += compressed_sample_size;
+    }
+    Longtail_Free(compressed_sample);
+
+    *out_is_compressible = (compressed_size * 100) <= (sampled_size * (100 - min_saving_percent));
+    return 0;
+}
+
+// Marks a block stored as is in the compressed size field of the block data header, the block
+// keeps its tag so the store index still matches the chunk tags of the version index
+#define LONGTAIL_COMPRESSBLOCKSTORE_UNCOMPRESSED_SIZE 0xffffffffu
+
+// Stores the block data as is after a block data header that marks it as uncompressed
+static int CreateUncompressedStoredBlock(
+    struct Longtail_StoredBlock* stored_block,
+    struct Longtail_StoredBlock** out_stored_block)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(stored_block, "%p"),
+        LONGTAIL_LOGFIELD(out_stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    uint32_t chunk_count = *stored_block->m_BlockIndex->m_ChunkCount;
+    size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
+    uint32_t block_chunk_data_size = stored_block->m_BlockChunksDataSize;
+    size_t uncompressed_stored_block_size = sizeof(struct Longtail_StoredBlock) + block_index_size + sizeof(uint32_t) + sizeof(uint32_t) + block_chunk_data_size;
+    struct Longtail_StoredBlock* uncompressed_stored_block = (struct Longtail_StoredBlock*)Longtail_Alloc("CompressBlockStore", uncompressed_stored_block_size);
+    if (!uncompressed_stored_block)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    uncompressed_stored_block->m_BlockIndex = Longtail_InitBlockIndex(&uncompressed_stored_block[1], chunk_count);
+    LONGTAIL_FATAL_ASSERT(ctx, uncompressed_stored_block->m_BlockIndex != 0, return EINVAL; )
+    memmove(uncompressed_stored_block->m_BlockIndex, stored_block->m_BlockIndex, block_index_size);
+
+    uint32_t* header_ptr = (uint32_t*)(&((uint8_t*)uncompressed_stored_block->m_BlockIndex)[block_index_size]);
+    header_ptr[0] = block_chunk_data_size;
+    header_ptr[1] = LONGTAIL_COMPRESSBLOCKSTORE_UNCOMPRESSED_SIZE;
+    memcpy(&header_ptr[2], stored_block->m_BlockData, block_chunk_data_size);
+    uncompressed_stored_block->m_BlockData = header_ptr;
+    uncompressed_stored_block->m_BlockChunksDataSize = (uint32_t)(sizeof(uint32_t) + sizeof(uint32_t) + block_chunk_data_size);
+    uncompressed_stored_block->Dispose = CompressedStoredBlock_Dispose;
+    *out_stored_block = uncompressed_stored_block;
+    return 0;
+}
+
+// Each idle worker lent to a compression gets at least this much of the block data
+#define LONGTAIL_COMPRESSBLOCKSTORE_MIN_WORKER_DATA_SIZE (1u * 1024u * 1024u)
+
+// Takes up to wanted idle worker slots without waiting, the workers that lost their
+// slots stay idle until the slots are posted back
+static uint32_t ReserveIdleWorkers(HLongtail_Sema worker_slots_sema, uint32_t wanted)
+{
+    uint32_t granted = 0;
+    while (worker_slots_sema != 0 && granted < wanted && Longtail_WaitSema(worker_slots_sema, 0) == 0)
+    {
+        ++granted;
+    }
+    return granted;
+}
+
 static int CompressBlock(
     struct Longtail_CompressionRegistryAPI* compression_registry,
+    uint32_t min_saving_percent,
+    HLongtail_Sema worker_slots_sema,
     struct Longtail_StoredBlock* uncompressed_stored_block,
     struct Longtail_StoredBlock** out_compressed_stored_block)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(compression_registry, "%p"),
+        LONGTAIL_LOGFIELD(min_saving_percent, "%u"),
+        LONGTAIL_LOGFIELD(worker_slots_sema, "%p"),
         LONGTAIL_LOGFIELD(uncompressed_stored_block, "%p"),
         LONGTAIL_LOGFIELD(out_compressed_stored_block, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
@@ -101,6 +248,27 @@ static int CompressBlock(
         return err;
     }
     uint32_t block_chunk_data_size = uncompressed_stored_block->m_BlockChunksDataSize;
+    if (min_saving_percent > 0)
+    {
+        int is_compressible;
+        err = IsBlockDataCompressible(
+            compression_api,
+            compression_settings,
+            (const char*)uncompressed_stored_block->m_BlockData,
+            block_chunk_data_size,
+            min_saving_percent,
+            &is_compressible);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "IsBlockDataCompressible() failed with %d", err)
+            return err;
+        }
+        if (!is_compressible)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Block data samples saved less than %u percent, storing block uncompressed", min_saving_percent)
+            return CreateUncompressedStoredBlock(uncompressed_stored_block, out_compressed_stored_block);
+        }
+    }
     uint32_t chunk_count = *uncompressed_stored_block->m_BlockIndex->m_ChunkCount;
     size_t block_index_size = Longtail_GetBlockIndexSize(chunk_count);
     size_t max_compressed_chunk_data_size = compression_api->GetMaxCompressedSize(compression_api, compression_settings, block_chunk_data_size);
@@ -117,21 +285,40 @@ static int CompressBlock(
     uint32_t* header_ptr = (uint32_t*)(&((uint8_t*)compressed_stored_block->m_BlockIndex)[block_index_size]);
     compressed_stored_block->m_BlockData = header_ptr;
     memmove(compressed_stored_block->m_BlockIndex, uncompressed_stored_block->m_BlockIndex, block_index_size);
+    // A block compressed on N threads holds this worker and N - 1 idle workers of the store
+    uint32_t extra_worker_count = 0;
+    if (compression_api->CompressWithWorkers && block_chunk_data_size >= 2 * LONGTAIL_COMPRESSBLOCKSTORE_MIN_WORKER_DATA_SIZE)
+    {
+        extra_worker_count = ReserveIdleWorkers(worker_slots_sema, block_chunk_data_size / LONGTAIL_COMPRESSBLOCKSTORE_MIN_WORKER_DATA_SIZE - 1);
+    }
     size_t compressed_chunk_data_size;
-    err = compression_api->Compress(
+    err = Longtail_CompressionAPI_CompressWithWorkers(
         compression_api,
         compression_settings,
+        extra_worker_count,
         (const char*)uncompressed_stored_block->m_BlockData,
         (char*)&header_ptr[2],
         block_chunk_data_size,
         max_compressed_chunk_data_size,
         &compressed_chunk_data_size);
+    if (extra_worker_count > 0)
+    {
+        Longtail_PostSema(worker_slots_sema, extra_worker_count);
+    }
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "compression_api->Compress() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CompressionAPI_CompressWithWorkers() failed with %d", err)
         Longtail_Free(compressed_stored_block);
         return err;
     }
+    if (min_saving_percent > 0 &&
+        (((uint64_t)compressed_chunk_data_size + sizeof(uint32_t) + sizeof(uint32_t)) * 100) > ((uint64_t)block_chunk_data_size * (100 - min_saving_percent)))
+    {
+        // Not worth paying for decompression on every read
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Block compressed from %u to %" PRIu64 " bytes, storing block uncompressed", block_chunk_data_size, (uint64_t)compressed_chunk_data_size)
+        Longtail_Free(compressed_stored_block);
+        return CreateUncompressedStoredBlock(uncompressed_stored_block, out_compressed_stored_block);
+    }
     header_ptr[0] = block_chunk_data_size;
     header_ptr[1] = (uint32_t)compressed_chunk_data_size;
     compressed_stored_block->m_BlockChunksDataSize = (uint32_t)(sizeof(uint32_t) + sizeof(uint32_t) + compressed_chunk_data_size);
@@ -143,6 +330,7 @@ static int CompressBlock(
 struct OnPutBackingStoreAsync_API
 {
     struct Longtail_AsyncPutStoredBlockAPI m_API;
+    struct Longtail_StoredBlock* m_StoredBlock;
     struct Longtail_StoredBlock* m_CompressedBlock;
     struct Longtail_AsyncPutStoredBlockAPI* m_AsyncCompleteAPI;
     struct CompressBlockStoreAPI* m_CompressBlockStoreAPI;
@@ -175,6 +363,85 @@ static void OnPutBackingStoreComplete(struct Longtail_AsyncPutStoredBlockAPI* as
     CompressBlockStore_CompleteRequest(compressblockstore_api);
 }
 
+// Compresses the block and forwards it to the backing store. On failure the
+// request is freed but neither the caller nor the pending request count is notified.
+static int CompressBlockStore_ExecutePut(
+    struct CompressBlockStoreAPI* block_store,
+    struct OnPutBackingStoreAsync_API* put_request)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store, "%p"),
+        LONGTAIL_LOGFIELD(put_request, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    struct Longtail_StoredBlock* compressed_stored_block;
+    int err = CompressBlock(block_store->m_CompressionRegistryAPI, block_store->m_MinSavingPercent, block_store->m_WorkerSlotsSema, put_request->m_StoredBlock, &compressed_stored_block);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CompressBlock() failed with %d", err)
+        Longtail_Free(put_request);
+        return err;
+    }
+    struct Longtail_StoredBlock* to_store = compressed_stored_block ? compressed_stored_block : put_request->m_StoredBlock;
+    put_request->m_CompressedBlock = compressed_stored_block;
+
+    err = block_store->m_BackingBlockStore->PutStoredBlock(block_store->m_BackingBlockStore, to_store, &put_request->m_API);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "block_store->m_BackingBlockStore->PutStoredBlock() failed with %d", err)
+        Longtail_Free(put_request);
+        if (compressed_stored_block)
+        {
+            compressed_stored_block->Dispose(compressed_stored_block);
+        }
+        return err;
+    }
+    return 0;
+}
+
+static int CompressBlockStore_WorkerExecute(void* context)
+{
+    struct CompressBlockStoreAPI* block_store = (struct CompressBlockStoreAPI*)context;
+    while (1)
+    {
+        Longtail_WaitSema(block_store->m_PutQueueReadySema, LONGTAIL_TIMEOUT_INFINITE);
+        // A worker only runs while it holds a slot, slots lent to a multithreaded
+        // compression keep the same number of workers idle
+        Longtail_WaitSema(block_store->m_WorkerSlotsSema, LONGTAIL_TIMEOUT_INFINITE);
+        Longtail_LockSpinLock(block_store->m_Lock);
+        if (block_store->m_PutQueueCount == 0)
+        {
+            Longtail_UnlockSpinLock(block_store->m_Lock);
+            Longtail_PostSema(block_store->m_WorkerSlotsSema, 1);
+            if (block_store->m_Stop)
+            {
+                break;
+            }
+            continue;
+        }
+        struct OnPutBackingStoreAsync_API* put_request = block_store->m_PutQueue[block_store->m_PutQueueHead];
+        block_store->m_PutQueueHead = (block_store->m_PutQueueHead + 1) % block_store->m_PutQueueCapacity;
+        --block_store->m_PutQueueCount;
+        Longtail_UnlockSpinLock(block_store->m_Lock);
+        Longtail_PostSema(block_store->m_PutQueueSlotsSema, 1);
+
+        struct Longtail_AsyncPutStoredBlockAPI* async_complete_api = put_request->m_AsyncCompleteAPI;
+        int err = CompressBlockStore_ExecutePut(block_store, put_request);
+        Longtail_PostSema(block_store->m_WorkerSlotsSema, 1);
+        if (err)
+        {
+            Longtail_AtomicAdd64(&block_store->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_FailCount], 1);
+            async_complete_api->OnComplete(async_complete_api, err);
+            CompressBlockStore_CompleteRequest(block_store);
+        }
+    }
+    return 0;
+}
+
 static int CompressBlockStore_PutStoredBlock(
     struct Longtail_BlockStoreAPI* block_store_api,
     struct Longtail_StoredBlock* stored_block,
@@ -200,39 +467,41 @@ static int CompressBlockStore_PutStoredBlock(
     Longtail_AtomicAdd64(&block_store->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_Chunk_Count], *stored_block->m_BlockIndex->m_ChunkCount);
     Longtail_AtomicAdd64(&block_store->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_Byte_Count], Longtail_GetBlockIndexDataSize(*stored_block->m_BlockIndex->m_ChunkCount) + stored_block->m_BlockChunksDataSize);
 
-    struct Longtail_StoredBlock* compressed_stored_block;
-
-    int err = CompressBlock(block_store->m_CompressionRegistryAPI, stored_block, &compressed_stored_block);
-    if (err)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CompressBlock() failed with %d", err)
-        Longtail_AtomicAdd64(&block_store->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_FailCount], 1);
-        return err;
-    }
-    struct Longtail_StoredBlock* to_store = compressed_stored_block ? compressed_stored_block : stored_block;
-
     size_t on_put_backing_store_async_api_size = sizeof(struct OnPutBackingStoreAsync_API);
     struct OnPutBackingStoreAsync_API* on_put_backing_store_async_api = (struct OnPutBackingStoreAsync_API*)Longtail_Alloc("CompressBlockStore", on_put_backing_store_async_api_size);
     if (!on_put_backing_store_async_api)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         Longtail_AtomicAdd64(&block_store->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_FailCount], 1);
-        Longtail_Free(compressed_stored_block);
         return ENOMEM;
     }
     on_put_backing_store_async_api->m_API.OnComplete = OnPutBackingStoreComplete;
     on_put_backing_store_async_api->m_API.m_API.Dispose = 0;
-    on_put_backing_store_async_api->m_CompressedBlock = compressed_stored_block;
+    on_put_backing_store_async_api->m_StoredBlock = stored_block;
+    on_put_backing_store_async_api->m_CompressedBlock = 0;
     on_put_backing_store_async_api->m_AsyncCompleteAPI = async_complete_api;
     on_put_backing_store_async_api->m_CompressBlockStoreAPI = block_store;
     Longtail_AtomicAdd32(&block_store->m_PendingRequestCount, 1);
-    err = block_store->m_BackingBlockStore->PutStoredBlock(block_store->m_BackingBlockStore, to_store, &on_put_backing_store_async_api->m_API);
+
+    if (block_store->m_WorkerCount > 0)
+    {
+        // Hand compression over to the worker threads so the caller can go on producing
+        // blocks, the bounded queue keeps the number of uncompressed blocks in flight in check
+        Longtail_WaitSema(block_store->m_PutQueueSlotsSema, LONGTAIL_TIMEOUT_INFINITE);
+        Longtail_LockSpinLock(block_store->m_Lock);
+        block_store->m_PutQueue[block_store->m_PutQueueTail] = on_put_backing_store_async_api;
+        block_store->m_PutQueueTail = (block_store->m_PutQueueTail + 1) % block_store->m_PutQueueCapacity;
+        ++block_store->m_PutQueueCount;
+        Longtail_UnlockSpinLock(block_store->m_Lock);
+        Longtail_PostSema(block_store->m_PutQueueReadySema, 1);
+        return 0;
+    }
+
+    int err = CompressBlockStore_ExecutePut(block_store, on_put_backing_store_async_api);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "block_store->m_BackingBlockStore->PutStoredBlock() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CompressBlockStore_ExecutePut() failed with %d", err)
         Longtail_AtomicAdd64(&block_store->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_FailCount], 1);
-        Longtail_Free(on_put_backing_store_async_api);
-        compressed_stored_block->Dispose(compressed_stored_block);
         CompressBlockStore_CompleteRequest(block_store);
     }
     return err;
@@ -268,6 +537,31 @@ static int CompressBlockStore_PreflightGet(
     return err;
 }
 
+// Hands out the data of a block stored uncompressed in place, the backing stored block
+// is disposed together with it
+struct UncompressedStoredBlock
+{
+    struct Longtail_StoredBlock m_StoredBlock;
+    struct Longtail_StoredBlock* m_BackingStoredBlock;
+};
+
+static int UncompressedStoredBlock_Dispose(struct Longtail_StoredBlock* stored_block)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(stored_block, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, stored_block, return EINVAL)
+    struct UncompressedStoredBlock* uncompressed_stored_block = (struct UncompressedStoredBlock*)stored_block;
+    uncompressed_stored_block->m_BackingStoredBlock->Dispose(uncompressed_stored_block->m_BackingStoredBlock);
+    Longtail_Free(uncompressed_stored_block);
+    return 0;
+}
+
 static int DecompressBlock(
     struct Longtail_CompressionRegistryAPI* compression_registry,
     struct Longtail_StoredBlock* compressed_stored_block,
@@ -282,6 +576,33 @@ static int DecompressBlock(
     LONGTAIL_FATAL_ASSERT(ctx, compression_registry, return EINVAL)
     LONGTAIL_FATAL_ASSERT(ctx, compressed_stored_block, return EINVAL)
     LONGTAIL_FATAL_ASSERT(ctx, out_stored_block, return EINVAL)
+    uint32_t* header_ptr = (uint32_t*)compressed_stored_block->m_BlockData;
+    if (compressed_stored_block->m_BlockChunksDataSize < sizeof(uint32_t) + sizeof(uint32_t))
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Compressed block data of %u bytes is too small for its header", compressed_stored_block->m_BlockChunksDataSize)
+        return EBADF;
+    }
+    if (header_ptr[1] == LONGTAIL_COMPRESSBLOCKSTORE_UNCOMPRESSED_SIZE)
+    {
+        if (header_ptr[0] != compressed_stored_block->m_BlockChunksDataSize - sizeof(uint32_t) - sizeof(uint32_t))
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Uncompressed block data size %u does not match stored size %u", header_ptr[0], compressed_stored_block->m_BlockChunksDataSize)
+            return EBADF;
+        }
+        struct UncompressedStoredBlock* uncompressed_stored_block = (struct UncompressedStoredBlock*)Longtail_Alloc("CompressBlockStore", sizeof(struct UncompressedStoredBlock));
+        if (!uncompressed_stored_block)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            return ENOMEM;
+        }
+        uncompressed_stored_block->m_StoredBlock.m_BlockIndex = compressed_stored_block->m_BlockIndex;
+        uncompressed_stored_block->m_StoredBlock.m_BlockData = &header_ptr[2];
+        uncompressed_stored_block->m_StoredBlock.m_BlockChunksDataSize = header_ptr[0];
+        uncompressed_stored_block->m_StoredBlock.Dispose = UncompressedStoredBlock_Dispose;
+        uncompressed_stored_block->m_BackingStoredBlock = compressed_stored_block;
+        *out_stored_block = &uncompressed_stored_block->m_StoredBlock;
+        return 0;
+    }
     uint32_t compressionType = *compressed_stored_block->m_BlockIndex->m_Tag;
     struct Longtail_CompressionAPI* compression_api;
     uint32_t compression_settings;
@@ -298,7 +619,6 @@ static int DecompressBlock(
 
     uint32_t chunk_count = *compressed_stored_block->m_BlockIndex->m_ChunkCount;
     uint32_t block_index_data_size = (uint32_t)Longtail_GetBlockIndexDataSize(chunk_count);
-    uint32_t* header_ptr = (uint32_t*)compressed_stored_block->m_BlockData;
     void* compressed_chunks_data = &header_ptr[2];
     uint32_t uncompressed_size = header_ptr[0];
     uint32_t compressed_size = header_ptr[1];
@@ -552,6 +872,32 @@ static int CompressBlockStore_Flush(struct Longtail_BlockStoreAPI* block_store_a
     return 0;
 }
 
+static void CompressBlockStore_StopWorkers(struct CompressBlockStoreAPI* block_store)
+{
+    if (block_store->m_PutQueueReadySema == 0)
+    {
+        return;
+    }
+    block_store->m_Stop = 1;
+    Longtail_PostSema(block_store->m_PutQueueReadySema, block_store->m_WorkerCount);
+    for (uint32_t t = 0; t < block_store->m_WorkerCount; ++t)
+    {
+        Longtail_JoinThread(block_store->m_WorkerThreads[t], LONGTAIL_TIMEOUT_INFINITE);
+        Longtail_DeleteThread(block_store->m_WorkerThreads[t]);
+        Longtail_Free(block_store->m_WorkerThreads[t]);
+    }
+    block_store->m_WorkerCount = 0;
+    Longtail_DeleteSema(block_store->m_PutQueueReadySema);
+    Longtail_Free(block_store->m_PutQueueReadySema);
+    block_store->m_PutQueueReadySema = 0;
+    Longtail_DeleteSema(block_store->m_PutQueueSlotsSema);
+    Longtail_Free(block_store->m_PutQueueSlotsSema);
+    block_store->m_PutQueueSlotsSema = 0;
+    Longtail_DeleteSema(block_store->m_WorkerSlotsSema);
+    Longtail_Free(block_store->m_WorkerSlotsSema);
+    block_store->m_WorkerSlotsSema = 0;
+}
+
 static void CompressBlockStore_Dispose(struct Longtail_API* api)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -569,21 +915,49 @@ static void CompressBlockStore_Dispose(struct Longtail_API* api)
             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Waiting for %d pending requests", (int32_t)block_store->m_PendingRequestCount);
         }
     }
+    CompressBlockStore_StopWorkers(block_store);
     Longtail_DeleteSpinLock(block_store->m_Lock);
     Longtail_Free(block_store->m_Lock);
     Longtail_Free(block_store);
 }
 
+static int CompressBlockStore_CreateSema(int initial_count, HLongtail_Sema* out_sema)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(initial_count, "%d"),
+        LONGTAIL_LOGFIELD(out_sema, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    void* sema_mem = Longtail_Alloc("CompressBlockStore", Longtail_GetSemaSize());
+    if (!sema_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    int err = Longtail_CreateSema(sema_mem, initial_count, out_sema);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateSema() failed with %d", err)
+        Longtail_Free(sema_mem);
+        return err;
+    }
+    return 0;
+}
+
 static int CompressBlockStore_Init(
     void* mem,
     struct Longtail_BlockStoreAPI* backing_block_store,
     struct Longtail_CompressionRegistryAPI* compression_registry,
+    uint32_t worker_count,
+    uint32_t min_saving_percent,
     struct Longtail_BlockStoreAPI** out_block_store_api)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(mem, "%p"),
         LONGTAIL_LOGFIELD(backing_block_store, "%p"),
         LONGTAIL_LOGFIELD(compression_registry, "%p"),
+        LONGTAIL_LOGFIELD(worker_count, "%u"),
+        LONGTAIL_LOGFIELD(min_saving_percent, "%u"),
         LONGTAIL_LOGFIELD(out_block_store_api, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
@@ -611,20 +985,104 @@ static int CompressBlockStore_Init(
 
     api->m_BackingBlockStore = backing_block_store;
     api->m_CompressionRegistryAPI = compression_registry;
+    api->m_MinSavingPercent = min_saving_percent;
     api->m_PendingRequestCount = 0;
     api->m_PendingAsyncFlushAPIs = 0;
+    api->m_WorkerCount = 0;
+    api->m_WorkerThreads = 0;
+    api->m_PutQueueSlotsSema = 0;
+    api->m_PutQueueReadySema = 0;
+    api->m_WorkerSlotsSema = 0;
+    api->m_PutQueue = 0;
+    api->m_PutQueueCapacity = 0;
+    api->m_PutQueueHead = 0;
+    api->m_PutQueueTail = 0;
+    api->m_PutQueueCount = 0;
+    api->m_Stop = 0;
 
     for (uint32_t s = 0; s < Longtail_BlockStoreAPI_StatU64_Count; ++s)
     {
         api->m_StatU64[s] = 0;
     }
 
-    int err = Longtail_CreateSpinLock(Longtail_Alloc("CompressBlockStore", Longtail_GetSpinLockSize()), &api->m_Lock);
+    void* lock_mem = Longtail_Alloc("CompressBlockStore", Longtail_GetSpinLockSize());
+    if (!lock_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    int err = Longtail_CreateSpinLock(lock_mem, &api->m_Lock);
     if (err)
     {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateSpinLock() failed with %d", err)
+        Longtail_Free(lock_mem);
         return err;
     }
 
+    if (worker_count > 0)
+    {
+        // Thread handles and the queue live in the same allocation as the api, see Longtail_CreateCompressBlockStoreAPIWithWorkers
+        char* p = (char*)&api[1];
+        api->m_WorkerThreads = (HLongtail_Thread*)p;
+        p += sizeof(HLongtail_Thread) * worker_count;
+        api->m_PutQueue = (struct OnPutBackingStoreAsync_API**)p;
+        api->m_PutQueueCapacity = worker_count * 2;
+
+        err = CompressBlockStore_CreateSema((int)api->m_PutQueueCapacity, &api->m_PutQueueSlotsSema);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CompressBlockStore_CreateSema() failed with %d", err)
+            Longtail_DeleteSpinLock(api->m_Lock);
+            Longtail_Free(api->m_Lock);
+            return err;
+        }
+        err = CompressBlockStore_CreateSema(0, &api->m_PutQueueReadySema);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CompressBlockStore_CreateSema() failed with %d", err)
+            Longtail_DeleteSema(api->m_PutQueueSlotsSema);
+            Longtail_Free(api->m_PutQueueSlotsSema);
+            Longtail_DeleteSpinLock(api->m_Lock);
+            Longtail_Free(api->m_Lock);
+            return err;
+        }
+        err = CompressBlockStore_CreateSema((int)worker_count, &api->m_WorkerSlotsSema);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CompressBlockStore_CreateSema() failed with %d", err)
+            Longtail_DeleteSema(api->m_PutQueueReadySema);
+            Longtail_Free(api->m_PutQueueReadySema);
+            Longtail_DeleteSema(api->m_PutQueueSlotsSema);
+            Longtail_Free(api->m_PutQueueSlotsSema);
+            Longtail_DeleteSpinLock(api->m_Lock);
+            Longtail_Free(api->m_Lock);
+            return err;
+        }
+        for (uint32_t t = 0; t < worker_count; ++t)
+        {
+            void* thread_mem = Longtail_Alloc("CompressBlockStore", Longtail_GetThreadSize());
+            if (!thread_mem)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+                CompressBlockStore_StopWorkers(api);
+                Longtail_DeleteSpinLock(api->m_Lock);
+                Longtail_Free(api->m_Lock);
+                return ENOMEM;
+            }
+            err = Longtail_CreateThread(thread_mem, CompressBlockStore_WorkerExecute, 0, api, 0, &api->m_WorkerThreads[t]);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateThread() failed with %d", err)
+                Longtail_Free(thread_mem);
+                CompressBlockStore_StopWorkers(api);
+                Longtail_DeleteSpinLock(api->m_Lock);
+                Longtail_Free(api->m_Lock);
+                return err;
+            }
+            api->m_WorkerCount = t + 1;
+        }
+    }
+
     *out_block_store_api = block_store_api;
     return 0;
 }
@@ -632,16 +1090,38 @@ static int CompressBlockStore_Init(
 struct Longtail_BlockStoreAPI* Longtail_CreateCompressBlockStoreAPI(
     struct Longtail_BlockStoreAPI* backing_block_store,
     struct Longtail_CompressionRegistryAPI* compression_registry)
+{
+    return Longtail_CreateAdaptiveCompressBlockStoreAPI(backing_block_store, compression_registry, 0, 0);
+}
+
+struct Longtail_BlockStoreAPI* Longtail_CreateCompressBlockStoreAPIWithWorkers(
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    struct Longtail_CompressionRegistryAPI* compression_registry,
+    uint32_t worker_count)
+{
+    return Longtail_CreateAdaptiveCompressBlockStoreAPI(backing_block_store, compression_registry, worker_count, 0);
+}
+
+struct Longtail_BlockStoreAPI* Longtail_CreateAdaptiveCompressBlockStoreAPI(
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    struct Longtail_CompressionRegistryAPI* compression_registry,
+    uint32_t worker_count,
+    uint32_t min_saving_percent)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(backing_block_store, "%p"),
-        LONGTAIL_LOGFIELD(compression_registry, "%p")
+        LONGTAIL_LOGFIELD(compression_registry, "%p"),
+        LONGTAIL_LOGFIELD(worker_count, "%u"),
+        LONGTAIL_LOGFIELD(min_saving_percent, "%u")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
     LONGTAIL_VALIDATE_INPUT(ctx, backing_block_store, return 0)
     LONGTAIL_VALIDATE_INPUT(ctx, compression_registry, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, min_saving_percent < 100, return 0)
 
-    size_t api_size = sizeof(struct CompressBlockStoreAPI);
+    size_t api_size = sizeof(struct CompressBlockStoreAPI) +
+        sizeof(HLongtail_Thread) * worker_count +
+        sizeof(struct OnPutBackingStoreAsync_API*) * worker_count * 2;
     void* mem = Longtail_Alloc("CompressBlockStore", api_size);
     if (!mem)
     {
@@ -653,6 +1133,8 @@ struct Longtail_BlockStoreAPI* Longtail_CreateCompressBlockStoreAPI(
         mem,
         backing_block_store,
         compression_registry,
+        worker_count,
+        min_saving_percent,
         &block_store_api);
     if (err)
     {
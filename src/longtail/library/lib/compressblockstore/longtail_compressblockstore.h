@@ -13,6 +13,24 @@ LONGTAIL_EXPORT extern struct Longtail_BlockStoreAPI* Longtail_CreateCompressBlo
     struct Longtail_BlockStoreAPI* backing_block_store,
     struct Longtail_CompressionRegistryAPI* compression_registry);
 
+// Compresses put blocks on worker_count dedicated threads, at most 2 * worker_count blocks
+// are queued before PutStoredBlock waits. A worker_count of 0 compresses on the calling thread.
+// Large blocks are compressed with Longtail_CompressionAPI_CompressWithWorkers on the idle workers.
+LONGTAIL_EXPORT extern struct Longtail_BlockStoreAPI* Longtail_CreateCompressBlockStoreAPIWithWorkers(
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    struct Longtail_CompressionRegistryAPI* compression_registry,
+    uint32_t worker_count);
+
+// As Longtail_CreateCompressBlockStoreAPIWithWorkers but blocks whose compressed data is not at least
+// min_saving_percent smaller are stored uncompressed so reading them skips decompression. They keep
+// their tag, the block data header marks them as uncompressed.
+// Large blocks are first trial compressed on a few samples, a min_saving_percent of 0 always compresses.
+LONGTAIL_EXPORT extern struct Longtail_BlockStoreAPI* Longtail_CreateAdaptiveCompressBlockStoreAPI(
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    struct Longtail_CompressionRegistryAPI* compression_registry,
+    uint32_t worker_count,
+    uint32_t min_saving_percent);
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,7 +13,7 @@ struct Longtail_CompressionRegistryAPI* Longtail_CreateFullCompressionRegistry()
         Longtail_CompressionRegistry_CreateForLZ4,
         Longtail_CompressionRegistry_CreateForZstd};
 
-    return Longtail_CreateDefaultCompressionRegistry(
+    return Longtail_CreateZStdDictionaryCompressionRegistry(
         3,
         (const Longtail_CompressionRegistry_CreateForTypeFunc*)compression_create_api_funcs);
 }
@@ -9,7 +9,7 @@ struct Longtail_CompressionRegistryAPI* Longtail_CreateZStdCompressionRegistry()
     Longtail_CompressionRegistry_CreateForTypeFunc compression_create_api_funcs[1] = {
         Longtail_CompressionRegistry_CreateForZstd};
 
-    return Longtail_CreateDefaultCompressionRegistry(
+    return Longtail_CreateZStdDictionaryCompressionRegistry(
         1,
         (const Longtail_CompressionRegistry_CreateForTypeFunc*)compression_create_api_funcs);
 }
@@ -0,0 +1,472 @@
+// FastCDC: https://www.usenix.org/conference/atc16/technical-sessions/presentation/xia
+//
+// Gear hash content defined chunking with cut-point skipping (no hashing before the
+// min chunk size) and normalized chunking (a stricter mask before the average chunk
+// size and a looser one after it) which narrows the chunk size distribution.
+// The gear hash only depends on the bytes since the chunk start so boundaries
+// resynchronize the same way as with the HPCDC chunker.
+
+#include "longtail_fastcdcchunker.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+
+const uint32_t LONGTAIL_FASTCDC_CHUNKER_TYPE = (((uint32_t)'f') << 24) + (((uint32_t)'c') << 16) + (((uint32_t)'d') << 8) + ((uint32_t)'c');
+uint32_t Longtail_GetFastCDCChunkerType() { return LONGTAIL_FASTCDC_CHUNKER_TYPE; }
+
+// FastCDCMinChunkSize is the number of bytes that affects the 64 bit gear hash
+#define FastCDCMinChunkSize 64u
+
+// Normalization level, the small/large masks have this many bits more/less than the
+// average chunk size calls for
+#define FastCDCNormalization 2u
+
+// The mask bits are spread over the upper 48 bits of the hash where the most bytes contribute
+#define FastCDCMaxMaskBits 48u
+
+struct Longtail_FastCDCChunkerParams
+{
+    uint32_t min;
+    uint32_t avg;
+    uint32_t max;
+};
+
+// Must never change, it defines the chunk boundaries
+static const uint64_t gearTable[256] = {
+    0xb80a1a704e27b7abull, 0x132c18bbf148e38dull, 0x861acbf4bd7ced98ull, 0xa8cf704b0f85a057ull,
+    0xc505f729d2bbc46cull, 0x7c3658acc4451b11ull, 0xfed3169f80908842ull, 0x00559675c309569cull,
+    0xe3f8ec8b15768ab4ull, 0xa7416319e7dd2ee9ull, 0x5291f2302200fd51ull, 0xc9919be8bdfe5e82ull,
+    0x795018461e4e333bull, 0x31938fa9a7eba26eull, 0xb37cd8ea76890186ull, 0x377b9eb183367452ull,
+    0x66ef8f6caad40b2cull, 0xa042a1429f2851a5ull, 0xe0ebc5f851830882ull, 0x3024b6f883f38bafull,
+    0x5d152cbac5c68b18ull, 0xe4a1bc2928039abdull, 0x0abdc6dd4a546612ull, 0x364f1b2147b8ac3cull,
+    0x08a1953becc3c327ull, 0x2c2510741017bb23ull, 0xcdec5c6f3445e132ull, 0x49fb1dacf8637dd8ull,
+    0xf43576abdf2d8cb5ull, 0x695b08e1e644e06dull, 0x260294d78cfeb7c8ull, 0xf3472f1fc6367dc4ull,
+    0x809113dc72dc56a0ull, 0x60e3f5cb8e6e0e50ull, 0xef947f8cfc205537ull, 0x6fc6d43496a9e706ull,
+    0xff5d291dcb001574ull, 0x655dfb061cd00ae8ull, 0x01779252b97ba8f7ull, 0xba9a90dcf3de942bull,
+    0xa478a724c645fba2ull, 0xe913efd76713975eull, 0x34e5c54d8dc89b33ull, 0x7f5548fa11e86d6cull,
+    0xf232ffcb2a1ac028ull, 0x171901e70cf10973ull, 0x94e072e852ee1e87ull, 0xa2650368ab265754ull,
+    0xe2a46f2b36c77b2aull, 0xb672f7b5b4a2b8b1ull, 0xeaa183a41ab8e763ull, 0x222caeaeec29ee8eull,
+    0x15fcb752ec622136ull, 0xfaa8e3a898771ef7ull, 0x874252fefb270398ull, 0xd204a50876230e21ull,
+    0x682de09e93c45281ull, 0xa2ef5b72369a84c6ull, 0x891bd96be5a20e40ull, 0x20cb19ba04a92d95ull,
+    0xcc78c64b50e0f1d1ull, 0x9d163beb862bf485ull, 0x66c441598903833full, 0x93546a41b3393b72ull,
+    0x400ede32946fa732ull, 0x6d091ad657ddaaa0ull, 0x69914bb05a328859ull, 0xf1060cd0acd2b424ull,
+    0xd9dd9d907dec63f6ull, 0x3224f05a0ef967e7ull, 0xeca2c4a1778ea868ull, 0x6eb1353cd81fc898ull,
+    0xddc583169fe0561aull, 0x70922644e87ed656ull, 0xd375895bb236dc5aull, 0x9ba335d3faeb71ebull,
+    0x1fd387b8d21c47a0ull, 0x1f242954ade4084eull, 0xf58af9610d8d7a80ull, 0x9a3f89dd6e80c67full,
+    0x84afc5f87180be2dull, 0x2ef3c55ed9c1f8e4ull, 0x6ebb0aa5313a358eull, 0xd52eb163d666063cull,
+    0x44ca280d0ff47569ull, 0x649d6e19535aa278ull, 0x99db9762c721ddcdull, 0x02116e193357c7a0ull,
+    0xc84e08bc153f743aull, 0x88c25f0461ed96e7ull, 0x79fbea7d4cfc6c77ull, 0x2f07c6ed22e5d521ull,
+    0x5ca752881398d088ull, 0x7497d379874aab91ull, 0x8545821516b0f50eull, 0x4b7224a91a5daa43ull,
+    0x26452ff3c66a90d2ull, 0x29d7038c06ce8580ull, 0x36eb76594d8c295cull, 0xbde5afdac84e628full,
+    0xb1c328d5922aae34ull, 0x429edcffd0ebf259ull, 0xfbec0f556afa9f5cull, 0x013c786813e9dc37ull,
+    0xe0adab48ab147729ull, 0x591c3a76bf374135ull, 0x496cb5e2020f1621ull, 0xe61834a89d5d57c5ull,
+    0x4bfc1798eec78f91ull, 0x809954d00478f923ull, 0xf5db1f6fcfbade2eull, 0xb635bd165a79674eull,
+    0xa224693cc651ce12ull, 0x1d89ea165c616884ull, 0x1a17c5c5cea3aecfull, 0xcec2eac45bc87d2dull,
+    0x834a0dce6268fa67ull, 0x97f21587c8d15604ull, 0xf69b40eed4df9162ull, 0x7b41b67c9bb0616cull,
+    0x20b7ac496a761a87ull, 0xd671cff82a46e534ull, 0x95aa415fb64337abull, 0x84083259c1e0d578ull,
+    0x12ed9eb3df0d1786ull, 0xbc600db7232bc1cbull, 0x150e9e3b9572e796ull, 0xe00c65e268bcd82cull,
+    0x814735c4063687e3ull, 0x384f953be43b9812ull, 0xdb967224fc1f6567ull, 0x5b39ef07b6cb2111ull,
+    0xb147808a22c39e16ull, 0xfc1ac7a1112b0ceaull, 0x42bb2e63e78b31bbull, 0xf6a7e03e0b3d9e18ull,
+    0xe9c59b0d0f8955adull, 0x4eb433831a93b634ull, 0xd73edc2a15e1ef35ull, 0xcd608b2f68362ed9ull,
+    0x971c31d38a43f29cull, 0x3da2bef966e4e8daull, 0x5a7b4fa255ec7e02ull, 0xd5bef043ba362099ull,
+    0x262f0514af1d2791ull, 0xa7f36da3ab71578bull, 0xb3c337969d7f07c2ull, 0xbdea91c9d8cf3c69ull,
+    0x3e6a0472dabed079ull, 0x489a8e79ebd005bdull, 0xe6b2ca1f96746f74ull, 0x1975f8464a663b8aull,
+    0x66cbf5a3b6d9a024ull, 0xefaa573f2b038407ull, 0x678a302379e47fafull, 0x7b46fb1cced93902ull,
+    0x1326e8ad7b8cf683ull, 0xc1962a19d0b04abcull, 0x5b324406236df4d8ull, 0xcb20ed7d7d764395ull,
+    0x6b39b0a6d03bd501ull, 0x636df0052ddc2417ull, 0x996cb1aabdc90c9aull, 0x92d1de11797856e6ull,
+    0xe646a2d15baf8396ull, 0x80a78712813ae3fdull, 0x56ec9016bc4846f1ull, 0x9d3f32d0e291f520ull,
+    0xe71c1c08f4b316d3ull, 0xa60cd4105a71eba2ull, 0x444f3f69c9b2112eull, 0xe6d99b5a72c2d4a9ull,
+    0xe842a4046f820366ull, 0x073d044777850305ull, 0xad9bed8aec124767ull, 0x49cee399edf14787ull,
+    0x31f40b5d869ec431ull, 0x74b9365ca6d3dbabull, 0x09b46c9948f34d10ull, 0x98a6228d9326f61full,
+    0xbc3cc588468ff805ull, 0xb66fc74dc5789acaull, 0x4878113dc7bb0340ull, 0xe10a7879d5c58680ull,
+    0x0909ef8ebe242c2bull, 0x715663a121b159e0ull, 0x52832ecb029cfd19ull, 0x10b03d6a7867e814ull,
+    0x80f4d5fe2464f6b1ull, 0x5059c021e1d0fe20ull, 0xeb598263686d245full, 0x6de2d1b885e4c571ull,
+    0x6862545a8d271062ull, 0x368314442c6ac908ull, 0x2ca523a64c952bf6ull, 0xdfb9f097048779e2ull,
+    0x8b9323a591bcd375ull, 0xdde5ac9d69c90de9ull, 0xa391d359748261c8ull, 0xbc748f1acb1b7277ull,
+    0xbf850ffc26623018ull, 0x747827dd307fa662ull, 0x2672aa705f7969b1ull, 0xe4bc7243788037bcull,
+    0x836f2f46c62cf054ull, 0x68c3a6a001c32054ull, 0xe68ad6e2bc1abc26ull, 0xdd474d7ab533369dull,
+    0x6bcffe41fbf44d96ull, 0xf835723dad64dc0aull, 0x9b91b190866ed2cdull, 0x2a5337ac7550df79ull,
+    0x1c09023f64dc5ce9ull, 0xb5c1cdf05bdb03e7ull, 0x8b36b41928aeaae3ull, 0xa1570c18116d3cfaull,
+    0x1df191f1ff936dfdull, 0xae39ca701483f77aull, 0x0d2c5060cb30b788ull, 0x10dae90a6deaaaf0ull,
+    0xee130dca85391b18ull, 0x48eec4905067ca2aull, 0x9ddb71adc19302dfull, 0xd3e69b206efe8aeaull,
+    0xe18f6a1da882e449ull, 0x5788e435bc9be71bull, 0x247a0458ff395ddcull, 0xa6ee9f4d5d1f98a3ull,
+    0x63ce29c69a4b08ecull, 0xf8ae1d4e912cc39full, 0x7fa5aedfe41a1ef6ull, 0xa561e00697c60be4ull,
+    0x8001506fead85203ull, 0xbb4f08319a586206ull, 0x2d8f932eddb92ca4ull, 0x61735a4022d81bb7ull,
+    0x8e2f9fdd5469397eull, 0xbfefb0509ae234a9ull, 0xf51b2080a98b2f6dull, 0xb4f3bf5d4ae3fbbfull,
+    0xc53fbee9ea86b7b5ull, 0x4eb72bed26f6a5f6ull, 0x8d40afa8c94cfef1ull, 0xf6a335a58a136b6dull,
+    0xbf1c309e1523d316ull, 0x4b185b6b9d29d57aull, 0x752300d22b649e01ull, 0x97f8da898b92709eull,
+    0x19b6070c65777da4ull, 0x33e5112e2d96d0a4ull, 0x62ca197306b64f02ull, 0x5dc4c4fed6e8a2d8ull,
+    0x6cc3377ac20a2e41ull, 0xfcab3aeb9b190c2aull, 0x573641c906d7a9f8ull, 0xae20bbb3cda61f3cull,
+};
+
+struct Longtail_FastCDCChunker
+{
+    struct Longtail_FastCDCChunkerParams params;
+    uint8_t* buf;
+    uint32_t len;
+    uint32_t max_feed;
+    uint32_t off;
+    uint64_t mask_s;
+    uint64_t mask_l;
+    uint64_t processed_count;
+};
+
+static uint32_t FastCDCLog2(uint32_t value)
+{
+    uint32_t bits = 0;
+    while ((1u << (bits + 1)) <= value && bits < 31)
+    {
+        ++bits;
+    }
+    // Round to nearest
+    if (bits < 31 && (value - (1u << bits)) > ((1u << bits) >> 1))
+    {
+        ++bits;
+    }
+    return bits;
+}
+
+static uint64_t FastCDCMask(uint32_t bits)
+{
+    if (bits < 1)
+    {
+        bits = 1;
+    }
+    if (bits > FastCDCMaxMaskBits)
+    {
+        bits = FastCDCMaxMaskBits;
+    }
+    uint64_t mask = 0;
+    for (uint32_t i = 0; i < bits; ++i)
+    {
+        mask |= ((uint64_t)1) << (63 - ((i * FastCDCMaxMaskBits) / bits));
+    }
+    return mask;
+}
+
+// Returns the size of the chunk starting at buf, len is the number of bytes available
+static uint32_t FastCDCCut(const struct Longtail_FastCDCChunker* c, const uint8_t* buf, uint32_t len)
+{
+    if (len <= c->params.min)
+    {
+        return len;
+    }
+    const uint32_t end = len > c->params.max ? c->params.max : len;
+    const uint32_t normal = c->params.avg < end ? c->params.avg : end;
+    const uint64_t mask_s = c->mask_s;
+    const uint64_t mask_l = c->mask_l;
+    uint64_t fp = 0;
+    uint32_t pos = c->params.min;
+    while (pos < normal)
+    {
+        fp = (fp << 1) + gearTable[buf[pos++]];
+        if (!(fp & mask_s))
+        {
+            return pos;
+        }
+    }
+    while (pos < end)
+    {
+        fp = (fp << 1) + gearTable[buf[pos++]];
+        if (!(fp & mask_l))
+        {
+            return pos;
+        }
+    }
+    return end;
+}
+
+static int FastCDCCreateChunker(
+    const struct Longtail_FastCDCChunkerParams* params,
+    struct Longtail_FastCDCChunker** out_chunker)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(params, "%p"),
+        LONGTAIL_LOGFIELD(out_chunker, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, params != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, params->min <= params->max, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, params->min <= params->avg, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, params->avg <= params->max, return EINVAL)
+
+    size_t max_feed = (size_t)params->max * 4;
+    if (max_feed >= 0xffffffffu)
+    {
+        max_feed = 0xffffffffu;
+    }
+
+    size_t chunker_size = sizeof(struct Longtail_FastCDCChunker) + max_feed;
+    struct Longtail_FastCDCChunker* c = (struct Longtail_FastCDCChunker*)Longtail_Alloc("FastCDCCreateChunker", chunker_size);
+    if (!c)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    uint32_t bits = FastCDCLog2(params->avg);
+    c->params = *params;
+    c->buf = (uint8_t*)&c[1];
+    c->len = 0;
+    c->max_feed = (uint32_t)max_feed;
+    c->off = 0;
+    c->mask_s = FastCDCMask(bits + FastCDCNormalization);
+    c->mask_l = FastCDCMask(bits > FastCDCNormalization ? bits - FastCDCNormalization : 1u);
+    c->processed_count = 0;
+    *out_chunker = c;
+    return 0;
+}
+
+static int FastCDCFeedChunker(
+    struct Longtail_FastCDCChunker* c,
+    Longtail_Chunker_Feeder feeder,
+    void* context)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(c, "%p"),
+        LONGTAIL_LOGFIELD(feeder, "%p"),
+        LONGTAIL_LOGFIELD(context, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, c != 0, return EINVAL)
+
+    if (c->off != 0)
+    {
+        memmove(c->buf, &c->buf[c->off], c->len - c->off);
+        c->processed_count += c->off;
+        c->len -= c->off;
+        c->off = 0;
+    }
+    uint32_t feed_max = (uint32_t)(c->max_feed - c->len);
+    uint32_t feed_count;
+    int err = feeder(context, (Longtail_ChunkerAPI_HChunker)c, feed_max, (char*)&c->buf[c->len], &feed_count);
+    c->len += feed_count;
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "feeder() failed with %d", err)
+    }
+    return err;
+}
+
+struct Longtail_FastCDCChunkerAPI
+{
+    struct Longtail_ChunkerAPI m_API;
+};
+
+static void FastCDCChunker_Dispose(struct Longtail_API* base_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(base_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, base_api, return)
+    Longtail_Free(base_api);
+}
+
+static int FastCDCChunker_GetMinChunkSize(struct Longtail_ChunkerAPI* chunker_api, uint32_t* out_min_chunk_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(out_min_chunk_size, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, chunker_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_min_chunk_size, return EINVAL)
+
+    *out_min_chunk_size = FastCDCMinChunkSize;
+    return 0;
+}
+
+static int FastCDCChunker_CreateChunker(
+    struct Longtail_ChunkerAPI* chunker_api,
+    uint32_t min_chunk_size,
+    uint32_t avg_chunk_size,
+    uint32_t max_chunk_size,
+    Longtail_ChunkerAPI_HChunker* out_chunker)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(min_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(avg_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(max_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(out_chunker, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, chunker_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_chunker, return EINVAL)
+
+    struct Longtail_FastCDCChunkerParams chunker_params;
+    chunker_params.min = min_chunk_size;
+    chunker_params.avg = avg_chunk_size;
+    chunker_params.max = max_chunk_size;
+
+    struct Longtail_FastCDCChunker* chunker;
+    int err = FastCDCCreateChunker(&chunker_params, &chunker);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FastCDCCreateChunker() failed with %d", err)
+        return err;
+    }
+
+    *out_chunker = (Longtail_ChunkerAPI_HChunker)chunker;
+    return 0;
+}
+
+static int FastCDCChunker_NextChunk(
+    struct Longtail_ChunkerAPI* chunker_api,
+    Longtail_ChunkerAPI_HChunker chunker,
+    Longtail_Chunker_Feeder feeder,
+    void* feeder_context,
+    struct Longtail_Chunker_ChunkRange* out_chunk_range)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(chunker, "%p"),
+        LONGTAIL_LOGFIELD(feeder, "%p"),
+        LONGTAIL_LOGFIELD(feeder_context, "%p"),
+        LONGTAIL_LOGFIELD(out_chunk_range, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, chunker_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunker, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, feeder_context, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_chunk_range, return EINVAL)
+
+    struct Longtail_FastCDCChunker* c = (struct Longtail_FastCDCChunker*)chunker;
+    if (c->len - c->off < c->params.max)
+    {
+        int err = FastCDCFeedChunker(c, feeder, feeder_context);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FastCDCFeedChunker() failed with %d", err)
+            return err;
+        }
+    }
+    out_chunk_range->offset = c->processed_count + c->off;
+    if (c->off == c->len)
+    {
+        // All done
+        out_chunk_range->buf = 0;
+        out_chunk_range->len = 0;
+        return ESPIPE;
+    }
+
+    const uint8_t* scoped_buf = &c->buf[c->off];
+    uint32_t len = FastCDCCut(c, scoped_buf, c->len - c->off);
+    out_chunk_range->buf = scoped_buf;
+    out_chunk_range->len = len;
+    c->off += len;
+    return 0;
+}
+
+static int FastCDCChunker_DisposeChunker(struct Longtail_ChunkerAPI* chunker_api, Longtail_ChunkerAPI_HChunker chunker)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(chunker, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, chunker_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunker, return EINVAL)
+    Longtail_Free(chunker);
+    return 0;
+}
+
+static int FastCDCChunker_NextChunkFromBuffer(
+    struct Longtail_ChunkerAPI* chunker_api,
+    Longtail_ChunkerAPI_HChunker chunker,
+    const void* buffer,
+    uint64_t buffer_size,
+    const void** out_next_chunk_start)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(chunker, "%p"),
+        LONGTAIL_LOGFIELD(buffer, "%p"),
+        LONGTAIL_LOGFIELD(buffer_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(out_next_chunk_start, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunker_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunker, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, buffer, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, buffer_size > 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_next_chunk_start, return EINVAL)
+
+    struct Longtail_FastCDCChunker* c = (struct Longtail_FastCDCChunker*)chunker;
+    uint32_t len = (uint32_t)(buffer_size > c->params.max ? c->params.max : buffer_size);
+    *out_next_chunk_start = ((const uint8_t*)buffer) + FastCDCCut(c, (const uint8_t*)buffer, len);
+    return 0;
+}
+
+static uint32_t FastCDCChunker_GetIdentifier(struct Longtail_ChunkerAPI* chunker_api)
+{
+    return LONGTAIL_FASTCDC_CHUNKER_TYPE;
+}
+
+static int FastCDCChunker_Init(
+    void* mem,
+    struct Longtail_ChunkerAPI** out_chunker_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(mem, "%p"),
+        LONGTAIL_LOGFIELD(out_chunker_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, mem != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_chunker_api != 0, return EINVAL)
+
+    struct Longtail_ChunkerAPI* chunker_api = Longtail_MakeChunkerAPIWithIdentifier(
+        mem,
+        FastCDCChunker_Dispose,
+        FastCDCChunker_GetMinChunkSize,
+        FastCDCChunker_CreateChunker,
+        FastCDCChunker_NextChunk,
+        FastCDCChunker_DisposeChunker,
+        FastCDCChunker_NextChunkFromBuffer,
+        FastCDCChunker_GetIdentifier);
+    if (!chunker_api)
+    {
+        return EINVAL;
+    }
+
+    *out_chunker_api = chunker_api;
+    return 0;
+}
+
+struct Longtail_ChunkerAPI* Longtail_CreateFastCDCChunkerAPI()
+{
+    MAKE_LOG_CONTEXT(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    size_t api_size =
+        sizeof(struct Longtail_FastCDCChunkerAPI);
+
+    void* mem = Longtail_Alloc("FastCDCCreateChunkerAPI", api_size);
+    if (!mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return 0;
+    }
+    struct Longtail_ChunkerAPI* chunker_api;
+    int err = FastCDCChunker_Init(
+        mem,
+        &chunker_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FastCDCChunker_Init() failed with %d", err)
+        Longtail_Free(mem);
+        return 0;
+    }
+    return chunker_api;
+}
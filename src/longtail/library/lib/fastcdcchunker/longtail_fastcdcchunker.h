@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../../src/longtail.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+LONGTAIL_EXPORT extern struct Longtail_ChunkerAPI* Longtail_CreateFastCDCChunkerAPI();
+LONGTAIL_EXPORT extern uint32_t Longtail_GetFastCDCChunkerType();
+
+#ifdef __cplusplus
+}
+#endif
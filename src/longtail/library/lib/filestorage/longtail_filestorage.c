@@ -1,3 +1,8 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    // O_DIRECT
+    #define _GNU_SOURCE
+#endif
+
 #include "longtail_filestorage.h"
 
 #include "../longtail_platform.h"
@@ -20,11 +25,483 @@
 
 #include <string.h>
 
+#if defined(__linux__) && !defined(LONGTAIL_NO_IO_URING)
+    #define LONGTAIL_FSSTORAGE_IO_URING
+#endif
+
+#if defined(LONGTAIL_FSSTORAGE_IO_URING)
+    #include <linux/io_uring.h>
+    #include <sys/syscall.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <stdio.h>
+#endif // defined(LONGTAIL_FSSTORAGE_IO_URING)
+
+#if defined(LONGTAIL_FSSTORAGE_IO_URING)
+
+// Reads larger than one segment are split in segments that are all queued at once
+#define FSSTORAGE_IO_URING_SEGMENT_SIZE    (64u * 1024u)
+#define FSSTORAGE_IO_URING_DIRECT_ALIGNMENT 4096u
+
+struct FSStorageIOUringSlot
+{
+    uint64_t m_FileOffset;
+    uint8_t* m_Data;
+    uint32_t m_Size;
+    uint32_t m_Done;
+    uint32_t m_InFlight;
+};
+
+struct FSStorageIOUring
+{
+    struct FSStorageIOUring* m_Next;
+    int m_RingFD;
+    uint32_t m_Entries;
+    void* m_RingMem;
+    size_t m_RingMemSize;
+    struct io_uring_sqe* m_SQEs;
+    size_t m_SQEsSize;
+    uint32_t* m_SQHead;
+    uint32_t* m_SQTail;
+    uint32_t m_SQMask;
+    uint32_t* m_SQArray;
+    uint32_t* m_CQHead;
+    uint32_t* m_CQTail;
+    uint32_t m_CQMask;
+    struct io_uring_cqe* m_CQEs;
+    // Bounce buffers for O_DIRECT reads, one segment per slot, registered with the ring if possible
+    uint8_t* m_Buffers;
+    size_t m_BuffersSize;
+    int m_BuffersRegistered;
+    uint32_t* m_FreeSlots;
+    struct FSStorageIOUringSlot* m_Slots;
+};
+
+static void FSStorageIOUring_Dispose(struct FSStorageIOUring* ring)
+{
+    if (ring->m_Buffers)
+    {
+        munmap(ring->m_Buffers, ring->m_BuffersSize);
+    }
+    if (ring->m_SQEs)
+    {
+        munmap(ring->m_SQEs, ring->m_SQEsSize);
+    }
+    if (ring->m_RingMem)
+    {
+        munmap(ring->m_RingMem, ring->m_RingMemSize);
+    }
+    if (ring->m_RingFD != -1)
+    {
+        close(ring->m_RingFD);
+    }
+    Longtail_Free(ring);
+}
+
+// Asks the kernel which operations the ring supports, IORING_REGISTER_PROBE itself arrived
+// in the same kernel (5.6) as IORING_OP_READ so older kernels fail the probe
+static int FSStorageIOUring_SupportsOps(int ring_fd)
+{
+    const uint32_t op_count = 256;
+    size_t probe_size = sizeof(struct io_uring_probe) + sizeof(struct io_uring_probe_op) * op_count;
+    struct io_uring_probe* probe = (struct io_uring_probe*)Longtail_Alloc("FSStorageAPI", probe_size);
+    if (!probe)
+    {
+        return 0;
+    }
+    memset(probe, 0, probe_size);
+    int supported = syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, op_count) == 0;
+    const uint8_t required_ops[] = { IORING_OP_READ, IORING_OP_READ_FIXED, IORING_OP_ASYNC_CANCEL };
+    for (size_t i = 0; supported && i < sizeof(required_ops) / sizeof(required_ops[0]); ++i)
+    {
+        uint8_t op = required_ops[i];
+        supported = op < probe->ops_len && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+    Longtail_Free(probe);
+    return supported;
+}
+
+static int FSStorageIOUring_Create(uint32_t queue_depth, struct FSStorageIOUring** out_ring)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(queue_depth, "%u"),
+        LONGTAIL_LOGFIELD(out_ring, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    size_t ring_size = sizeof(struct FSStorageIOUring) +
+        sizeof(uint32_t) * queue_depth +
+        sizeof(struct FSStorageIOUringSlot) * queue_depth;
+    struct FSStorageIOUring* ring = (struct FSStorageIOUring*)Longtail_Alloc("FSStorageAPI", ring_size);
+    if (!ring)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    memset(ring, 0, ring_size);
+    ring->m_RingFD = -1;
+    ring->m_FreeSlots = (uint32_t*)&ring[1];
+    ring->m_Slots = (struct FSStorageIOUringSlot*)&ring->m_FreeSlots[queue_depth];
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, queue_depth, &params);
+    if (fd < 0)
+    {
+        int err = errno;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "io_uring_setup() failed with %d", err)
+        FSStorageIOUring_Dispose(ring);
+        return err;
+    }
+    ring->m_RingFD = fd;
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "io_uring features 0x%x are not sufficient", params.features)
+        FSStorageIOUring_Dispose(ring);
+        return ENOTSUP;
+    }
+    if (!FSStorageIOUring_SupportsOps(fd))
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "io_uring does not support the read operations", 0)
+        FSStorageIOUring_Dispose(ring);
+        return ENOTSUP;
+    }
+    ring->m_Entries = params.sq_entries < queue_depth ? params.sq_entries : queue_depth;
+
+    size_t sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    size_t cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->m_RingMemSize = sq_ring_size > cq_ring_size ? sq_ring_size : cq_ring_size;
+    void* ring_mem = mmap(0, ring->m_RingMemSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring_mem == MAP_FAILED)
+    {
+        int err = errno;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "mmap() failed with %d", err)
+        FSStorageIOUring_Dispose(ring);
+        return err;
+    }
+    ring->m_RingMem = ring_mem;
+    ring->m_SQEsSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(0, ring->m_SQEsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        int err = errno;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "mmap() failed with %d", err)
+        FSStorageIOUring_Dispose(ring);
+        return err;
+    }
+    ring->m_SQEs = (struct io_uring_sqe*)sqes;
+
+    uint8_t* ring_ptr = (uint8_t*)ring_mem;
+    ring->m_SQHead = (uint32_t*)&ring_ptr[params.sq_off.head];
+    ring->m_SQTail = (uint32_t*)&ring_ptr[params.sq_off.tail];
+    ring->m_SQMask = *(uint32_t*)&ring_ptr[params.sq_off.ring_mask];
+    ring->m_SQArray = (uint32_t*)&ring_ptr[params.sq_off.array];
+    ring->m_CQHead = (uint32_t*)&ring_ptr[params.cq_off.head];
+    ring->m_CQTail = (uint32_t*)&ring_ptr[params.cq_off.tail];
+    ring->m_CQMask = *(uint32_t*)&ring_ptr[params.cq_off.ring_mask];
+    ring->m_CQEs = (struct io_uring_cqe*)&ring_ptr[params.cq_off.cqes];
+
+    ring->m_BuffersSize = (size_t)ring->m_Entries * FSSTORAGE_IO_URING_SEGMENT_SIZE;
+    void* buffers = mmap(0, ring->m_BuffersSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffers == MAP_FAILED)
+    {
+        int err = errno;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "mmap() failed with %d", err)
+        FSStorageIOUring_Dispose(ring);
+        return err;
+    }
+    ring->m_Buffers = (uint8_t*)buffers;
+    struct iovec buffers_iovec;
+    buffers_iovec.iov_base = ring->m_Buffers;
+    buffers_iovec.iov_len = ring->m_BuffersSize;
+    // Registering can fail on RLIMIT_MEMLOCK, the buffers then work as plain aligned buffers
+    ring->m_BuffersRegistered = syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, &buffers_iovec, 1) == 0;
+
+    for (uint32_t s = 0; s < ring->m_Entries; ++s)
+    {
+        ring->m_FreeSlots[s] = s;
+    }
+    *out_ring = ring;
+    return 0;
+}
+
+static int FSStorageIOUring_Enter(struct FSStorageIOUring* ring, uint32_t* pending_submit)
+{
+    for (;;)
+    {
+        int res = (int)syscall(__NR_io_uring_enter, ring->m_RingFD, *pending_submit, 1, IORING_ENTER_GETEVENTS, 0, 0);
+        if (res >= 0)
+        {
+            *pending_submit -= (uint32_t)res;
+            return 0;
+        }
+        if (errno != EINTR)
+        {
+            return errno;
+        }
+    }
+}
+
+static void FSStorageIOUring_QueueSlot(struct FSStorageIOUring* ring, int fd, int direct, uint32_t slot_index)
+{
+    struct FSStorageIOUringSlot* slot = &ring->m_Slots[slot_index];
+    uint32_t tail = *ring->m_SQTail;
+    uint32_t sqe_index = tail & ring->m_SQMask;
+    struct io_uring_sqe* sqe = &ring->m_SQEs[sqe_index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = (direct && ring->m_BuffersRegistered) ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = slot->m_FileOffset + slot->m_Done;
+    sqe->addr = (uint64_t)(uintptr_t)(slot->m_Data + slot->m_Done);
+    sqe->len = slot->m_Size - slot->m_Done;
+    sqe->buf_index = 0;
+    sqe->user_data = slot_index;
+    ring->m_SQArray[sqe_index] = sqe_index;
+    slot->m_InFlight = 1;
+    __atomic_store_n(ring->m_SQTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+// Marks cancel requests so their completions are not taken for a slot
+#define FSSTORAGE_IO_URING_CANCEL_USER_DATA 0x100000000ull
+
+// Called when io_uring_enter() failed. Reads the kernel already took may still complete into
+// the caller's buffer so they are cancelled and their completions waited for before returning,
+// reads that were queued but not submitted are taken back.
+static void FSStorageIOUring_Drain(struct FSStorageIOUring* ring, uint32_t pending_submit)
+{
+    uint32_t tail = *ring->m_SQTail;
+    for (uint32_t i = 0; i < pending_submit; ++i)
+    {
+        uint32_t sqe_index = (tail - 1 - i) & ring->m_SQMask;
+        ring->m_Slots[(uint32_t)ring->m_SQEs[sqe_index].user_data].m_InFlight = 0;
+    }
+    tail -= pending_submit;
+    __atomic_store_n(ring->m_SQTail, tail, __ATOMIC_RELEASE);
+
+    uint32_t in_flight_count = 0;
+    for (uint32_t s = 0; s < ring->m_Entries; ++s)
+    {
+        struct FSStorageIOUringSlot* slot = &ring->m_Slots[s];
+        if (!slot->m_InFlight)
+        {
+            continue;
+        }
+        uint32_t sqe_index = (tail + in_flight_count) & ring->m_SQMask;
+        struct io_uring_sqe* sqe = &ring->m_SQEs[sqe_index];
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = s;
+        sqe->user_data = FSSTORAGE_IO_URING_CANCEL_USER_DATA | s;
+        ring->m_SQArray[sqe_index] = sqe_index;
+        ++in_flight_count;
+    }
+    if (in_flight_count == 0)
+    {
+        return;
+    }
+    __atomic_store_n(ring->m_SQTail, tail + in_flight_count, __ATOMIC_RELEASE);
+    int submitted = (int)syscall(__NR_io_uring_enter, ring->m_RingFD, in_flight_count, 0, 0, 0, 0);
+    uint32_t cancel_count = submitted > 0 ? (uint32_t)submitted : 0;
+    if (cancel_count < in_flight_count)
+    {
+        // The cancels the kernel did not take are dropped, the reads then run to completion
+        __atomic_store_n(ring->m_SQTail, tail + cancel_count, __ATOMIC_RELEASE);
+    }
+
+    while (in_flight_count > 0 || cancel_count > 0)
+    {
+        uint32_t head = *ring->m_CQHead;
+        uint32_t cq_tail = __atomic_load_n(ring->m_CQTail, __ATOMIC_ACQUIRE);
+        while (head != cq_tail)
+        {
+            struct io_uring_cqe* cqe = &ring->m_CQEs[head & ring->m_CQMask];
+            if (cqe->user_data & FSSTORAGE_IO_URING_CANCEL_USER_DATA)
+            {
+                --cancel_count;
+            }
+            else
+            {
+                ring->m_Slots[(uint32_t)cqe->user_data].m_InFlight = 0;
+                --in_flight_count;
+            }
+            ++head;
+        }
+        __atomic_store_n(ring->m_CQHead, head, __ATOMIC_RELEASE);
+        if (in_flight_count > 0 || cancel_count > 0)
+        {
+            if (syscall(__NR_io_uring_enter, ring->m_RingFD, 0, 1, IORING_ENTER_GETEVENTS, 0, 0) < 0)
+            {
+                Longtail_Sleep(1000);
+            }
+        }
+    }
+}
+
+// Reads [offset, offset + length) with up to m_Entries segment reads in flight.
+// With direct set the file is opened with O_DIRECT and the reads go through the
+// aligned bounce buffers. *out_ring_failed is set if io_uring_enter() failed, the
+// ring then has nothing in flight but should not be used again.
+static int FSStorageIOUring_Read(struct FSStorageIOUring* ring, int fd, int direct, uint64_t offset, uint64_t length, uint8_t* output, int* out_ring_failed)
+{
+    const uint64_t end = offset + length;
+    uint64_t next_offset = direct ? (offset & ~((uint64_t)FSSTORAGE_IO_URING_DIRECT_ALIGNMENT - 1)) : offset;
+    const uint64_t read_end = direct ? ((end + FSSTORAGE_IO_URING_DIRECT_ALIGNMENT - 1) & ~((uint64_t)FSSTORAGE_IO_URING_DIRECT_ALIGNMENT - 1)) : end;
+    uint32_t free_slot_count = ring->m_Entries;
+    uint32_t pending_submit = 0;
+    int err = 0;
+    *out_ring_failed = 0;
+
+    while (free_slot_count < ring->m_Entries || (err == 0 && next_offset < read_end))
+    {
+        while (err == 0 && free_slot_count > 0 && next_offset < read_end)
+        {
+            uint32_t slot_index = ring->m_FreeSlots[--free_slot_count];
+            struct FSStorageIOUringSlot* slot = &ring->m_Slots[slot_index];
+            uint64_t size = read_end - next_offset;
+            slot->m_FileOffset = next_offset;
+            slot->m_Size = (uint32_t)(size < FSSTORAGE_IO_URING_SEGMENT_SIZE ? size : FSSTORAGE_IO_URING_SEGMENT_SIZE);
+            slot->m_Done = 0;
+            slot->m_Data = direct ? &ring->m_Buffers[(size_t)slot_index * FSSTORAGE_IO_URING_SEGMENT_SIZE] : &output[next_offset - offset];
+            FSStorageIOUring_QueueSlot(ring, fd, direct, slot_index);
+            ++pending_submit;
+            next_offset += slot->m_Size;
+        }
+
+        int enter_err = FSStorageIOUring_Enter(ring, &pending_submit);
+        if (enter_err)
+        {
+            FSStorageIOUring_Drain(ring, pending_submit);
+            *out_ring_failed = 1;
+            return enter_err;
+        }
+
+        uint32_t head = *ring->m_CQHead;
+        uint32_t tail = __atomic_load_n(ring->m_CQTail, __ATOMIC_ACQUIRE);
+        while (head != tail)
+        {
+            struct io_uring_cqe* cqe = &ring->m_CQEs[head & ring->m_CQMask];
+            uint32_t slot_index = (uint32_t)cqe->user_data;
+            int32_t res = cqe->res;
+            ++head;
+            struct FSStorageIOUringSlot* slot = &ring->m_Slots[slot_index];
+            slot->m_InFlight = 0;
+            if (res < 0)
+            {
+                if (err == 0)
+                {
+                    err = -res;
+                }
+                ring->m_FreeSlots[free_slot_count++] = slot_index;
+                continue;
+            }
+            slot->m_Done += (uint32_t)res;
+            if (res > 0 && slot->m_Done < slot->m_Size && !direct && err == 0)
+            {
+                // Short buffered read, queue the rest of the segment
+                FSStorageIOUring_QueueSlot(ring, fd, direct, slot_index);
+                ++pending_submit;
+                continue;
+            }
+            if (direct && slot->m_Done > 0)
+            {
+                uint64_t copy_start = slot->m_FileOffset > offset ? slot->m_FileOffset : offset;
+                uint64_t copy_end = slot->m_FileOffset + slot->m_Done < end ? slot->m_FileOffset + slot->m_Done : end;
+                if (copy_start < copy_end)
+                {
+                    memcpy(&output[copy_start - offset], &slot->m_Data[copy_start - slot->m_FileOffset], (size_t)(copy_end - copy_start));
+                }
+            }
+            ring->m_FreeSlots[free_slot_count++] = slot_index;
+        }
+        __atomic_store_n(ring->m_CQHead, head, __ATOMIC_RELEASE);
+    }
+    return err;
+}
+
+#endif // defined(LONGTAIL_FSSTORAGE_IO_URING)
+
 struct FSStorageAPI
 {
     struct Longtail_StorageAPI m_FSStorageAPI;
+#if defined(LONGTAIL_FSSTORAGE_IO_URING)
+    uint32_t m_IOUringQueueDepth;
+    uint64_t m_DirectIOMinSize;
+    HLongtail_SpinLock m_IOUringLock;
+    struct FSStorageIOUring* m_IdleIOUrings;
+#endif // defined(LONGTAIL_FSSTORAGE_IO_URING)
 };
 
+#if defined(LONGTAIL_FSSTORAGE_IO_URING)
+
+static struct FSStorageIOUring* FSStorageAPI_AcquireIOUring(struct FSStorageAPI* api)
+{
+    Longtail_LockSpinLock(api->m_IOUringLock);
+    struct FSStorageIOUring* ring = api->m_IdleIOUrings;
+    if (ring)
+    {
+        api->m_IdleIOUrings = ring->m_Next;
+    }
+    Longtail_UnlockSpinLock(api->m_IOUringLock);
+    if (ring == 0)
+    {
+        if (FSStorageIOUring_Create(api->m_IOUringQueueDepth, &ring))
+        {
+            return 0;
+        }
+    }
+    return ring;
+}
+
+static void FSStorageAPI_ReleaseIOUring(struct FSStorageAPI* api, struct FSStorageIOUring* ring)
+{
+    Longtail_LockSpinLock(api->m_IOUringLock);
+    ring->m_Next = api->m_IdleIOUrings;
+    api->m_IdleIOUrings = ring;
+    Longtail_UnlockSpinLock(api->m_IOUringLock);
+}
+
+// Reads through a buffered fd of our own, the O_DIRECT fd is shared by all readers
+// of the open file so its flags must not change under them
+static int FSStorageAPI_ReadBuffered(int direct_fd, uint64_t offset, uint64_t length, uint8_t* output)
+{
+    char fd_path[64];
+    snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", direct_fd);
+    int fd = open(fd_path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return errno;
+    }
+    int err = 0;
+    while (length > 0)
+    {
+        ssize_t read_size = pread(fd, output, (size_t)length, (off_t)offset);
+        if (read_size < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            err = errno;
+            break;
+        }
+        if (read_size == 0)
+        {
+            err = EIO;
+            break;
+        }
+        output += read_size;
+        offset += (uint64_t)read_size;
+        length -= (uint64_t)read_size;
+    }
+    close(fd);
+    return err;
+}
+
+#endif // defined(LONGTAIL_FSSTORAGE_IO_URING)
+
 static void FSStorageAPI_Dispose(struct Longtail_API* storage_api)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -32,6 +509,19 @@ static void FSStorageAPI_Dispose(struct Longtail_API* storage_api)
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
     LONGTAIL_FATAL_ASSERT(ctx, storage_api != 0, return);
+#if defined(LONGTAIL_FSSTORAGE_IO_URING)
+    struct FSStorageAPI* api = (struct FSStorageAPI*)storage_api;
+    if (api->m_IOUringQueueDepth > 0)
+    {
+        while (api->m_IdleIOUrings)
+        {
+            struct FSStorageIOUring* ring = api->m_IdleIOUrings;
+            api->m_IdleIOUrings = ring->m_Next;
+            FSStorageIOUring_Dispose(ring);
+        }
+        Longtail_DeleteSpinLock(api->m_IOUringLock);
+    }
+#endif // defined(LONGTAIL_FSSTORAGE_IO_URING)
     Longtail_Free(storage_api);
 }
 
@@ -54,6 +544,45 @@ static int FSStorageAPI_OpenReadFile(
     LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL);
     LONGTAIL_VALIDATE_INPUT(ctx, out_open_file != 0, return EINVAL);
 
+#if defined(LONGTAIL_FSSTORAGE_IO_URING)
+    struct FSStorageAPI* api = (struct FSStorageAPI*)storage_api;
+    if (api->m_IOUringQueueDepth > 0)
+    {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            int err = errno;
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "open() failed with %d", err)
+            return err;
+        }
+        struct stat stat_buf;
+        if (api->m_DirectIOMinSize > 0 && fstat(fd, &stat_buf) == 0 && (uint64_t)stat_buf.st_size >= api->m_DirectIOMinSize)
+        {
+            // Huge files are read once, bypass the page cache. Not all file systems support O_DIRECT, keep the buffered fd if it fails
+            int direct_fd = open(path, O_RDONLY | O_CLOEXEC | O_DIRECT);
+            if (direct_fd != -1)
+            {
+                close(fd);
+                fd = direct_fd;
+            }
+        }
+        else
+        {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+        FILE* f = fdopen(fd, "rb");
+        if (f == 0)
+        {
+            int err = errno;
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "fdopen() failed with %d", err)
+            close(fd);
+            return err;
+        }
+        *out_open_file = (Longtail_StorageAPI_HOpenFile)f;
+        return 0;
+    }
+#endif // defined(LONGTAIL_FSSTORAGE_IO_URING)
+
     HLongtail_OpenFile r;
     int err = Longtail_OpenReadFile(path, &r);
     if (err != 0)
@@ -114,6 +643,45 @@ static int FSStorageAPI_Read(
     LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL);
     LONGTAIL_VALIDATE_INPUT(ctx, f != 0, return EINVAL);
     LONGTAIL_VALIDATE_INPUT(ctx, output != 0, return EINVAL);
+#if defined(LONGTAIL_FSSTORAGE_IO_URING)
+    struct FSStorageAPI* api = (struct FSStorageAPI*)storage_api;
+    if (api->m_IOUringQueueDepth > 0)
+    {
+        int fd = fileno((FILE*)f);
+        int direct = (api->m_DirectIOMinSize > 0) && ((fcntl(fd, F_GETFL) & O_DIRECT) != 0);
+        if (direct || length > FSSTORAGE_IO_URING_SEGMENT_SIZE)
+        {
+            struct FSStorageIOUring* ring = FSStorageAPI_AcquireIOUring(api);
+            if (ring)
+            {
+                int ring_failed;
+                int err = FSStorageIOUring_Read(ring, fd, direct, offset, length, (uint8_t*)output, &ring_failed);
+                if (!ring_failed)
+                {
+                    FSStorageAPI_ReleaseIOUring(api, ring);
+                    if (err)
+                    {
+                        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FSStorageIOUring_Read() failed with %d", err)
+                    }
+                    return err;
+                }
+                // Nothing is in flight any more, read the range with pread instead
+                FSStorageIOUring_Dispose(ring);
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "io_uring_enter() failed with %d, falling back to pread", err)
+            }
+            if (direct)
+            {
+                // Without a ring we can not read unaligned ranges from the O_DIRECT fd
+                int err = FSStorageAPI_ReadBuffered(fd, offset, length, (uint8_t*)output);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FSStorageAPI_ReadBuffered() failed with %d", err)
+                }
+                return err;
+            }
+        }
+    }
+#endif // defined(LONGTAIL_FSSTORAGE_IO_URING)
     int err = Longtail_Read((HLongtail_OpenFile)f, offset,length, output);
     if (err)
     {
@@ -185,6 +753,34 @@ static int FSStorageAPI_Write(
     return err;
 }
 
+static int FSStorageAPI_StreamWritten(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile f,
+    uint64_t offset,
+    uint64_t length)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(f, "%p"),
+        LONGTAIL_LOGFIELD(offset, "%" PRIu64),
+        LONGTAIL_LOGFIELD(length, "%" PRIu64)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL);
+    LONGTAIL_VALIDATE_INPUT(ctx, f != 0, return EINVAL);
+    int err = Longtail_StreamWritten((HLongtail_OpenFile)f, offset, length);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_StreamWritten() failed with %d", err)
+        return err;
+    }
+    return 0;
+}
+
 static int FSStorageAPI_SetSize(
     struct Longtail_StorageAPI* storage_api,
     Longtail_StorageAPI_HOpenFile f,
@@ -328,6 +924,30 @@ static int FSStorageAPI_RenameFile(struct Longtail_StorageAPI* storage_api, cons
     return 0;
 }
 
+static int FSStorageAPI_CloneFile(struct Longtail_StorageAPI* storage_api, const char* source_path, const char* target_path)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(source_path, "%s"),
+        LONGTAIL_LOGFIELD(target_path, "%s")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL);
+    LONGTAIL_VALIDATE_INPUT(ctx, source_path != 0, return EINVAL);
+    LONGTAIL_VALIDATE_INPUT(ctx, target_path != 0, return EINVAL);
+    int err = Longtail_CopyFile(source_path, target_path);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "Longtail_CopyFile() failed with %d", err)
+        return err;
+    }
+    return 0;
+}
+
 static char* FSStorageAPI_ConcatPath(struct Longtail_StorageAPI* storage_api, const char* root_path, const char* sub_path)
 {
 #if defined(LONGTAIL_ASSERTS)
@@ -669,11 +1289,67 @@ static int FSStorageAPI_Init(
         FSStorageAPI_GetParentPath,
         FSStorageAPI_MapFile,
         FSStorageAPI_UnmapFile);
+    api->CloneFile = FSStorageAPI_CloneFile;
+    api->StreamWritten = FSStorageAPI_StreamWritten;
     *out_storage_api = api;
     return 0;
 }
 
 
+struct Longtail_StorageAPI* Longtail_CreateFSStorageAPIWithIOUring(uint32_t queue_depth, uint64_t direct_io_min_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(queue_depth, "%u"),
+        LONGTAIL_LOGFIELD(direct_io_min_size, "%" PRIu64)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, queue_depth > 0, return 0);
+#if defined(LONGTAIL_FSSTORAGE_IO_URING)
+    // Probe once so callers can fall back to Longtail_CreateFSStorageAPI if the kernel does not give us io_uring
+    struct FSStorageIOUring* ring;
+    int err = FSStorageIOUring_Create(queue_depth, &ring);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "FSStorageIOUring_Create() failed with %d", err)
+        return 0;
+    }
+
+    size_t api_size = sizeof(struct FSStorageAPI) + Longtail_GetSpinLockSize();
+    void* mem = Longtail_Alloc("FSStorageAPI", api_size);
+    if (!mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        FSStorageIOUring_Dispose(ring);
+        return 0;
+    }
+    struct FSStorageAPI* api = (struct FSStorageAPI*)mem;
+    err = Longtail_CreateSpinLock(&api[1], &api->m_IOUringLock);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateSpinLock() failed with %d", err)
+        Longtail_Free(mem);
+        FSStorageIOUring_Dispose(ring);
+        return 0;
+    }
+    api->m_IOUringQueueDepth = queue_depth;
+    api->m_DirectIOMinSize = direct_io_min_size;
+    api->m_IdleIOUrings = ring;
+    ring->m_Next = 0;
+    struct Longtail_StorageAPI* storage_api;
+    err = FSStorageAPI_Init(mem, &storage_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "FSStorageAPI_Init() failed with %d", err)
+        FSStorageAPI_Dispose(&api->m_FSStorageAPI.m_API);
+        return 0;
+    }
+    return storage_api;
+#else
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "io_uring is not supported on this platform")
+    return 0;
+#endif // defined(LONGTAIL_FSSTORAGE_IO_URING)
+}
+
 struct Longtail_StorageAPI* Longtail_CreateFSStorageAPI()
 {
     MAKE_LOG_CONTEXT(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
@@ -684,6 +1360,10 @@ struct Longtail_StorageAPI* Longtail_CreateFSStorageAPI()
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return 0;
     }
+#if defined(LONGTAIL_FSSTORAGE_IO_URING)
+    ((struct FSStorageAPI*)mem)->m_IOUringQueueDepth = 0;
+    ((struct FSStorageAPI*)mem)->m_IdleIOUrings = 0;
+#endif // defined(LONGTAIL_FSSTORAGE_IO_URING)
     struct Longtail_StorageAPI* storage_api;
     int err = FSStorageAPI_Init(mem, &storage_api);
     if (err)
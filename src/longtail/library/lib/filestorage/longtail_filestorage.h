@@ -8,6 +8,11 @@ extern "C" {
 
 LONGTAIL_EXPORT extern struct Longtail_StorageAPI* Longtail_CreateFSStorageAPI();
 
+// Reads through a pool of io_uring instances, large reads are split in segments that are kept in flight together.
+// Files of direct_io_min_size bytes or more are opened with O_DIRECT, 0 disables O_DIRECT.
+// Returns 0 if io_uring is not available, use Longtail_CreateFSStorageAPI() instead.
+LONGTAIL_EXPORT extern struct Longtail_StorageAPI* Longtail_CreateFSStorageAPIWithIOUring(uint32_t queue_depth, uint64_t direct_io_min_size);
+
 #ifdef __cplusplus
 }
 #endif
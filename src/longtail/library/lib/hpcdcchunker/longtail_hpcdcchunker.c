@@ -1,13 +1,17 @@
 // https://moinakg.wordpress.com/2013/06/22/high-performance-content-defined-chunking/
 
 #include "longtail_hpcdcchunker.h"
+#include "longtail_hpcdcchunker_scan.h"
 
 #include <errno.h>
 #include <string.h>
 #include <stdlib.h>
 
+// HPCDC predates chunker identifiers in the version index, an identifier of zero means HPCDC
+uint32_t Longtail_GetHPCDCChunkerType() { return 0u; }
+
 // ChunkerWindowSize is the number of bytes in the rolling hash window
-#define ChunkerWindowSize 48u
+#define ChunkerWindowSize HPCDCScanWindowSize
 
 struct Longtail_HPCDCChunker;
 
@@ -104,13 +108,113 @@ struct Longtail_HPCDCChunker
     uint32_t max_feed;
     uint32_t off;
     uint32_t hValue;
-    uint8_t hWindow[ChunkerWindowSize];
     uint32_t hDiscriminator;
+    struct HPCDCScanParams scan_params;
+    HPCDCScan_Func scan_func;
     Longtail_Chunker_Feeder fFeeder;
     void* cFeederContext;
     uint64_t processed_count;
 };
 
+#if defined(HPCDCSCAN_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+enum HPCDCCPUFeature
+{
+    HPCDC_CPU_SSE41 = 1 << 0,
+    HPCDC_CPU_AVX2 = 1 << 1,
+    HPCDC_CPU_AVX512 = 1 << 2
+};
+
+static uint64_t HPCDCGetXCR0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax = 0, edx = 0;
+    __asm__ __volatile__("xgetbv\n" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+static void HPCDCCPUID(uint32_t out[4], uint32_t id, uint32_t sub_id)
+{
+#if defined(_MSC_VER)
+    __cpuidex((int*)out, (int)id, (int)sub_id);
+#else
+    __cpuid_count(id, sub_id, out[0], out[1], out[2], out[3]);
+#endif
+}
+
+static int HPCDCGetCPUFeatures()
+{
+    uint32_t regs[4] = {0};
+    int features = 0;
+    HPCDCCPUID(regs, 0, 0);
+    const uint32_t max_id = regs[0];
+    HPCDCCPUID(regs, 1, 0);
+    if (regs[2] & (1u << 19))
+    {
+        features |= HPCDC_CPU_SSE41;
+    }
+    if ((regs[2] & (1u << 27)) == 0 || max_id < 7)  // OSXSAVE
+    {
+        return features;
+    }
+    const uint64_t xcr0 = HPCDCGetXCR0();
+    if ((xcr0 & 6) != 6) // SSE and AVX states
+    {
+        return features;
+    }
+    HPCDCCPUID(regs, 7, 0);
+    if (regs[1] & (1u << 5))
+    {
+        features |= HPCDC_CPU_AVX2;
+    }
+    if ((xcr0 & 224) == 224 && (regs[1] & (1u << 16)) && (regs[1] & (1u << 31))) // Opmask, ZMM_Hi256, Hi16_Zmm, AVX512F and AVX512VL
+    {
+        features |= HPCDC_CPU_AVX512;
+    }
+    return features;
+}
+#endif // defined(HPCDCSCAN_X86)
+
+static uint32_t HPCDCScan_Portable(const struct HPCDCScanParams* params, const uint8_t* buf, uint32_t pos, uint32_t end, uint32_t* hash)
+{
+    return HPCDCScan_Scalar(params, buf, pos, end, hash);
+}
+
+// Picks the widest boundary scanner the CPU supports, all of them find the same boundaries
+static HPCDCScan_Func GetHPCDCScanFunc()
+{
+    static HPCDCScan_Func scan_func = 0;
+    if (scan_func == 0)
+    {
+        HPCDCScan_Func func = HPCDCScan_Portable;
+#if defined(HPCDCSCAN_X86)
+        int features = HPCDCGetCPUFeatures();
+        if (features & HPCDC_CPU_AVX512)
+        {
+            func = HPCDCScan_AVX512;
+        }
+        else if (features & HPCDC_CPU_AVX2)
+        {
+            func = HPCDCScan_AVX2;
+        }
+        else if (features & HPCDC_CPU_SSE41)
+        {
+            func = HPCDCScan_SSE41;
+        }
+#endif // defined(HPCDCSCAN_X86)
+        scan_func = func;
+    }
+    return scan_func;
+}
+
 static uint32_t HPCDCDiscriminatorFromAvg(double avg)
 {
     return (uint32_t)(avg / (-1.42888852e-7*avg + 1.33237515));
@@ -151,6 +255,10 @@ int Longtail_HPCDCCreateChunker(
     c->off = 0;
     c->hValue = 0;
     c->hDiscriminator = HPCDCDiscriminatorFromAvg((double)params->avg);
+    c->scan_params.table = hashTable;
+    c->scan_params.discriminator = c->hDiscriminator;
+    c->scan_params.mod_magic = HPCDCScan_ModMagic(c->hDiscriminator);
+    c->scan_func = GetHPCDCScanFunc();
     c->processed_count = 0;
     *out_chunker = c;
     return 0;
@@ -191,12 +299,6 @@ static int FeedChunker(
     return err;
 }
 
-#if defined(_MSC_VER)
-#  define LONGTAIL_rotl32(x,r) _rotl(x,r)
-#else
-#  define LONGTAIL_rotl32(x,r) ((x << r) | (x >> (32 - r)))
-#endif
-
 static const struct Longtail_Chunker_ChunkRange EmptyChunkRange = {0, 0, 0};
 
 struct Longtail_Chunker_ChunkRange Longtail_HPCDCNextChunk(
@@ -241,46 +343,17 @@ struct Longtail_Chunker_ChunkRange Longtail_HPCDCNextChunk(
     }
 
     uint32_t hash = 0;
-    struct Longtail_Chunker_ChunkRange scoped_data = {&c->buf.data[c->off], c->processed_count + c->off, left};
+    const uint8_t* scoped_buf = &c->buf.data[c->off];
     {
-        struct Longtail_Chunker_ChunkRange window = {
-            &scoped_data.buf[c->params.min - ChunkerWindowSize],
-            c->processed_count + c->off + c->params.min - ChunkerWindowSize,
-            ChunkerWindowSize};
+        const uint8_t* window = &scoped_buf[c->params.min - ChunkerWindowSize];
         for (uint32_t i = 0; i < ChunkerWindowSize; ++i)
         {
-            uint8_t b = window.buf[i];
-            hash ^= LONGTAIL_rotl32(hashTable[b], (int)((ChunkerWindowSize-i-1u) & 31));
-            c->hWindow[i] = b;
+            hash ^= HPCDCScan_rotl32(hashTable[window[i]], (int)((ChunkerWindowSize-i-1u) & 31));
         }
     }
 
-    uint32_t pos = c->params.min;
-    uint32_t idx = 0;
-
-    uint32_t data_len = scoped_data.len > c->params.max ? c->params.max : scoped_data.len;
-    uint8_t* window = c->hWindow;
-    const uint32_t discriminator = c->hDiscriminator - 1;
-    const uint8_t* scoped_buf = scoped_data.buf;
-    const uint32_t d = c->hDiscriminator;
-    while(pos < data_len)
-    {
-        uint8_t in = scoped_buf[pos++];
-        uint8_t out = window[idx];
-        window[idx++] = in;
-        hash = LONGTAIL_rotl32(hash, 1) ^
-            LONGTAIL_rotl32(hashTable[out], (int)(ChunkerWindowSize & 31)) ^
-            hashTable[in];
-
-        if ((hash % d) == discriminator)
-        {
-            break;
-        }
-        if (idx == ChunkerWindowSize)
-        {
-            idx = 0;
-        }
-    }
+    uint32_t data_len = left > c->params.max ? c->params.max : left;
+    uint32_t pos = c->scan_func(&c->scan_params, scoped_buf, c->params.min, data_len, &hash);
     struct Longtail_Chunker_ChunkRange r = {scoped_buf, c->processed_count + c->off, pos};
     c->off += pos;
     return r;
@@ -442,36 +515,31 @@ int HPCDCChunker_NextChunkFromBuffer(
     uint32_t hash = 0;
     for (uint32_t i = 0; i < ChunkerWindowSize; ++i)
     {
-        uint8_t b = buf[i];
-        hash ^= LONGTAIL_rotl32(hashTable[b], (int)((ChunkerWindowSize-i-1u) & 31));
-        c->hWindow[i] = b;
+        hash ^= HPCDCScan_rotl32(hashTable[buf[i]], (int)((ChunkerWindowSize-i-1u) & 31));
     }
 
-    uint32_t pos = c->params.min;
-    uint32_t idx = 0;
-
     uint32_t data_len = (uint32_t)(buffer_size > c->params.max ? c->params.max : buffer_size);
-    uint8_t* window = c->hWindow;
+
+    // The window is seeded with the start of the buffer rather than the bytes before min
+    // so until the window has been rolled through, the outgoing byte at pos is buf[pos - min]
+    uint32_t pos = c->params.min;
+    uint32_t seeded_end = data_len < c->params.min + ChunkerWindowSize ? data_len : c->params.min + ChunkerWindowSize;
     const uint32_t discriminator = c->hDiscriminator - 1;
-    const uint32_t d = c->hDiscriminator;
-    while(pos < data_len)
+    while (pos < seeded_end)
     {
-        uint8_t in = buf[pos++];
-        uint8_t out = window[idx];
-        window[idx++] = in;
-        hash = LONGTAIL_rotl32(hash, 1) ^
-            LONGTAIL_rotl32(hashTable[out], (int)(ChunkerWindowSize & 31)) ^
+        uint8_t in = buf[pos];
+        uint8_t out = buf[pos - c->params.min];
+        ++pos;
+        hash = HPCDCScan_rotl32(hash, 1) ^
+            HPCDCScan_rotl32(hashTable[out], (int)(ChunkerWindowSize & 31)) ^
             hashTable[in];
-
-        if ((hash % d) == discriminator)
-        {
-            break;
-        }
-        if (idx == ChunkerWindowSize)
+        if (HPCDCScan_Mod(&c->scan_params, hash) == discriminator)
         {
-            idx = 0;
+            *out_next_chunk_start = ((const uint8_t*)buffer) + pos;
+            return 0;
         }
     }
+    pos = c->scan_func(&c->scan_params, buf, pos, data_len, &hash);
     *out_next_chunk_start = ((const uint8_t*)buffer) + pos;
     return 0;
 }
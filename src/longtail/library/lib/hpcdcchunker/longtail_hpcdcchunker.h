@@ -8,6 +8,7 @@ extern "C" {
 #endif
 
 LONGTAIL_EXPORT extern struct Longtail_ChunkerAPI* Longtail_CreateHPCDCChunkerAPI();
+LONGTAIL_EXPORT extern uint32_t Longtail_GetHPCDCChunkerType();
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+
+// Boundary scanning shared by the scalar HPCDC chunker and its SIMD variants.
+//
+// The rolling hash at position p is
+//   hash(p) = rotl(hash(p-1), 1) ^ rotl(table[buf[p-W]], W & 31) ^ table[buf[p]]
+// and p is a boundary when hash(p) % discriminator == discriminator - 1.
+// The SIMD variants compute a run of positions at once using a prefix xor-rotate
+// over the per-position table terms and must return exactly what the scalar scan
+// returns.
+
+// HPCDCScanWindowSize is the number of bytes in the rolling hash window
+#define HPCDCScanWindowSize 48u
+
+#if defined(_MSC_VER)
+#  include <stdlib.h>
+#  define HPCDCScan_rotl32(x,r) _rotl(x,r)
+#else
+#  define HPCDCScan_rotl32(x,r) ((x << r) | (x >> (32 - r)))
+#endif
+
+struct HPCDCScanParams
+{
+    const uint32_t* table;
+    uint32_t discriminator;
+    // ceil(2^64 / discriminator), lets the modulo be computed with multiplications
+    uint64_t mod_magic;
+};
+
+static inline uint64_t HPCDCScan_ModMagic(uint32_t discriminator)
+{
+    return (UINT64_C(0xffffffffffffffff) / discriminator) + 1u;
+}
+
+// Exact value % discriminator for all 32 bit values, see Lemire et al,
+// "Faster Remainder by Direct Computation"
+static inline uint32_t HPCDCScan_Mod(const struct HPCDCScanParams* params, uint32_t value)
+{
+    uint64_t lowbits = params->mod_magic * value;
+    uint64_t d = params->discriminator;
+    return (uint32_t)((((lowbits >> 32) * d) + (((lowbits & 0xffffffffu) * d) >> 32)) >> 32);
+}
+
+// Scans buf[pos..end) where buf[pos - HPCDCScanWindowSize] is the byte leaving the
+// window at pos. Returns the position after the first boundary or end if there is none.
+// *hash is the rolling hash before pos and is updated to the hash before the returned position.
+static inline uint32_t HPCDCScan_Scalar(
+    const struct HPCDCScanParams* params,
+    const uint8_t* buf,
+    uint32_t pos,
+    uint32_t end,
+    uint32_t* hash)
+{
+    const uint32_t* table = params->table;
+    const uint32_t discriminator = params->discriminator - 1;
+    uint32_t h = *hash;
+    while (pos < end)
+    {
+        uint8_t in = buf[pos];
+        uint8_t out = buf[pos - HPCDCScanWindowSize];
+        ++pos;
+        h = HPCDCScan_rotl32(h, 1) ^
+            HPCDCScan_rotl32(table[out], (int)(HPCDCScanWindowSize & 31)) ^
+            table[in];
+        if (HPCDCScan_Mod(params, h) == discriminator)
+        {
+            break;
+        }
+    }
+    *hash = h;
+    return pos;
+}
+
+typedef uint32_t (*HPCDCScan_Func)(const struct HPCDCScanParams* params, const uint8_t* buf, uint32_t pos, uint32_t end, uint32_t* hash);
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HPCDCSCAN_X86
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t HPCDCScan_SSE41(const struct HPCDCScanParams* params, const uint8_t* buf, uint32_t pos, uint32_t end, uint32_t* hash);
+uint32_t HPCDCScan_AVX2(const struct HPCDCScanParams* params, const uint8_t* buf, uint32_t pos, uint32_t end, uint32_t* hash);
+uint32_t HPCDCScan_AVX512(const struct HPCDCScanParams* params, const uint8_t* buf, uint32_t pos, uint32_t end, uint32_t* hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
@@ -0,0 +1,90 @@
+#include "../longtail_hpcdcchunker_scan.h"
+
+#include <immintrin.h>
+
+#define HPCDCSCAN_AVX2_LANES 8u
+
+static inline __m256i rotl_avx2(__m256i x, int r)
+{
+    return _mm256_or_si256(_mm256_slli_epi32(x, r), _mm256_srli_epi32(x, 32 - r));
+}
+
+// Shifts the lanes of x up as given by index, keep clears the lanes shifted in
+static inline __m256i shift_lanes_avx2(__m256i x, __m256i index, __m256i keep)
+{
+    return _mm256_and_si256(_mm256_permutevar8x32_epi32(x, index), keep);
+}
+
+// value % discriminator for the even 32 bit lanes of value, the result is in the low
+// half of each 64 bit lane
+static inline __m256i mod_even_avx2(__m256i value, __m256i magic_lo, __m256i magic_hi, __m256i discriminator)
+{
+    __m256i lowbits = _mm256_add_epi64(
+        _mm256_mul_epu32(value, magic_lo),
+        _mm256_slli_epi64(_mm256_mul_epu32(value, magic_hi), 32));
+    __m256i low_product = _mm256_srli_epi64(_mm256_mul_epu32(lowbits, discriminator), 32);
+    __m256i high_product = _mm256_mul_epu32(_mm256_srli_epi64(lowbits, 32), discriminator);
+    return _mm256_srli_epi64(_mm256_add_epi64(high_product, low_product), 32);
+}
+
+uint32_t HPCDCScan_AVX2(
+    const struct HPCDCScanParams* params,
+    const uint8_t* buf,
+    uint32_t pos,
+    uint32_t end,
+    uint32_t* hash)
+{
+    const int* table = (const int*)params->table;
+    const __m256i index1 = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+    const __m256i keep1 = _mm256_setr_epi32(0, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i index2 = _mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5);
+    const __m256i keep2 = _mm256_setr_epi32(0, 0, -1, -1, -1, -1, -1, -1);
+    const __m256i index4 = _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3);
+    const __m256i keep4 = _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1);
+    const __m256i last_lane = _mm256_set1_epi32(HPCDCSCAN_AVX2_LANES - 1);
+    const __m256i carry_shl = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8);
+    const __m256i carry_shr = _mm256_setr_epi32(31, 30, 29, 28, 27, 26, 25, 24);
+    const __m256i magic_lo = _mm256_set1_epi64x((long long)(params->mod_magic & 0xffffffffu));
+    const __m256i magic_hi = _mm256_set1_epi64x((long long)(params->mod_magic >> 32));
+    const __m256i discriminator = _mm256_set1_epi64x((long long)params->discriminator);
+    const __m256i boundary = _mm256_set1_epi32((int)(params->discriminator - 1));
+
+    __m256i h = _mm256_set1_epi32((int)*hash);
+    while (end - pos >= HPCDCSCAN_AVX2_LANES)
+    {
+        __m256i in = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&buf[pos]));
+        __m256i out = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&buf[pos - HPCDCScanWindowSize]));
+
+        // v[i] = rotl(table[out], W & 31) ^ table[in], the term each position adds
+        __m256i v = _mm256_xor_si256(
+            rotl_avx2(_mm256_i32gather_epi32(table, out, 4), (int)(HPCDCScanWindowSize & 31)),
+            _mm256_i32gather_epi32(table, in, 4));
+
+        // v[i] = xor of rotl(v[j], i - j) for j <= i
+        v = _mm256_xor_si256(v, rotl_avx2(shift_lanes_avx2(v, index1, keep1), 1));
+        v = _mm256_xor_si256(v, rotl_avx2(shift_lanes_avx2(v, index2, keep2), 2));
+        v = _mm256_xor_si256(v, rotl_avx2(shift_lanes_avx2(v, index4, keep4), 4));
+
+        // Add the hash before pos, rotated once for every position since
+        h = _mm256_xor_si256(v, _mm256_or_si256(_mm256_sllv_epi32(h, carry_shl), _mm256_srlv_epi32(h, carry_shr)));
+
+        __m256i even = mod_even_avx2(h, magic_lo, magic_hi, discriminator);
+        __m256i odd = mod_even_avx2(_mm256_srli_epi64(h, 32), magic_lo, magic_hi, discriminator);
+        __m256i mod = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(mod, boundary)));
+        if (mask)
+        {
+            uint32_t lane = 0;
+            while ((mask & (1 << lane)) == 0)
+            {
+                ++lane;
+            }
+            *hash = (uint32_t)_mm256_cvtsi256_si32(_mm256_permutevar8x32_epi32(h, _mm256_set1_epi32((int)lane)));
+            return pos + lane + 1;
+        }
+        h = _mm256_permutevar8x32_epi32(h, last_lane);
+        pos += HPCDCSCAN_AVX2_LANES;
+    }
+    *hash = (uint32_t)_mm256_cvtsi256_si32(h);
+    return HPCDCScan_Scalar(params, buf, pos, end, hash);
+}
@@ -0,0 +1,78 @@
+#include "../longtail_hpcdcchunker_scan.h"
+
+#include <immintrin.h>
+
+#define HPCDCSCAN_AVX512_LANES 16u
+
+// value % discriminator for the even 32 bit lanes of value, the result is in the low
+// half of each 64 bit lane
+static inline __m512i mod_even_avx512(__m512i value, __m512i magic_lo, __m512i magic_hi, __m512i discriminator)
+{
+    __m512i lowbits = _mm512_add_epi64(
+        _mm512_mul_epu32(value, magic_lo),
+        _mm512_slli_epi64(_mm512_mul_epu32(value, magic_hi), 32));
+    __m512i low_product = _mm512_srli_epi64(_mm512_mul_epu32(lowbits, discriminator), 32);
+    __m512i high_product = _mm512_mul_epu32(_mm512_srli_epi64(lowbits, 32), discriminator);
+    return _mm512_srli_epi64(_mm512_add_epi64(high_product, low_product), 32);
+}
+
+uint32_t HPCDCScan_AVX512(
+    const struct HPCDCScanParams* params,
+    const uint8_t* buf,
+    uint32_t pos,
+    uint32_t end,
+    uint32_t* hash)
+{
+    const int* table = (const int*)params->table;
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i index1 = _mm512_sub_epi32(lanes, _mm512_set1_epi32(1));
+    const __m512i index2 = _mm512_sub_epi32(lanes, _mm512_set1_epi32(2));
+    const __m512i index4 = _mm512_sub_epi32(lanes, _mm512_set1_epi32(4));
+    const __m512i index8 = _mm512_sub_epi32(lanes, _mm512_set1_epi32(8));
+    const __m512i last_lane = _mm512_set1_epi32(HPCDCSCAN_AVX512_LANES - 1);
+    const __m512i carry = _mm512_add_epi32(lanes, _mm512_set1_epi32(1));
+    const __m512i magic_lo = _mm512_set1_epi64((long long)(params->mod_magic & 0xffffffffu));
+    const __m512i magic_hi = _mm512_set1_epi64((long long)(params->mod_magic >> 32));
+    const __m512i discriminator = _mm512_set1_epi64((long long)params->discriminator);
+    const __m512i boundary = _mm512_set1_epi32((int)(params->discriminator - 1));
+
+    __m512i h = _mm512_set1_epi32((int)*hash);
+    while (end - pos >= HPCDCSCAN_AVX512_LANES)
+    {
+        __m512i in = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)&buf[pos]));
+        __m512i out = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)&buf[pos - HPCDCScanWindowSize]));
+
+        // v[i] = rotl(table[out], W & 31) ^ table[in], the term each position adds
+        __m512i v = _mm512_xor_si512(
+            _mm512_rol_epi32(_mm512_i32gather_epi32(out, table, 4), (int)(HPCDCScanWindowSize & 31)),
+            _mm512_i32gather_epi32(in, table, 4));
+
+        // v[i] = xor of rotl(v[j], i - j) for j <= i
+        v = _mm512_xor_si512(v, _mm512_rol_epi32(_mm512_maskz_permutexvar_epi32((__mmask16)0xfffe, index1, v), 1));
+        v = _mm512_xor_si512(v, _mm512_rol_epi32(_mm512_maskz_permutexvar_epi32((__mmask16)0xfffc, index2, v), 2));
+        v = _mm512_xor_si512(v, _mm512_rol_epi32(_mm512_maskz_permutexvar_epi32((__mmask16)0xfff0, index4, v), 4));
+        v = _mm512_xor_si512(v, _mm512_rol_epi32(_mm512_maskz_permutexvar_epi32((__mmask16)0xff00, index8, v), 8));
+
+        // Add the hash before pos, rotated once for every position since
+        h = _mm512_xor_si512(v, _mm512_rolv_epi32(h, carry));
+
+        __m512i even = mod_even_avx512(h, magic_lo, magic_hi, discriminator);
+        __m512i odd = mod_even_avx512(_mm512_srli_epi64(h, 32), magic_lo, magic_hi, discriminator);
+        __m512i mod = _mm512_mask_blend_epi32((__mmask16)0xaaaa, even, _mm512_slli_epi64(odd, 32));
+        uint32_t mask = (uint32_t)_mm512_cmpeq_epi32_mask(mod, boundary);
+        if (mask)
+        {
+            uint32_t lane = 0;
+            while ((mask & (1u << lane)) == 0)
+            {
+                ++lane;
+            }
+            *hash = (uint32_t)_mm_cvtsi128_si32(_mm512_castsi512_si128(_mm512_permutexvar_epi32(_mm512_set1_epi32((int)lane), h)));
+            return pos + lane + 1;
+        }
+        h = _mm512_permutexvar_epi32(last_lane, h);
+        pos += HPCDCSCAN_AVX512_LANES;
+    }
+    *hash = (uint32_t)_mm_cvtsi128_si32(_mm512_castsi512_si128(h));
+    return HPCDCScan_Scalar(params, buf, pos, end, hash);
+}
@@ -0,0 +1,70 @@
+#include "../longtail_hpcdcchunker_scan.h"
+
+#include <immintrin.h>
+
+#define HPCDCSCAN_SSE41_LANES 4u
+
+static inline __m128i rotl_sse41(__m128i x, int r)
+{
+    return _mm_or_si128(_mm_slli_epi32(x, r), _mm_srli_epi32(x, 32 - r));
+}
+
+// value % discriminator for the even 32 bit lanes of value, the result is in the low
+// half of each 64 bit lane
+static inline __m128i mod_even_sse41(__m128i value, __m128i magic_lo, __m128i magic_hi, __m128i discriminator)
+{
+    __m128i lowbits = _mm_add_epi64(
+        _mm_mul_epu32(value, magic_lo),
+        _mm_slli_epi64(_mm_mul_epu32(value, magic_hi), 32));
+    __m128i low_product = _mm_srli_epi64(_mm_mul_epu32(lowbits, discriminator), 32);
+    __m128i high_product = _mm_mul_epu32(_mm_srli_epi64(lowbits, 32), discriminator);
+    return _mm_srli_epi64(_mm_add_epi64(high_product, low_product), 32);
+}
+
+uint32_t HPCDCScan_SSE41(
+    const struct HPCDCScanParams* params,
+    const uint8_t* buf,
+    uint32_t pos,
+    uint32_t end,
+    uint32_t* hash)
+{
+    const uint32_t* table = params->table;
+    const __m128i magic_lo = _mm_set1_epi64x((long long)(params->mod_magic & 0xffffffffu));
+    const __m128i magic_hi = _mm_set1_epi64x((long long)(params->mod_magic >> 32));
+    const __m128i discriminator = _mm_set1_epi64x((long long)params->discriminator);
+    const __m128i boundary = _mm_set1_epi32((int)(params->discriminator - 1));
+
+    uint32_t h = *hash;
+    while (end - pos >= HPCDCSCAN_SSE41_LANES)
+    {
+        const uint8_t* in = &buf[pos];
+        const uint8_t* out = &buf[pos - HPCDCScanWindowSize];
+
+        // There is no gather so the hashes are rolled in scalar code, only the
+        // modulo is vectorized
+        uint32_t h0 = HPCDCScan_rotl32(h, 1) ^ HPCDCScan_rotl32(table[out[0]], (int)(HPCDCScanWindowSize & 31)) ^ table[in[0]];
+        uint32_t h1 = HPCDCScan_rotl32(h0, 1) ^ HPCDCScan_rotl32(table[out[1]], (int)(HPCDCScanWindowSize & 31)) ^ table[in[1]];
+        uint32_t h2 = HPCDCScan_rotl32(h1, 1) ^ HPCDCScan_rotl32(table[out[2]], (int)(HPCDCScanWindowSize & 31)) ^ table[in[2]];
+        uint32_t h3 = HPCDCScan_rotl32(h2, 1) ^ HPCDCScan_rotl32(table[out[3]], (int)(HPCDCScanWindowSize & 31)) ^ table[in[3]];
+        __m128i hv = _mm_setr_epi32((int)h0, (int)h1, (int)h2, (int)h3);
+
+        __m128i even = mod_even_sse41(hv, magic_lo, magic_hi, discriminator);
+        __m128i odd = mod_even_sse41(_mm_srli_epi64(hv, 32), magic_lo, magic_hi, discriminator);
+        __m128i mod = _mm_blend_epi16(even, _mm_slli_epi64(odd, 32), 0xcc);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(mod, boundary)));
+        if (mask)
+        {
+            uint32_t lane = 0;
+            while ((mask & (1 << lane)) == 0)
+            {
+                ++lane;
+            }
+            *hash = lane == 0 ? h0 : lane == 1 ? h1 : lane == 2 ? h2 : h3;
+            return pos + lane + 1;
+        }
+        h = h3;
+        pos += HPCDCSCAN_SSE41_LANES;
+    }
+    *hash = h;
+    return HPCDCScan_Scalar(params, buf, pos, end, hash);
+}
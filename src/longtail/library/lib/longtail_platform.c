@@ -1,3 +1,8 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    // statx
+    #define _GNU_SOURCE
+#endif
+
 #include "longtail_platform.h"
 #include "../src/longtail.h"
 #include <stdint.h>
@@ -553,6 +558,21 @@ int Longtail_MoveFile(const char* source, const char* target)
     return Win32ErrorToErrno(GetLastError());
 }
 
+int Longtail_CopyFile(const char* source, const char* target)
+{
+    wchar_t* long_source_path = MakeLongPlatformPath(source);
+    wchar_t* long_target_path = MakeLongPlatformPath(target);
+    // CopyFileW clones the file on file systems with block cloning
+    BOOL ok = CopyFileW(long_source_path, long_target_path, FALSE);
+    Longtail_Free(long_source_path);
+    Longtail_Free(long_target_path);
+    if (ok)
+    {
+        return 0;
+    }
+    return Win32ErrorToErrno(GetLastError());
+}
+
 int Longtail_IsDir(const char* path)
 {
 #if defined(LONGTAIL_ASSERTS)
@@ -1001,6 +1021,11 @@ int Longtail_Write(HLongtail_OpenFile handle, uint64_t offset, uint64_t length,
     return 0;
 }
 
+int Longtail_StreamWritten(HLongtail_OpenFile handle, uint64_t offset, uint64_t length)
+{
+    return 0;
+}
+
 int Longtail_GetFileSize(HLongtail_OpenFile handle, uint64_t* out_size)
 {
     HANDLE h = (HANDLE)(handle);
@@ -1254,9 +1279,19 @@ void Longtail_UnmapFile(HLongtail_FileMap file_map)
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/file.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <pwd.h>
 
+#if defined(__linux__)
+    #include <sys/syscall.h>
+    #include <sys/ioctl.h>
+    #include <linux/fs.h>
+
+    // Streamed writes start writeback every window and wait for the window before
+    #define LONGTAIL_WRITEBACK_WINDOW_SIZE (8u * 1024u * 1024u)
+#endif
+
 uint32_t Longtail_GetCPUCount()
 {
    return (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
@@ -1772,6 +1807,96 @@ int Longtail_MoveFile(const char* source, const char* target)
     return errno;
 }
 
+#define LONGTAIL_COPY_BUFFER_SIZE (1024u * 1024u)
+
+int Longtail_CopyFile(const char* source, const char* target)
+{
+    int source_fd = open(source, O_RDONLY | O_CLOEXEC);
+    if (source_fd == -1)
+    {
+        return errno;
+    }
+    struct stat source_stat;
+    if (fstat(source_fd, &source_stat) != 0)
+    {
+        int e = errno;
+        close(source_fd);
+        return e;
+    }
+    int target_fd = open(target, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (target_fd == -1)
+    {
+        int e = errno;
+        close(source_fd);
+        return e;
+    }
+
+    int err = 0;
+    off_t copied = 0;
+#if defined(__linux__)
+#if defined(FICLONE)
+    // Shares the extents of the source on file systems with reflinks, such as btrfs and xfs
+    if (ioctl(target_fd, FICLONE, source_fd) == 0)
+    {
+        copied = source_stat.st_size;
+    }
+#endif // defined(FICLONE)
+    // Copies inside the kernel, or on the server for network file systems
+    while (copied < source_stat.st_size)
+    {
+        ssize_t length = copy_file_range(source_fd, 0, target_fd, 0, (size_t)(source_stat.st_size - copied), 0);
+        if (length <= 0)
+        {
+            if (length == -1 && copied == 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL))
+            {
+                break;
+            }
+            err = length == 0 ? EIO : errno;
+            break;
+        }
+        copied += length;
+    }
+#endif // defined(__linux__)
+
+    if (!err && copied < source_stat.st_size)
+    {
+        char* buffer = (char*)Longtail_Alloc("Longtail_CopyFile", LONGTAIL_COPY_BUFFER_SIZE);
+        if (!buffer)
+        {
+            err = ENOMEM;
+        }
+        while (!err && copied < source_stat.st_size)
+        {
+            ssize_t length = pread(source_fd, buffer, LONGTAIL_COPY_BUFFER_SIZE, copied);
+            if (length <= 0)
+            {
+                err = length == 0 ? EIO : errno;
+                break;
+            }
+            ssize_t written = 0;
+            while (written < length)
+            {
+                ssize_t w = pwrite(target_fd, &buffer[written], (size_t)(length - written), copied + written);
+                if (w < 0)
+                {
+                    err = errno;
+                    break;
+                }
+                written += w;
+            }
+            copied += length;
+        }
+        Longtail_Free(buffer);
+    }
+
+    if (close(target_fd) != 0 && !err)
+    {
+        err = errno;
+    }
+    close(source_fd);
+    return err;
+}
+
 int Longtail_IsDir(const char* path)
 {
 #if defined(LONGTAIL_ASSERTS)
@@ -1842,6 +1967,71 @@ int Longtail_RemoveFile(const char* path)
     return errno;
 }
 
+#if defined(__linux__)
+
+// Directories are read with getdents64 into a buffer owned by the iterator and
+// entries are stat'ed relative to the directory fd, skipping the path build
+// and lookup stat() would do for each entry.
+struct Longtail_Dirent64
+{
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+#define LONGTAIL_DIRENT_BUFFER_SIZE 32768
+
+struct Longtail_FSIterator_private
+{
+    char* m_DirPath;
+    int m_DirFd;
+    uint32_t m_BufferSize;
+    uint32_t m_BufferOffset;
+    struct Longtail_Dirent64* m_DirEntry;
+    uint64_t m_Buffer[LONGTAIL_DIRENT_BUFFER_SIZE / sizeof(uint64_t)];
+};
+
+static int OpenDir(HLongtail_FSIterator fs_iterator)
+{
+    fs_iterator->m_DirFd = open(fs_iterator->m_DirPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fs_iterator->m_DirFd == -1)
+    {
+        return errno;
+    }
+    fs_iterator->m_BufferSize = 0;
+    fs_iterator->m_BufferOffset = 0;
+    return 0;
+}
+
+static void CloseDir(HLongtail_FSIterator fs_iterator)
+{
+    close(fs_iterator->m_DirFd);
+    fs_iterator->m_DirFd = -1;
+}
+
+static struct Longtail_Dirent64* ReadDir(HLongtail_FSIterator fs_iterator)
+{
+    if (fs_iterator->m_BufferOffset == fs_iterator->m_BufferSize)
+    {
+        long res = syscall(SYS_getdents64, fs_iterator->m_DirFd, fs_iterator->m_Buffer, sizeof(fs_iterator->m_Buffer));
+        if (res <= 0)
+        {
+            fs_iterator->m_BufferSize = 0;
+            fs_iterator->m_BufferOffset = 0;
+            return 0;
+        }
+        fs_iterator->m_BufferSize = (uint32_t)res;
+        fs_iterator->m_BufferOffset = 0;
+    }
+    struct Longtail_Dirent64* entry = (struct Longtail_Dirent64*)&((char*)fs_iterator->m_Buffer)[fs_iterator->m_BufferOffset];
+    fs_iterator->m_BufferOffset += entry->d_reclen;
+    return entry;
+}
+
+#else
+
 struct Longtail_FSIterator_private
 {
     char* m_DirPath;
@@ -1849,6 +2039,30 @@ struct Longtail_FSIterator_private
     struct dirent * m_DirEntry;
 };
 
+static int OpenDir(HLongtail_FSIterator fs_iterator)
+{
+    fs_iterator->m_DirStream = opendir(fs_iterator->m_DirPath);
+    if (0 == fs_iterator->m_DirStream)
+    {
+        int e = errno;
+        return e ? e : ENOENT;
+    }
+    return 0;
+}
+
+static void CloseDir(HLongtail_FSIterator fs_iterator)
+{
+    closedir(fs_iterator->m_DirStream);
+    fs_iterator->m_DirStream = 0;
+}
+
+static struct dirent* ReadDir(HLongtail_FSIterator fs_iterator)
+{
+    return readdir(fs_iterator->m_DirStream);
+}
+
+#endif // defined(__linux__)
+
 size_t Longtail_GetFSIteratorSize()
 {
     return sizeof(struct Longtail_FSIterator_private);
@@ -1885,7 +2099,7 @@ static int Skip(HLongtail_FSIterator fs_iterator)
 {
     while (IsSkippableFile(fs_iterator))
     {
-        fs_iterator->m_DirEntry = readdir(fs_iterator->m_DirStream);
+        fs_iterator->m_DirEntry = ReadDir(fs_iterator);
         if (fs_iterator->m_DirEntry == 0)
         {
                 return ENOENT;
@@ -1909,23 +2123,17 @@ int Longtail_StartFind(HLongtail_FSIterator fs_iterator, const char* path)
         fs_iterator->m_DirPath = Longtail_Strdup(path);
     }
 
-    fs_iterator->m_DirStream = opendir(fs_iterator->m_DirPath);
-    if (0 == fs_iterator->m_DirStream)
+    int e = OpenDir(fs_iterator);
+    if (e)
     {
-        int e = errno;
         Longtail_Free(fs_iterator->m_DirPath);
-        if (e == 0)
-        {
-            return ENOENT;
-        }
         return e;
     }
 
-    fs_iterator->m_DirEntry = readdir(fs_iterator->m_DirStream);
+    fs_iterator->m_DirEntry = ReadDir(fs_iterator);
     if (fs_iterator->m_DirEntry == 0)
     {
-        closedir(fs_iterator->m_DirStream);
-        fs_iterator->m_DirStream = 0;
+        CloseDir(fs_iterator);
         Longtail_Free(fs_iterator->m_DirPath);
         fs_iterator->m_DirPath = 0;
         return ENOENT;
@@ -1933,8 +2141,7 @@ int Longtail_StartFind(HLongtail_FSIterator fs_iterator, const char* path)
     int err = Skip(fs_iterator);
     if (err)
     {
-        closedir(fs_iterator->m_DirStream);
-        fs_iterator->m_DirStream = 0;
+        CloseDir(fs_iterator);
         Longtail_Free(fs_iterator->m_DirPath);
         fs_iterator->m_DirPath = 0;
         return err;
@@ -1944,7 +2151,7 @@ int Longtail_StartFind(HLongtail_FSIterator fs_iterator, const char* path)
 
 int Longtail_FindNext(HLongtail_FSIterator fs_iterator)
 {
-    fs_iterator->m_DirEntry = readdir(fs_iterator->m_DirStream);
+    fs_iterator->m_DirEntry = ReadDir(fs_iterator);
     if (fs_iterator->m_DirEntry == 0)
     {
         return ENOENT;
@@ -1954,8 +2161,7 @@ int Longtail_FindNext(HLongtail_FSIterator fs_iterator)
 
 void Longtail_CloseFind(HLongtail_FSIterator fs_iterator)
 {
-    closedir(fs_iterator->m_DirStream);
-    fs_iterator->m_DirStream = 0;
+    CloseDir(fs_iterator);
     Longtail_Free(fs_iterator->m_DirPath);
     fs_iterator->m_DirPath = 0;
 }
@@ -1980,6 +2186,43 @@ const char* Longtail_GetDirectoryName(HLongtail_FSIterator fs_iterator)
 
 int Longtail_GetEntryProperties(HLongtail_FSIterator fs_iterator, uint64_t* out_size, uint16_t* out_permissions, int* out_is_dir)
 {
+#if defined(__linux__) && defined(STATX_TYPE)
+    struct statx statx_buf;
+    if (statx(fs_iterator->m_DirFd, fs_iterator->m_DirEntry->d_name, 0, STATX_TYPE | STATX_MODE | STATX_SIZE, &statx_buf) != 0)
+    {
+        return errno;
+    }
+    *out_permissions = (uint16_t)(statx_buf.stx_mode & 0x1FF);
+    if (S_ISDIR(statx_buf.stx_mode))
+    {
+        *out_is_dir = 1;
+        *out_size = 0;
+    }
+    else
+    {
+        *out_is_dir = 0;
+        *out_size = (uint64_t)statx_buf.stx_size;
+    }
+    return 0;
+#elif defined(__linux__)
+    struct stat stat_buf;
+    if (fstatat(fs_iterator->m_DirFd, fs_iterator->m_DirEntry->d_name, &stat_buf, 0) != 0)
+    {
+        return errno;
+    }
+    *out_permissions = (uint16_t)(stat_buf.st_mode & 0x1FF);
+    if (S_ISDIR(stat_buf.st_mode))
+    {
+        *out_is_dir = 1;
+        *out_size = 0;
+    }
+    else
+    {
+        *out_is_dir = 0;
+        *out_size = (uint64_t)stat_buf.st_size;
+    }
+    return 0;
+#else
     size_t dir_len = strlen(fs_iterator->m_DirPath);
     size_t file_len = strlen(fs_iterator->m_DirEntry->d_name);
     char* path = (char*)Longtail_Alloc("FSIterator", dir_len + 1 + file_len + 1);
@@ -2009,6 +2252,7 @@ int Longtail_GetEntryProperties(HLongtail_FSIterator fs_iterator, uint64_t* out_
     }
     Longtail_Free(path);
     return res;
+#endif // defined(__linux__) && defined(STATX_TYPE)
 }
 
 int Longtail_OpenReadFile(const char* path, HLongtail_OpenFile* out_read_file)
@@ -2032,7 +2276,17 @@ int Longtail_OpenWriteFile(const char* path, uint64_t initial_size, HLongtail_Op
     }
     if  (initial_size > 0)
     {
+#if defined(__linux__)
+        // Reserve all the blocks up front so large files are laid out contiguously instead
+        // of being allocated piecemeal as the writes come in
+        int err = fallocate(fileno(f), 0, 0, (off64_t)initial_size);
+        if (err != 0 && (errno == EOPNOTSUPP || errno == ENOSYS))
+        {
+            err = ftruncate64(fileno(f), (off64_t)initial_size);
+        }
+#else
         int err = ftruncate64(fileno(f), (off64_t)initial_size);
+#endif // defined(__linux__)
         if (err != 0)
         {
             int e = errno;
@@ -2100,6 +2354,32 @@ int Longtail_Write(HLongtail_OpenFile handle, uint64_t offset, uint64_t length,
     return 0;
 }
 
+int Longtail_StreamWritten(HLongtail_OpenFile handle, uint64_t offset, uint64_t length)
+{
+#if defined(__linux__)
+    // When a sequential write crosses into a new writeback window we start writeback of the
+    // windows it completed and wait for the window before it, which had its writeback started
+    // when it was completed. This streams dirty pages out at the rate we write them rather
+    // than in bursts that stall every writer. The caller does not read the range back right
+    // away so the pages that are on disk are dropped from the page cache.
+    int fd = fileno((FILE*)handle);
+    uint64_t first_window = offset / LONGTAIL_WRITEBACK_WINDOW_SIZE;
+    uint64_t last_window = (offset + length) / LONGTAIL_WRITEBACK_WINDOW_SIZE;
+    if (last_window > first_window)
+    {
+        uint64_t window_start = first_window * LONGTAIL_WRITEBACK_WINDOW_SIZE;
+        sync_file_range(fd, (off64_t)window_start, (off64_t)(last_window * LONGTAIL_WRITEBACK_WINDOW_SIZE - window_start), SYNC_FILE_RANGE_WRITE);
+        if (first_window > 0)
+        {
+            uint64_t previous_window_start = window_start - LONGTAIL_WRITEBACK_WINDOW_SIZE;
+            sync_file_range(fd, (off64_t)previous_window_start, LONGTAIL_WRITEBACK_WINDOW_SIZE, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+            posix_fadvise(fd, (off_t)previous_window_start, LONGTAIL_WRITEBACK_WINDOW_SIZE, POSIX_FADV_DONTNEED);
+        }
+    }
+#endif // defined(__linux__)
+    return 0;
+}
+
 int Longtail_GetFileSize(HLongtail_OpenFile handle, uint64_t* out_size)
 {
     FILE* f = (FILE*)handle;
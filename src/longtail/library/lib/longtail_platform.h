@@ -51,6 +51,7 @@ LONGTAIL_EXPORT size_t Longtail_GetFSIteratorSize();
 
 LONGTAIL_EXPORT int     Longtail_CreateDirectory(const char* path);
 LONGTAIL_EXPORT int     Longtail_MoveFile(const char* source, const char* target);
+LONGTAIL_EXPORT int     Longtail_CopyFile(const char* source, const char* target);
 LONGTAIL_EXPORT int     Longtail_IsDir(const char* path);
 LONGTAIL_EXPORT int     Longtail_IsFile(const char* path);
 LONGTAIL_EXPORT int     Longtail_RemoveDir(const char* path);
@@ -72,6 +73,7 @@ LONGTAIL_EXPORT int     Longtail_SetFilePermissions(const char* path, uint16_t p
 LONGTAIL_EXPORT int     Longtail_GetFilePermissions(const char* path, uint16_t* out_permissions);
 LONGTAIL_EXPORT int     Longtail_Read(HLongtail_OpenFile handle, uint64_t offset, uint64_t length, void* output);
 LONGTAIL_EXPORT int     Longtail_Write(HLongtail_OpenFile handle, uint64_t offset, uint64_t length, const void* input);
+LONGTAIL_EXPORT int     Longtail_StreamWritten(HLongtail_OpenFile handle, uint64_t offset, uint64_t length);
 LONGTAIL_EXPORT int     Longtail_GetFileSize(HLongtail_OpenFile handle, uint64_t* out_size);
 LONGTAIL_EXPORT void    Longtail_CloseFile(HLongtail_OpenFile handle);
 LONGTAIL_EXPORT char*   Longtail_ConcatPath(const char* folder, const char* file);
@@ -1,5 +1,7 @@
 #include "longtail_lz4.h"
 
+#include "../longtail_platform.h"
+#include "../../src/ext/stb_ds.h"
 #include "ext/lz4.h"
 
 #include <errno.h>
@@ -37,13 +39,44 @@ static int SettingsIDToCompressionSetting(uint32_t settings_id)
 struct LZ4CompressionAPI
 {
     struct Longtail_CompressionAPI m_LZ4CompressionAPI;
+    HLongtail_SpinLock m_Lock;
+    void** m_FreeStates;
 };
 
 void LZ4CompressionAPI_Dispose(struct Longtail_API* compression_api)
 {
+    struct LZ4CompressionAPI* api = (struct LZ4CompressionAPI*)compression_api;
+    size_t state_count = arrlen(api->m_FreeStates);
+    for (size_t s = 0; s < state_count; ++s)
+    {
+        Longtail_Free(api->m_FreeStates[s]);
+    }
+    arrfree(api->m_FreeStates);
+    Longtail_DeleteSpinLock(api->m_Lock);
+    Longtail_Free(api->m_Lock);
     Longtail_Free(compression_api);
 }
 
+// LZ4_compress_fast() sets up a fresh state on the stack for every call, reuse heap states instead
+static void* LZ4CompressionAPI_AcquireState(struct LZ4CompressionAPI* api)
+{
+    void* state = 0;
+    Longtail_LockSpinLock(api->m_Lock);
+    if (arrlen(api->m_FreeStates) > 0)
+    {
+        state = arrpop(api->m_FreeStates);
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+    return state ? state : Longtail_Alloc("LZ4CompressionAPI", (size_t)LZ4_sizeofState());
+}
+
+static void LZ4CompressionAPI_ReleaseState(struct LZ4CompressionAPI* api, void* state)
+{
+    Longtail_LockSpinLock(api->m_Lock);
+    arrput(api->m_FreeStates, state);
+    Longtail_UnlockSpinLock(api->m_Lock);
+}
+
 static size_t LZ4CompressionAPI_GetMaxCompressedSize(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, size_t size)
 {
     return (size_t)LZ4_COMPRESSBOUND((unsigned)size);
@@ -65,8 +98,17 @@ int LZ4CompressionAPI_Compress(struct Longtail_CompressionAPI* compression_api,
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
+    struct LZ4CompressionAPI* api = (struct LZ4CompressionAPI*)compression_api;
+    void* state = LZ4CompressionAPI_AcquireState(api);
+    if (!state)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM);
+        return ENOMEM;
+    }
+
     int compression_setting = SettingsIDToCompressionSetting(settings_id);
-    int compressed_size = LZ4_compress_fast(uncompressed, compressed, (int)uncompressed_size, (int)max_compressed_size, compression_setting);
+    int compressed_size = LZ4_compress_fast_extState(state, uncompressed, compressed, (int)uncompressed_size, (int)max_compressed_size, compression_setting);
+    LZ4CompressionAPI_ReleaseState(api, state);
     if (compressed_size == 0)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "LZ4_compress_fast() failed with %d", ENOMEM);
@@ -101,12 +143,26 @@ static int LZ4CompressionAPI_Decompress(struct Longtail_CompressionAPI* compress
     return 0;
 }
 
-static void LZ4CompressionAPI_Init(struct LZ4CompressionAPI* compression_api)
+static int LZ4CompressionAPI_Init(struct LZ4CompressionAPI* compression_api)
 {
     compression_api->m_LZ4CompressionAPI.m_API.Dispose = LZ4CompressionAPI_Dispose;
     compression_api->m_LZ4CompressionAPI.GetMaxCompressedSize = LZ4CompressionAPI_GetMaxCompressedSize;
     compression_api->m_LZ4CompressionAPI.Compress = LZ4CompressionAPI_Compress;
     compression_api->m_LZ4CompressionAPI.Decompress = LZ4CompressionAPI_Decompress;
+    compression_api->m_LZ4CompressionAPI.CompressWithWorkers = 0;
+    compression_api->m_FreeStates = 0;
+    void* lock_mem = Longtail_Alloc("LZ4CompressionAPI", Longtail_GetSpinLockSize());
+    if (!lock_mem)
+    {
+        return ENOMEM;
+    }
+    int err = Longtail_CreateSpinLock(lock_mem, &compression_api->m_Lock);
+    if (err)
+    {
+        Longtail_Free(lock_mem);
+        return err;
+    }
+    return 0;
 }
 
 struct Longtail_CompressionAPI* Longtail_CreateLZ4CompressionAPI()
@@ -118,6 +174,12 @@ struct Longtail_CompressionAPI* Longtail_CreateLZ4CompressionAPI()
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return 0;
     }
-    LZ4CompressionAPI_Init(compression_api);
+    int err = LZ4CompressionAPI_Init(compression_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "LZ4CompressionAPI_Init() failed with %d", err)
+        Longtail_Free(compression_api);
+        return 0;
+    }
     return &compression_api->m_LZ4CompressionAPI;
 }
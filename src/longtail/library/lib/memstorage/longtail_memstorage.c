@@ -325,6 +325,11 @@ static int InMemStorageAPI_OpenWriteFile(struct Longtail_StorageAPI* storage_api
     }
     arrsetcap(path_entry->m_Content, initial_size == 0 ? 16 : (uint32_t)initial_size);
     arrsetlen(path_entry->m_Content, (uint32_t)initial_size);
+    if (initial_size > 0)
+    {
+        // Like a file system we read zeros from ranges that have not been written
+        memset(path_entry->m_Content, 0, (size_t)initial_size);
+    }
     Longtail_UnlockSpinLock(instance->m_SpinLock);
     *out_open_file = (Longtail_StorageAPI_HOpenFile)(uintptr_t)path_hash;
     return 0;
@@ -358,13 +363,18 @@ static int InMemStorageAPI_Write(struct Longtail_StorageAPI* storage_api, Longta
         return EINVAL;
     }
     struct PathEntry* path_entry = &instance->m_PathEntries[instance->m_PathHashToContent[it].value];
-    ptrdiff_t size = arrlen(path_entry->m_Content);
+    ptrdiff_t old_size = arrlen(path_entry->m_Content);
+    ptrdiff_t size = old_size;
     if ((ptrdiff_t)(offset + length) > size)
     {
         size = offset + length;
     }
     arrsetcap(path_entry->m_Content, size == 0 ? 16 : (uint32_t)size);
     arrsetlen(path_entry->m_Content, (uint32_t)size);
+    if ((ptrdiff_t)offset > old_size)
+    {
+        memset(&(path_entry->m_Content)[old_size], 0, (size_t)(offset - old_size));
+    }
     memcpy(&(path_entry->m_Content)[offset], input, length);
     Longtail_UnlockSpinLock(instance->m_SpinLock);
     return 0;
@@ -395,7 +405,12 @@ static int InMemStorageAPI_SetSize(struct Longtail_StorageAPI* storage_api, Long
         return EINVAL;
     }
     struct PathEntry* path_entry = &instance->m_PathEntries[instance->m_PathHashToContent[it].value];
+    ptrdiff_t old_size = arrlen(path_entry->m_Content);
     arrsetlen(path_entry->m_Content, (uint32_t)length);
+    if ((ptrdiff_t)length > old_size)
+    {
+        memset(&(path_entry->m_Content)[old_size], 0, (size_t)(length - old_size));
+    }
     Longtail_UnlockSpinLock(instance->m_SpinLock);
     return 0;
 }
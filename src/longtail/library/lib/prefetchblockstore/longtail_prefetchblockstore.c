@@ -0,0 +1,618 @@
+#include "longtail_prefetchblockstore.h"
+
+#include "../../src/ext/stb_ds.h"
+#include "../longtail_platform.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+
+enum PrefetchBlockState
+{
+    PrefetchBlockState_Pending,
+    PrefetchBlockState_Fetching,
+    PrefetchBlockState_Ready,
+    PrefetchBlockState_Consumed
+};
+
+struct PrefetchBlock
+{
+    struct Longtail_StoredBlock* m_StoredBlock;
+    struct Longtail_AsyncGetStoredBlockAPI** m_WaitingAsyncCompleteAPIs;
+    uint64_t m_Size;
+    enum PrefetchBlockState m_State;
+};
+
+struct BlockHashToPrefetchBlock
+{
+    TLongtail_Hash key;
+    struct PrefetchBlock* value;
+};
+
+struct PrefetchBlockStoreAPI;
+
+struct PrefetchWorker
+{
+    struct Longtail_AsyncGetStoredBlockAPI m_AsyncCompleteAPI;
+    struct PrefetchBlockStoreAPI* m_PrefetchBlockStoreAPI;
+    HLongtail_Thread m_Thread;
+    HLongtail_Sema m_CompleteSema;
+    struct Longtail_StoredBlock* m_StoredBlock;
+    int m_Err;
+};
+
+struct PrefetchBlockStoreAPI
+{
+    struct Longtail_BlockStoreAPI m_BlockStoreAPI;
+    struct Longtail_BlockStoreAPI* m_BackingBlockStore;
+
+    TLongtail_Atomic64 m_StatU64[Longtail_BlockStoreAPI_StatU64_Count];
+
+    HLongtail_SpinLock m_Lock;
+    struct BlockHashToPrefetchBlock* m_BlockHashToPrefetchBlock;
+    TLongtail_Hash* m_PrefetchQueue;
+    size_t m_PrefetchQueueHead;
+    uint64_t m_PrefetchedSize;
+    uint64_t m_MaxPrefetchedSize;
+
+    HLongtail_Sema m_WorkSema;
+    uint32_t m_WorkerCount;
+    struct PrefetchWorker* m_Workers;
+    int32_t volatile m_Stop;
+};
+
+static uint64_t GetStoredBlockSize(const struct Longtail_StoredBlock* stored_block)
+{
+    return Longtail_GetBlockIndexDataSize(*stored_block->m_BlockIndex->m_ChunkCount) + stored_block->m_BlockChunksDataSize;
+}
+
+static int PrefetchBlockStore_PutStoredBlock(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StoredBlock* stored_block,
+    struct Longtail_AsyncPutStoredBlockAPI* async_complete_api)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(stored_block, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, stored_block, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+
+    struct PrefetchBlockStoreAPI* api = (struct PrefetchBlockStoreAPI*)block_store_api;
+
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_Count], 1);
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_Chunk_Count], *stored_block->m_BlockIndex->m_ChunkCount);
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_Byte_Count], GetStoredBlockSize(stored_block));
+
+    int err = api->m_BackingBlockStore->PutStoredBlock(
+        api->m_BackingBlockStore,
+        stored_block,
+        async_complete_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->PutStoredBlock() failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PutStoredBlock_FailCount], 1);
+    }
+    return err;
+}
+
+static int PrefetchBlockStore_PreflightGet(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint32_t block_count,
+    const TLongtail_Hash* block_hashes,
+    struct Longtail_AsyncPreflightStartedAPI* optional_async_complete_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_count, "%u"),
+        LONGTAIL_LOGFIELD(block_hashes, "%p"),
+        LONGTAIL_LOGFIELD(optional_async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (block_count == 0) || (block_hashes != 0), return EINVAL)
+
+    struct PrefetchBlockStoreAPI* api = (struct PrefetchBlockStoreAPI*)block_store_api;
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PreflightGet_Count], 1);
+
+    int err = api->m_BackingBlockStore->PreflightGet(
+        api->m_BackingBlockStore,
+        block_count,
+        block_hashes,
+        optional_async_complete_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->PreflightGet() failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_PreflightGet_FailCount], 1);
+        return err;
+    }
+
+    Longtail_LockSpinLock(api->m_Lock);
+    for (uint32_t b = 0; b < block_count; ++b)
+    {
+        TLongtail_Hash block_hash = block_hashes[b];
+        intptr_t find_ptr = hmgeti(api->m_BlockHashToPrefetchBlock, block_hash);
+        if (find_ptr != -1)
+        {
+            struct PrefetchBlock* block = api->m_BlockHashToPrefetchBlock[find_ptr].value;
+            if (block->m_State != PrefetchBlockState_Consumed)
+            {
+                continue;
+            }
+            block->m_State = PrefetchBlockState_Pending;
+        }
+        else
+        {
+            struct PrefetchBlock* block = (struct PrefetchBlock*)Longtail_Alloc("PrefetchBlockStore", sizeof(struct PrefetchBlock));
+            if (!block)
+            {
+                // Prefetching is only an optimization, the blocks not queued are fetched when asked for
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Longtail_Alloc() failed with %d", ENOMEM)
+                break;
+            }
+            block->m_StoredBlock = 0;
+            block->m_WaitingAsyncCompleteAPIs = 0;
+            block->m_Size = 0;
+            block->m_State = PrefetchBlockState_Pending;
+            hmput(api->m_BlockHashToPrefetchBlock, block_hash, block);
+        }
+        arrput(api->m_PrefetchQueue, block_hash);
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+
+    Longtail_PostSema(api->m_WorkSema, api->m_WorkerCount);
+    return 0;
+}
+
+static void PrefetchWorker_OnComplete(struct Longtail_AsyncGetStoredBlockAPI* async_complete_api, struct Longtail_StoredBlock* stored_block, int err)
+{
+    struct PrefetchWorker* worker = (struct PrefetchWorker*)async_complete_api;
+    worker->m_StoredBlock = stored_block;
+    worker->m_Err = err;
+    Longtail_PostSema(worker->m_CompleteSema, 1);
+}
+
+// Gets the block from the backing store for a request that prefetching could not serve
+static void PrefetchBlockStore_ForwardGet(
+    struct PrefetchBlockStoreAPI* api,
+    TLongtail_Hash block_hash,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+    int err = api->m_BackingBlockStore->GetStoredBlock(api->m_BackingBlockStore, block_hash, async_complete_api);
+    if (err)
+    {
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
+        async_complete_api->OnComplete(async_complete_api, 0, err);
+    }
+}
+
+static int PrefetchBlockStore_WorkerExecute(void* context)
+{
+    struct PrefetchWorker* worker = (struct PrefetchWorker*)context;
+    struct PrefetchBlockStoreAPI* api = worker->m_PrefetchBlockStoreAPI;
+    while (api->m_Stop == 0)
+    {
+        TLongtail_Hash block_hash = 0;
+        struct PrefetchBlock* block = 0;
+        Longtail_LockSpinLock(api->m_Lock);
+        while (api->m_PrefetchQueueHead < (size_t)arrlen(api->m_PrefetchQueue) && api->m_PrefetchedSize < api->m_MaxPrefetchedSize)
+        {
+            block_hash = api->m_PrefetchQueue[api->m_PrefetchQueueHead++];
+            struct PrefetchBlock* candidate = hmget(api->m_BlockHashToPrefetchBlock, block_hash);
+            if (candidate->m_State == PrefetchBlockState_Pending)
+            {
+                candidate->m_State = PrefetchBlockState_Fetching;
+                block = candidate;
+                break;
+            }
+        }
+        Longtail_UnlockSpinLock(api->m_Lock);
+
+        if (!block)
+        {
+            Longtail_WaitSema(api->m_WorkSema, LONGTAIL_TIMEOUT_INFINITE);
+            continue;
+        }
+
+        worker->m_StoredBlock = 0;
+        worker->m_Err = 0;
+        int err = api->m_BackingBlockStore->GetStoredBlock(api->m_BackingBlockStore, block_hash, &worker->m_AsyncCompleteAPI);
+        if (err)
+        {
+            worker->m_Err = err;
+        }
+        else
+        {
+            Longtail_WaitSema(worker->m_CompleteSema, LONGTAIL_TIMEOUT_INFINITE);
+        }
+
+        struct Longtail_StoredBlock* stored_block = worker->m_StoredBlock;
+        Longtail_LockSpinLock(api->m_Lock);
+        struct Longtail_AsyncGetStoredBlockAPI** waiting = block->m_WaitingAsyncCompleteAPIs;
+        block->m_WaitingAsyncCompleteAPIs = 0;
+        if (worker->m_Err == 0 && arrlen(waiting) == 0)
+        {
+            block->m_StoredBlock = stored_block;
+            block->m_Size = GetStoredBlockSize(stored_block);
+            block->m_State = PrefetchBlockState_Ready;
+            api->m_PrefetchedSize += block->m_Size;
+        }
+        else
+        {
+            block->m_State = PrefetchBlockState_Consumed;
+        }
+        Longtail_UnlockSpinLock(api->m_Lock);
+
+        // Requests that waited for the fetch are completed on this worker, if the prefetch failed
+        // they get the block from the backing store themselves
+        size_t wait_count = arrlen(waiting);
+        size_t forward_start = 0;
+        if (worker->m_Err == 0 && wait_count > 0)
+        {
+            Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count], *stored_block->m_BlockIndex->m_ChunkCount);
+            Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Byte_Count], GetStoredBlockSize(stored_block));
+            waiting[0]->OnComplete(waiting[0], stored_block, 0);
+            forward_start = 1;
+        }
+        for (size_t w = forward_start; w < wait_count; ++w)
+        {
+            PrefetchBlockStore_ForwardGet(api, block_hash, waiting[w]);
+        }
+        arrfree(waiting);
+    }
+    return 0;
+}
+
+static int PrefetchBlockStore_GetStoredBlock(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint64_t block_hash,
+    struct Longtail_AsyncGetStoredBlockAPI* async_complete_api)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_hash, "%" PRIx64),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api->OnComplete, return EINVAL)
+
+    struct PrefetchBlockStoreAPI* api = (struct PrefetchBlockStoreAPI*)block_store_api;
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Count], 1);
+
+    Longtail_LockSpinLock(api->m_Lock);
+    intptr_t find_ptr = hmgeti(api->m_BlockHashToPrefetchBlock, block_hash);
+    if (find_ptr != -1)
+    {
+        struct PrefetchBlock* block = api->m_BlockHashToPrefetchBlock[find_ptr].value;
+        if (block->m_State == PrefetchBlockState_Ready)
+        {
+            struct Longtail_StoredBlock* stored_block = block->m_StoredBlock;
+            block->m_StoredBlock = 0;
+            block->m_State = PrefetchBlockState_Consumed;
+            api->m_PrefetchedSize -= block->m_Size;
+            Longtail_UnlockSpinLock(api->m_Lock);
+            // The freed room lets a worker start on the next block
+            Longtail_PostSema(api->m_WorkSema, 1);
+            Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Chunk_Count], *stored_block->m_BlockIndex->m_ChunkCount);
+            Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_Byte_Count], GetStoredBlockSize(stored_block));
+            async_complete_api->OnComplete(async_complete_api, stored_block, 0);
+            return 0;
+        }
+        if (block->m_State == PrefetchBlockState_Fetching)
+        {
+            arrput(block->m_WaitingAsyncCompleteAPIs, async_complete_api);
+            Longtail_UnlockSpinLock(api->m_Lock);
+            return 0;
+        }
+        // Fetched on demand below, the workers skip it when they get to it
+        block->m_State = PrefetchBlockState_Consumed;
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+
+    int err = api->m_BackingBlockStore->GetStoredBlock(api->m_BackingBlockStore, block_hash, async_complete_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, err == ENOENT ? LONGTAIL_LOG_LEVEL_INFO : LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->GetStoredBlock() failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStoredBlock_FailCount], 1);
+    }
+    return err;
+}
+
+static int PrefetchBlockStore_GetExistingContent(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    uint32_t min_block_usage_percent,
+    struct Longtail_AsyncGetExistingContentAPI* async_complete_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(min_block_usage_percent, "%u"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (chunk_count == 0) || (chunk_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+
+    struct PrefetchBlockStoreAPI* api = (struct PrefetchBlockStoreAPI*)block_store_api;
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetExistingContent_Count], 1);
+    int err = api->m_BackingBlockStore->GetExistingContent(
+        api->m_BackingBlockStore,
+        chunk_count,
+        chunk_hashes,
+        min_block_usage_percent,
+        async_complete_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->GetExistingContent() failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetExistingContent_FailCount], 1);
+    }
+    return err;
+}
+
+static int PrefetchBlockStore_PruneBlocks(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    uint32_t block_keep_count,
+    const TLongtail_Hash* block_keep_hashes,
+    struct Longtail_AsyncPruneBlocksAPI* async_complete_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(block_keep_count, "%u"),
+        LONGTAIL_LOGFIELD(block_keep_hashes, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (block_keep_count == 0) || (block_keep_hashes != 0), return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+
+    return ENOTSUP;
+}
+
+static int PrefetchBlockStore_GetStats(struct Longtail_BlockStoreAPI* block_store_api, struct Longtail_BlockStore_Stats* out_stats)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(out_stats, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_stats, return EINVAL)
+    struct PrefetchBlockStoreAPI* api = (struct PrefetchBlockStoreAPI*)block_store_api;
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_GetStats_Count], 1);
+    memset(out_stats, 0, sizeof(struct Longtail_BlockStore_Stats));
+    for (uint32_t s = 0; s < Longtail_BlockStoreAPI_StatU64_Count; ++s)
+    {
+        out_stats->m_StatU64[s] = api->m_StatU64[s];
+    }
+    return 0;
+}
+
+static int PrefetchBlockStore_Flush(struct Longtail_BlockStoreAPI* block_store_api, struct Longtail_AsyncFlushAPI* async_complete_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(async_complete_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, block_store_api, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, async_complete_api, return EINVAL)
+
+    struct PrefetchBlockStoreAPI* api = (struct PrefetchBlockStoreAPI*)block_store_api;
+    Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_Flush_Count], 1);
+    int err = api->m_BackingBlockStore->Flush(api->m_BackingBlockStore, async_complete_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "api->m_BackingBlockStore->Flush() failed with %d", err)
+        Longtail_AtomicAdd64(&api->m_StatU64[Longtail_BlockStoreAPI_StatU64_Flush_FailCount], 1);
+    }
+    return err;
+}
+
+static void PrefetchBlockStore_StopWorkers(struct PrefetchBlockStoreAPI* api)
+{
+    api->m_Stop = 1;
+    Longtail_PostSema(api->m_WorkSema, api->m_WorkerCount);
+    for (uint32_t t = 0; t < api->m_WorkerCount; ++t)
+    {
+        struct PrefetchWorker* worker = &api->m_Workers[t];
+        Longtail_JoinThread(worker->m_Thread, LONGTAIL_TIMEOUT_INFINITE);
+        Longtail_DeleteThread(worker->m_Thread);
+        Longtail_Free(worker->m_Thread);
+        Longtail_DeleteSema(worker->m_CompleteSema);
+        Longtail_Free(worker->m_CompleteSema);
+    }
+    api->m_WorkerCount = 0;
+}
+
+static void PrefetchBlockStore_Dispose(struct Longtail_API* base_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(base_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, base_api, return)
+
+    struct PrefetchBlockStoreAPI* api = (struct PrefetchBlockStoreAPI*)base_api;
+    PrefetchBlockStore_StopWorkers(api);
+    size_t block_count = hmlen(api->m_BlockHashToPrefetchBlock);
+    for (size_t b = 0; b < block_count; ++b)
+    {
+        struct PrefetchBlock* block = api->m_BlockHashToPrefetchBlock[b].value;
+        LONGTAIL_FATAL_ASSERT(ctx, arrlen(block->m_WaitingAsyncCompleteAPIs) == 0, return)
+        if (block->m_StoredBlock && block->m_StoredBlock->Dispose)
+        {
+            block->m_StoredBlock->Dispose(block->m_StoredBlock);
+        }
+        Longtail_Free(block);
+    }
+    hmfree(api->m_BlockHashToPrefetchBlock);
+    arrfree(api->m_PrefetchQueue);
+    Longtail_DeleteSema(api->m_WorkSema);
+    Longtail_Free(api->m_WorkSema);
+    Longtail_DeleteSpinLock(api->m_Lock);
+    Longtail_Free(api->m_Lock);
+    Longtail_Free(api);
+}
+
+static int PrefetchBlockStore_Init(
+    void* mem,
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    uint32_t worker_count,
+    uint64_t max_prefetched_size,
+    struct Longtail_BlockStoreAPI** out_block_store_api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(mem, "%p"),
+        LONGTAIL_LOGFIELD(backing_block_store, "%p"),
+        LONGTAIL_LOGFIELD(worker_count, "%u"),
+        LONGTAIL_LOGFIELD(max_prefetched_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(out_block_store_api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_FATAL_ASSERT(ctx, mem, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, backing_block_store, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, out_block_store_api, return EINVAL)
+
+    struct Longtail_BlockStoreAPI* block_store_api = Longtail_MakeBlockStoreAPI(
+        mem,
+        PrefetchBlockStore_Dispose,
+        PrefetchBlockStore_PutStoredBlock,
+        PrefetchBlockStore_PreflightGet,
+        PrefetchBlockStore_GetStoredBlock,
+        PrefetchBlockStore_GetExistingContent,
+        PrefetchBlockStore_PruneBlocks,
+        PrefetchBlockStore_GetStats,
+        PrefetchBlockStore_Flush);
+    if (!block_store_api)
+    {
+        return EINVAL;
+    }
+
+    struct PrefetchBlockStoreAPI* api = (struct PrefetchBlockStoreAPI*)block_store_api;
+    api->m_BackingBlockStore = backing_block_store;
+    api->m_BlockHashToPrefetchBlock = 0;
+    api->m_PrefetchQueue = 0;
+    api->m_PrefetchQueueHead = 0;
+    api->m_PrefetchedSize = 0;
+    api->m_MaxPrefetchedSize = max_prefetched_size;
+    api->m_WorkerCount = 0;
+    // Workers live in the same allocation as the api, see Longtail_CreatePrefetchBlockStoreAPI
+    api->m_Workers = (struct PrefetchWorker*)&api[1];
+    api->m_Stop = 0;
+
+    for (uint32_t s = 0; s < Longtail_BlockStoreAPI_StatU64_Count; ++s)
+    {
+        api->m_StatU64[s] = 0;
+    }
+
+    int err = Longtail_CreateSpinLock(Longtail_Alloc("PrefetchBlockStore", Longtail_GetSpinLockSize()), &api->m_Lock);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateSpinLock() failed with %d", err)
+        return err;
+    }
+    err = Longtail_CreateSema(Longtail_Alloc("PrefetchBlockStore", Longtail_GetSemaSize()), 0, &api->m_WorkSema);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateSema() failed with %d", err)
+        Longtail_DeleteSpinLock(api->m_Lock);
+        Longtail_Free(api->m_Lock);
+        return err;
+    }
+
+    for (uint32_t t = 0; t < worker_count; ++t)
+    {
+        struct PrefetchWorker* worker = &api->m_Workers[t];
+        worker->m_AsyncCompleteAPI.m_API.Dispose = 0;
+        worker->m_AsyncCompleteAPI.OnComplete = PrefetchWorker_OnComplete;
+        worker->m_PrefetchBlockStoreAPI = api;
+        worker->m_StoredBlock = 0;
+        worker->m_Err = 0;
+        err = Longtail_CreateSema(Longtail_Alloc("PrefetchBlockStore", Longtail_GetSemaSize()), 0, &worker->m_CompleteSema);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateSema() failed with %d", err)
+            PrefetchBlockStore_StopWorkers(api);
+            Longtail_DeleteSema(api->m_WorkSema);
+            Longtail_Free(api->m_WorkSema);
+            Longtail_DeleteSpinLock(api->m_Lock);
+            Longtail_Free(api->m_Lock);
+            return err;
+        }
+        void* thread_mem = Longtail_Alloc("PrefetchBlockStore", Longtail_GetThreadSize());
+        err = Longtail_CreateThread(thread_mem, PrefetchBlockStore_WorkerExecute, 0, worker, 0, &worker->m_Thread);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateThread() failed with %d", err)
+            Longtail_Free(thread_mem);
+            Longtail_DeleteSema(worker->m_CompleteSema);
+            Longtail_Free(worker->m_CompleteSema);
+            PrefetchBlockStore_StopWorkers(api);
+            Longtail_DeleteSema(api->m_WorkSema);
+            Longtail_Free(api->m_WorkSema);
+            Longtail_DeleteSpinLock(api->m_Lock);
+            Longtail_Free(api->m_Lock);
+            return err;
+        }
+        api->m_WorkerCount = t + 1;
+    }
+
+    *out_block_store_api = block_store_api;
+    return 0;
+}
+
+struct Longtail_BlockStoreAPI* Longtail_CreatePrefetchBlockStoreAPI(
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    uint32_t worker_count,
+    uint64_t max_prefetched_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(backing_block_store, "%p"),
+        LONGTAIL_LOGFIELD(worker_count, "%u"),
+        LONGTAIL_LOGFIELD(max_prefetched_size, "%" PRIu64)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, backing_block_store, return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, worker_count > 0, return 0)
+
+    size_t api_size = sizeof(struct PrefetchBlockStoreAPI) +
+        sizeof(struct PrefetchWorker) * worker_count;
+    void* mem = Longtail_Alloc("PrefetchBlockStore", api_size);
+    if (!mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return 0;
+    }
+    struct Longtail_BlockStoreAPI* block_store_api;
+    int err = PrefetchBlockStore_Init(
+        mem,
+        backing_block_store,
+        worker_count,
+        max_prefetched_size,
+        &block_store_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "PrefetchBlockStore_Init() failed with %d", err)
+        Longtail_Free(mem);
+        return 0;
+    }
+    return block_store_api;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../../src/longtail.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Gets the blocks passed to PreflightGet from the backing block store on worker_count dedicated
+// threads, in the order they were preflighted, and holds them until GetStoredBlock asks for them.
+// Workers stop starting new gets while the held blocks add up to max_prefetched_size or more.
+// Blocks asked for that are not held or being fetched are forwarded to the backing block store,
+// a held block is handed out once, asking for it again gets it from the backing block store.
+LONGTAIL_EXPORT extern struct Longtail_BlockStoreAPI* Longtail_CreatePrefetchBlockStoreAPI(
+    struct Longtail_BlockStoreAPI* backing_block_store,
+    uint32_t worker_count,
+    uint64_t max_prefetched_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,85 @@
+#include "longtail_xxhash.h"
+
+#include <errno.h>
+
+#define XXH_INLINE_ALL
+#include "ext/xxhash.h"
+
+const uint32_t LONGTAIL_XXH3_HASH_TYPE = (((uint32_t)'x') << 24) + (((uint32_t)'x') << 16) + (((uint32_t)'h') << 8) + ((uint32_t)'3');
+const uint32_t Longtail_GetXXH3HashType() { return LONGTAIL_XXH3_HASH_TYPE; }
+
+// XXH3_state_t must be 64 byte aligned, the allocation is stored in front of the aligned state
+#define XXH3_STATE_ALIGNMENT 64
+
+static uint32_t XXH3Hash_GetIdentifier(struct Longtail_HashAPI* hash_api)
+{
+    return LONGTAIL_XXH3_HASH_TYPE;
+}
+
+struct XXH3HashAPI
+{
+    struct Longtail_HashAPI m_XXH3HashAPI;
+};
+
+static int XXH3Hash_BeginContext(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext* out_context)
+{
+    void* mem = Longtail_Alloc("XXH3HashAPI", sizeof(void*) + XXH3_STATE_ALIGNMENT + sizeof(XXH3_state_t));
+    if (!mem)
+    {
+        return ENOMEM;
+    }
+    uintptr_t aligned = ((uintptr_t)mem + sizeof(void*) + (XXH3_STATE_ALIGNMENT - 1)) & ~((uintptr_t)XXH3_STATE_ALIGNMENT - 1);
+    XXH3_state_t* state = (XXH3_state_t*)aligned;
+    ((void**)state)[-1] = mem;
+    XXH3_128bits_reset(state);
+    *out_context = (Longtail_HashAPI_HContext)state;
+    return 0;
+}
+
+static void XXH3Hash_Hash(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context, uint32_t length, const void* data)
+{
+    XXH3_state_t* state = (XXH3_state_t*)context;
+    XXH3_128bits_update(state, data, length);
+}
+
+static uint64_t XXH3Hash_EndContext(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context)
+{
+    XXH3_state_t* state = (XXH3_state_t*)context;
+    XXH128_hash_t hash = XXH3_128bits_digest(state);
+    Longtail_Free(((void**)state)[-1]);
+    return (uint64_t)hash.low64;
+}
+
+static int XXH3Hash_HashBuffer(struct Longtail_HashAPI* hash_api, uint32_t length, const void* data, uint64_t* out_hash)
+{
+    XXH128_hash_t hash = XXH3_128bits(data, length);
+    *out_hash = (uint64_t)hash.low64;
+    return 0;
+}
+
+static void XXH3Hash_Dispose(struct Longtail_API* hash_api)
+{
+    Longtail_Free(hash_api);
+}
+
+static void XXH3Hash_Init(struct XXH3HashAPI* hash_api)
+{
+    hash_api->m_XXH3HashAPI.m_API.Dispose = XXH3Hash_Dispose;
+    hash_api->m_XXH3HashAPI.GetIdentifier = XXH3Hash_GetIdentifier;
+    hash_api->m_XXH3HashAPI.BeginContext = XXH3Hash_BeginContext;
+    hash_api->m_XXH3HashAPI.Hash = XXH3Hash_Hash;
+    hash_api->m_XXH3HashAPI.EndContext = XXH3Hash_EndContext;
+    hash_api->m_XXH3HashAPI.HashBuffer = XXH3Hash_HashBuffer;
+    hash_api->m_XXH3HashAPI.HashBuffers = 0;
+}
+
+struct Longtail_HashAPI* Longtail_CreateXXH3HashAPI()
+{
+    struct XXH3HashAPI* xxh3_hash = (struct XXH3HashAPI*)Longtail_Alloc("XXH3HashAPI", sizeof(struct XXH3HashAPI));
+    if (!xxh3_hash)
+    {
+        return 0;
+    }
+    XXH3Hash_Init(xxh3_hash);
+    return &xxh3_hash->m_XXH3HashAPI;
+}
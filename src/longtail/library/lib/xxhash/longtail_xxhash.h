@@ -0,0 +1,15 @@
+#pragma once
+
+#include "../../src/longtail.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// XXH3 128-bit, the hash is the low 64 bits. Not a cryptographic hash, use it for trusted content only
+LONGTAIL_EXPORT extern struct Longtail_HashAPI* Longtail_CreateXXH3HashAPI();
+LONGTAIL_EXPORT extern const uint32_t Longtail_GetXXH3HashType();
+
+#ifdef __cplusplus
+}
+#endif
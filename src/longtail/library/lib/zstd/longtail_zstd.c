@@ -1,11 +1,16 @@
 #include "longtail_zstd.h"
 
+#include "../longtail_platform.h"
+#include "../compressionregistry/longtail_compression_registry.h"
+#include "../../src/ext/stb_ds.h"
 #include "ext/zstd.h"
 #include "ext/zstd_errors.h"
+#include "ext/zdict.h"
 #include "ext/compress/clevels.h"
 
 #include <errno.h>
 #include <inttypes.h>
+#include <string.h>
 
 
 const int LONGTAIL_ZSTD_MIN_COMPRESSION_LEVEL      = 0;
@@ -21,6 +26,16 @@ const int LONGTAIL_ZSTD_MAX_COMPRESSION_LEVEL      = ZSTD_MAX_CLEVEL;
 #define LONGTAIL_ZSTD_HIGH_COMPRESSION_TYPE    (LONGTAIL_ZSTD_COMPRESSION_TYPE + ((uint32_t)'4'))
 #define LONGTAIL_ZSTD_LOW_COMPRESSION_TYPE     (LONGTAIL_ZSTD_COMPRESSION_TYPE + ((uint32_t)'5'))
 
+// 'Z', 16 bit dictionary id, zstd quality character
+#define LONGTAIL_ZSTD_DICTIONARY_COMPRESSION_TYPE  (((uint32_t)'Z') << 24)
+#define LONGTAIL_ZSTD_MIN_DICTIONARY_ID            32768u
+#define LONGTAIL_ZSTD_MAX_DICTIONARY_ID            65535u
+#define LONGTAIL_ZSTD_QUALITY_COUNT                5
+
+// Data at least this large is compressed in LONGTAIL_ZSTD_MT_JOB_SIZE jobs on zstd worker threads
+#define LONGTAIL_ZSTD_MT_MIN_SIZE                  (2u * 1024u * 1024u)
+#define LONGTAIL_ZSTD_MT_JOB_SIZE                  (1u * 1024u * 1024u)
+
 uint32_t Longtail_GetZStdMinQuality() { return LONGTAIL_ZSTD_MIN_COMPRESSION_TYPE; }
 uint32_t Longtail_GetZStdDefaultQuality() { return LONGTAIL_ZSTD_DEFAULT_COMPRESSION_TYPE; }
 uint32_t Longtail_GetZStdMaxQuality() { return LONGTAIL_ZSTD_MAX_COMPRESSION_TYPE; }
@@ -40,6 +55,34 @@ struct Longtail_CompressionAPI* Longtail_CompressionRegistry_CreateForZstd(uint3
     return Longtail_CreateZStdCompressionAPI();
 }
 
+static int IsZStdQuality(uint32_t quality)
+{
+    return quality >= (uint32_t)'1' && quality < (uint32_t)'1' + LONGTAIL_ZSTD_QUALITY_COUNT;
+}
+
+uint32_t Longtail_GetZStdDictionaryCompressionType(uint32_t dictionary_id, uint32_t zstd_compression_type)
+{
+    return LONGTAIL_ZSTD_DICTIONARY_COMPRESSION_TYPE | ((dictionary_id & 0xffffu) << 8) | (zstd_compression_type & 0xffu);
+}
+
+uint32_t Longtail_GetZStdDictionaryCompressionTypeQuality(uint32_t compression_type)
+{
+    if ((compression_type & 0xff000000) != LONGTAIL_ZSTD_DICTIONARY_COMPRESSION_TYPE || !IsZStdQuality(compression_type & 0xffu))
+    {
+        return 0;
+    }
+    return LONGTAIL_ZSTD_COMPRESSION_TYPE + (compression_type & 0xffu);
+}
+
+uint32_t Longtail_GetZStdDictionaryCompressionTypeID(uint32_t compression_type)
+{
+    if (Longtail_GetZStdDictionaryCompressionTypeQuality(compression_type) == 0)
+    {
+        return 0;
+    }
+    return (compression_type >> 8) & 0xffffu;
+}
+
 static int SettingsIDToCompressionSetting(uint32_t settings_id)
 {
     switch(settings_id)
@@ -62,24 +105,110 @@ static int SettingsIDToCompressionSetting(uint32_t settings_id)
 struct ZStdCompressionAPI
 {
     struct Longtail_CompressionAPI m_ZStdCompressionAPI;
+    HLongtail_SpinLock m_Lock;
+    ZSTD_CCtx** m_FreeCCtxs;
+    ZSTD_DCtx** m_FreeDCtxs;
 };
 
 void ZStdCompressionAPI_Dispose(struct Longtail_API* compression_api)
 {
+    struct ZStdCompressionAPI* api = (struct ZStdCompressionAPI*)compression_api;
+    size_t cctx_count = arrlen(api->m_FreeCCtxs);
+    for (size_t c = 0; c < cctx_count; ++c)
+    {
+        ZSTD_freeCCtx(api->m_FreeCCtxs[c]);
+    }
+    arrfree(api->m_FreeCCtxs);
+    size_t dctx_count = arrlen(api->m_FreeDCtxs);
+    for (size_t d = 0; d < dctx_count; ++d)
+    {
+        ZSTD_freeDCtx(api->m_FreeDCtxs[d]);
+    }
+    arrfree(api->m_FreeDCtxs);
+    Longtail_DeleteSpinLock(api->m_Lock);
+    Longtail_Free(api->m_Lock);
     Longtail_Free(compression_api);
 }
 
+// Contexts are expensive to set up (window and hash tables), so they are kept in a
+// free list and reused - the list grows to the number of threads compressing concurrently
+static ZSTD_CCtx* ZStdCompressionAPI_AcquireCCtx(struct ZStdCompressionAPI* api)
+{
+    ZSTD_CCtx* cctx = 0;
+    Longtail_LockSpinLock(api->m_Lock);
+    if (arrlen(api->m_FreeCCtxs) > 0)
+    {
+        cctx = arrpop(api->m_FreeCCtxs);
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+    return cctx ? cctx : ZSTD_createCCtx();
+}
+
+static void ZStdCompressionAPI_ReleaseCCtx(struct ZStdCompressionAPI* api, ZSTD_CCtx* cctx)
+{
+    Longtail_LockSpinLock(api->m_Lock);
+    arrput(api->m_FreeCCtxs, cctx);
+    Longtail_UnlockSpinLock(api->m_Lock);
+}
+
+static ZSTD_DCtx* ZStdCompressionAPI_AcquireDCtx(struct ZStdCompressionAPI* api)
+{
+    ZSTD_DCtx* dctx = 0;
+    Longtail_LockSpinLock(api->m_Lock);
+    if (arrlen(api->m_FreeDCtxs) > 0)
+    {
+        dctx = arrpop(api->m_FreeDCtxs);
+    }
+    Longtail_UnlockSpinLock(api->m_Lock);
+    return dctx ? dctx : ZSTD_createDCtx();
+}
+
+static void ZStdCompressionAPI_ReleaseDCtx(struct ZStdCompressionAPI* api, ZSTD_DCtx* dctx)
+{
+    Longtail_LockSpinLock(api->m_Lock);
+    arrput(api->m_FreeDCtxs, dctx);
+    Longtail_UnlockSpinLock(api->m_Lock);
+}
+
+static size_t ZStdCompressionAPI_CompressMT(ZSTD_CCtx* cctx, int compression_setting, uint32_t worker_count, const char* uncompressed, char* compressed, size_t uncompressed_size, size_t max_compressed_size)
+{
+    size_t job_size = uncompressed_size / worker_count;
+    job_size = job_size < LONGTAIL_ZSTD_MT_JOB_SIZE ? LONGTAIL_ZSTD_MT_JOB_SIZE : job_size;
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+    size_t res = ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, compression_setting);
+    if (!ZSTD_isError(res))
+    {
+        res = ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, (int)worker_count);
+    }
+    if (!ZSTD_isError(res))
+    {
+        res = ZSTD_CCtx_setParameter(cctx, ZSTD_c_jobSize, (int)job_size);
+    }
+    if (!ZSTD_isError(res))
+    {
+        res = ZSTD_compress2(cctx, compressed, max_compressed_size, uncompressed, uncompressed_size);
+    }
+    else
+    {
+        // Built without ZSTD_MULTITHREAD
+        res = ZSTD_compressCCtx(cctx, compressed, max_compressed_size, uncompressed, uncompressed_size, compression_setting);
+    }
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+    return res;
+}
+
 static size_t ZStdCompressionAPI_GetMaxCompressedSize(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, size_t size)
 {
     return ZSTD_COMPRESSBOUND(size);
 }
 
-int ZStdCompressionAPI_Compress(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, const char* uncompressed, char* compressed, size_t uncompressed_size, size_t max_compressed_size, size_t* out_compressed_size)
+int ZStdCompressionAPI_CompressWithWorkers(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, uint32_t extra_worker_count, const char* uncompressed, char* compressed, size_t uncompressed_size, size_t max_compressed_size, size_t* out_compressed_size)
 {
 #if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(compression_api, "%p"),
         LONGTAIL_LOGFIELD(settings_id, "%u"),
+        LONGTAIL_LOGFIELD(extra_worker_count, "%u"),
         LONGTAIL_LOGFIELD(uncompressed, "%p"),
         LONGTAIL_LOGFIELD(compressed, "%p"),
         LONGTAIL_LOGFIELD(uncompressed_size, "%" PRIu64),
@@ -90,8 +219,23 @@ int ZStdCompressionAPI_Compress(struct Longtail_CompressionAPI* compression_api,
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
+    struct ZStdCompressionAPI* api = (struct ZStdCompressionAPI*)compression_api;
+    ZSTD_CCtx* cctx = ZStdCompressionAPI_AcquireCCtx(api);
+    if (!cctx)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_createCCtx() failed with %d", ENOMEM);
+        return ENOMEM;
+    }
+
     int compression_setting = SettingsIDToCompressionSetting(settings_id);
-    size_t size = ZSTD_compress(compressed, max_compressed_size, uncompressed, uncompressed_size, compression_setting);
+    // The calling thread waits while the zstd workers compress so it counts as one of them,
+    // each worker gets at least LONGTAIL_ZSTD_MT_JOB_SIZE of the data
+    uint32_t max_extra_worker_count = uncompressed_size >= LONGTAIL_ZSTD_MT_MIN_SIZE ? (uint32_t)(uncompressed_size / LONGTAIL_ZSTD_MT_JOB_SIZE) - 1 : 0;
+    extra_worker_count = extra_worker_count < max_extra_worker_count ? extra_worker_count : max_extra_worker_count;
+    size_t size = extra_worker_count > 0 ?
+        ZStdCompressionAPI_CompressMT(cctx, compression_setting, extra_worker_count + 1, uncompressed, compressed, uncompressed_size, max_compressed_size) :
+        ZSTD_compressCCtx(cctx, compressed, max_compressed_size, uncompressed, uncompressed_size, compression_setting);
+    ZStdCompressionAPI_ReleaseCCtx(api, cctx);
     if (ZSTD_isError(size))
     {
         int err = ZSTD_getErrorCode(size);
@@ -102,6 +246,11 @@ int ZStdCompressionAPI_Compress(struct Longtail_CompressionAPI* compression_api,
     return 0;
 }
 
+int ZStdCompressionAPI_Compress(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, const char* uncompressed, char* compressed, size_t uncompressed_size, size_t max_compressed_size, size_t* out_compressed_size)
+{
+    return ZStdCompressionAPI_CompressWithWorkers(compression_api, settings_id, 0, uncompressed, compressed, uncompressed_size, max_compressed_size, out_compressed_size);
+}
+
 
 int ZStdCompressionAPI_Decompress(struct Longtail_CompressionAPI* compression_api, const char* compressed, char* uncompressed, size_t compressed_size, size_t max_uncompressed_size, size_t* out_uncompressed_size)
 {
@@ -118,7 +267,16 @@ int ZStdCompressionAPI_Decompress(struct Longtail_CompressionAPI* compression_ap
     struct Longtail_LogContextFmt_Private* ctx = 0;
 #endif // defined(LONGTAIL_ASSERTS)
 
-    size_t size = ZSTD_decompress(uncompressed, max_uncompressed_size, compressed, compressed_size);
+    struct ZStdCompressionAPI* api = (struct ZStdCompressionAPI*)compression_api;
+    ZSTD_DCtx* dctx = ZStdCompressionAPI_AcquireDCtx(api);
+    if (!dctx)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_createDCtx() failed with %d", ENOMEM);
+        return ENOMEM;
+    }
+
+    size_t size = ZSTD_decompressDCtx(dctx, uncompressed, max_uncompressed_size, compressed, compressed_size);
+    ZStdCompressionAPI_ReleaseDCtx(api, dctx);
     if (ZSTD_isError(size))
     {
         int err = ZSTD_getErrorCode(size);
@@ -129,12 +287,27 @@ int ZStdCompressionAPI_Decompress(struct Longtail_CompressionAPI* compression_ap
     return 0;
 }
 
-static void ZStdCompressionAPI_Init(struct ZStdCompressionAPI* compression_api)
+static int ZStdCompressionAPI_Init(struct ZStdCompressionAPI* compression_api)
 {
     compression_api->m_ZStdCompressionAPI.m_API.Dispose = ZStdCompressionAPI_Dispose;
     compression_api->m_ZStdCompressionAPI.GetMaxCompressedSize = ZStdCompressionAPI_GetMaxCompressedSize;
     compression_api->m_ZStdCompressionAPI.Compress = ZStdCompressionAPI_Compress;
     compression_api->m_ZStdCompressionAPI.Decompress = ZStdCompressionAPI_Decompress;
+    compression_api->m_ZStdCompressionAPI.CompressWithWorkers = ZStdCompressionAPI_CompressWithWorkers;
+    compression_api->m_FreeCCtxs = 0;
+    compression_api->m_FreeDCtxs = 0;
+    void* lock_mem = Longtail_Alloc("ZStdCompressionAPI", Longtail_GetSpinLockSize());
+    if (!lock_mem)
+    {
+        return ENOMEM;
+    }
+    int err = Longtail_CreateSpinLock(lock_mem, &compression_api->m_Lock);
+    if (err)
+    {
+        Longtail_Free(lock_mem);
+        return err;
+    }
+    return 0;
 }
 
 struct Longtail_CompressionAPI* Longtail_CreateZStdCompressionAPI()
@@ -146,6 +319,468 @@ struct Longtail_CompressionAPI* Longtail_CreateZStdCompressionAPI()
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return 0;
     }
-    ZStdCompressionAPI_Init(compression_api);
+    int err = ZStdCompressionAPI_Init(compression_api);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZStdCompressionAPI_Init() failed with %d", err)
+        Longtail_Free(compression_api);
+        return 0;
+    }
     return &compression_api->m_ZStdCompressionAPI;
 }
+
+// Dictionaries belong to the dictionary compression registry they were added to and are
+// released when it is disposed, a dictionary id always refers to the same content in a registry
+struct ZStdDictionary
+{
+    void* m_Data;
+    size_t m_Size;
+    ZSTD_DDict* m_DDict;
+    ZSTD_CDict* m_CDicts[LONGTAIL_ZSTD_QUALITY_COUNT];
+};
+
+struct ZStdDictionary_Lookup
+{
+    uint32_t key;
+    struct ZStdDictionary* value;
+};
+
+struct ZStdDictionaryCompressionRegistry
+{
+    struct Longtail_CompressionRegistryAPI m_CompressionRegistryAPI;
+    struct Longtail_CompressionRegistryAPI* m_CompressionRegistry;
+    struct Longtail_CompressionAPI* m_DictionaryCompressionAPI;
+    HLongtail_SpinLock m_SpinLock;
+    struct ZStdDictionary_Lookup* m_Dictionaries;
+};
+
+struct ZStdDictionaryCompressionAPI
+{
+    struct ZStdCompressionAPI m_ZStdCompressionAPI;
+    struct ZStdDictionaryCompressionRegistry* m_Registry;
+};
+
+static void ZStdDictionary_Free(struct ZStdDictionary* dictionary)
+{
+    for (uint32_t q = 0; q < LONGTAIL_ZSTD_QUALITY_COUNT; ++q)
+    {
+        ZSTD_freeCDict(dictionary->m_CDicts[q]);
+    }
+    ZSTD_freeDDict(dictionary->m_DDict);
+    Longtail_Free(dictionary);
+}
+
+static struct ZStdDictionary* ZStdDictionaryCompressionRegistry_Find(struct ZStdDictionaryCompressionRegistry* registry, uint32_t dictionary_id)
+{
+    Longtail_LockSpinLock(registry->m_SpinLock);
+    intptr_t it = hmgeti(registry->m_Dictionaries, dictionary_id);
+    struct ZStdDictionary* dictionary = (it == -1) ? 0 : registry->m_Dictionaries[it].value;
+    Longtail_UnlockSpinLock(registry->m_SpinLock);
+    return dictionary;
+}
+
+static ZSTD_CDict* ZStdDictionaryCompressionRegistry_GetCDict(struct ZStdDictionaryCompressionRegistry* registry, struct ZStdDictionary* dictionary, uint32_t quality)
+{
+    uint32_t quality_index = quality - (uint32_t)'1';
+    Longtail_LockSpinLock(registry->m_SpinLock);
+    ZSTD_CDict* cdict = dictionary->m_CDicts[quality_index];
+    Longtail_UnlockSpinLock(registry->m_SpinLock);
+    if (cdict)
+    {
+        return cdict;
+    }
+
+    // Digesting the dictionary can take a while at high levels so it is done outside the lock
+    ZSTD_CDict* new_cdict = ZSTD_createCDict(dictionary->m_Data, dictionary->m_Size, SettingsIDToCompressionSetting(LONGTAIL_ZSTD_COMPRESSION_TYPE + quality));
+    if (!new_cdict)
+    {
+        return 0;
+    }
+    Longtail_LockSpinLock(registry->m_SpinLock);
+    cdict = dictionary->m_CDicts[quality_index];
+    if (!cdict)
+    {
+        dictionary->m_CDicts[quality_index] = new_cdict;
+        cdict = new_cdict;
+        new_cdict = 0;
+    }
+    Longtail_UnlockSpinLock(registry->m_SpinLock);
+    ZSTD_freeCDict(new_cdict);
+    return cdict;
+}
+
+int Longtail_AddZStdDictionary(struct Longtail_CompressionRegistryAPI* dictionary_compression_registry, const void* dictionary, size_t dictionary_size, uint32_t* out_dictionary_id)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(dictionary_compression_registry, "%p"),
+        LONGTAIL_LOGFIELD(dictionary, "%p"),
+        LONGTAIL_LOGFIELD(dictionary_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(out_dictionary_id, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, dictionary_compression_registry != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, dictionary != 0, return EINVAL)
+
+    struct ZStdDictionaryCompressionRegistry* registry = (struct ZStdDictionaryCompressionRegistry*)dictionary_compression_registry;
+
+    // The full 32 bit id from the dictionary header is what compressed frames name
+    uint32_t dictionary_id = ZDICT_getDictID(dictionary, dictionary_size);
+    if (dictionary_id < LONGTAIL_ZSTD_MIN_DICTIONARY_ID || dictionary_id > LONGTAIL_ZSTD_MAX_DICTIONARY_ID)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Invalid dictionary id %u", dictionary_id)
+        return EINVAL;
+    }
+
+    size_t mem_size = sizeof(struct ZStdDictionary) + dictionary_size;
+    struct ZStdDictionary* new_dictionary = (struct ZStdDictionary*)Longtail_Alloc("ZStdDictionary", mem_size);
+    if (!new_dictionary)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    memset(new_dictionary, 0, sizeof(struct ZStdDictionary));
+    new_dictionary->m_Data = &new_dictionary[1];
+    new_dictionary->m_Size = dictionary_size;
+    memcpy(new_dictionary->m_Data, dictionary, dictionary_size);
+
+    int err = 0;
+    Longtail_LockSpinLock(registry->m_SpinLock);
+    intptr_t it = hmgeti(registry->m_Dictionaries, dictionary_id);
+    if (it != -1)
+    {
+        struct ZStdDictionary* existing = registry->m_Dictionaries[it].value;
+        if (existing->m_Size != dictionary_size || memcmp(existing->m_Data, dictionary, dictionary_size) != 0)
+        {
+            err = EEXIST;
+        }
+    }
+    else
+    {
+        new_dictionary->m_DDict = ZSTD_createDDict(new_dictionary->m_Data, dictionary_size);
+        if (new_dictionary->m_DDict)
+        {
+            hmput(registry->m_Dictionaries, dictionary_id, new_dictionary);
+            new_dictionary = 0;
+        }
+        else
+        {
+            err = ENOMEM;
+        }
+    }
+    Longtail_UnlockSpinLock(registry->m_SpinLock);
+    if (new_dictionary)
+    {
+        ZStdDictionary_Free(new_dictionary);
+    }
+    if (err == EEXIST)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "A different dictionary with id %u already exists", dictionary_id)
+        return err;
+    }
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_createDDict() failed with %d", err)
+        return err;
+    }
+    if (out_dictionary_id)
+    {
+        *out_dictionary_id = dictionary_id;
+    }
+    return 0;
+}
+
+int Longtail_HasZStdDictionary(struct Longtail_CompressionRegistryAPI* dictionary_compression_registry, uint32_t dictionary_id)
+{
+    return ZStdDictionaryCompressionRegistry_Find((struct ZStdDictionaryCompressionRegistry*)dictionary_compression_registry, dictionary_id) != 0;
+}
+
+int Longtail_ProbeZStdDictionaryID(void* dictionary, size_t dictionary_size, uint32_t probe, uint32_t* out_dictionary_id)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(dictionary, "%p"),
+        LONGTAIL_LOGFIELD(dictionary_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(probe, "%u"),
+        LONGTAIL_LOGFIELD(out_dictionary_id, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, dictionary != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, dictionary_size >= 8, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, ZDICT_getDictID(dictionary, dictionary_size) != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, probe <= LONGTAIL_ZSTD_MAX_DICTIONARY_ID - LONGTAIL_ZSTD_MIN_DICTIONARY_ID, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_dictionary_id != 0, return EINVAL)
+
+    // 64 bit FNV-1a of everything after the magic number and the id. The range of ids is a power of two
+    // so stepping with an odd stride derived from the hash visits every id once before repeating
+    uint64_t content_hash = 14695981039346656037ull;
+    const uint8_t* content = (const uint8_t*)dictionary;
+    for (size_t i = 8; i < dictionary_size; ++i)
+    {
+        content_hash = (content_hash ^ content[i]) * 1099511628211ull;
+    }
+    uint32_t id_range = LONGTAIL_ZSTD_MAX_DICTIONARY_ID - LONGTAIL_ZSTD_MIN_DICTIONARY_ID + 1;
+    uint32_t start = (uint32_t)(content_hash ^ (content_hash >> 32));
+    uint32_t stride = (uint32_t)(content_hash >> 17) | 1u;
+    uint32_t dictionary_id = LONGTAIL_ZSTD_MIN_DICTIONARY_ID + ((start + probe * stride) & (id_range - 1));
+
+    // The id is stored little endian after the magic number
+    uint8_t* id_bytes = &((uint8_t*)dictionary)[4];
+    id_bytes[0] = (uint8_t)(dictionary_id);
+    id_bytes[1] = (uint8_t)(dictionary_id >> 8);
+    id_bytes[2] = (uint8_t)(dictionary_id >> 16);
+    id_bytes[3] = (uint8_t)(dictionary_id >> 24);
+
+    *out_dictionary_id = dictionary_id;
+    return 0;
+}
+
+int Longtail_TrainZStdDictionary(
+    const void* samples,
+    const size_t* sample_sizes,
+    uint32_t sample_count,
+    size_t max_dictionary_size,
+    void** out_dictionary,
+    size_t* out_dictionary_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(samples, "%p"),
+        LONGTAIL_LOGFIELD(sample_sizes, "%p"),
+        LONGTAIL_LOGFIELD(sample_count, "%u"),
+        LONGTAIL_LOGFIELD(max_dictionary_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(out_dictionary, "%p"),
+        LONGTAIL_LOGFIELD(out_dictionary_size, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, sample_count == 0 || samples != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, sample_count == 0 || sample_sizes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, max_dictionary_size >= 256, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_dictionary != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_dictionary_size != 0, return EINVAL)
+
+    void* dictionary = Longtail_Alloc("ZStdDictionary", max_dictionary_size);
+    if (!dictionary)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    size_t dictionary_size = ZDICT_trainFromBuffer(dictionary, max_dictionary_size, samples, sample_sizes, sample_count);
+    if (ZDICT_isError(dictionary_size))
+    {
+        // Usually too few or too small samples
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "ZDICT_trainFromBuffer() failed with `%s`", ZDICT_getErrorName(dictionary_size))
+        Longtail_Free(dictionary);
+        return EINVAL;
+    }
+
+    uint32_t dictionary_id = 0;
+    int err = Longtail_ProbeZStdDictionaryID(dictionary, dictionary_size, 0, &dictionary_id);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_ProbeZStdDictionaryID() failed with %d", err)
+        Longtail_Free(dictionary);
+        return err;
+    }
+
+    *out_dictionary = dictionary;
+    *out_dictionary_size = dictionary_size;
+    return 0;
+}
+
+int ZStdDictionaryCompressionAPI_Compress(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, const char* uncompressed, char* compressed, size_t uncompressed_size, size_t max_compressed_size, size_t* out_compressed_size)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(compression_api, "%p"),
+        LONGTAIL_LOGFIELD(settings_id, "%u"),
+        LONGTAIL_LOGFIELD(uncompressed, "%p"),
+        LONGTAIL_LOGFIELD(compressed, "%p"),
+        LONGTAIL_LOGFIELD(uncompressed_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(max_compressed_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(out_compressed_size, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    struct ZStdDictionaryCompressionAPI* api = (struct ZStdDictionaryCompressionAPI*)compression_api;
+    uint32_t dictionary_id = Longtail_GetZStdDictionaryCompressionTypeID(settings_id);
+    struct ZStdDictionary* dictionary = ZStdDictionaryCompressionRegistry_Find(api->m_Registry, dictionary_id);
+    if (!dictionary)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Dictionary %u has not been added, failed with %d", dictionary_id, ENOENT);
+        return ENOENT;
+    }
+    ZSTD_CDict* cdict = ZStdDictionaryCompressionRegistry_GetCDict(api->m_Registry, dictionary, settings_id & 0xffu);
+    if (!cdict)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_createCDict() failed with %d", ENOMEM);
+        return ENOMEM;
+    }
+    ZSTD_CCtx* cctx = ZStdCompressionAPI_AcquireCCtx(&api->m_ZStdCompressionAPI);
+    if (!cctx)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_createCCtx() failed with %d", ENOMEM);
+        return ENOMEM;
+    }
+
+    size_t size = ZSTD_compress_usingCDict(cctx, compressed, max_compressed_size, uncompressed, uncompressed_size, cdict);
+    ZStdCompressionAPI_ReleaseCCtx(&api->m_ZStdCompressionAPI, cctx);
+    if (ZSTD_isError(size))
+    {
+        int err = ZSTD_getErrorCode(size);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_compress_usingCDict() failed with %d", err);
+        return EINVAL;
+    }
+    *out_compressed_size = size;
+    return 0;
+}
+
+int ZStdDictionaryCompressionAPI_Decompress(struct Longtail_CompressionAPI* compression_api, const char* compressed, char* uncompressed, size_t compressed_size, size_t max_uncompressed_size, size_t* out_uncompressed_size)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(compression_api, "%p"),
+        LONGTAIL_LOGFIELD(compressed, "%p"),
+        LONGTAIL_LOGFIELD(uncompressed, "%p"),
+        LONGTAIL_LOGFIELD(compressed_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(max_uncompressed_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(out_uncompressed_size, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    struct ZStdDictionaryCompressionAPI* api = (struct ZStdDictionaryCompressionAPI*)compression_api;
+
+    // The frame header names the dictionary it was compressed with
+    uint32_t dictionary_id = ZSTD_getDictID_fromFrame(compressed, compressed_size);
+    struct ZStdDictionary* dictionary = ZStdDictionaryCompressionRegistry_Find(api->m_Registry, dictionary_id);
+    if (dictionary_id != 0 && !dictionary)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Dictionary %u has not been added, failed with %d", dictionary_id, ENOENT);
+        return ENOENT;
+    }
+    ZSTD_DCtx* dctx = ZStdCompressionAPI_AcquireDCtx(&api->m_ZStdCompressionAPI);
+    if (!dctx)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_createDCtx() failed with %d", ENOMEM);
+        return ENOMEM;
+    }
+
+    size_t size = dictionary ?
+        ZSTD_decompress_usingDDict(dctx, uncompressed, max_uncompressed_size, compressed, compressed_size, dictionary->m_DDict) :
+        ZSTD_decompressDCtx(dctx, uncompressed, max_uncompressed_size, compressed, compressed_size);
+    ZStdCompressionAPI_ReleaseDCtx(&api->m_ZStdCompressionAPI, dctx);
+    if (ZSTD_isError(size))
+    {
+        int err = ZSTD_getErrorCode(size);
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZSTD_decompress_usingDDict() failed with %d", err);
+        return EINVAL;
+    }
+    *out_uncompressed_size = size;
+    return 0;
+}
+
+static void ZStdDictionaryCompressionRegistry_Dispose(struct Longtail_API* api)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(api, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, api, return);
+    struct ZStdDictionaryCompressionRegistry* registry = (struct ZStdDictionaryCompressionRegistry*)api;
+    registry->m_DictionaryCompressionAPI->m_API.Dispose(&registry->m_DictionaryCompressionAPI->m_API);
+    registry->m_CompressionRegistry->m_API.Dispose(&registry->m_CompressionRegistry->m_API);
+    intptr_t dictionary_count = hmlen(registry->m_Dictionaries);
+    for (intptr_t i = 0; i < dictionary_count; ++i)
+    {
+        ZStdDictionary_Free(registry->m_Dictionaries[i].value);
+    }
+    hmfree(registry->m_Dictionaries);
+    Longtail_DeleteSpinLock(registry->m_SpinLock);
+    Longtail_Free(registry);
+}
+
+static int ZStdDictionaryCompressionRegistry_GetCompressionAPI(
+    struct Longtail_CompressionRegistryAPI* compression_registry,
+    uint32_t compression_type,
+    struct Longtail_CompressionAPI** out_compression_api,
+    uint32_t* out_settings)
+{
+    struct ZStdDictionaryCompressionRegistry* registry = (struct ZStdDictionaryCompressionRegistry*)compression_registry;
+    if (Longtail_GetZStdDictionaryCompressionTypeQuality(compression_type) == 0)
+    {
+        return registry->m_CompressionRegistry->GetCompressionAPI(registry->m_CompressionRegistry, compression_type, out_compression_api, out_settings);
+    }
+    *out_compression_api = registry->m_DictionaryCompressionAPI;
+    if (out_settings)
+    {
+        *out_settings = compression_type;
+    }
+    return 0;
+}
+
+struct Longtail_CompressionRegistryAPI* Longtail_CreateZStdDictionaryCompressionRegistry(
+    uint32_t compression_type_count,
+    const Longtail_CompressionRegistry_CreateForTypeFunc* create_api_funcs)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(compression_type_count, "%u"),
+        LONGTAIL_LOGFIELD(create_api_funcs, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, create_api_funcs, return 0);
+
+    size_t registry_size = sizeof(struct ZStdDictionaryCompressionRegistry) + Longtail_GetSpinLockSize();
+    void* mem = Longtail_Alloc("ZStdDictionaryCompressionRegistry", registry_size);
+    if (!mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return 0;
+    }
+    struct ZStdDictionaryCompressionRegistry* registry = (struct ZStdDictionaryCompressionRegistry*)Longtail_MakeCompressionRegistryAPI(
+        mem,
+        ZStdDictionaryCompressionRegistry_Dispose,
+        ZStdDictionaryCompressionRegistry_GetCompressionAPI);
+    registry->m_Dictionaries = 0;
+    int err = Longtail_CreateSpinLock(&registry[1], &registry->m_SpinLock);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateSpinLock() failed with %d", err)
+        Longtail_Free(mem);
+        return 0;
+    }
+
+    struct ZStdDictionaryCompressionAPI* dictionary_compression_api = (struct ZStdDictionaryCompressionAPI*)Longtail_Alloc("ZStdCompressionAPI", sizeof(struct ZStdDictionaryCompressionAPI));
+    if (!dictionary_compression_api)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_DeleteSpinLock(registry->m_SpinLock);
+        Longtail_Free(mem);
+        return 0;
+    }
+    err = ZStdCompressionAPI_Init(&dictionary_compression_api->m_ZStdCompressionAPI);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ZStdCompressionAPI_Init() failed with %d", err)
+        Longtail_Free(dictionary_compression_api);
+        Longtail_DeleteSpinLock(registry->m_SpinLock);
+        Longtail_Free(mem);
+        return 0;
+    }
+    dictionary_compression_api->m_ZStdCompressionAPI.m_ZStdCompressionAPI.Compress = ZStdDictionaryCompressionAPI_Compress;
+    dictionary_compression_api->m_ZStdCompressionAPI.m_ZStdCompressionAPI.Decompress = ZStdDictionaryCompressionAPI_Decompress;
+    dictionary_compression_api->m_ZStdCompressionAPI.m_ZStdCompressionAPI.CompressWithWorkers = 0;
+    dictionary_compression_api->m_Registry = registry;
+    registry->m_DictionaryCompressionAPI = &dictionary_compression_api->m_ZStdCompressionAPI.m_ZStdCompressionAPI;
+
+    registry->m_CompressionRegistry = Longtail_CreateDefaultCompressionRegistry(compression_type_count, create_api_funcs);
+    if (!registry->m_CompressionRegistry)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateDefaultCompressionRegistry() failed with %d", ENOMEM)
+        registry->m_DictionaryCompressionAPI->m_API.Dispose(&registry->m_DictionaryCompressionAPI->m_API);
+        Longtail_DeleteSpinLock(registry->m_SpinLock);
+        Longtail_Free(mem);
+        return 0;
+    }
+    return &registry->m_CompressionRegistryAPI;
+}
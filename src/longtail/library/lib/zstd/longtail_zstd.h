@@ -1,7 +1,7 @@
 #pragma once
 
 #include "../../src/longtail.h"
-#include "../compressblockstore/longtail_compressblockstore.h"
+#include "../compressionregistry/longtail_compression_registry.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,6 +15,41 @@ LONGTAIL_EXPORT extern uint32_t Longtail_GetZStdHighQuality();
 LONGTAIL_EXPORT extern uint32_t Longtail_GetZStdLowQuality();
 LONGTAIL_EXPORT extern struct Longtail_CompressionAPI* Longtail_CompressionRegistry_CreateForZstd(uint32_t compression_type, uint32_t* out_settings);
 
+// Dictionary compression types are 'Z', a 16 bit dictionary id and the quality of a zstd compression type.
+// Compressed frames name their dictionary so any dictionary compression type can decompress data
+// compressed with any dictionary added to the same registry.
+LONGTAIL_EXPORT extern uint32_t Longtail_GetZStdDictionaryCompressionType(uint32_t dictionary_id, uint32_t zstd_compression_type);
+// Returns the zstd compression type with the same quality, zero if compression_type is not a dictionary compression type
+LONGTAIL_EXPORT extern uint32_t Longtail_GetZStdDictionaryCompressionTypeQuality(uint32_t compression_type);
+LONGTAIL_EXPORT extern uint32_t Longtail_GetZStdDictionaryCompressionTypeID(uint32_t compression_type);
+
+// Creates a compression registry for create_api_funcs that also handles the dictionary compression
+// types. Dictionaries are added to the registry and released when it is disposed.
+LONGTAIL_EXPORT extern struct Longtail_CompressionRegistryAPI* Longtail_CreateZStdDictionaryCompressionRegistry(
+    uint32_t compression_type_count,
+    const Longtail_CompressionRegistry_CreateForTypeFunc* create_api_funcs);
+
+// Trains a dictionary from sample_count samples stored back to back in samples, the dictionary id is
+// the first candidate id derived from the trained content. *out_dictionary is allocated with Longtail_Alloc.
+LONGTAIL_EXPORT extern int Longtail_TrainZStdDictionary(
+    const void* samples,
+    const size_t* sample_sizes,
+    uint32_t sample_count,
+    size_t max_dictionary_size,
+    void** out_dictionary,
+    size_t* out_dictionary_size);
+
+// Sets the id of a trained dictionary to candidate number probe of the ids derived from its content.
+// A dictionary whose id is taken by a different dictionary can move on to the next probe, all 32768
+// ids that fit in a dictionary compression type are visited before the candidates repeat.
+LONGTAIL_EXPORT extern int Longtail_ProbeZStdDictionaryID(void* dictionary, size_t dictionary_size, uint32_t probe, uint32_t* out_dictionary_id);
+
+// Adds a copy of a trained dictionary to a registry created with Longtail_CreateZStdDictionaryCompressionRegistry,
+// adding the same dictionary again is a no-op. Returns EEXIST if a different dictionary with the same id
+// has already been added to the registry.
+LONGTAIL_EXPORT extern int Longtail_AddZStdDictionary(struct Longtail_CompressionRegistryAPI* dictionary_compression_registry, const void* dictionary, size_t dictionary_size, uint32_t* out_dictionary_id);
+LONGTAIL_EXPORT extern int Longtail_HasZStdDictionary(struct Longtail_CompressionRegistryAPI* dictionary_compression_registry, uint32_t dictionary_id);
+
 #ifdef __cplusplus
 }
 #endif
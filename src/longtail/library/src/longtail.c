@@ -48,10 +48,14 @@ void Longtail_NukeFree(void* p);
 
 #define LONGTAIL_VERSION(major, minor, patch)  ((((uint32_t)major) << 24) | ((uint32_t)minor << 16) | ((uint32_t)patch))
 #define LONGTAIL_VERSION_INDEX_VERSION_0_0_2  LONGTAIL_VERSION(0,0,2)
+#define LONGTAIL_VERSION_INDEX_VERSION_0_0_3  LONGTAIL_VERSION(0,0,3)
+#define LONGTAIL_VERSION_INDEX_VERSION_0_0_4  LONGTAIL_VERSION(0,0,4)
 #define LONGTAIL_STORE_INDEX_VERSION_1_0_0    LONGTAIL_VERSION(1,0,0)
 #define LONGTAIL_ARCHIVE_VERSION_0_0_1        LONGTAIL_VERSION(0,0,1)
 
-uint32_t Longtail_CurrentVersionIndexVersion = LONGTAIL_VERSION_INDEX_VERSION_0_0_2;
+#define LONGTAIL_VERSION_INDEX_FLAGS_KNOWN    (LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS | LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES)
+
+uint32_t Longtail_CurrentVersionIndexVersion = LONGTAIL_VERSION_INDEX_VERSION_0_0_4;
 uint32_t Longtail_CurrentStoreIndexVersion = LONGTAIL_STORE_INDEX_VERSION_1_0_0;
 uint32_t Longtail_CurrentArchiveVersion = LONGTAIL_ARCHIVE_VERSION_0_0_1;
 
@@ -145,7 +149,8 @@ struct Longtail_HashAPI* Longtail_MakeHashAPI(
     Longtail_Hash_BeginContextFunc begin_context_func,
     Longtail_Hash_HashFunc hash_func,
     Longtail_Hash_EndContextFunc end_context_func,
-    Longtail_Hash_HashBufferFunc hash_buffer_func)
+    Longtail_Hash_HashBufferFunc hash_buffer_func,
+    Longtail_Hash_HashBuffersFunc hash_buffers_func)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(mem, "%p"),
@@ -154,7 +159,8 @@ struct Longtail_HashAPI* Longtail_MakeHashAPI(
         LONGTAIL_LOGFIELD(begin_context_func, "%p"),
         LONGTAIL_LOGFIELD(hash_func, "%p"),
         LONGTAIL_LOGFIELD(end_context_func, "%p"),
-        LONGTAIL_LOGFIELD(hash_buffer_func, "%p")
+        LONGTAIL_LOGFIELD(hash_buffer_func, "%p"),
+        LONGTAIL_LOGFIELD(hash_buffers_func, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
     LONGTAIL_VALIDATE_INPUT(ctx, mem != 0, return 0)
@@ -165,6 +171,7 @@ struct Longtail_HashAPI* Longtail_MakeHashAPI(
     api->Hash = hash_func;
     api->EndContext = end_context_func;
     api->HashBuffer = hash_buffer_func;
+    api->HashBuffers = hash_buffers_func;
     return api;
 }
 
@@ -174,6 +181,23 @@ void Longtail_Hash_Hash(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HCon
 uint64_t Longtail_Hash_EndContext(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context) { return hash_api->EndContext(hash_api, context); }
 int Longtail_Hash_HashBuffer(struct Longtail_HashAPI* hash_api, uint32_t length, const void* data, uint64_t* out_hash) { return hash_api->HashBuffer(hash_api, length, data, out_hash); }
 
+int Longtail_Hash_HashBuffers(struct Longtail_HashAPI* hash_api, uint32_t count, const uint32_t* lengths, const void* const* datas, uint64_t* out_hashes)
+{
+    if (hash_api->HashBuffers)
+    {
+        return hash_api->HashBuffers(hash_api, count, lengths, datas, out_hashes);
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        int err = hash_api->HashBuffer(hash_api, lengths[i], datas[i], &out_hashes[i]);
+        if (err)
+        {
+            return err;
+        }
+    }
+    return 0;
+}
+
 
 uint64_t Longtail_GetHashRegistrySize()
 {
@@ -227,11 +251,36 @@ struct Longtail_CompressionAPI* Longtail_MakeCompressionAPI(
     api->GetMaxCompressedSize = get_max_compressed_size_func;
     api->Compress = compress_func;
     api->Decompress = decompress_func;
+    api->CompressWithWorkers = 0;
+    return api;
+}
+
+struct Longtail_CompressionAPI* Longtail_MakeCompressionAPIWithWorkers(
+    void* mem,
+    Longtail_DisposeFunc dispose_func,
+    Longtail_CompressionAPI_GetMaxCompressedSizeFunc get_max_compressed_size_func,
+    Longtail_CompressionAPI_CompressFunc compress_func,
+    Longtail_CompressionAPI_DecompressFunc decompress_func,
+    Longtail_CompressionAPI_CompressWithWorkersFunc compress_with_workers_func)
+{
+    struct Longtail_CompressionAPI* api = Longtail_MakeCompressionAPI(mem, dispose_func, get_max_compressed_size_func, compress_func, decompress_func);
+    if (api)
+    {
+        api->CompressWithWorkers = compress_with_workers_func;
+    }
     return api;
 }
 
 size_t Longtail_CompressionAPI_GetMaxCompressedSize(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, size_t size) { return compression_api->GetMaxCompressedSize(compression_api, settings_id, size); }
 int Longtail_CompressionAPI_Compress(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, const char* uncompressed, char* compressed, size_t uncompressed_size, size_t max_compressed_size, size_t* out_compressed_size) { return compression_api->Compress(compression_api, settings_id, uncompressed, compressed, uncompressed_size, max_compressed_size, out_compressed_size); }
+int Longtail_CompressionAPI_CompressWithWorkers(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, uint32_t extra_worker_count, const char* uncompressed, char* compressed, size_t uncompressed_size, size_t max_compressed_size, size_t* out_compressed_size)
+{
+    if (compression_api->CompressWithWorkers == 0 || extra_worker_count == 0)
+    {
+        return compression_api->Compress(compression_api, settings_id, uncompressed, compressed, uncompressed_size, max_compressed_size, out_compressed_size);
+    }
+    return compression_api->CompressWithWorkers(compression_api, settings_id, extra_worker_count, uncompressed, compressed, uncompressed_size, max_compressed_size, out_compressed_size);
+}
 int Longtail_CompressionAPI_Decompress(struct Longtail_CompressionAPI* compression_api, const char* compressed, char* uncompressed, size_t compressed_size, size_t max_uncompressed_size, size_t* out_uncompressed_size) { return compression_api->Decompress(compression_api, compressed, uncompressed, compressed_size, max_uncompressed_size, out_uncompressed_size); }
 
 
@@ -358,6 +407,8 @@ struct Longtail_StorageAPI* Longtail_MakeStorageAPI(
     api->MapFile = map_file_func;
     api->UnMapFile = unmap_file_func;
     api->m_StorageFlags = 0;
+    api->CloneFile = 0;
+    api->StreamWritten = 0;
     return api;
 }
 
@@ -387,6 +438,90 @@ char* Longtail_Storage_GetParentPath(struct Longtail_StorageAPI* storage_api, co
 int Longtail_Storage_MapFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t offset, uint64_t length, Longtail_StorageAPI_HFileMap* out_file_map, const void** out_data_ptr) { return storage_api->MapFile(storage_api, f, offset, length, out_file_map, out_data_ptr); }
 void Longtail_Storage_UnmapFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HFileMap m) { storage_api->UnMapFile(storage_api, m); }
 
+#define STORAGE_COPY_BUFFER_SIZE (4u * 1024u * 1024u)
+
+int Longtail_Storage_CopyFile(struct Longtail_StorageAPI* storage_api, const char* source_path, const char* target_path)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(source_path, "%s"),
+        LONGTAIL_LOGFIELD(target_path, "%s")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, source_path != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, target_path != 0, return EINVAL)
+
+    if (storage_api->CloneFile)
+    {
+        return storage_api->CloneFile(storage_api, source_path, target_path);
+    }
+
+    Longtail_StorageAPI_HOpenFile source_file;
+    int err = storage_api->OpenReadFile(storage_api, source_path, &source_file);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "storage_api->OpenReadFile() failed with %d", err)
+        return err;
+    }
+    uint64_t size;
+    err = storage_api->GetSize(storage_api, source_file, &size);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "storage_api->GetSize() failed with %d", err)
+        storage_api->CloseFile(storage_api, source_file);
+        return err;
+    }
+    Longtail_StorageAPI_HOpenFile target_file;
+    err = storage_api->OpenWriteFile(storage_api, target_path, size, &target_file);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "storage_api->OpenWriteFile() failed with %d", err)
+        storage_api->CloseFile(storage_api, source_file);
+        return err;
+    }
+    size_t buffer_size = size < STORAGE_COPY_BUFFER_SIZE ? (size_t)size : STORAGE_COPY_BUFFER_SIZE;
+    void* buffer = buffer_size > 0 ? Longtail_Alloc("Longtail_Storage_CopyFile", buffer_size) : 0;
+    if (buffer_size > 0 && !buffer)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        storage_api->CloseFile(storage_api, target_file);
+        storage_api->CloseFile(storage_api, source_file);
+        return ENOMEM;
+    }
+    uint64_t offset = 0;
+    while (offset < size)
+    {
+        uint64_t length = (size - offset) < buffer_size ? (size - offset) : buffer_size;
+        err = storage_api->Read(storage_api, source_file, offset, length, buffer);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "storage_api->Read() failed with %d", err)
+            break;
+        }
+        err = storage_api->Write(storage_api, target_file, offset, length, buffer);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "storage_api->Write() failed with %d", err)
+            break;
+        }
+        offset += length;
+    }
+    Longtail_Free(buffer);
+    storage_api->CloseFile(storage_api, target_file);
+    storage_api->CloseFile(storage_api, source_file);
+    return err;
+}
+
+int Longtail_Storage_StreamWritten(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t offset, uint64_t length)
+{
+    if (storage_api->StreamWritten)
+    {
+        return storage_api->StreamWritten(storage_api, f, offset, length);
+    }
+    return 0;
+}
+
 ////////////// ProgressAPI
 
 uint64_t Longtail_GetProgressAPISize()
@@ -484,6 +619,27 @@ struct Longtail_ChunkerAPI* Longtail_MakeChunkerAPI(
     Longtail_Chunker_NextChunkFunc next_chunk_func,
     Longtail_Chunker_DisposeChunkerFunc dispose_chunker_func,
     Longtail_Chunker_NextChunkFromBufferFunc next_chunk_from_buffer)
+{
+    return Longtail_MakeChunkerAPIWithIdentifier(
+        mem,
+        dispose_func,
+        get_min_chunk_size_func,
+        create_chunker_func,
+        next_chunk_func,
+        dispose_chunker_func,
+        next_chunk_from_buffer,
+        0);
+}
+
+struct Longtail_ChunkerAPI* Longtail_MakeChunkerAPIWithIdentifier(
+    void* mem,
+    Longtail_DisposeFunc dispose_func,
+    Longtail_Chunker_GetMinChunkSizeFunc get_min_chunk_size_func,
+    Longtail_Chunker_CreateChunkerFunc create_chunker_func,
+    Longtail_Chunker_NextChunkFunc next_chunk_func,
+    Longtail_Chunker_DisposeChunkerFunc dispose_chunker_func,
+    Longtail_Chunker_NextChunkFromBufferFunc next_chunk_from_buffer,
+    Longtail_Chunker_GetIdentifierFunc get_identifier_func)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(mem, "%p"),
@@ -492,7 +648,8 @@ struct Longtail_ChunkerAPI* Longtail_MakeChunkerAPI(
         LONGTAIL_LOGFIELD(create_chunker_func, "%p"),
         LONGTAIL_LOGFIELD(next_chunk_func, "%p"),
         LONGTAIL_LOGFIELD(dispose_chunker_func, "%p"),
-        LONGTAIL_LOGFIELD(next_chunk_from_buffer, "%p")
+        LONGTAIL_LOGFIELD(next_chunk_from_buffer, "%p"),
+        LONGTAIL_LOGFIELD(get_identifier_func, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
     LONGTAIL_VALIDATE_INPUT(ctx, mem != 0, return 0)
@@ -503,6 +660,7 @@ struct Longtail_ChunkerAPI* Longtail_MakeChunkerAPI(
     api->NextChunk = next_chunk_func;
     api->DisposeChunker = dispose_chunker_func;
     api->NextChunkFromBuffer = next_chunk_from_buffer;
+    api->GetIdentifier = get_identifier_func;
     return api;
 }
 
@@ -511,6 +669,7 @@ int Longtail_Chunker_CreateChunker(struct Longtail_ChunkerAPI* chunker_api, uint
 int Longtail_Chunker_NextChunk(struct Longtail_ChunkerAPI* chunker_api, Longtail_ChunkerAPI_HChunker chunker, Longtail_Chunker_Feeder feeder, void* feeder_context, struct Longtail_Chunker_ChunkRange* out_chunk_range) { return chunker_api->NextChunk(chunker_api, chunker, feeder, feeder_context, out_chunk_range); }
 int Longtail_Chunker_DisposeChunker(struct Longtail_ChunkerAPI* chunker_api, Longtail_ChunkerAPI_HChunker chunker) { return chunker_api->DisposeChunker(chunker_api, chunker); }
 int Longtail_Chunker_NextChunkFromBuffer(struct Longtail_ChunkerAPI* chunker_api, Longtail_ChunkerAPI_HChunker chunker, const void* buffer, uint64_t buffer_size, const void** out_next_chunk_start) { return chunker_api->NextChunkFromBuffer(chunker_api, chunker, buffer, buffer_size, out_next_chunk_start); }
+uint32_t Longtail_Chunker_GetIdentifier(struct Longtail_ChunkerAPI* chunker_api) { return chunker_api->GetIdentifier ? chunker_api->GetIdentifier(chunker_api) : 0u; }
 
 ////////////// AsyncPutStoredBlockAPI
 
@@ -1140,6 +1299,25 @@ int Longtail_GetPathHash(struct Longtail_HashAPI* hash_api, const char* path, TL
     return 0;
 }
 
+TLongtail_Hash Longtail_GetZeroChunkHash(uint32_t chunk_size)
+{
+    // Zero chunks of different sizes must get different hashes, mix the size into a fixed seed
+    uint64_t h = 0x7a65726f6368756eull ^ ((uint64_t)chunk_size * 0x9e3779b97f4a7c15ull);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return (TLongtail_Hash)h;
+}
+
+int Longtail_IsZeroChunk(const struct Longtail_VersionIndex* version_index, uint32_t chunk_index)
+{
+    if ((Longtail_VersionIndex_GetFlags(version_index) & LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS) == 0)
+    {
+        return 0;
+    }
+    return version_index->m_ChunkHashes[chunk_index] == Longtail_GetZeroChunkHash(version_index->m_ChunkSizes[chunk_index]) ? 1 : 0;
+}
+
 int EnsureParentPathExists(struct Longtail_StorageAPI* storage_api, const char* path)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -1349,152 +1527,454 @@ static int RecurseTree(
     return err;
 }
 
-static size_t GetFileInfosSize(uint32_t path_count, uint32_t path_data_size)
+struct ScanDirectoryEntry
 {
-    return sizeof(struct Longtail_FileInfos) +
-        sizeof(uint32_t) * path_count +    // m_Permissions[path_count]
-        sizeof(uint32_t) * path_count +    // m_Offsets[path_count]
-        sizeof(uint64_t) * path_count +    // m_Sizes[path_count]
-        path_data_size;
+    uint64_t m_Size;
+    uint32_t m_NameOffset;
+    uint16_t m_Permissions;
+    uint16_t m_IsDir;
 };
 
-static struct Longtail_FileInfos* CreateFileInfos(uint32_t path_count, uint32_t path_data_size)
+struct ScanDirectoryJob
 {
-    MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(path_count, "%u"),
-        LONGTAIL_LOGFIELD(path_data_size, "%u")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-
-    LONGTAIL_FATAL_ASSERT(ctx, (path_count == 0 && path_data_size == 0) || (path_count > 0 && path_data_size > path_count), return 0)
-    size_t file_infos_size = GetFileInfosSize(path_count, path_data_size);
-    struct Longtail_FileInfos* file_infos = (struct Longtail_FileInfos*)Longtail_Alloc("GetFilesRecursively", file_infos_size);
-    if (!file_infos)
-    {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-        return 0;
-    }
-    char* p = (char*)&file_infos[1];
-    file_infos->m_Count = 0;
-    file_infos->m_PathDataSize = 0;
-    file_infos->m_Sizes = (uint64_t*)p;
-    p += sizeof(uint64_t) * path_count;
-    file_infos->m_PathStartOffsets = (uint32_t*)p;
-    p += sizeof(uint32_t) * path_count;
-    file_infos->m_Permissions = (uint16_t*)p;
-    p += sizeof(uint16_t) * path_count;
-    file_infos->m_PathData = p;
-    return file_infos;
+    struct Longtail_StorageAPI* m_StorageAPI;
+    const char* m_FullSearchPath;
+    struct ScanDirectoryEntry* m_Entries;
+    char* m_NameData;
+    int m_Err;
 };
 
-int LongtailPrivate_MakeFileInfos(
-    uint32_t path_count,
-    const char* const* path_names,
-    const uint64_t* file_sizes,
-    const uint16_t* file_permissions,
-    struct Longtail_FileInfos** out_file_infos)
+static int ScanDirectory(void* context, uint32_t job_id, int is_cancelled)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(path_count, "%u"),
-        LONGTAIL_LOGFIELD(path_names, "%p"),
-        LONGTAIL_LOGFIELD(file_sizes, "%p"),
-        LONGTAIL_LOGFIELD(file_permissions, "%p"),
-        LONGTAIL_LOGFIELD(out_file_infos, "%p")
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
-    LONGTAIL_VALIDATE_INPUT(ctx, (path_count == 0 && path_names == 0) || (path_count > 0 && path_names != 0), return 0)
-    LONGTAIL_VALIDATE_INPUT(ctx, (path_count == 0 && file_sizes == 0) || (path_count > 0 && file_sizes != 0), return 0)
-    LONGTAIL_VALIDATE_INPUT(ctx, (path_count == 0 && file_permissions == 0) || (path_count > 0 && file_permissions != 0), return 0)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_file_infos != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return EINVAL)
 
-    uint32_t name_data_size = 0;
-    for (uint32_t i = 0; i < path_count; ++i)
+    struct ScanDirectoryJob* job = (struct ScanDirectoryJob*)context;
+    if (is_cancelled)
     {
-        name_data_size += (uint32_t)strlen(path_names[i]) + 1;
+        job->m_Err = ECANCELED;
+        return 0;
     }
-    struct Longtail_FileInfos* file_infos = CreateFileInfos(path_count, name_data_size);
-    if (file_infos == 0)
+
+    struct Longtail_StorageAPI* storage_api = job->m_StorageAPI;
+    Longtail_StorageAPI_HIterator fs_iterator = 0;
+    int err = storage_api->StartFind(storage_api, job->m_FullSearchPath, &fs_iterator);
+    if (err == ENOENT)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateFileInfos() failed with %d", ENOMEM)
-        return ENOMEM;
+        job->m_Err = 0;
+        return 0;
     }
-    uint32_t offset = 0;
-    for (uint32_t i = 0; i < path_count; ++i)
+    else if (err)
     {
-        uint32_t length = (uint32_t)strlen(path_names[i]) + 1;
-        file_infos->m_Sizes[i] = file_sizes[i];
-        file_infos->m_Permissions[i] = file_permissions[i];
-        file_infos->m_PathStartOffsets[i] = offset;
-        memmove(&file_infos->m_PathData[offset], path_names[i], length);
-        offset += length;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "storage_api->StartFind() failed with %d for `%s`", err, job->m_FullSearchPath)
+        job->m_Err = err;
+        return 0;
     }
-    file_infos->m_PathDataSize = offset;
-    file_infos->m_Count = path_count;
-    *out_file_infos = file_infos;
+    while (err == 0)
+    {
+        struct Longtail_StorageAPI_EntryProperties properties;
+        err = storage_api->GetEntryProperties(storage_api, fs_iterator, &properties);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "storage_api->GetEntryProperties() failed with %d in `%s`", err, job->m_FullSearchPath)
+        }
+        else
+        {
+            size_t name_size = strlen(properties.m_Name) + 1;
+            size_t name_offset = (size_t)arrlen(job->m_NameData);
+            arraddn(job->m_NameData, name_size);
+            memcpy(&job->m_NameData[name_offset], properties.m_Name, name_size);
+            struct ScanDirectoryEntry entry = {properties.m_Size, (uint32_t)name_offset, properties.m_Permissions, (uint16_t)(properties.m_IsDir ? 1 : 0)};
+            arrput(job->m_Entries, entry);
+        }
+        err = storage_api->FindNext(storage_api, fs_iterator);
+    }
+    storage_api->CloseFind(storage_api, fs_iterator);
+    job->m_Err = (err == ENOENT) ? 0 : err;
     return 0;
 }
 
-static int AppendPath(
-    struct Longtail_FileInfos** file_infos,
-    const char* path,
-    uint64_t file_size,
-    uint16_t file_permissions,
-    uint32_t* max_path_count,
-    uint32_t* max_data_size,
-    uint32_t path_count_increment,
-    uint32_t data_size_increment)
+// Walks the tree one directory level at a time, the directories of a level are
+// read in parallel and the entries are then handed to entry_processor on the
+// calling thread in the same order as RecurseTree() would.
+static int RecurseTreeParallel(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_JobAPI* optional_job_api,
+    struct Longtail_PathFilterAPI* optional_path_filter_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_folder,
+    ProcessEntry entry_processor,
+    void* context)
 {
-#if defined(LONGTAIL_ASSERTS)
     MAKE_LOG_CONTEXT_FIELDS(ctx)
-        LONGTAIL_LOGFIELD(file_infos, "%p"),
-        LONGTAIL_LOGFIELD(path, "%s"),
-        LONGTAIL_LOGFIELD(file_size, "%" PRIu64),
-        LONGTAIL_LOGFIELD(file_permissions, "%u"),
-        LONGTAIL_LOGFIELD(max_path_count, "%p"),
-        LONGTAIL_LOGFIELD(max_data_size, "%p"),
-        LONGTAIL_LOGFIELD(path_count_increment, "%u"),
-        LONGTAIL_LOGFIELD(data_size_increment, "%u")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
-#else
-    struct Longtail_LogContextFmt_Private* ctx = 0;
-#endif // defined(LONGTAIL_ASSERTS)
-    LONGTAIL_FATAL_ASSERT(ctx, (*file_infos) != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, max_path_count != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, max_data_size != 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, path_count_increment > 0, return EINVAL)
-    LONGTAIL_FATAL_ASSERT(ctx, data_size_increment > 0, return EINVAL)
-    uint32_t path_size = (uint32_t)(strlen(path) + 1);
-
-    int out_of_path_data = (*file_infos)->m_PathDataSize + path_size > *max_data_size;
-    int out_of_path_count = (*file_infos)->m_Count >= *max_path_count;
-    if (out_of_path_count | out_of_path_data)
-    {
-        uint32_t extra_path_count = out_of_path_count ? path_count_increment : 0;
-        uint32_t extra_path_data_size = out_of_path_data ? (path_count_increment * data_size_increment) : 0;
-
-        const uint32_t new_path_count = *max_path_count + extra_path_count;
-        const uint32_t new_path_data_size = *max_data_size + extra_path_data_size;
-        struct Longtail_FileInfos* new_file_infos = CreateFileInfos(new_path_count, new_path_data_size);
-        if (new_file_infos == 0)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateFileInfos() failed with %d", ENOMEM)
-            return ENOMEM;
-        }
-        *max_path_count = new_path_count;
-        *max_data_size = new_path_data_size;
-        new_file_infos->m_PathDataSize = (*file_infos)->m_PathDataSize;
-        new_file_infos->m_Count = (*file_infos)->m_Count;
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_job_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_path_filter_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(root_folder, "%s"),
+        LONGTAIL_LOGFIELD(entry_processor, "%p"),
+        LONGTAIL_LOGFIELD(context, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
-        memmove(new_file_infos->m_Sizes, (*file_infos)->m_Sizes, sizeof(uint64_t) * (*file_infos)->m_Count);
-        memmove(new_file_infos->m_PathStartOffsets, (*file_infos)->m_PathStartOffsets, sizeof(uint32_t) * (*file_infos)->m_Count);
-        memmove(new_file_infos->m_Permissions, (*file_infos)->m_Permissions, sizeof(uint32_t) * (*file_infos)->m_Count);
-        memmove(new_file_infos->m_PathData, (*file_infos)->m_PathData, (*file_infos)->m_PathDataSize);
+    LONGTAIL_FATAL_ASSERT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, root_folder != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, entry_processor != 0, return EINVAL)
 
-        Longtail_Free(*file_infos);
-        *file_infos = new_file_infos;
+    if (optional_job_api == 0)
+    {
+        return RecurseTree(storage_api, optional_path_filter_api, optional_cancel_api, optional_cancel_token, root_folder, entry_processor, context);
     }
 
-    memmove(&(*file_infos)->m_PathData[(*file_infos)->m_PathDataSize], path, path_size);
-    (*file_infos)->m_PathStartOffsets[(*file_infos)->m_Count] = (*file_infos)->m_PathDataSize;
+    uint32_t max_job_batch_count = 0;
+    int err = optional_job_api->GetMaxBatchCountFunc(optional_job_api, &max_job_batch_count, 0);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "optional_job_api->GetMaxBatchCountFunc() failed with %d", err)
+        return err;
+    }
+
+    char* root_folder_copy = Longtail_Strdup(root_folder);
+    if (!root_folder_copy)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Strdup() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+
+    char** full_search_paths = 0;
+    char** relative_parent_paths = 0;
+    char** next_full_search_paths = 0;
+    char** next_relative_parent_paths = 0;
+    arrput(full_search_paths, root_folder_copy);
+    arrput(relative_parent_paths, 0);
+
+    while (err == 0 && arrlen(full_search_paths) > 0)
+    {
+        if (optional_cancel_api && optional_cancel_token && optional_cancel_api->IsCancelled(optional_cancel_api, optional_cancel_token) == ECANCELED)
+        {
+            err = ECANCELED;
+            break;
+        }
+
+        uint32_t job_count = (uint32_t)arrlen(full_search_paths);
+        size_t work_mem_size = (sizeof(struct ScanDirectoryJob) * job_count) +
+            (sizeof(Longtail_JobAPI_JobFunc) * job_count) +
+            (sizeof(void*) * job_count);
+        void* work_mem = Longtail_Alloc("RecurseTreeParallel", work_mem_size);
+        if (!work_mem)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            err = ENOMEM;
+            break;
+        }
+        struct ScanDirectoryJob* jobs = (struct ScanDirectoryJob*)work_mem;
+        Longtail_JobAPI_JobFunc* funcs = (Longtail_JobAPI_JobFunc*)&jobs[job_count];
+        void** ctxs = (void**)&funcs[job_count];
+
+        for (uint32_t i = 0; i < job_count; ++i)
+        {
+            struct ScanDirectoryJob* job = &jobs[i];
+            job->m_StorageAPI = storage_api;
+            job->m_FullSearchPath = full_search_paths[i];
+            job->m_Entries = 0;
+            job->m_NameData = 0;
+            job->m_Err = EINVAL;
+            funcs[i] = ScanDirectory;
+            ctxs[i] = job;
+        }
+
+        if (job_count == 1)
+        {
+            ScanDirectory(&jobs[0], 0, 0);
+        }
+        else
+        {
+            Longtail_JobAPI_Group job_group = 0;
+            err = optional_job_api->ReserveJobs(optional_job_api, job_count, &job_group);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "optional_job_api->ReserveJobs() failed with %d", err)
+                Longtail_Free(work_mem);
+                break;
+            }
+            uint32_t jobs_submitted = 0;
+            while (jobs_submitted < job_count)
+            {
+                uint32_t batch_count = (job_count - jobs_submitted) < max_job_batch_count ? (job_count - jobs_submitted) : max_job_batch_count;
+                Longtail_JobAPI_Jobs batch_jobs;
+                err = optional_job_api->CreateJobs(optional_job_api, job_group, 0, optional_cancel_api, optional_cancel_token, batch_count, &funcs[jobs_submitted], &ctxs[jobs_submitted], 0, &batch_jobs);
+                LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+                err = optional_job_api->ReadyJobs(optional_job_api, batch_count, batch_jobs);
+                LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+                jobs_submitted += batch_count;
+            }
+            err = optional_job_api->WaitForAllJobs(optional_job_api, job_group, 0, optional_cancel_api, optional_cancel_token);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "optional_job_api->WaitForAllJobs() failed with %d", err)
+            }
+        }
+
+        for (uint32_t i = 0; i < job_count && err == 0; ++i)
+        {
+            struct ScanDirectoryJob* job = &jobs[i];
+            if (job->m_Err)
+            {
+                LONGTAIL_LOG(ctx, (job->m_Err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_WARNING, "ScanDirectory() failed with %d for `%s`", job->m_Err, job->m_FullSearchPath)
+                err = job->m_Err;
+                break;
+            }
+            const char* relative_parent_path = relative_parent_paths[i];
+            size_t relative_parent_path_length = relative_parent_path ? strlen(relative_parent_path) : 0;
+            uint32_t entry_count = (uint32_t)arrlen(job->m_Entries);
+            for (uint32_t e = 0; e < entry_count; ++e)
+            {
+                const struct ScanDirectoryEntry* entry = &job->m_Entries[e];
+                const char* name = &job->m_NameData[entry->m_NameOffset];
+                size_t name_length = strlen(name);
+                size_t asset_path_length = relative_parent_path ? (relative_parent_path_length + 1 + name_length) : name_length;
+                char* asset_path = (char*)Longtail_Alloc("GetFilesRecursively", asset_path_length + 1);
+                if (!asset_path)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+                    err = ENOMEM;
+                    break;
+                }
+                if (relative_parent_path)
+                {
+                    memcpy(asset_path, relative_parent_path, relative_parent_path_length);
+                    asset_path[relative_parent_path_length] = '/';
+                    memcpy(&asset_path[relative_parent_path_length + 1], name, name_length + 1);
+                }
+                else
+                {
+                    memcpy(asset_path, name, name_length + 1);
+                }
+
+                struct Longtail_StorageAPI_EntryProperties properties = {name, entry->m_Size, entry->m_Permissions, entry->m_IsDir};
+                if (!optional_path_filter_api
+                    || optional_path_filter_api->Include(
+                        optional_path_filter_api,
+                        root_folder,
+                        asset_path,
+                        properties.m_Name,
+                        properties.m_IsDir,
+                        properties.m_Size,
+                        properties.m_Permissions)
+                    )
+                {
+                    err = entry_processor(context, job->m_FullSearchPath, asset_path, &properties);
+                    if (err)
+                    {
+                        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "entry_processor() failed with %d for `%s`",
+                            err, asset_path)
+                        Longtail_Free(asset_path);
+                        break;
+                    }
+                    if (properties.m_IsDir)
+                    {
+                        arrput(next_full_search_paths, storage_api->ConcatPath(storage_api, job->m_FullSearchPath, name));
+                        arrput(next_relative_parent_paths, asset_path);
+                        asset_path = 0;
+                    }
+                }
+                Longtail_Free(asset_path);
+            }
+        }
+
+        for (uint32_t i = 0; i < job_count; ++i)
+        {
+            arrfree(jobs[i].m_Entries);
+            arrfree(jobs[i].m_NameData);
+            Longtail_Free(full_search_paths[i]);
+            Longtail_Free(relative_parent_paths[i]);
+        }
+        Longtail_Free(work_mem);
+
+        arrsetlen(full_search_paths, 0);
+        arrsetlen(relative_parent_paths, 0);
+        char** swap_paths = full_search_paths;
+        full_search_paths = next_full_search_paths;
+        next_full_search_paths = swap_paths;
+        swap_paths = relative_parent_paths;
+        relative_parent_paths = next_relative_parent_paths;
+        next_relative_parent_paths = swap_paths;
+    }
+
+    for (ptrdiff_t i = 0; i < arrlen(full_search_paths); ++i)
+    {
+        Longtail_Free(full_search_paths[i]);
+        Longtail_Free(relative_parent_paths[i]);
+    }
+    arrfree(next_relative_parent_paths);
+    arrfree(next_full_search_paths);
+    arrfree(relative_parent_paths);
+    arrfree(full_search_paths);
+    return err;
+}
+
+static size_t GetFileInfosSize(uint32_t path_count, uint32_t path_data_size)
+{
+    return sizeof(struct Longtail_FileInfos) +
+        sizeof(uint32_t) * path_count +    // m_Permissions[path_count]
+        sizeof(uint32_t) * path_count +    // m_Offsets[path_count]
+        sizeof(uint64_t) * path_count +    // m_Sizes[path_count]
+        path_data_size;
+};
+
+static struct Longtail_FileInfos* CreateFileInfos(uint32_t path_count, uint32_t path_data_size)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(path_count, "%u"),
+        LONGTAIL_LOGFIELD(path_data_size, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, (path_count == 0 && path_data_size == 0) || (path_count > 0 && path_data_size > path_count), return 0)
+    size_t file_infos_size = GetFileInfosSize(path_count, path_data_size);
+    struct Longtail_FileInfos* file_infos = (struct Longtail_FileInfos*)Longtail_Alloc("GetFilesRecursively", file_infos_size);
+    if (!file_infos)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return 0;
+    }
+    char* p = (char*)&file_infos[1];
+    file_infos->m_Count = 0;
+    file_infos->m_PathDataSize = 0;
+    file_infos->m_Sizes = (uint64_t*)p;
+    p += sizeof(uint64_t) * path_count;
+    file_infos->m_PathStartOffsets = (uint32_t*)p;
+    p += sizeof(uint32_t) * path_count;
+    file_infos->m_Permissions = (uint16_t*)p;
+    p += sizeof(uint16_t) * path_count;
+    file_infos->m_PathData = p;
+    return file_infos;
+};
+
+int LongtailPrivate_MakeFileInfos(
+    uint32_t path_count,
+    const char* const* path_names,
+    const uint64_t* file_sizes,
+    const uint16_t* file_permissions,
+    struct Longtail_FileInfos** out_file_infos)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(path_count, "%u"),
+        LONGTAIL_LOGFIELD(path_names, "%p"),
+        LONGTAIL_LOGFIELD(file_sizes, "%p"),
+        LONGTAIL_LOGFIELD(file_permissions, "%p"),
+        LONGTAIL_LOGFIELD(out_file_infos, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, (path_count == 0 && path_names == 0) || (path_count > 0 && path_names != 0), return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, (path_count == 0 && file_sizes == 0) || (path_count > 0 && file_sizes != 0), return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, (path_count == 0 && file_permissions == 0) || (path_count > 0 && file_permissions != 0), return 0)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_file_infos != 0, return 0)
+
+    uint32_t name_data_size = 0;
+    for (uint32_t i = 0; i < path_count; ++i)
+    {
+        name_data_size += (uint32_t)strlen(path_names[i]) + 1;
+    }
+    struct Longtail_FileInfos* file_infos = CreateFileInfos(path_count, name_data_size);
+    if (file_infos == 0)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateFileInfos() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < path_count; ++i)
+    {
+        uint32_t length = (uint32_t)strlen(path_names[i]) + 1;
+        file_infos->m_Sizes[i] = file_sizes[i];
+        file_infos->m_Permissions[i] = file_permissions[i];
+        file_infos->m_PathStartOffsets[i] = offset;
+        memmove(&file_infos->m_PathData[offset], path_names[i], length);
+        offset += length;
+    }
+    file_infos->m_PathDataSize = offset;
+    file_infos->m_Count = path_count;
+    *out_file_infos = file_infos;
+    return 0;
+}
+
+int Longtail_MakeFileInfos(
+    uint32_t path_count,
+    const char* const* path_names,
+    const uint64_t* file_sizes,
+    const uint16_t* file_permissions,
+    struct Longtail_FileInfos** out_file_infos)
+{
+    return LongtailPrivate_MakeFileInfos(path_count, path_names, file_sizes, file_permissions, out_file_infos);
+}
+
+static int AppendPath(
+    struct Longtail_FileInfos** file_infos,
+    const char* path,
+    uint64_t file_size,
+    uint16_t file_permissions,
+    uint32_t* max_path_count,
+    uint32_t* max_data_size,
+    uint32_t path_count_increment,
+    uint32_t data_size_increment)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(file_infos, "%p"),
+        LONGTAIL_LOGFIELD(path, "%s"),
+        LONGTAIL_LOGFIELD(file_size, "%" PRIu64),
+        LONGTAIL_LOGFIELD(file_permissions, "%u"),
+        LONGTAIL_LOGFIELD(max_path_count, "%p"),
+        LONGTAIL_LOGFIELD(max_data_size, "%p"),
+        LONGTAIL_LOGFIELD(path_count_increment, "%u"),
+        LONGTAIL_LOGFIELD(data_size_increment, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+    LONGTAIL_FATAL_ASSERT(ctx, (*file_infos) != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, max_path_count != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, max_data_size != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, path_count_increment > 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, data_size_increment > 0, return EINVAL)
+    uint32_t path_size = (uint32_t)(strlen(path) + 1);
+
+    int out_of_path_data = (*file_infos)->m_PathDataSize + path_size > *max_data_size;
+    int out_of_path_count = (*file_infos)->m_Count >= *max_path_count;
+    if (out_of_path_count | out_of_path_data)
+    {
+        uint32_t extra_path_count = out_of_path_count ? path_count_increment : 0;
+        uint32_t extra_path_data_size = out_of_path_data ? (path_count_increment * data_size_increment) : 0;
+
+        const uint32_t new_path_count = *max_path_count + extra_path_count;
+        const uint32_t new_path_data_size = *max_data_size + extra_path_data_size;
+        struct Longtail_FileInfos* new_file_infos = CreateFileInfos(new_path_count, new_path_data_size);
+        if (new_file_infos == 0)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateFileInfos() failed with %d", ENOMEM)
+            return ENOMEM;
+        }
+        *max_path_count = new_path_count;
+        *max_data_size = new_path_data_size;
+        new_file_infos->m_PathDataSize = (*file_infos)->m_PathDataSize;
+        new_file_infos->m_Count = (*file_infos)->m_Count;
+
+        memmove(new_file_infos->m_Sizes, (*file_infos)->m_Sizes, sizeof(uint64_t) * (*file_infos)->m_Count);
+        memmove(new_file_infos->m_PathStartOffsets, (*file_infos)->m_PathStartOffsets, sizeof(uint32_t) * (*file_infos)->m_Count);
+        memmove(new_file_infos->m_Permissions, (*file_infos)->m_Permissions, sizeof(uint32_t) * (*file_infos)->m_Count);
+        memmove(new_file_infos->m_PathData, (*file_infos)->m_PathData, (*file_infos)->m_PathDataSize);
+
+        Longtail_Free(*file_infos);
+        *file_infos = new_file_infos;
+    }
+
+    memmove(&(*file_infos)->m_PathData[(*file_infos)->m_PathDataSize], path, path_size);
+    (*file_infos)->m_PathStartOffsets[(*file_infos)->m_Count] = (*file_infos)->m_PathDataSize;
     (*file_infos)->m_PathDataSize += path_size;
     (*file_infos)->m_Sizes[(*file_infos)->m_Count] = file_size;
     (*file_infos)->m_Permissions[(*file_infos)->m_Count] = file_permissions;
@@ -1565,9 +2045,22 @@ int Longtail_GetFilesRecursively(
     Longtail_CancelAPI_HCancelToken optional_cancel_token,
     const char* root_path,
     struct Longtail_FileInfos** out_file_infos)
+{
+    return Longtail_GetFilesRecursivelyWithJobs(storage_api, 0, optional_path_filter_api, optional_cancel_api, optional_cancel_token, root_path, out_file_infos);
+}
+
+int Longtail_GetFilesRecursivelyWithJobs(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_JobAPI* optional_job_api,
+    struct Longtail_PathFilterAPI* optional_path_filter_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    struct Longtail_FileInfos** out_file_infos)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_job_api, "%p"),
         LONGTAIL_LOGFIELD(optional_path_filter_api, "%p"),
         LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
         LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
@@ -1591,10 +2084,10 @@ int Longtail_GetFilesRecursively(
     struct AddFile_Context context = {storage_api, default_path_count, default_path_data_size, (uint32_t)(strlen(root_path)), file_infos};
     file_infos = 0;
 
-    int err = RecurseTree(storage_api, optional_path_filter_api, optional_cancel_api, optional_cancel_token, root_path, AddFile, &context);
+    int err = RecurseTreeParallel(storage_api, optional_job_api, optional_path_filter_api, optional_cancel_api, optional_cancel_token, root_path, AddFile, &context);
     if(err)
     {
-        LONGTAIL_LOG(ctx, (err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "RecurseTree() failed with %d", err)
+        LONGTAIL_LOG(ctx, (err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "RecurseTreeParallel() failed with %d", err)
         Longtail_Free(context.m_FileInfos);
         context.m_FileInfos = 0;
         return err;
@@ -1673,6 +2166,7 @@ static int FilteredAddFile(void* context, const char* root_path, const char* ass
 
 int Longtail_GetFilesFilteredByVersionIndex(
     struct Longtail_StorageAPI* storage_api,
+    struct Longtail_JobAPI* optional_job_api,
     struct Longtail_VersionIndex* version_index,
     struct Longtail_CancelAPI* optional_cancel_api,
     Longtail_CancelAPI_HCancelToken optional_cancel_token,
@@ -1681,6 +2175,7 @@ int Longtail_GetFilesFilteredByVersionIndex(
 {
   MAKE_LOG_CONTEXT_FIELDS(ctx)
       LONGTAIL_LOGFIELD(storage_api, "%p"),
+      LONGTAIL_LOGFIELD(optional_job_api, "%p"),
       LONGTAIL_LOGFIELD(version_index, "%p"),
       LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
       LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
@@ -1764,13 +2259,13 @@ int Longtail_GetFilesFilteredByVersionIndex(
   // retrieves size+permissions from cached WIN32_FIND_DATAW with no extra syscalls.
   // This replaces the old per-file OpenReadFile loop which was extremely slow for
   // files in non-existent directories (CreateFileW retry loop with Sleep).
-  int err = RecurseTree(storage_api, 0, optional_cancel_api, optional_cancel_token, root_path, FilteredAddFile, &context);
+  int err = RecurseTreeParallel(storage_api, optional_job_api, 0, optional_cancel_api, optional_cancel_token, root_path, FilteredAddFile, &context);
 
   Longtail_Free(lut_mem);
 
   if (err)
   {
-      LONGTAIL_LOG(ctx, (err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "RecurseTree() failed with %d", err)
+      LONGTAIL_LOG(ctx, (err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "RecurseTreeParallel() failed with %d", err)
       Longtail_Free(context.m_FileInfos);
       return err;
   }
@@ -1820,34 +2315,126 @@ static int StorageChunkFeederFunc(void* context, Longtail_ChunkerAPI_HChunker ch
         int err = c->m_StorageAPI->Read(c->m_StorageAPI, c->m_AssetFile, c->m_StartRange + c->m_Offset, read_count, buffer);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "m_StorageAPI->Read() failed with %d", err)
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "m_StorageAPI->Read() failed with %d", err)
+            return err;
+        }
+        c->m_Offset += read_count;
+    }
+    *out_size = (uint32_t)read_count;
+    return 0;
+}
+
+struct HashJob
+{
+    struct Longtail_StorageAPI* m_StorageAPI;
+    struct Longtail_HashAPI* m_HashAPI;
+    struct Longtail_ChunkerAPI* m_ChunkerAPI;
+    TLongtail_Hash* m_PathHash;
+    uint32_t m_AssetIndex;
+    const char* m_RootPath;
+    const char* m_Path;
+    uint64_t m_StartRange;
+    uint64_t m_SizeRange;
+    uint32_t* m_AssetChunkCount;
+    TLongtail_Hash* m_ChunkHashes;
+    uint32_t* m_ChunkSizes;
+    uint32_t m_TargetChunkSize;
+    int m_ReserveZeroChunks;
+    int m_EnableFileMap;
+    int m_Err;
+};
+
+// Chunks are hashed in batches so hash apis with HashBuffers can hash many small chunks
+// at once while the chunk data is still in cache. Chunks from the chunker feeder are only
+// valid until the next chunk so the smaller ones are copied to a stage buffer, larger chunks
+// do not gain from batching and are hashed directly.
+#define CHUNK_HASH_BATCH_COUNT          64
+#define CHUNK_HASH_BATCH_STAGE_SIZE     (256 * 1024)
+#define CHUNK_HASH_BATCH_MAX_STAGED     (CHUNK_HASH_BATCH_STAGE_SIZE / 16)
+
+struct ChunkHashBatch
+{
+    struct Longtail_HashAPI* m_HashAPI;
+    int m_ReserveZeroChunks;
+    char* m_Stage;
+    uint32_t m_StageUsed;
+    uint32_t m_Count;
+    uint32_t m_ChunkIndexes[CHUNK_HASH_BATCH_COUNT];
+    uint32_t m_Lengths[CHUNK_HASH_BATCH_COUNT];
+    const void* m_Datas[CHUNK_HASH_BATCH_COUNT];
+    TLongtail_Hash m_Hashes[CHUNK_HASH_BATCH_COUNT];
+};
+
+static int IsZeroData(const void* data, uint32_t length)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    return length > 0 && p[0] == 0 && memcmp(p, &p[1], length - 1) == 0;
+}
+
+// Hashes the data of a chunk, if reserve_zero_chunks is set all-zero chunks get the reserved zero chunk hash
+static int HashChunk(struct Longtail_HashAPI* hash_api, int reserve_zero_chunks, uint32_t length, const void* data, TLongtail_Hash* out_hash)
+{
+    if (reserve_zero_chunks && IsZeroData(data, length))
+    {
+        *out_hash = Longtail_GetZeroChunkHash(length);
+        return 0;
+    }
+    return hash_api->HashBuffer(hash_api, length, data, out_hash);
+}
+
+static int ChunkHashBatch_Flush(struct ChunkHashBatch* batch, TLongtail_Hash* chunk_hashes)
+{
+    if (batch->m_Count == 0)
+    {
+        return 0;
+    }
+    int err = Longtail_Hash_HashBuffers(batch->m_HashAPI, batch->m_Count, batch->m_Lengths, batch->m_Datas, batch->m_Hashes);
+    if (err)
+    {
+        return err;
+    }
+    for (uint32_t i = 0; i < batch->m_Count; ++i)
+    {
+        chunk_hashes[batch->m_ChunkIndexes[i]] = batch->m_Hashes[i];
+    }
+    batch->m_Count = 0;
+    batch->m_StageUsed = 0;
+    return 0;
+}
+
+// Adds a chunk to the batch, data must stay valid until the batch is flushed unless the batch has a stage buffer
+static int ChunkHashBatch_Add(struct ChunkHashBatch* batch, TLongtail_Hash* chunk_hashes, uint32_t chunk_index, uint32_t length, const void* data)
+{
+    if (batch->m_ReserveZeroChunks && IsZeroData(data, length))
+    {
+        chunk_hashes[chunk_index] = Longtail_GetZeroChunkHash(length);
+        return 0;
+    }
+    if (batch->m_Stage && length > CHUNK_HASH_BATCH_MAX_STAGED)
+    {
+        return batch->m_HashAPI->HashBuffer(batch->m_HashAPI, length, data, &chunk_hashes[chunk_index]);
+    }
+    if (batch->m_Count == CHUNK_HASH_BATCH_COUNT || (batch->m_Stage && batch->m_StageUsed + length > CHUNK_HASH_BATCH_STAGE_SIZE))
+    {
+        int err = ChunkHashBatch_Flush(batch, chunk_hashes);
+        if (err)
+        {
             return err;
         }
-        c->m_Offset += read_count;
     }
-    *out_size = (uint32_t)read_count;
+    if (batch->m_Stage)
+    {
+        memcpy(&batch->m_Stage[batch->m_StageUsed], data, length);
+        data = &batch->m_Stage[batch->m_StageUsed];
+        batch->m_StageUsed += length;
+    }
+    batch->m_ChunkIndexes[batch->m_Count] = chunk_index;
+    batch->m_Lengths[batch->m_Count] = length;
+    batch->m_Datas[batch->m_Count] = data;
+    ++batch->m_Count;
     return 0;
 }
 
-struct HashJob
-{
-    struct Longtail_StorageAPI* m_StorageAPI;
-    struct Longtail_HashAPI* m_HashAPI;
-    struct Longtail_ChunkerAPI* m_ChunkerAPI;
-    TLongtail_Hash* m_PathHash;
-    uint32_t m_AssetIndex;
-    const char* m_RootPath;
-    const char* m_Path;
-    uint64_t m_StartRange;
-    uint64_t m_SizeRange;
-    uint32_t* m_AssetChunkCount;
-    TLongtail_Hash* m_ChunkHashes;
-    uint32_t* m_ChunkSizes;
-    uint32_t m_TargetChunkSize;
-    int m_EnableFileMap;
-    int m_Err;
-};
-
 #define MIN_CHUNKER_SIZE(min_chunk_size, target_chunk_size) (((target_chunk_size / 8) < min_chunk_size) ? min_chunk_size : (target_chunk_size / 8))
 #define AVG_CHUNKER_SIZE(min_chunk_size, target_chunk_size) (((target_chunk_size / 2) < min_chunk_size) ? min_chunk_size : (target_chunk_size / 2))
 #define MAX_CHUNKER_SIZE(min_chunk_size, target_chunk_size) (((target_chunk_size * 2) < min_chunk_size) ? min_chunk_size : (target_chunk_size * 2))
@@ -1947,10 +2534,10 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
                 return 0;
             }
 
-            err = hash_job->m_HashAPI->HashBuffer(hash_job->m_HashAPI, (uint32_t)hash_size, buffer, &hash_job->m_ChunkHashes[0]);
+            err = HashChunk(hash_job->m_HashAPI, hash_job->m_ReserveZeroChunks, (uint32_t)hash_size, buffer, &hash_job->m_ChunkHashes[0]);
             if (err)
             {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "hash_job->m_HashAPI->HashBuffer() failed with %d", err)
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "HashChunk() failed with %d", err)
                 Longtail_Free(buffer);
                 buffer = 0;
                 storage_api->CloseFile(storage_api, file_handle);
@@ -1989,6 +2576,13 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
                 return 0;
             }
 
+            struct ChunkHashBatch batch;
+            batch.m_HashAPI = hash_job->m_HashAPI;
+            batch.m_ReserveZeroChunks = hash_job->m_ReserveZeroChunks;
+            batch.m_Stage = 0;
+            batch.m_StageUsed = 0;
+            batch.m_Count = 0;
+
             int use_read_file = 1;
             if (hash_job->m_EnableFileMap)
             {
@@ -2053,10 +2647,10 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
                             return 0;
                         }
                         uint32_t range_length = (uint32_t)(next_chunk_start - chunk_start_ptr);
-                        err = hash_job->m_HashAPI->HashBuffer(hash_job->m_HashAPI, range_length, (const void*)chunk_start_ptr, &hash_job->m_ChunkHashes[chunk_count]);
+                        err = ChunkHashBatch_Add(&batch, hash_job->m_ChunkHashes, chunk_count, range_length, (const void*)chunk_start_ptr);
                         if (err != 0)
                         {
-                            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "hash_job->m_HashAPI->HashBuffer() failed with %d", err)
+                            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ChunkHashBatch_Add() failed with %d", err)
                             storage_api->UnMapFile(storage_api, mapping);
                             mapping = 0;
                             hash_job->m_ChunkerAPI->DisposeChunker(hash_job->m_ChunkerAPI, chunker);
@@ -2072,7 +2666,20 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
                         ++chunk_count;
                         chunk_start_ptr = next_chunk_start;
                     }
+                    err = ChunkHashBatch_Flush(&batch, hash_job->m_ChunkHashes);
                     storage_api->UnMapFile(storage_api, mapping);
+                    if (err != 0)
+                    {
+                        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ChunkHashBatch_Flush() failed with %d", err)
+                        hash_job->m_ChunkerAPI->DisposeChunker(hash_job->m_ChunkerAPI, chunker);
+                        chunker = 0;
+                        storage_api->CloseFile(storage_api, file_handle);
+                        file_handle = 0;
+                        Longtail_Free(path);
+                        path = 0;
+                        hash_job->m_Err = err;
+                        return 0;
+                    }
                 }
             }
             if (use_read_file)
@@ -2087,6 +2694,20 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
                     0
                 };
 
+                batch.m_Stage = (char*)Longtail_Alloc("DynamicChunking", CHUNK_HASH_BATCH_STAGE_SIZE);
+                if (!batch.m_Stage)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+                    hash_job->m_ChunkerAPI->DisposeChunker(hash_job->m_ChunkerAPI, chunker);
+                    chunker = 0;
+                    storage_api->CloseFile(storage_api, file_handle);
+                    file_handle = 0;
+                    Longtail_Free(path);
+                    path = 0;
+                    hash_job->m_Err = ENOMEM;
+                    return 0;
+                }
+
                 struct Longtail_Chunker_ChunkRange chunk_range;
                 err = hash_job->m_ChunkerAPI->NextChunk(hash_job->m_ChunkerAPI, chunker, StorageChunkFeederFunc, &feeder_context, &chunk_range);
                 while (err == 0)
@@ -2100,6 +2721,7 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
                         if (!new_output_mem)
                         {
                             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+                            Longtail_Free(batch.m_Stage);
                             hash_job->m_ChunkerAPI->DisposeChunker(hash_job->m_ChunkerAPI, chunker);
                             chunker = 0;
                             storage_api->CloseFile(storage_api, file_handle);
@@ -2124,10 +2746,11 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
                         chunk_capacity = new_chunk_capacity;
                     }
 
-                    err = hash_job->m_HashAPI->HashBuffer(hash_job->m_HashAPI, chunk_range.len, (void*)chunk_range.buf, &hash_job->m_ChunkHashes[chunk_count]);
+                    err = ChunkHashBatch_Add(&batch, hash_job->m_ChunkHashes, chunk_count, chunk_range.len, chunk_range.buf);
                     if (err != 0)
                     {
-                        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "hash_job->m_HashAPI->HashBuffer() failed with %d", err)
+                        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ChunkHashBatch_Add() failed with %d", err)
+                        Longtail_Free(batch.m_Stage);
                         hash_job->m_ChunkerAPI->DisposeChunker(hash_job->m_ChunkerAPI, chunker);
                         chunker = 0;
                         storage_api->CloseFile(storage_api, file_handle);
@@ -2143,6 +2766,21 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
 
                     err = hash_job->m_ChunkerAPI->NextChunk(hash_job->m_ChunkerAPI, chunker, StorageChunkFeederFunc, &feeder_context, &chunk_range);
                 }
+                err = ChunkHashBatch_Flush(&batch, hash_job->m_ChunkHashes);
+                Longtail_Free(batch.m_Stage);
+                batch.m_Stage = 0;
+                if (err != 0)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "ChunkHashBatch_Flush() failed with %d", err)
+                    hash_job->m_ChunkerAPI->DisposeChunker(hash_job->m_ChunkerAPI, chunker);
+                    chunker = 0;
+                    storage_api->CloseFile(storage_api, file_handle);
+                    file_handle = 0;
+                    Longtail_Free(path);
+                    path = 0;
+                    hash_job->m_Err = err;
+                    return 0;
+                }
             }
             hash_job->m_ChunkerAPI->DisposeChunker(hash_job->m_ChunkerAPI, chunker);
         }
@@ -2160,6 +2798,354 @@ static int DynamicChunking(void* context, uint32_t job_id, int is_cancelled)
     return 0;
 }
 
+struct ResyncChunksJob
+{
+    struct Longtail_StorageAPI* m_StorageAPI;
+    struct Longtail_HashAPI* m_HashAPI;
+    struct Longtail_ChunkerAPI* m_ChunkerAPI;
+    const char* m_RootPath;
+    struct HashJob* m_PartJobs;
+    uint32_t m_PartCount;
+    uint64_t m_AssetSize;
+    TLongtail_Hash* m_ChunkHashes;
+    uint32_t* m_ChunkSizes;
+    uint32_t m_ChunkCount;
+    uint32_t m_ChunkCapacity;
+    int m_Err;
+};
+
+static int ResyncChunksJob_AddChunk(struct ResyncChunksJob* job, TLongtail_Hash chunk_hash, uint32_t chunk_size)
+{
+    if (job->m_ChunkCount == job->m_ChunkCapacity)
+    {
+        uint32_t new_chunk_capacity = job->m_ChunkCapacity + 16 + (job->m_ChunkCapacity / 2);
+        void* new_output_mem = Longtail_Alloc("ResyncChunks", sizeof(TLongtail_Hash) * new_chunk_capacity + sizeof(uint32_t) * new_chunk_capacity);
+        if (!new_output_mem)
+        {
+            return ENOMEM;
+        }
+        TLongtail_Hash* new_chunk_hashes = (TLongtail_Hash*)new_output_mem;
+        uint32_t* new_chunk_sizes = (uint32_t*)&new_chunk_hashes[new_chunk_capacity];
+        if (job->m_ChunkHashes)
+        {
+            memcpy(new_chunk_hashes, job->m_ChunkHashes, sizeof(TLongtail_Hash) * job->m_ChunkCount);
+            memcpy(new_chunk_sizes, job->m_ChunkSizes, sizeof(uint32_t) * job->m_ChunkCount);
+            Longtail_Free(job->m_ChunkHashes);
+        }
+        job->m_ChunkHashes = new_chunk_hashes;
+        job->m_ChunkSizes = new_chunk_sizes;
+        job->m_ChunkCapacity = new_chunk_capacity;
+    }
+    job->m_ChunkHashes[job->m_ChunkCount] = chunk_hash;
+    job->m_ChunkSizes[job->m_ChunkCount] = chunk_size;
+    ++job->m_ChunkCount;
+    return 0;
+}
+
+// The parts of a large asset are chunked independently from the start of each part which
+// forces a chunk boundary at every part edge. The chunker decides each boundary only from
+// the data following the start of the chunk, so re-chunking from the start of the last
+// chunk of a part will sooner or later end on a boundary that the next part also found, from
+// there on the chunks of that part are the same as a serial pass over the asset would find.
+static int ResyncChunks(void* context, uint32_t job_id, int is_cancelled)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return EINVAL)
+    struct ResyncChunksJob* job = (struct ResyncChunksJob*)context;
+
+    if (is_cancelled)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Cancelled with errno %d", ECANCELED)
+        job->m_Err = ECANCELED;
+        return 0;
+    }
+
+    // A trailing part can be empty if the asset size is a multiple of the part size
+    uint32_t part_count = job->m_PartCount;
+    while (part_count > 1 && *job->m_PartJobs[part_count - 1].m_AssetChunkCount == 0)
+    {
+        --part_count;
+    }
+
+    struct Longtail_StorageAPI* storage_api = job->m_StorageAPI;
+    struct Longtail_ChunkerAPI* chunker_api = job->m_ChunkerAPI;
+    char* path = 0;
+    Longtail_StorageAPI_HOpenFile file_handle = 0;
+    Longtail_ChunkerAPI_HChunker chunker = 0;
+    struct StorageChunkFeederContext feeder_context;
+
+    int err = 0;
+    uint64_t pos = 0;
+    uint32_t part = 0;
+    uint32_t part_chunk = 0;
+    uint64_t part_chunk_start = 0;
+    int in_sync = 1;
+    while (err == 0 && pos < job->m_AssetSize)
+    {
+        struct HashJob* part_job = &job->m_PartJobs[part];
+        uint32_t part_chunk_count = *part_job->m_AssetChunkCount;
+        if (in_sync)
+        {
+            if (part_chunk == part_chunk_count - 1 && part + 1 < part_count)
+            {
+                // The last chunk of a part ends at the forced part boundary
+                in_sync = 0;
+                continue;
+            }
+            uint32_t chunk_size = part_job->m_ChunkSizes[part_chunk];
+            err = ResyncChunksJob_AddChunk(job, part_job->m_ChunkHashes[part_chunk], chunk_size);
+            pos += chunk_size;
+            part_chunk_start += chunk_size;
+            ++part_chunk;
+            continue;
+        }
+
+        if (chunker == 0)
+        {
+            if (file_handle == 0)
+            {
+                path = storage_api->ConcatPath(storage_api, job->m_RootPath, part_job->m_Path);
+                err = storage_api->OpenReadFile(storage_api, path, &file_handle);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
+                    file_handle = 0;
+                    break;
+                }
+            }
+            uint32_t chunker_min_size;
+            err = chunker_api->GetMinChunkSize(chunker_api, &chunker_min_size);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "chunker_api->GetMinChunkSize() failed with %d", err)
+                break;
+            }
+            uint32_t target_chunk_size = part_job->m_TargetChunkSize;
+            err = chunker_api->CreateChunker(
+                chunker_api,
+                MIN_CHUNKER_SIZE(chunker_min_size, target_chunk_size),
+                AVG_CHUNKER_SIZE(chunker_min_size, target_chunk_size),
+                MAX_CHUNKER_SIZE(chunker_min_size, target_chunk_size),
+                &chunker);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "chunker_api->CreateChunker() failed with %d", err)
+                chunker = 0;
+                break;
+            }
+            feeder_context.m_StorageAPI = storage_api;
+            feeder_context.m_AssetFile = file_handle;
+            feeder_context.m_AssetPath = path;
+            feeder_context.m_StartRange = pos;
+            feeder_context.m_Size = job->m_AssetSize - pos;
+            feeder_context.m_Offset = 0;
+        }
+
+        struct Longtail_Chunker_ChunkRange chunk_range;
+        err = chunker_api->NextChunk(chunker_api, chunker, StorageChunkFeederFunc, &feeder_context, &chunk_range);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "chunker_api->NextChunk() failed with %d", err)
+            break;
+        }
+        TLongtail_Hash chunk_hash;
+        err = HashChunk(job->m_HashAPI, job->m_PartJobs[0].m_ReserveZeroChunks, chunk_range.len, (void*)chunk_range.buf, &chunk_hash);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "HashChunk() failed with %d", err)
+            break;
+        }
+        err = ResyncChunksJob_AddChunk(job, chunk_hash, chunk_range.len);
+        pos += chunk_range.len;
+
+        // Look for a chunk of the part we are in that starts where this chunk ended
+        while (part + 1 < part_count && pos >= job->m_PartJobs[part + 1].m_StartRange)
+        {
+            ++part;
+            part_chunk = 0;
+            part_chunk_start = job->m_PartJobs[part].m_StartRange;
+        }
+        part_job = &job->m_PartJobs[part];
+        part_chunk_count = *part_job->m_AssetChunkCount;
+        while (part_chunk < part_chunk_count && part_chunk_start < pos)
+        {
+            part_chunk_start += part_job->m_ChunkSizes[part_chunk];
+            ++part_chunk;
+        }
+        if (part_chunk_start == pos && part_chunk < part_chunk_count && (part_chunk < part_chunk_count - 1 || part + 1 == part_count))
+        {
+            in_sync = 1;
+            chunker_api->DisposeChunker(chunker_api, chunker);
+            chunker = 0;
+        }
+    }
+
+    if (chunker)
+    {
+        chunker_api->DisposeChunker(chunker_api, chunker);
+    }
+    if (file_handle)
+    {
+        storage_api->CloseFile(storage_api, file_handle);
+    }
+    Longtail_Free(path);
+    job->m_Err = err;
+    return 0;
+}
+
+static int ResyncAssetPartChunks(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    struct HashJob* hash_jobs,
+    uint32_t hash_job_count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(chunker_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(root_path, "%s"),
+        LONGTAIL_LOGFIELD(hash_jobs, "%p"),
+        LONGTAIL_LOGFIELD(hash_job_count, "%u")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    uint32_t job_count = 0;
+    for (uint32_t i = 0; i + 1 < hash_job_count; ++i)
+    {
+        if (hash_jobs[i].m_StartRange == 0 && hash_jobs[i + 1].m_AssetIndex == hash_jobs[i].m_AssetIndex)
+        {
+            ++job_count;
+        }
+    }
+    if (job_count == 0)
+    {
+        return 0;
+    }
+
+    uint32_t max_job_batch_count = 0;
+    int err = job_api->GetMaxBatchCountFunc(job_api, &max_job_batch_count, 0);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->GetMaxBatchCountFunc() failed with %d", err)
+        return err;
+    }
+
+    size_t work_mem_size = (sizeof(struct ResyncChunksJob) * job_count) +
+        (sizeof(Longtail_JobAPI_JobFunc) * job_count) +
+        (sizeof(void*) * job_count);
+    void* work_mem = Longtail_Alloc("ResyncAssetPartChunks", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct ResyncChunksJob* resync_jobs = (struct ResyncChunksJob*)work_mem;
+    Longtail_JobAPI_JobFunc* funcs = (Longtail_JobAPI_JobFunc*)&resync_jobs[job_count];
+    void** ctxs = (void**)&funcs[job_count];
+
+    uint32_t job_index = 0;
+    for (uint32_t i = 0; i < hash_job_count; ++i)
+    {
+        uint32_t part_count = 1;
+        uint64_t asset_size = hash_jobs[i].m_SizeRange;
+        while (i + part_count < hash_job_count && hash_jobs[i + part_count].m_AssetIndex == hash_jobs[i].m_AssetIndex)
+        {
+            asset_size += hash_jobs[i + part_count].m_SizeRange;
+            ++part_count;
+        }
+        if (part_count > 1)
+        {
+            struct ResyncChunksJob* job = &resync_jobs[job_index];
+            job->m_StorageAPI = storage_api;
+            job->m_HashAPI = hash_api;
+            job->m_ChunkerAPI = chunker_api;
+            job->m_RootPath = root_path;
+            job->m_PartJobs = &hash_jobs[i];
+            job->m_PartCount = part_count;
+            job->m_AssetSize = asset_size;
+            job->m_ChunkHashes = 0;
+            job->m_ChunkSizes = 0;
+            job->m_ChunkCount = 0;
+            job->m_ChunkCapacity = 0;
+            job->m_Err = EINVAL;
+            funcs[job_index] = ResyncChunks;
+            ctxs[job_index] = job;
+            ++job_index;
+        }
+        i += part_count - 1;
+    }
+    LONGTAIL_FATAL_ASSERT(ctx, job_index == job_count, return EINVAL)
+
+    Longtail_JobAPI_Group job_group = 0;
+    err = job_api->ReserveJobs(job_api, job_count, &job_group);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
+        Longtail_Free(work_mem);
+        return err;
+    }
+    uint32_t jobs_submitted = 0;
+    while (jobs_submitted < job_count)
+    {
+        uint32_t batch_count = (job_count - jobs_submitted) < max_job_batch_count ? (job_count - jobs_submitted) : max_job_batch_count;
+        Longtail_JobAPI_Jobs jobs;
+        err = job_api->CreateJobs(job_api, job_group, 0, optional_cancel_api, optional_cancel_token, batch_count, &funcs[jobs_submitted], &ctxs[jobs_submitted], 0, &jobs);
+        LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+        err = job_api->ReadyJobs(job_api, batch_count, jobs);
+        LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+        jobs_submitted += batch_count;
+    }
+
+    err = job_api->WaitForAllJobs(job_api, job_group, 0, optional_cancel_api, optional_cancel_token);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+    }
+    for (uint32_t j = 0; j < job_count && err == 0; ++j)
+    {
+        err = resync_jobs[j].m_Err;
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, (err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "resync_jobs[j].m_Err failed with %d", err)
+        }
+    }
+
+    for (uint32_t j = 0; j < job_count; ++j)
+    {
+        struct ResyncChunksJob* job = &resync_jobs[j];
+        if (err)
+        {
+            Longtail_Free(job->m_ChunkHashes);
+            continue;
+        }
+        // The first part takes over the chunks of the whole asset
+        for (uint32_t p = 0; p < job->m_PartCount; ++p)
+        {
+            Longtail_Free(job->m_PartJobs[p].m_ChunkHashes);
+            job->m_PartJobs[p].m_ChunkHashes = 0;
+            job->m_PartJobs[p].m_ChunkSizes = 0;
+            *job->m_PartJobs[p].m_AssetChunkCount = 0;
+        }
+        job->m_PartJobs[0].m_ChunkHashes = job->m_ChunkHashes;
+        job->m_PartJobs[0].m_ChunkSizes = job->m_ChunkSizes;
+        *job->m_PartJobs[0].m_AssetChunkCount = job->m_ChunkCount;
+    }
+    Longtail_Free(work_mem);
+    return err;
+}
+
 struct ChunkAssetsData {
     uint32_t m_ChunkCount;
     TLongtail_Hash* m_ChunkHashes;
@@ -2190,6 +3176,15 @@ struct ChunkAssetsData* AllocChunkAssetsData(uint32_t chunk_count)
     return chunk_assets_data;
 }
 
+static uint32_t GetAssetTargetChunkSize(const uint32_t* optional_asset_target_chunk_sizes, uint32_t asset_index, uint32_t target_chunk_size)
+{
+    if (optional_asset_target_chunk_sizes == 0 || optional_asset_target_chunk_sizes[asset_index] == 0)
+    {
+        return target_chunk_size;
+    }
+    return optional_asset_target_chunk_sizes[asset_index];
+}
+
 static int ChunkAssets(
     struct Longtail_StorageAPI* storage_api,
     struct Longtail_HashAPI* hash_api,
@@ -2203,9 +3198,11 @@ static int ChunkAssets(
     TLongtail_Hash* path_hashes,
     TLongtail_Hash* content_hashes,
     const uint32_t* optional_asset_tags,
+    const uint32_t* optional_asset_target_chunk_sizes,
     uint32_t* asset_chunk_start_index,
     uint32_t* asset_chunk_counts,
     uint32_t target_chunk_size,
+    int reserve_zero_chunks,
     int enable_file_map,
     struct ChunkAssetsData** out_chunk_assets_data)
 {
@@ -2222,9 +3219,11 @@ static int ChunkAssets(
         LONGTAIL_LOGFIELD(path_hashes, "%p"),
         LONGTAIL_LOGFIELD(content_hashes, "%p"),
         LONGTAIL_LOGFIELD(optional_asset_tags, "%p"),
+        LONGTAIL_LOGFIELD(optional_asset_target_chunk_sizes, "%p"),
         LONGTAIL_LOGFIELD(asset_chunk_start_index, "%p"),
         LONGTAIL_LOGFIELD(asset_chunk_counts, "%p"),
         LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
+        LONGTAIL_LOGFIELD(reserve_zero_chunks, "%d"),
         LONGTAIL_LOGFIELD(out_chunk_assets_data, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
@@ -2243,11 +3242,12 @@ static int ChunkAssets(
 
     uint32_t asset_count = file_infos->m_Count;
 
-    uint64_t max_hash_size = target_chunk_size * 1024;
     uint32_t job_count = 0;
 
     for (uint32_t asset_index = 0; asset_index < asset_count; ++asset_index)
     {
+        uint32_t asset_target_chunk_size = GetAssetTargetChunkSize(optional_asset_target_chunk_sizes, asset_index, target_chunk_size);
+        uint64_t max_hash_size = (uint64_t)asset_target_chunk_size * 1024;
         uint64_t asset_size = file_infos->m_Sizes[asset_index];
         uint64_t asset_part_count = 1 + (asset_size / max_hash_size);
         job_count += (uint32_t)asset_part_count;
@@ -2298,6 +3298,8 @@ static int ChunkAssets(
     uint64_t chunks_offset = 0;
     for (uint32_t asset_index = 0; asset_index < asset_count; ++asset_index)
     {
+        uint32_t asset_target_chunk_size = GetAssetTargetChunkSize(optional_asset_target_chunk_sizes, asset_index, target_chunk_size);
+        uint64_t max_hash_size = (uint64_t)asset_target_chunk_size * 1024;
         uint64_t asset_size = file_infos->m_Sizes[asset_index];
         uint64_t asset_part_count = 1 + (asset_size / max_hash_size);
 
@@ -2333,7 +3335,8 @@ static int ChunkAssets(
             job->m_AssetChunkCount = &tmp_job_chunk_counts[jobs_submitted + jobs_prepared];
             job->m_ChunkHashes = 0;
             job->m_ChunkSizes = 0;
-            job->m_TargetChunkSize = target_chunk_size;
+            job->m_TargetChunkSize = asset_target_chunk_size;
+            job->m_ReserveZeroChunks = reserve_zero_chunks;
             job->m_EnableFileMap = 0;
             job->m_Err = EINVAL;
             funcs[jobs_submitted + jobs_prepared] = DynamicChunking;
@@ -2381,6 +3384,11 @@ static int ChunkAssets(
         }
     }
 
+    if (!err)
+    {
+        err = ResyncAssetPartChunks(storage_api, hash_api, chunker_api, job_api, optional_cancel_api, optional_cancel_token, root_path, tmp_hash_jobs, jobs_submitted);
+    }
+
     if (!err)
     {
         uint32_t built_chunk_count = 0;
@@ -2448,13 +3456,38 @@ static int ChunkAssets(
     return err;
 }
 
+// Version 0.0.3 adds the chunker identifier to the header and version 0.0.4 the version index flags.
+// Version indexes chunked with HPCDC (chunker identifier zero) and without flags are still written
+// as 0.0.2 and those without flags as 0.0.3 so older versions can read them.
+static uint32_t GetVersionIndexVersion(uint32_t chunker_identifier, uint32_t flags)
+{
+    if (flags != 0)
+    {
+        return LONGTAIL_VERSION_INDEX_VERSION_0_0_4;
+    }
+    return (chunker_identifier == 0) ? LONGTAIL_VERSION_INDEX_VERSION_0_0_2 : LONGTAIL_VERSION_INDEX_VERSION_0_0_3;
+}
+
+static size_t GetVersionIndexHeaderSize(uint32_t version)
+{
+    if (version == LONGTAIL_VERSION_INDEX_VERSION_0_0_2)
+    {
+        return 6 * sizeof(uint32_t);
+    }
+    return (version == LONGTAIL_VERSION_INDEX_VERSION_0_0_3) ? (7 * sizeof(uint32_t)) : (8 * sizeof(uint32_t));
+}
+
 static size_t Longtail_GetVersionIndexDataSize(
+    uint32_t version,
+    uint32_t flags,
     uint32_t asset_count,
     uint32_t chunk_count,
     uint32_t asset_chunk_index_count,
     uint32_t path_data_size)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(version, "%u"),
+        LONGTAIL_LOGFIELD(flags, "%x"),
         LONGTAIL_LOGFIELD(asset_count, "%u"),
         LONGTAIL_LOGFIELD(chunk_count, "%u"),
         LONGTAIL_LOGFIELD(asset_chunk_index_count, "%u"),
@@ -2463,12 +3496,7 @@ static size_t Longtail_GetVersionIndexDataSize(
     LONGTAIL_VALIDATE_INPUT(ctx, asset_chunk_index_count >= chunk_count, return EINVAL)
 
     size_t version_index_data_size =
-        sizeof(uint32_t) +                              // m_Version
-        sizeof(uint32_t) +                              // m_HashIdentifier
-        sizeof(uint32_t) +                              // m_TargetChunkSize
-        sizeof(uint32_t) +                              // m_AssetCount
-        sizeof(uint32_t) +                              // m_ChunkCount
-        sizeof(uint32_t) +                              // m_AssetChunkIndexCount
+        GetVersionIndexHeaderSize(version) +            // m_Version, m_HashIdentifier, m_TargetChunkSize, m_AssetCount, m_ChunkCount, m_AssetChunkIndexCount, m_ChunkerIdentifier and m_Flags
         (sizeof(TLongtail_Hash) * asset_count) +        // m_PathHashes
         (sizeof(TLongtail_Hash) * asset_count) +        // m_ContentHashes
         (sizeof(uint64_t) * asset_count) +              // m_AssetSizes
@@ -2478,6 +3506,7 @@ static size_t Longtail_GetVersionIndexDataSize(
         (sizeof(TLongtail_Hash) * chunk_count) +        // m_ChunkHashes
         (sizeof(uint32_t) * chunk_count) +              // m_ChunkSizes
         (sizeof(uint32_t) * chunk_count) +              // m_ChunkTags
+        (((flags & LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES) != 0) ? (sizeof(uint32_t) * asset_count) : 0) + // m_AssetTargetChunkSizes
         (sizeof(uint32_t) * asset_count) +              // m_NameOffsets
         (sizeof(uint16_t) * asset_count) +              // m_Permissions
         path_data_size;
@@ -2490,16 +3519,29 @@ size_t Longtail_GetVersionIndexSize(
     uint32_t chunk_count,
     uint32_t asset_chunk_index_count,
     uint32_t path_data_size)
+{
+    return Longtail_GetVersionIndexSizeWithFormat(asset_count, chunk_count, asset_chunk_index_count, path_data_size, 0, 0);
+}
+
+size_t Longtail_GetVersionIndexSizeWithFormat(
+    uint32_t asset_count,
+    uint32_t chunk_count,
+    uint32_t asset_chunk_index_count,
+    uint32_t path_data_size,
+    uint32_t chunker_identifier,
+    uint32_t flags)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(asset_count, "%u"),
         LONGTAIL_LOGFIELD(chunk_count, "%u"),
         LONGTAIL_LOGFIELD(asset_chunk_index_count, "%u"),
         LONGTAIL_LOGFIELD(path_data_size, "%u"),
+        LONGTAIL_LOGFIELD(chunker_identifier, "%u"),
+        LONGTAIL_LOGFIELD(flags, "%x"),
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
     LONGTAIL_VALIDATE_INPUT(ctx, asset_chunk_index_count >= chunk_count, return EINVAL)
     return sizeof(struct Longtail_VersionIndex) +
-            Longtail_GetVersionIndexDataSize(asset_count, chunk_count, asset_chunk_index_count, path_data_size);
+            Longtail_GetVersionIndexDataSize(GetVersionIndexVersion(chunker_identifier, flags), flags, asset_count, chunk_count, asset_chunk_index_count, path_data_size);
 }
 
 static int InitVersionIndexFromData(
@@ -2529,11 +3571,17 @@ static int InitVersionIndexFromData(
     version_index->m_Version = (uint32_t*)(void*)p;
     p += sizeof(uint32_t);
 
-    if ((*version_index->m_Version) != Longtail_CurrentVersionIndexVersion)
+    uint32_t version = *version_index->m_Version;
+    if (version != Longtail_CurrentVersionIndexVersion && version != LONGTAIL_VERSION_INDEX_VERSION_0_0_3 && version != LONGTAIL_VERSION_INDEX_VERSION_0_0_2)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Mismatching versions in version index data %" PRIu64 " != %" PRIu64 "", (void*)version_index->m_Version, Longtail_CurrentVersionIndexVersion);
         return EBADF;
     }
+    if (data_size < GetVersionIndexHeaderSize(version))
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Version index is invalid, not big enough for header. Size %" PRIu64 " < %" PRIu64 "", data_size, GetVersionIndexHeaderSize(version));
+        return EBADF;
+    }
 
     version_index->m_HashIdentifier = (uint32_t*)(void*)p;
     p += sizeof(uint32_t);
@@ -2556,7 +3604,29 @@ static int InitVersionIndexFromData(
 
     uint32_t asset_chunk_index_count = *version_index->m_AssetChunkIndexCount;
 
-    size_t version_index_data_size = Longtail_GetVersionIndexDataSize(asset_count, chunk_count, asset_chunk_index_count, 0);
+    version_index->m_ChunkerIdentifier = 0;
+    if (version != LONGTAIL_VERSION_INDEX_VERSION_0_0_2)
+    {
+        version_index->m_ChunkerIdentifier = (uint32_t*)(void*)p;
+        p += sizeof(uint32_t);
+    }
+
+    uint32_t flags = 0;
+    version_index->m_Flags = 0;
+    if (version != LONGTAIL_VERSION_INDEX_VERSION_0_0_2 && version != LONGTAIL_VERSION_INDEX_VERSION_0_0_3)
+    {
+        version_index->m_Flags = (uint32_t*)(void*)p;
+        p += sizeof(uint32_t);
+
+        flags = *version_index->m_Flags;
+        if ((flags & ~LONGTAIL_VERSION_INDEX_FLAGS_KNOWN) != 0)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Version index has unsupported flags 0x%x", flags)
+            return EBADF;
+        }
+    }
+
+    size_t version_index_data_size = Longtail_GetVersionIndexDataSize(version, flags, asset_count, chunk_count, asset_chunk_index_count, 0);
     if (version_index_data_size > data_size)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Version index data is truncated: %" PRIu64 " <= %" PRIu64, data_size, version_index_data_size)
@@ -2590,6 +3660,13 @@ static int InitVersionIndexFromData(
     version_index->m_ChunkTags = (uint32_t*)(void*)p;
     p += (sizeof(uint32_t) * chunk_count);
 
+    version_index->m_AssetTargetChunkSizes = 0;
+    if (flags & LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES)
+    {
+        version_index->m_AssetTargetChunkSizes = (uint32_t*)(void*)p;
+        p += (sizeof(uint32_t) * asset_count);
+    }
+
     version_index->m_NameOffsets = (uint32_t*)(void*)p;
     p += (sizeof(uint32_t) * asset_count);
 
@@ -2622,6 +3699,49 @@ int Longtail_BuildVersionIndex(
     uint32_t hash_api_identifier,
     uint32_t target_chunk_size,
     struct Longtail_VersionIndex** out_version_index)
+{
+    return Longtail_BuildVersionIndexWithChunkSizes(
+        mem,
+        mem_size,
+        file_infos,
+        path_hashes,
+        content_hashes,
+        asset_chunk_index_starts,
+        asset_chunk_counts,
+        asset_chunk_index_count,
+        asset_chunk_indexes,
+        chunk_count,
+        chunk_sizes,
+        chunk_hashes,
+        optional_chunk_tags,
+        0,
+        hash_api_identifier,
+        0,
+        0,
+        target_chunk_size,
+        out_version_index);
+}
+
+int Longtail_BuildVersionIndexWithChunkSizes(
+    void* mem,
+    size_t mem_size,
+    const struct Longtail_FileInfos* file_infos,
+    const TLongtail_Hash* path_hashes,
+    const TLongtail_Hash* content_hashes,
+    const uint32_t* asset_chunk_index_starts,
+    const uint32_t* asset_chunk_counts,
+    uint32_t asset_chunk_index_count,
+    const uint32_t* asset_chunk_indexes,
+    uint32_t chunk_count,
+    const uint32_t* chunk_sizes,
+    const TLongtail_Hash* chunk_hashes,
+    const uint32_t* optional_chunk_tags,
+    const uint32_t* optional_asset_target_chunk_sizes,
+    uint32_t hash_api_identifier,
+    uint32_t chunker_identifier,
+    uint32_t flags,
+    uint32_t target_chunk_size,
+    struct Longtail_VersionIndex** out_version_index)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(mem, "%p"),
@@ -2637,7 +3757,10 @@ int Longtail_BuildVersionIndex(
         LONGTAIL_LOGFIELD(chunk_sizes, "%p"),
         LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
         LONGTAIL_LOGFIELD(optional_chunk_tags, "%p"),
+        LONGTAIL_LOGFIELD(optional_asset_target_chunk_sizes, "%p"),
         LONGTAIL_LOGFIELD(hash_api_identifier, "%u"),
+        LONGTAIL_LOGFIELD(chunker_identifier, "%u"),
+        LONGTAIL_LOGFIELD(flags, "%x"),
         LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
         LONGTAIL_LOGFIELD(out_version_index, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
@@ -2651,9 +3774,20 @@ int Longtail_BuildVersionIndex(
     LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || asset_chunk_indexes != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_sizes != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_hashes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (flags & ~LONGTAIL_VERSION_INDEX_FLAGS_KNOWN) == 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, out_version_index != 0, return EINVAL)
 
+    flags &= ~LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES;
+    if (optional_asset_target_chunk_sizes)
+    {
+        flags |= LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES;
+    }
+
     uint32_t asset_count = file_infos == 0 ? 0u : file_infos->m_Count;
+    uint32_t version = GetVersionIndexVersion(chunker_identifier, flags);
+    size_t index_data_size = Longtail_GetVersionIndexDataSize(version, flags, asset_count, chunk_count, asset_chunk_index_count, file_infos == 0 ? 0u : file_infos->m_PathDataSize);
+    LONGTAIL_VALIDATE_INPUT(ctx, mem_size >= sizeof(struct Longtail_VersionIndex) + index_data_size, return EINVAL)
+
     struct Longtail_VersionIndex* version_index = (struct Longtail_VersionIndex*)mem;
     uint32_t* p = (uint32_t*)(void*)&version_index[1];
     version_index->m_Version = &p[0];
@@ -2662,14 +3796,21 @@ int Longtail_BuildVersionIndex(
     version_index->m_AssetCount = &p[3];
     version_index->m_ChunkCount = &p[4];
     version_index->m_AssetChunkIndexCount = &p[5];
-    *version_index->m_Version = Longtail_CurrentVersionIndexVersion;
+    *version_index->m_Version = version;
     *version_index->m_HashIdentifier = hash_api_identifier;
     *version_index->m_TargetChunkSize = target_chunk_size;
     *version_index->m_AssetCount = asset_count;
     *version_index->m_ChunkCount = chunk_count;
     *version_index->m_AssetChunkIndexCount = asset_chunk_index_count;
+    if (version != LONGTAIL_VERSION_INDEX_VERSION_0_0_2)
+    {
+        p[6] = chunker_identifier;
+    }
+    if (version != LONGTAIL_VERSION_INDEX_VERSION_0_0_2 && version != LONGTAIL_VERSION_INDEX_VERSION_0_0_3)
+    {
+        p[7] = flags;
+    }
 
-    size_t index_data_size = mem_size - sizeof(struct Longtail_VersionIndex);
     int err = InitVersionIndexFromData(version_index, &version_index[1], index_data_size);
     if (err)
     {
@@ -2695,6 +3836,10 @@ int Longtail_BuildVersionIndex(
         {
             memset(version_index->m_ChunkTags, 0, sizeof(uint32_t) * chunk_count);
         }
+        if (optional_asset_target_chunk_sizes)
+        {
+            memmove(version_index->m_AssetTargetChunkSizes, optional_asset_target_chunk_sizes, sizeof(uint32_t) * asset_count);
+        }
         memmove(version_index->m_NameOffsets, file_infos->m_PathStartOffsets, sizeof(uint32_t) * asset_count);
         memmove(version_index->m_Permissions, file_infos->m_Permissions, sizeof(uint16_t) * asset_count);
         memmove(version_index->m_NameData, file_infos->m_PathData, file_infos->m_PathDataSize);
@@ -2718,6 +3863,41 @@ int Longtail_CreateVersionIndex(
     uint32_t target_chunk_size,
     int enable_file_map,
     struct Longtail_VersionIndex** out_version_index)
+{
+    return Longtail_CreateVersionIndexWithChunkSizes(
+        storage_api,
+        hash_api,
+        chunker_api,
+        job_api,
+        progress_api,
+        optional_cancel_api,
+        optional_cancel_token,
+        root_path,
+        file_infos,
+        optional_asset_tags,
+        0,
+        0,
+        target_chunk_size,
+        enable_file_map,
+        out_version_index);
+}
+
+int Longtail_CreateVersionIndexWithChunkSizes(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    const struct Longtail_FileInfos* file_infos,
+    const uint32_t* optional_asset_tags,
+    const uint32_t* optional_asset_target_chunk_sizes,
+    uint32_t flags,
+    uint32_t target_chunk_size,
+    int enable_file_map,
+    struct Longtail_VersionIndex** out_version_index)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(storage_api, "%p"),
@@ -2729,7 +3909,9 @@ int Longtail_CreateVersionIndex(
         LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
         LONGTAIL_LOGFIELD(root_path, "%s"),
         LONGTAIL_LOGFIELD(file_infos, "%p"),
-        LONGTAIL_LOGFIELD(optional_asset_tags, "%u"),
+        LONGTAIL_LOGFIELD(optional_asset_tags, "%p"),
+        LONGTAIL_LOGFIELD(optional_asset_target_chunk_sizes, "%p"),
+        LONGTAIL_LOGFIELD(flags, "%x"),
         LONGTAIL_LOGFIELD(target_chunk_size, "%u"),
         LONGTAIL_LOGFIELD(out_version_index, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
@@ -2740,12 +3922,14 @@ int Longtail_CreateVersionIndex(
     LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || root_path != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || target_chunk_size > 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, (file_infos == 0 || file_infos->m_Count == 0) || out_version_index != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, (flags & ~LONGTAIL_VERSION_INDEX_FLAGS_KNOWN) == 0, return EINVAL)
 
     uint32_t path_count = file_infos == 0 ? 0u : file_infos->m_Count;
+    uint32_t chunker_identifier = chunker_api == 0 ? 0u : Longtail_Chunker_GetIdentifier(chunker_api);
 
     if (path_count == 0)
     {
-        size_t version_index_size = Longtail_GetVersionIndexSize(path_count, 0, 0, 0);
+        size_t version_index_size = Longtail_GetVersionIndexSizeWithFormat(path_count, 0, 0, 0, chunker_identifier, flags);
         void* version_index_mem = Longtail_Alloc("CreateVersionIndex", version_index_size);
         if (!version_index_mem)
         {
@@ -2754,7 +3938,7 @@ int Longtail_CreateVersionIndex(
         }
 
         struct Longtail_VersionIndex* version_index;
-        int err = Longtail_BuildVersionIndex(
+        int err = Longtail_BuildVersionIndexWithChunkSizes(
             version_index_mem,              // mem
             version_index_size,             // mem_size
             file_infos,                          // paths
@@ -2768,12 +3952,15 @@ int Longtail_CreateVersionIndex(
             0,           // chunk_sizes
             0,           // chunk_hashes
             0,          // chunk_tags
+            0,          // asset_target_chunk_sizes
             hash_api->GetIdentifier(hash_api),
+            chunker_identifier,
+            flags,
             target_chunk_size,
             &version_index);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_BuildVersionIndex() failed with %d", err)
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_BuildVersionIndexWithChunkSizes() failed with %d", err)
             return err;
         }
         *out_version_index = version_index;
@@ -2811,9 +3998,11 @@ int Longtail_CreateVersionIndex(
         tmp_path_hashes,
         tmp_content_hashes,
         optional_asset_tags,
+        optional_asset_target_chunk_sizes,
         tmp_asset_chunk_start_index,
         tmp_asset_chunk_counts,
         target_chunk_size,
+        (flags & LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS) != 0,
         enable_file_map,
         &chunk_assets_data);
     if (err)
@@ -2868,7 +4057,19 @@ int Longtail_CreateVersionIndex(
         }
     }
 
-    size_t version_index_size = Longtail_GetVersionIndexSize(path_count, unique_chunk_count, assets_chunk_index_count, file_infos->m_PathDataSize);
+    // The target chunk size of each asset is only recorded if some asset is not chunked with target_chunk_size
+    const uint32_t* asset_target_chunk_sizes = 0;
+    for (uint32_t a = 0; optional_asset_target_chunk_sizes != 0 && a < path_count; ++a)
+    {
+        if (GetAssetTargetChunkSize(optional_asset_target_chunk_sizes, a, target_chunk_size) != target_chunk_size)
+        {
+            asset_target_chunk_sizes = optional_asset_target_chunk_sizes;
+            break;
+        }
+    }
+
+    uint32_t version_index_flags = (flags & ~LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES) | ((asset_target_chunk_sizes != 0) ? LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES : 0u);
+    size_t version_index_size = Longtail_GetVersionIndexSizeWithFormat(path_count, unique_chunk_count, assets_chunk_index_count, file_infos->m_PathDataSize, chunker_identifier, version_index_flags);
     void* version_index_mem = Longtail_Alloc("CreateVersionIndex", version_index_size);
     if (!version_index_mem)
     {
@@ -2880,7 +4081,7 @@ int Longtail_CreateVersionIndex(
     }
 
     struct Longtail_VersionIndex* version_index;
-    err = Longtail_BuildVersionIndex(
+    err = Longtail_BuildVersionIndexWithChunkSizes(
         version_index_mem,              // mem
         version_index_size,             // mem_size
         file_infos,                          // paths
@@ -2894,25 +4095,242 @@ int Longtail_CreateVersionIndex(
         tmp_compact_chunk_sizes,            // chunk_sizes
         tmp_compact_chunk_hashes,           // chunk_hashes
         tmp_compact_chunk_tags,// chunk_tags
+        asset_target_chunk_sizes,   // asset_target_chunk_sizes
         hash_api->GetIdentifier(hash_api),
+        chunker_identifier,
+        flags,
         target_chunk_size,
         &version_index);
     if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_BuildVersionIndex() failed with %d", err)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_BuildVersionIndexWithChunkSizes() failed with %d", err)
         Longtail_Free(work_mem_compact);
         Longtail_Free(version_index_mem);
         Longtail_Free(chunk_assets_data);
         Longtail_Free(work_mem);
         return err;
     }
-
-    Longtail_Free(work_mem_compact);
-    Longtail_Free(chunk_assets_data);
+
+    Longtail_Free(work_mem_compact);
+    Longtail_Free(chunk_assets_data);
+    Longtail_Free(work_mem);
+
+    *out_version_index = version_index;
+    return 0;
+}
+
+#define FILE_FINGERPRINT_READ_SIZE (1024 * 1024)
+
+struct FileFingerprintJob
+{
+    struct Longtail_StorageAPI* m_StorageAPI;
+    struct Longtail_HashAPI* m_HashAPI;
+    const char* m_RootPath;
+    const char* m_Path;
+    uint64_t m_Size;
+    TLongtail_Hash* m_Fingerprint;
+    int m_Err;
+};
+
+static int FileFingerprint(void* context, uint32_t job_id, int is_cancelled)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(job_id, "%u"),
+        LONGTAIL_LOGFIELD(is_cancelled, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return EINVAL)
+    struct FileFingerprintJob* job = (struct FileFingerprintJob*)context;
+
+    if (is_cancelled)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Cancelled with errno %d", ECANCELED)
+        job->m_Err = ECANCELED;
+        return 0;
+    }
+
+    if (IsDirPath(job->m_Path))
+    {
+        *job->m_Fingerprint = 0;
+        job->m_Err = 0;
+        return 0;
+    }
+
+    struct Longtail_StorageAPI* storage_api = job->m_StorageAPI;
+    struct Longtail_HashAPI* hash_api = job->m_HashAPI;
+    char* path = storage_api->ConcatPath(storage_api, job->m_RootPath, job->m_Path);
+    Longtail_StorageAPI_HOpenFile file_handle;
+    int err = storage_api->OpenReadFile(storage_api, path, &file_handle);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->OpenReadFile() failed with %d", err)
+        Longtail_Free(path);
+        job->m_Err = err;
+        return 0;
+    }
+
+    size_t buffer_size = job->m_Size < FILE_FINGERPRINT_READ_SIZE ? (size_t)job->m_Size : FILE_FINGERPRINT_READ_SIZE;
+    char* buffer = (char*)Longtail_Alloc("FileFingerprint", buffer_size == 0 ? 1 : buffer_size);
+    if (!buffer)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        storage_api->CloseFile(storage_api, file_handle);
+        Longtail_Free(path);
+        job->m_Err = ENOMEM;
+        return 0;
+    }
+
+    Longtail_HashAPI_HContext hash_context;
+    err = hash_api->BeginContext(hash_api, &hash_context);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "hash_api->BeginContext() failed with %d", err)
+        Longtail_Free(buffer);
+        storage_api->CloseFile(storage_api, file_handle);
+        Longtail_Free(path);
+        job->m_Err = err;
+        return 0;
+    }
+
+    uint64_t offset = 0;
+    while (offset < job->m_Size)
+    {
+        uint32_t read_size = (uint32_t)((job->m_Size - offset) < buffer_size ? (job->m_Size - offset) : buffer_size);
+        err = storage_api->Read(storage_api, file_handle, offset, read_size, buffer);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "storage_api->Read() failed with %d", err)
+            break;
+        }
+        hash_api->Hash(hash_api, hash_context, read_size, buffer);
+        offset += read_size;
+    }
+    TLongtail_Hash fingerprint = hash_api->EndContext(hash_api, hash_context);
+
+    Longtail_Free(buffer);
+    storage_api->CloseFile(storage_api, file_handle);
+    Longtail_Free(path);
+    if (err)
+    {
+        job->m_Err = err;
+        return 0;
+    }
+    *job->m_Fingerprint = fingerprint;
+    job->m_Err = 0;
+    return 0;
+}
+
+int Longtail_GetFileFingerprints(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    const struct Longtail_FileInfos* file_infos,
+    TLongtail_Hash* out_fingerprints)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(storage_api, "%p"),
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(root_path, "%s"),
+        LONGTAIL_LOGFIELD(file_infos, "%p"),
+        LONGTAIL_LOGFIELD(out_fingerprints, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, storage_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, hash_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, job_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, root_path != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, file_infos != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, file_infos->m_Count == 0 || out_fingerprints != 0, return EINVAL)
+
+    uint32_t job_count = file_infos->m_Count;
+    if (job_count == 0)
+    {
+        return 0;
+    }
+
+    uint32_t max_job_batch_count = 0;
+    int err = job_api->GetMaxBatchCountFunc(job_api, &max_job_batch_count, 0);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->GetMaxBatchCountFunc() failed with %d", err)
+        return err;
+    }
+
+    size_t work_mem_size = (sizeof(struct FileFingerprintJob) * job_count) +
+        (sizeof(Longtail_JobAPI_JobFunc) * job_count) +
+        (sizeof(void*) * job_count);
+    void* work_mem = Longtail_Alloc("GetFileFingerprints", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct FileFingerprintJob* jobs = (struct FileFingerprintJob*)work_mem;
+    Longtail_JobAPI_JobFunc* funcs = (Longtail_JobAPI_JobFunc*)&jobs[job_count];
+    void** ctxs = (void**)&funcs[job_count];
+
+    for (uint32_t i = 0; i < job_count; ++i)
+    {
+        struct FileFingerprintJob* job = &jobs[i];
+        job->m_StorageAPI = storage_api;
+        job->m_HashAPI = hash_api;
+        job->m_RootPath = root_path;
+        job->m_Path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[i]];
+        job->m_Size = file_infos->m_Sizes[i];
+        job->m_Fingerprint = &out_fingerprints[i];
+        job->m_Err = EINVAL;
+        funcs[i] = FileFingerprint;
+        ctxs[i] = job;
+    }
+
+    Longtail_JobAPI_Group job_group = 0;
+    err = job_api->ReserveJobs(job_api, job_count, &job_group);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job_api->ReserveJobs() failed with %d", err)
+        Longtail_Free(work_mem);
+        return err;
+    }
+
+    uint32_t jobs_submitted = 0;
+    while (jobs_submitted < job_count)
+    {
+        uint32_t batch_count = (job_count - jobs_submitted) < max_job_batch_count ? (job_count - jobs_submitted) : max_job_batch_count;
+        Longtail_JobAPI_Jobs batch_jobs;
+        err = job_api->CreateJobs(job_api, job_group, progress_api, optional_cancel_api, optional_cancel_token, batch_count, &funcs[jobs_submitted], &ctxs[jobs_submitted], 0, &batch_jobs);
+        LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+        err = job_api->ReadyJobs(job_api, batch_count, batch_jobs);
+        LONGTAIL_FATAL_ASSERT(ctx, !err, return err)
+        jobs_submitted += batch_count;
+    }
+
+    err = job_api->WaitForAllJobs(job_api, job_group, progress_api, optional_cancel_api, optional_cancel_token);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "job_api->WaitForAllJobs() failed with %d", err)
+        Longtail_Free(work_mem);
+        return err;
+    }
+
+    for (uint32_t i = 0; i < job_count; ++i)
+    {
+        if (jobs[i].m_Err)
+        {
+            LONGTAIL_LOG(ctx, (jobs[i].m_Err == ECANCELED) ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "jobs[i].m_Err failed with %d", jobs[i].m_Err)
+            err = err ? err : jobs[i].m_Err;
+        }
+    }
     Longtail_Free(work_mem);
-
-    *out_version_index = version_index;
-    return 0;
+    return err;
 }
 
 static SORTFUNC(SortPathShortToLongVersionMerge)
@@ -2956,6 +4374,13 @@ int Longtail_MergeVersionIndex(
     LONGTAIL_VALIDATE_INPUT(ctx, out_version_index != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, *base_version_index->m_TargetChunkSize == *overlay_version_index->m_TargetChunkSize, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, *base_version_index->m_HashIdentifier == *overlay_version_index->m_HashIdentifier, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, Longtail_VersionIndex_GetChunkerIdentifier(base_version_index) == Longtail_VersionIndex_GetChunkerIdentifier(overlay_version_index), return EINVAL)
+
+    uint32_t chunker_identifier = Longtail_VersionIndex_GetChunkerIdentifier(base_version_index);
+    // The merged index keeps the zero chunks of both, a chunk hashed with the hash api does not
+    // get the reserved hash of a zero chunk so assets from an index without zero chunks stay intact
+    uint32_t flags = Longtail_VersionIndex_GetFlags(base_version_index) | Longtail_VersionIndex_GetFlags(overlay_version_index);
+    uint32_t version = GetVersionIndexVersion(chunker_identifier, flags);
 
     uint32_t base_asset_count = *base_version_index->m_AssetCount;
     uint32_t overlay_asset_count = *overlay_version_index->m_AssetCount;
@@ -2963,7 +4388,7 @@ int Longtail_MergeVersionIndex(
     size_t max_asset_count = (size_t)(base_asset_count) + (size_t)(overlay_asset_count);
     if (max_asset_count == 0)
     {
-        size_t version_index_size = Longtail_GetVersionIndexSize(0, 0, 0, 0);
+        size_t version_index_size = Longtail_GetVersionIndexSizeWithFormat(0, 0, 0, 0, chunker_identifier, flags);
         void* version_index_mem = Longtail_Alloc("CreateVersionIndex", version_index_size);
         if (!version_index_mem)
         {
@@ -2979,12 +4404,25 @@ int Longtail_MergeVersionIndex(
         version_index->m_AssetCount = &p[3];
         version_index->m_ChunkCount = &p[4];
         version_index->m_AssetChunkIndexCount = &p[5];
-        *version_index->m_Version = Longtail_CurrentVersionIndexVersion;
+        version_index->m_ChunkerIdentifier = 0;
+        version_index->m_Flags = 0;
+        version_index->m_AssetTargetChunkSizes = 0;
+        *version_index->m_Version = version;
         *version_index->m_HashIdentifier = *base_version_index->m_HashIdentifier;
         *version_index->m_TargetChunkSize = *base_version_index->m_TargetChunkSize;
         *version_index->m_AssetCount = 0;
         *version_index->m_ChunkCount = 0;
         *version_index->m_AssetChunkIndexCount = 0;
+        if (version != LONGTAIL_VERSION_INDEX_VERSION_0_0_2)
+        {
+            version_index->m_ChunkerIdentifier = &p[6];
+            *version_index->m_ChunkerIdentifier = chunker_identifier;
+        }
+        if (version != LONGTAIL_VERSION_INDEX_VERSION_0_0_2 && version != LONGTAIL_VERSION_INDEX_VERSION_0_0_3)
+        {
+            version_index->m_Flags = &p[7];
+            *version_index->m_Flags = flags;
+        }
         *out_version_index = version_index;
         return 0;
     }
@@ -3002,8 +4440,10 @@ int Longtail_MergeVersionIndex(
     size_t chunk_hashes_size = sizeof(TLongtail_Hash) * max_chunk_count;
     size_t name_lengths_size = sizeof(uint32_t) * max_asset_count;
     size_t asset_indexes_size = sizeof(uint32_t) * max_asset_count;
+    uint32_t removed_file_count = removed_files != 0 ? (uint32_t)num_removed_files : 0;
+    size_t removed_lookup_table_size = LongtailPrivate_LookupTable_GetSize(removed_file_count);
 
-    size_t tmp_mem_size = base_asset_lookup_table_size + overlay_asset_lookup_table_size + base_chunk_lookup_table_size + overlay_chunk_lookup_table_size + path_hashes_size + chunk_hashes_size + name_lengths_size + asset_indexes_size;
+    size_t tmp_mem_size = base_asset_lookup_table_size + overlay_asset_lookup_table_size + base_chunk_lookup_table_size + overlay_chunk_lookup_table_size + path_hashes_size + chunk_hashes_size + name_lengths_size + asset_indexes_size + removed_lookup_table_size;
     void* tmp_mem = Longtail_Alloc("Longtail_MergeVersionIndex", tmp_mem_size);
     if (!tmp_mem)
     {
@@ -3030,6 +4470,12 @@ int Longtail_MergeVersionIndex(
     p += path_hashes_size;
     TLongtail_Hash* chunk_hashes = (TLongtail_Hash*)p;
     p += chunk_hashes_size;
+    struct Longtail_LookupTable* removed_lut = LongtailPrivate_LookupTable_Create(p, removed_file_count, 0);
+    p += removed_lookup_table_size;
+    for (uint32_t j = 0; j < removed_file_count; j++)
+    {
+        LongtailPrivate_LookupTable_PutUnique(removed_lut, removed_files[j], 0);
+    }
 
     size_t asset_chunk_index_count = 0;
 
@@ -3039,23 +4485,9 @@ int Longtail_MergeVersionIndex(
     {
         TLongtail_Hash path_hash = base_version_index->m_PathHashes[i];
 
-        if (num_removed_files > 0 && removed_files != 0)
+        if (LongtailPrivate_LookupTable_Get(removed_lut, path_hash) != 0)
         {
-            char is_removed_file = 0;
-            for (uint32_t j = 0; j < num_removed_files; j++)
-            {
-
-                if (path_hash == removed_files[j])
-                {
-                    is_removed_file = 1;
-                    break;
-                }
-            }
-
-            if (is_removed_file != 0)
-            {
-                continue;
-            }
+            continue;
         }
 
         path_hashes[base_asset_count_post_removal] = path_hash;
@@ -3064,7 +4496,7 @@ int Longtail_MergeVersionIndex(
         name_lengths[base_asset_count_post_removal] = path_length;
         path_name_size += path_length + 1;
         asset_indexes[base_asset_count_post_removal] = base_asset_count_post_removal;
-        LongtailPrivate_LookupTable_Put(base_asset_lut, path_hash, base_asset_count_post_removal);
+        LongtailPrivate_LookupTable_Put(base_asset_lut, path_hash, i);
         asset_chunk_index_count += base_version_index->m_AssetChunkCounts[i];
         base_asset_count_post_removal++;
     }
@@ -3179,7 +4611,7 @@ int Longtail_MergeVersionIndex(
         LongtailPrivate_LookupTable_Put(chunk_lut, chunk_hashes[chunk_index], chunk_index);
     }
 
-    size_t version_index_size = Longtail_GetVersionIndexSize((uint32_t)unique_asset_count, (uint32_t)unique_chunk_count, (uint32_t)asset_chunk_index_count, (uint32_t)path_name_size);
+    size_t version_index_size = Longtail_GetVersionIndexSizeWithFormat((uint32_t)unique_asset_count, (uint32_t)unique_chunk_count, (uint32_t)asset_chunk_index_count, (uint32_t)path_name_size, chunker_identifier, flags);
     void* out_mem = Longtail_Alloc("Longtail_MergeVersionIndex", version_index_size);
     if (out_mem == 0)
     {
@@ -3205,6 +4637,18 @@ int Longtail_MergeVersionIndex(
         p += sizeof(uint32_t);
         merged_version_index->m_AssetChunkIndexCount = (uint32_t*)p;
         p += sizeof(uint32_t);
+        merged_version_index->m_ChunkerIdentifier = 0;
+        if (version != LONGTAIL_VERSION_INDEX_VERSION_0_0_2)
+        {
+            merged_version_index->m_ChunkerIdentifier = (uint32_t*)p;
+            p += sizeof(uint32_t);
+        }
+        merged_version_index->m_Flags = 0;
+        if (version != LONGTAIL_VERSION_INDEX_VERSION_0_0_2 && version != LONGTAIL_VERSION_INDEX_VERSION_0_0_3)
+        {
+            merged_version_index->m_Flags = (uint32_t*)p;
+            p += sizeof(uint32_t);
+        }
         merged_version_index->m_PathHashes = (TLongtail_Hash*)p;
         p += sizeof(TLongtail_Hash) * unique_asset_count;
         merged_version_index->m_ContentHashes = (TLongtail_Hash*)p;
@@ -3223,18 +4667,32 @@ int Longtail_MergeVersionIndex(
         p += sizeof(uint32_t) * unique_chunk_count;
         merged_version_index->m_ChunkTags = (uint32_t*)p;
         p += sizeof(uint32_t) * unique_chunk_count;
+        merged_version_index->m_AssetTargetChunkSizes = 0;
+        if (flags & LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES)
+        {
+            merged_version_index->m_AssetTargetChunkSizes = (uint32_t*)p;
+            p += sizeof(uint32_t) * unique_asset_count;
+        }
         merged_version_index->m_NameOffsets = (uint32_t*)p;
         p += sizeof(uint32_t) * unique_asset_count;
         merged_version_index->m_Permissions = (uint16_t*)p;
         p += sizeof(uint16_t) * unique_asset_count;
         merged_version_index->m_NameData = (char*)p;
     }
-    *merged_version_index->m_Version = Longtail_CurrentVersionIndexVersion;
+    *merged_version_index->m_Version = version;
     *merged_version_index->m_HashIdentifier = *base_version_index->m_HashIdentifier;
     *merged_version_index->m_TargetChunkSize = *base_version_index->m_TargetChunkSize;
     *merged_version_index->m_AssetCount = (uint32_t)unique_asset_count;
     *merged_version_index->m_ChunkCount = (uint32_t)unique_chunk_count;
     *merged_version_index->m_AssetChunkIndexCount = (uint32_t)asset_chunk_index_count;
+    if (merged_version_index->m_ChunkerIdentifier)
+    {
+        *merged_version_index->m_ChunkerIdentifier = chunker_identifier;
+    }
+    if (merged_version_index->m_Flags)
+    {
+        *merged_version_index->m_Flags = flags;
+    }
     merged_version_index->m_NameDataSize = (uint32_t)path_name_size;
     memcpy(merged_version_index->m_PathHashes, path_hashes, sizeof(TLongtail_Hash) * unique_asset_count);
     memcpy(merged_version_index->m_ChunkHashes, chunk_hashes, sizeof(TLongtail_Hash) * unique_chunk_count);
@@ -3273,6 +4731,10 @@ int Longtail_MergeVersionIndex(
         merged_version_index->m_AssetSizes[asset_index] = source_asset_size;
         merged_version_index->m_AssetChunkIndexStarts[asset_index] = asset_index_offset;
         merged_version_index->m_AssetChunkCounts[asset_index] = asset_chunk_count;
+        if (merged_version_index->m_AssetTargetChunkSizes)
+        {
+            merged_version_index->m_AssetTargetChunkSizes[asset_index] = source_version_index->m_AssetTargetChunkSizes ? source_version_index->m_AssetTargetChunkSizes[source_asset_index] : 0;
+        }
         for (uint32_t asset_chunk_index_offset = 0; asset_chunk_index_offset < asset_chunk_count; ++asset_chunk_index_offset)
         {
             uint32_t source_chunk_index = asset_chunk_indexes[asset_chunk_index_offset];
@@ -3333,7 +4795,7 @@ int Longtail_WriteVersionIndexToBuffer(
     LONGTAIL_VALIDATE_INPUT(ctx, out_buffer != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, out_size != 0, return EINVAL)
 
-    size_t index_data_size = Longtail_GetVersionIndexDataSize(*version_index->m_AssetCount, *version_index->m_ChunkCount, *version_index->m_AssetChunkIndexCount, version_index->m_NameDataSize);
+    size_t index_data_size = Longtail_GetVersionIndexDataSize(*version_index->m_Version, Longtail_VersionIndex_GetFlags(version_index), *version_index->m_AssetCount, *version_index->m_ChunkCount, *version_index->m_AssetChunkIndexCount, version_index->m_NameDataSize);
     *out_buffer = Longtail_Alloc("WriteVersionIndexToBuffer", index_data_size);
     if (!(*out_buffer))
     {
@@ -3359,7 +4821,7 @@ int Longtail_WriteVersionIndex(
     LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, path != 0, return EINVAL)
 
-    size_t index_data_size = Longtail_GetVersionIndexDataSize(*version_index->m_AssetCount, *version_index->m_ChunkCount, *version_index->m_AssetChunkIndexCount, version_index->m_NameDataSize);
+    size_t index_data_size = Longtail_GetVersionIndexDataSize(*version_index->m_Version, Longtail_VersionIndex_GetFlags(version_index), *version_index->m_AssetCount, *version_index->m_ChunkCount, *version_index->m_AssetChunkIndexCount, version_index->m_NameDataSize);
 
     int err = EnsureParentPathExists(storage_api, path);
     if (err)
@@ -4293,6 +5755,10 @@ int Longtail_GetRequiredChunkHashes(
         {
             uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + ci];
             TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
+            if (Longtail_IsZeroChunk(version_index, chunk_index))
+            {
+                continue;
+            }
             if (0 == LongtailPrivate_LookupTable_PutUnique(chunk_lookup, chunk_hash, chunk_count))
             {
                 out_chunk_hashes[chunk_count] = chunk_hash;
@@ -4310,6 +5776,10 @@ int Longtail_GetRequiredChunkHashes(
         {
             uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + ci];
             TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
+            if (Longtail_IsZeroChunk(version_index, chunk_index))
+            {
+                continue;
+            }
             if (0 == LongtailPrivate_LookupTable_PutUnique(chunk_lookup, chunk_hash, chunk_count))
             {
                 out_chunk_hashes[chunk_count] = chunk_hash;
@@ -4934,6 +6404,175 @@ static int WriteReady(void* context, uint32_t job_id, int is_cancelled)
     return 0;
 }
 
+#define ASSET_WRITE_BUFFER_SIZE  (4u * 1024u * 1024u)
+
+// Gathers the chunk ranges of an asset into large writes that end on ASSET_WRITE_BUFFER_SIZE
+// aligned file offsets. Ranges that fill a whole aligned write are written straight from the block.
+// With stream_writes set every write is followed by Longtail_Storage_StreamWritten().
+struct AssetWriteBuffer
+{
+    struct Longtail_StorageAPI* m_StorageAPI;
+    Longtail_StorageAPI_HOpenFile m_File;
+    char* m_Buffer;
+    size_t m_BufferSize;
+    size_t m_BufferUsedSize;
+    uint64_t m_WriteOffset;
+    int m_StreamWrites;
+};
+
+static void AssetWriteBuffer_Init(
+    struct AssetWriteBuffer* write_buffer,
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile file,
+    char* buffer,
+    size_t buffer_size,
+    uint64_t write_offset,
+    int stream_writes)
+{
+    write_buffer->m_StorageAPI = storage_api;
+    write_buffer->m_File = file;
+    write_buffer->m_Buffer = buffer;
+    write_buffer->m_BufferSize = buffer_size;
+    write_buffer->m_BufferUsedSize = 0;
+    write_buffer->m_WriteOffset = write_offset;
+    write_buffer->m_StreamWrites = stream_writes;
+}
+
+static int AssetWriteBuffer_WriteRange(struct AssetWriteBuffer* write_buffer, const void* data, uint64_t size)
+{
+    int err = write_buffer->m_StorageAPI->Write(write_buffer->m_StorageAPI, write_buffer->m_File, write_buffer->m_WriteOffset, size, data);
+    if (err)
+    {
+        return err;
+    }
+    if (write_buffer->m_StreamWrites)
+    {
+        return Longtail_Storage_StreamWritten(write_buffer->m_StorageAPI, write_buffer->m_File, write_buffer->m_WriteOffset, size);
+    }
+    return 0;
+}
+
+static int AssetWriteBuffer_Flush(struct AssetWriteBuffer* write_buffer)
+{
+    if (write_buffer->m_BufferUsedSize == 0)
+    {
+        return 0;
+    }
+    int err = AssetWriteBuffer_WriteRange(write_buffer, write_buffer->m_Buffer, write_buffer->m_BufferUsedSize);
+    if (err)
+    {
+        return err;
+    }
+    write_buffer->m_WriteOffset += write_buffer->m_BufferUsedSize;
+    write_buffer->m_BufferUsedSize = 0;
+    return 0;
+}
+
+static int AssetWriteBuffer_Write(struct AssetWriteBuffer* write_buffer, const char* data, uint64_t size)
+{
+    while (size > 0)
+    {
+        size_t write_size = write_buffer->m_BufferSize - (size_t)(write_buffer->m_WriteOffset % write_buffer->m_BufferSize);
+        if (write_buffer->m_BufferUsedSize == 0 && size >= write_size)
+        {
+            uint64_t direct_size = write_size + ((size - write_size) / write_buffer->m_BufferSize) * write_buffer->m_BufferSize;
+            int err = AssetWriteBuffer_WriteRange(write_buffer, data, direct_size);
+            if (err)
+            {
+                return err;
+            }
+            write_buffer->m_WriteOffset += direct_size;
+            data += direct_size;
+            size -= direct_size;
+            continue;
+        }
+        size_t copy_size = write_size - write_buffer->m_BufferUsedSize;
+        if (copy_size > size)
+        {
+            copy_size = (size_t)size;
+        }
+        memcpy(&write_buffer->m_Buffer[write_buffer->m_BufferUsedSize], data, copy_size);
+        write_buffer->m_BufferUsedSize += copy_size;
+        data += copy_size;
+        size -= copy_size;
+        if (write_buffer->m_BufferUsedSize == write_size)
+        {
+            int err = AssetWriteBuffer_Flush(write_buffer);
+            if (err)
+            {
+                return err;
+            }
+        }
+    }
+    return 0;
+}
+
+// Leaves size bytes unwritten, used for the range of a zero chunk
+static int AssetWriteBuffer_Skip(struct AssetWriteBuffer* write_buffer, uint64_t size)
+{
+    int err = AssetWriteBuffer_Flush(write_buffer);
+    if (err)
+    {
+        return err;
+    }
+    write_buffer->m_WriteOffset += size;
+    return 0;
+}
+
+static int IsZeroAssetChunk(const struct Longtail_VersionIndex* version_index, uint32_t asset_chunk_index)
+{
+    uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index];
+    return Longtail_IsZeroChunk(version_index, chunk_index);
+}
+
+// Hash of the first chunk of the asset that is stored in a block, the asset must have one
+static TLongtail_Hash GetFirstStoredChunkHash(const struct Longtail_VersionIndex* version_index, uint32_t asset_index)
+{
+    uint32_t asset_chunk_index = version_index->m_AssetChunkIndexStarts[asset_index];
+    while (IsZeroAssetChunk(version_index, asset_chunk_index))
+    {
+        ++asset_chunk_index;
+    }
+    return version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[asset_chunk_index]];
+}
+
+// Assets with zero chunks are opened empty and extended to their size so the zero chunk ranges,
+// which are never written, are holes in the file. Other assets are allocated at their full size.
+static int OpenAssetOutputFile(
+    struct Longtail_StorageAPI* version_storage_api,
+    const struct Longtail_VersionIndex* version_index,
+    uint32_t asset_index,
+    const char* full_asset_path,
+    Longtail_StorageAPI_HOpenFile* out_open_file)
+{
+    uint64_t asset_size = version_index->m_AssetSizes[asset_index];
+    uint32_t asset_chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
+    uint32_t asset_chunk_index_end = asset_chunk_index_start + version_index->m_AssetChunkCounts[asset_index];
+    int has_zero_chunks = 0;
+    for (uint32_t c = asset_chunk_index_start; c < asset_chunk_index_end && !has_zero_chunks; ++c)
+    {
+        has_zero_chunks = IsZeroAssetChunk(version_index, c);
+    }
+    if (!has_zero_chunks)
+    {
+        return version_storage_api->OpenWriteFile(version_storage_api, full_asset_path, asset_size, out_open_file);
+    }
+    Longtail_StorageAPI_HOpenFile open_file;
+    int err = version_storage_api->OpenWriteFile(version_storage_api, full_asset_path, 0, &open_file);
+    if (err)
+    {
+        return err;
+    }
+    err = version_storage_api->SetSize(version_storage_api, open_file, asset_size);
+    if (err)
+    {
+        version_storage_api->CloseFile(version_storage_api, open_file);
+        return err;
+    }
+    *out_open_file = open_file;
+    return 0;
+}
+
 #define MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE  32u
 
 struct WritePartialAssetFromBlocksJob
@@ -4950,6 +6589,7 @@ struct WritePartialAssetFromBlocksJob
     struct Longtail_LookupTable* m_ChunkHashToBlockIndex;
     uint32_t m_AssetIndex;
     int m_RetainPermissions;
+    int m_StreamWrites;
 
     Longtail_JobAPI_Group m_JobGroup;
     struct BlockReaderJob m_BlockReaderJobs[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
@@ -4994,6 +6634,7 @@ static int CreatePartialAssetWriteJob(
     struct Longtail_LookupTable* chunk_hash_to_block_index,
     uint32_t asset_index,
     int retain_permissions,
+    int stream_writes,
     Longtail_JobAPI_Group job_group,
     struct WritePartialAssetFromBlocksJob* job,
     uint32_t asset_chunk_index_offset,
@@ -5010,6 +6651,7 @@ static int CreatePartialAssetWriteJob(
         LONGTAIL_LOGFIELD(chunk_hash_to_block_index, "%p"),
         LONGTAIL_LOGFIELD(asset_index, "%u"),
         LONGTAIL_LOGFIELD(retain_permissions, "%d"),
+        LONGTAIL_LOGFIELD(stream_writes, "%d"),
         LONGTAIL_LOGFIELD(job_group, "%p"),
         LONGTAIL_LOGFIELD(job, "%p"),
         LONGTAIL_LOGFIELD(asset_chunk_index_offset, "%u"),
@@ -5041,6 +6683,7 @@ static int CreatePartialAssetWriteJob(
     job->m_AssetIndex = asset_index;
     job->m_JobGroup = job_group;
     job->m_RetainPermissions = retain_permissions;
+    job->m_StreamWrites = stream_writes;
     job->m_BlockReaderJobCount = 0;
     job->m_AssetChunkIndexOffset = asset_chunk_index_offset;
     job->m_AssetChunkCount = 0;
@@ -5059,6 +6702,12 @@ static int CreatePartialAssetWriteJob(
 
     while (chunk_index_offset != chunk_index_end && job->m_BlockReaderJobCount <= max_parallell_block_read_jobs)
     {
+        if (IsZeroAssetChunk(version_index, chunk_index_offset))
+        {
+            ++job->m_AssetChunkCount;
+            ++chunk_index_offset;
+            continue;
+        }
         uint32_t chunk_index = version_index->m_AssetChunkIndexes[chunk_index_offset];
         TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
         const uint32_t* block_index_ptr = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, chunk_hash);
@@ -5300,11 +6949,10 @@ int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled
             }
         }
 
-        uint64_t asset_size = job->m_VersionIndex->m_AssetSizes[job->m_AssetIndex];
-        err = job->m_VersionStorageAPI->OpenWriteFile(job->m_VersionStorageAPI, full_asset_path, asset_size, &job->m_AssetOutputFile);
+        err = OpenAssetOutputFile(job->m_VersionStorageAPI, job->m_VersionIndex, job->m_AssetIndex, full_asset_path, &job->m_AssetOutputFile);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->OpenWriteFile() failed with %d", err)
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "OpenAssetOutputFile() failed with %d", err)
             Longtail_Free(full_asset_path);
             for (uint32_t d = 0; d < block_reader_job_count; ++d)
             {
@@ -5334,6 +6982,7 @@ int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled
             job->m_ChunkHashToBlockIndex,
             job->m_AssetIndex,
             job->m_RetainPermissions,
+            job->m_StreamWrites,
             job->m_JobGroup,
             job,    // Reuse job
             write_chunk_index_offset + write_chunk_count,
@@ -5376,7 +7025,7 @@ int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled
     size_t chunk_sizes_size = sizeof(uint32_t) * block_chunks_count;
     size_t chunk_offsets_size = sizeof(uint32_t) * block_chunks_count;
     size_t block_indexes_size = sizeof(uint32_t) * block_chunks_count;
-    size_t buffer_size = 512*1024;
+    size_t buffer_size = ASSET_WRITE_BUFFER_SIZE;
 
     size_t work_mem_size =
         block_chunks_lookup_size +
@@ -5434,7 +7083,8 @@ int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled
         }
     }
 
-    size_t buffer_used_size = 0;
+    struct AssetWriteBuffer write_buffer;
+    AssetWriteBuffer_Init(&write_buffer, job->m_VersionStorageAPI, job->m_AssetOutputFile, buffer, buffer_size, write_offset, job->m_StreamWrites);
     uint32_t chunk_index_end = write_chunk_index_offset + write_chunk_count;
 
     while (chunk_index_offset < chunk_index_end)
@@ -5443,6 +7093,33 @@ int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled
         uint32_t chunk_index = job->m_VersionIndex->m_AssetChunkIndexes[asset_chunk_index];
         TLongtail_Hash chunk_hash = job->m_VersionIndex->m_ChunkHashes[chunk_index];
 
+        if (IsZeroAssetChunk(job->m_VersionIndex, asset_chunk_index))
+        {
+            int err = AssetWriteBuffer_Skip(&write_buffer, job->m_VersionIndex->m_ChunkSizes[chunk_index]);
+            if (err)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AssetWriteBuffer_Skip() failed with %d", err)
+                job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+                job->m_AssetOutputFile = 0;
+
+                for (uint32_t d = 0; d < block_reader_job_count; ++d)
+                {
+                    stored_block[d]->Dispose(stored_block[d]);
+                    stored_block[d] = 0;
+                }
+                job->m_Err = err;
+                if (sync_write_job)
+                {
+                    int sync_err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
+                    LONGTAIL_FATAL_ASSERT(ctx, sync_err == 0, return 0)
+                }
+                Longtail_Free(work_mem);
+                return 0;
+            }
+            ++chunk_index_offset;
+            continue;
+        }
+
         uint32_t* chunk_block_index = LongtailPrivate_LookupTable_Get(block_chunks_lookup, chunk_hash);
         if (chunk_block_index == 0)
         {
@@ -5470,7 +7147,12 @@ int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled
 
         while(chunk_index_offset < (chunk_index_end - 1))
         {
-            uint32_t next_chunk_index = job->m_VersionIndex->m_AssetChunkIndexes[asset_chunk_index + 1];
+            uint32_t next_asset_chunk_index = chunk_index_start + chunk_index_offset + 1;
+            if (IsZeroAssetChunk(job->m_VersionIndex, next_asset_chunk_index))
+            {
+                break;
+            }
+            uint32_t next_chunk_index = job->m_VersionIndex->m_AssetChunkIndexes[next_asset_chunk_index];
             TLongtail_Hash next_chunk_hash = job->m_VersionIndex->m_ChunkHashes[next_chunk_index];
 
             uint32_t* next_chunk_block_index = LongtailPrivate_LookupTable_Get(block_chunks_lookup, next_chunk_hash);
@@ -5507,59 +7189,10 @@ int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled
             ++chunk_index_offset;
         }
 
-        if (buffer_used_size + chunk_size <= buffer_size)
-        {
-            if (buffer_used_size > 0 || (chunk_index_offset < chunk_index_end - 1))
-            {
-                memcpy(&buffer[buffer_used_size], &block_data[chunk_block_offset], chunk_size);
-                buffer_used_size += chunk_size;
-                ++chunk_index_offset;
-                continue;
-            }
-        }
-
-        if (buffer_used_size > 0)
-        {
-            int err = job->m_VersionStorageAPI->Write(job->m_VersionStorageAPI, job->m_AssetOutputFile, write_offset, buffer_used_size, buffer);
-            if (err)
-            {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->Write() failed with %d", err)
-                job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-                job->m_AssetOutputFile = 0;
-
-                for (uint32_t d = 0; d < block_reader_job_count; ++d)
-                {
-                    stored_block[d]->Dispose(stored_block[d]);
-                    stored_block[d] = 0;
-                }
-                job->m_Err = err;
-                if (sync_write_job)
-                {
-                    int sync_err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
-                    LONGTAIL_FATAL_ASSERT(ctx, sync_err == 0, return 0)
-                }
-                Longtail_Free(work_mem);
-                return 0;
-            }
-            write_offset += buffer_used_size;
-            buffer_used_size = 0;
-        }
-
-        if (buffer_used_size + chunk_size <= buffer_size)
-        {
-            if (buffer_used_size > 0 || (chunk_index_offset < chunk_index_end - 1))
-            {
-                memcpy(&buffer[buffer_used_size], &block_data[chunk_block_offset], chunk_size);
-                buffer_used_size += chunk_size;
-                ++chunk_index_offset;
-                continue;
-            }
-        }
-
-        int err = job->m_VersionStorageAPI->Write(job->m_VersionStorageAPI, job->m_AssetOutputFile, write_offset, chunk_size, &block_data[chunk_block_offset]);
+        int err = AssetWriteBuffer_Write(&write_buffer, &block_data[chunk_block_offset], chunk_size);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->Write() failed with %d", err)
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AssetWriteBuffer_Write() failed with %d", err)
             job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
             job->m_AssetOutputFile = 0;
 
@@ -5577,36 +7210,30 @@ int WritePartialAssetFromBlocks(void* context, uint32_t job_id, int is_cancelled
             Longtail_Free(work_mem);
             return 0;
         }
-        write_offset += chunk_size;
 
         ++chunk_index_offset;
     }
 
-    if (buffer_used_size > 0)
+    int err = AssetWriteBuffer_Flush(&write_buffer);
+    if (err)
     {
-        int err = job->m_VersionStorageAPI->Write(job->m_VersionStorageAPI, job->m_AssetOutputFile, write_offset, buffer_used_size, buffer);
-        if (err)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "job->m_VersionStorageAPI->Write() failed with %d", err)
-            job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
-            job->m_AssetOutputFile = 0;
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AssetWriteBuffer_Flush() failed with %d", err)
+        job->m_VersionStorageAPI->CloseFile(job->m_VersionStorageAPI, job->m_AssetOutputFile);
+        job->m_AssetOutputFile = 0;
 
-            for (uint32_t d = 0; d < block_reader_job_count; ++d)
-            {
-                stored_block[d]->Dispose(stored_block[d]);
-                stored_block[d] = 0;
-            }
-            job->m_Err = err;
-            if (sync_write_job)
-            {
-                int sync_err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
-                LONGTAIL_FATAL_ASSERT(ctx, sync_err == 0, return 0)
-            }
-            Longtail_Free(work_mem);
-            return 0;
+        for (uint32_t d = 0; d < block_reader_job_count; ++d)
+        {
+            stored_block[d]->Dispose(stored_block[d]);
+            stored_block[d] = 0;
+        }
+        job->m_Err = err;
+        if (sync_write_job)
+        {
+            int sync_err = job->m_JobAPI->ReadyJobs(job->m_JobAPI, 1, sync_write_job);
+            LONGTAIL_FATAL_ASSERT(ctx, sync_err == 0, return 0)
         }
-        write_offset += buffer_used_size;
-        buffer_used_size = 0;
+        Longtail_Free(work_mem);
+        return 0;
     }
 
     Longtail_Free(work_mem);
@@ -5662,6 +7289,7 @@ struct WriteAssetsFromBlockJob
     uint32_t* m_AssetIndexes;
     uint32_t m_AssetCount;
     int m_RetainPermissions;
+    int m_StreamWrites;
     int m_Err;
 };
 
@@ -5702,11 +7330,20 @@ static int WriteAssetsFromBlock(void* context, uint32_t job_id, int is_cancelled
 
     uint32_t block_chunks_count = *block_index->m_ChunkCount;
 
+    // Assets written from a single block are never larger than the block data
+    uint64_t block_data_size = 0;
+    for (uint32_t c = 0; c < block_chunks_count; ++c)
+    {
+        block_data_size += block_index->m_ChunkSizes[c];
+    }
+
     size_t chuck_offsets_size = sizeof(uint32_t) * block_chunks_count;
     size_t block_chunks_lookup_size = LongtailPrivate_LookupTable_GetSize(block_chunks_count);
+    size_t buffer_size = block_data_size < ASSET_WRITE_BUFFER_SIZE ? (size_t)block_data_size : ASSET_WRITE_BUFFER_SIZE;
     size_t tmp_mem_size =
         chuck_offsets_size +
-        block_chunks_lookup_size;
+        block_chunks_lookup_size +
+        buffer_size;
 
     char* tmp_mem = (char*)Longtail_Alloc("WriteAssetsFromBlock", tmp_mem_size);
     if (!tmp_mem)
@@ -5719,6 +7356,7 @@ static int WriteAssetsFromBlock(void* context, uint32_t job_id, int is_cancelled
     }
     struct Longtail_LookupTable* block_chunks_lookup = LongtailPrivate_LookupTable_Create(tmp_mem, block_chunks_count, 0);
     uint32_t* chunk_offsets = (uint32_t*)(&tmp_mem[block_chunks_lookup_size]);
+    char* buffer = &tmp_mem[block_chunks_lookup_size + chuck_offsets_size];
     const uint32_t* chunk_sizes = block_index->m_ChunkSizes;
 
     uint32_t block_chunk_index_offset = 0;
@@ -5784,10 +7422,10 @@ static int WriteAssetsFromBlock(void* context, uint32_t job_id, int is_cancelled
         }
 
         Longtail_StorageAPI_HOpenFile asset_file;
-        err = version_storage_api->OpenWriteFile(version_storage_api, full_asset_path, 0, &asset_file);
+        err = OpenAssetOutputFile(version_storage_api, version_index, asset_index, full_asset_path, &asset_file);
         if (err)
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->OpenWriteFile() failed with %d", err)
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "OpenAssetOutputFile() failed with %d", err)
             Longtail_Free(full_asset_path);
             full_asset_path = 0;
             job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
@@ -5797,7 +7435,8 @@ static int WriteAssetsFromBlock(void* context, uint32_t job_id, int is_cancelled
             return 0;
         }
 
-        uint64_t asset_write_offset = 0;
+        struct AssetWriteBuffer write_buffer;
+        AssetWriteBuffer_Init(&write_buffer, version_storage_api, asset_file, buffer, buffer_size, 0, job->m_StreamWrites);
         uint32_t asset_chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
         uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[asset_index];
         for (uint32_t asset_chunk_index = 0; asset_chunk_index < asset_chunk_count; ++asset_chunk_index)
@@ -5805,6 +7444,25 @@ static int WriteAssetsFromBlock(void* context, uint32_t job_id, int is_cancelled
             uint32_t chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + asset_chunk_index];
             TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
 
+            if (IsZeroAssetChunk(version_index, asset_chunk_index_start + asset_chunk_index))
+            {
+                err = AssetWriteBuffer_Skip(&write_buffer, version_index->m_ChunkSizes[chunk_index]);
+                if (err)
+                {
+                    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AssetWriteBuffer_Skip() failed with %d", err)
+                    version_storage_api->CloseFile(version_storage_api, asset_file);
+                    asset_file = 0;
+                    Longtail_Free(full_asset_path);
+                    full_asset_path = 0;
+                    job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+                    job->m_BlockReadJob.m_StoredBlock = 0;
+                    job->m_Err = err;
+                    Longtail_Free(tmp_mem);
+                    return 0;
+                }
+                continue;
+            }
+
             uint32_t* chunk_block_index = LongtailPrivate_LookupTable_Get(block_chunks_lookup, chunk_hash);
             if (chunk_block_index == 0)
             {
@@ -5825,6 +7483,10 @@ static int WriteAssetsFromBlock(void* context, uint32_t job_id, int is_cancelled
 
             while(asset_chunk_index < (asset_chunk_count - 1))
             {
+                if (IsZeroAssetChunk(version_index, asset_chunk_index_start + asset_chunk_index + 1))
+                {
+                    break;
+                }
                 uint32_t next_chunk_index = version_index->m_AssetChunkIndexes[asset_chunk_index_start + asset_chunk_index + 1];
                 TLongtail_Hash next_chunk_hash = version_index->m_ChunkHashes[next_chunk_index];
                 uint32_t* next_chunk_block_index = LongtailPrivate_LookupTable_Get(block_chunks_lookup, next_chunk_hash);
@@ -5852,10 +7514,10 @@ static int WriteAssetsFromBlock(void* context, uint32_t job_id, int is_cancelled
                 ++asset_chunk_index;
             }
 
-            err = version_storage_api->Write(version_storage_api, asset_file, asset_write_offset, chunk_size, &block_data[chunk_block_offset]);
+            err = AssetWriteBuffer_Write(&write_buffer, &block_data[chunk_block_offset], chunk_size);
             if (err)
             {
-                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->Write() failed with %d", err)
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AssetWriteBuffer_Write() failed with %d", err)
                 version_storage_api->CloseFile(version_storage_api, asset_file);
                 asset_file = 0;
                 Longtail_Free(full_asset_path);
@@ -5866,7 +7528,21 @@ static int WriteAssetsFromBlock(void* context, uint32_t job_id, int is_cancelled
                 Longtail_Free(tmp_mem);
                 return 0;
             }
-            asset_write_offset += chunk_size;
+        }
+
+        err = AssetWriteBuffer_Flush(&write_buffer);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "AssetWriteBuffer_Flush() failed with %d", err)
+            version_storage_api->CloseFile(version_storage_api, asset_file);
+            asset_file = 0;
+            Longtail_Free(full_asset_path);
+            full_asset_path = 0;
+            job->m_BlockReadJob.m_StoredBlock->Dispose(job->m_BlockReadJob.m_StoredBlock);
+            job->m_BlockReadJob.m_StoredBlock = 0;
+            job->m_Err = err;
+            Longtail_Free(tmp_mem);
+            return 0;
         }
 
         version_storage_api->CloseFile(version_storage_api, asset_file);
@@ -5913,6 +7589,7 @@ struct JobCompareContext
     const uint32_t* asset_chunk_index_starts;
     const uint32_t* asset_chunk_indexes;
     const TLongtail_Hash* chunk_hashes;
+    const struct Longtail_VersionIndex* version_index;
     struct Longtail_LookupTable* chunk_hash_to_block_index;
 };
 
@@ -5928,14 +7605,23 @@ static uint32_t GetJobBlockIndex(struct JobCompareContext* c, uint32_t asset_ind
 #endif // defined(LONGTAIL_ASSERTS)
 
     uint32_t asset_chunk_offset = c->asset_chunk_index_starts[asset_index];
-    uint32_t chunk_index = c->asset_chunk_indexes[asset_chunk_offset];
-
-    TLongtail_Hash chunk_hash = c->chunk_hashes[chunk_index];
+    uint32_t asset_chunk_count = c->asset_chunk_counts[asset_index];
+    for (uint32_t a = 0; a < asset_chunk_count; ++a)
+    {
+        uint32_t chunk_index = c->asset_chunk_indexes[asset_chunk_offset + a];
+        TLongtail_Hash chunk_hash = c->chunk_hashes[chunk_index];
+        if (Longtail_IsZeroChunk(c->version_index, chunk_index))
+        {
+            continue;
+        }
 
-    const uint32_t* block_index_ptr = LongtailPrivate_LookupTable_Get(c->chunk_hash_to_block_index, chunk_hash);
-    LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return 0)
+        const uint32_t* block_index_ptr = LongtailPrivate_LookupTable_Get(c->chunk_hash_to_block_index, chunk_hash);
+        LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return 0)
 
-    return *block_index_ptr;
+        return *block_index_ptr;
+    }
+    // Assets with only zero chunks are not read from any block
+    return 0;
 }
 
 static SORTFUNC(JobCompare)
@@ -6017,6 +7703,7 @@ static int BuildAssetWriteList(
     const uint32_t* asset_chunk_counts,
     const uint32_t* asset_chunk_index_starts,
     const uint32_t* asset_chunk_indexes,
+    const struct Longtail_VersionIndex* version_index,
     struct Longtail_LookupTable* chunk_hash_to_block_index,
     struct AssetWriteList** out_asset_write_list)
 {
@@ -6029,6 +7716,7 @@ static int BuildAssetWriteList(
         LONGTAIL_LOGFIELD(asset_chunk_counts, "%p"),
         LONGTAIL_LOGFIELD(asset_chunk_index_starts, "%p"),
         LONGTAIL_LOGFIELD(asset_chunk_indexes, "%p"),
+        LONGTAIL_LOGFIELD(version_index, "%p"),
         LONGTAIL_LOGFIELD(chunk_hash_to_block_index, "%p"),
         LONGTAIL_LOGFIELD(out_asset_write_list, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
@@ -6036,6 +7724,7 @@ static int BuildAssetWriteList(
     LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || name_offsets != 0, return EINVAL)
     LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || name_data != 0, return EINVAL)
     LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || chunk_hashes != 0, return EINVAL)
+    LONGTAIL_FATAL_ASSERT(ctx, version_index != 0, return EINVAL)
     LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || asset_chunk_counts != 0, return EINVAL)
     LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || asset_chunk_index_starts != 0, return EINVAL)
     LONGTAIL_FATAL_ASSERT(ctx, asset_count == 0 || asset_chunk_indexes != 0, return EINVAL)
@@ -6061,21 +7750,17 @@ static int BuildAssetWriteList(
             ++awl->m_AssetJobCount;
             continue;
         }
-        uint32_t chunk_index = asset_chunk_indexes[asset_chunk_offset];
-        TLongtail_Hash chunk_hash = chunk_hashes[chunk_index];
-        uint32_t* content_block_index = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, chunk_hash);
-        if (content_block_index == 0)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "LongtailPrivate_LookupTable_Get() failed with %d", ENOENT)
-            Longtail_Free(awl);
-            return ENOENT;
-        }
-
+        uint32_t* content_block_index = 0;
         int is_block_job = 1;
-        for (uint32_t c = 1; c < chunk_count; ++c)
+        for (uint32_t c = 0; c < chunk_count; ++c)
         {
             uint32_t next_chunk_index = asset_chunk_indexes[asset_chunk_offset + c];
             TLongtail_Hash next_chunk_hash = chunk_hashes[next_chunk_index];
+            if (Longtail_IsZeroChunk(version_index, next_chunk_index))
+            {
+                // Zero chunks are not stored in any block, they are left as holes in the asset
+                continue;
+            }
             uint32_t* next_content_block_index = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, next_chunk_hash);
             if (next_content_block_index == 0)
             {
@@ -6083,14 +7768,18 @@ static int BuildAssetWriteList(
                 Longtail_Free(awl);
                 return ENOENT;
             }
-            if (*content_block_index != *next_content_block_index)
+            if (content_block_index == 0)
+            {
+                content_block_index = next_content_block_index;
+            }
+            else if (*content_block_index != *next_content_block_index)
             {
                 is_block_job = 0;
                 // We don't break here since we want to validate that all the chunks are in the content index
             }
         }
 
-        if (is_block_job)
+        if (is_block_job && content_block_index != 0)
         {
             awl->m_BlockJobAssetIndexes[awl->m_BlockJobCount] = asset_index;
             ++awl->m_BlockJobCount;
@@ -6108,6 +7797,7 @@ static int BuildAssetWriteList(
             asset_chunk_index_starts,
             asset_chunk_indexes,
             chunk_hashes,
+            version_index,
             chunk_hash_to_block_index
         };
     QSORT(awl->m_BlockJobAssetIndexes, (size_t)awl->m_BlockJobCount, sizeof(uint32_t), JobCompare, &block_job_compare_context);
@@ -6129,7 +7819,8 @@ static int WriteAssets(
     const char* version_path,
     struct Longtail_LookupTable* chunk_hash_to_block_index,
     struct AssetWriteList* awl,
-    int retain_permssions)
+    int retain_permssions,
+    int stream_writes)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(block_store_api, "%p"),
@@ -6143,7 +7834,8 @@ static int WriteAssets(
         LONGTAIL_LOGFIELD(version_path, "%s"),
         LONGTAIL_LOGFIELD(chunk_hash_to_block_index, "%p"),
         LONGTAIL_LOGFIELD(awl, "%p"),
-        LONGTAIL_LOGFIELD(retain_permssions, "%d")
+        LONGTAIL_LOGFIELD(retain_permssions, "%d"),
+        LONGTAIL_LOGFIELD(stream_writes, "%d")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
     LONGTAIL_FATAL_ASSERT(ctx, block_store_api != 0, return EINVAL)
@@ -6161,7 +7853,7 @@ static int WriteAssets(
         while (j < awl->m_BlockJobCount)
         {
             uint32_t asset_index = awl->m_BlockJobAssetIndexes[j];
-            TLongtail_Hash first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[asset_index]]];
+            TLongtail_Hash first_chunk_hash = GetFirstStoredChunkHash(version_index, asset_index);
             const uint32_t* block_index_ptr = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, first_chunk_hash);
             if (!block_index_ptr)
             {
@@ -6175,7 +7867,7 @@ static int WriteAssets(
             while (j < awl->m_BlockJobCount)
             {
                 uint32_t asset_index = awl->m_BlockJobAssetIndexes[j];
-                TLongtail_Hash first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[asset_index]]];
+                TLongtail_Hash first_chunk_hash = GetFirstStoredChunkHash(version_index, asset_index);
                 const uint32_t* next_block_index_ptr = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, first_chunk_hash);
                 if (!next_block_index_ptr)
                 {
@@ -6216,6 +7908,11 @@ static int WriteAssets(
             TLongtail_Hash block_hashes[MAX_BLOCKS_PER_PARTIAL_ASSET_WRITE];
             while (chunk_index_offset != chunk_index_end && block_read_job_count < max_parallell_block_read_jobs)
             {
+                if (IsZeroAssetChunk(version_index, chunk_index_offset))
+                {
+                    ++chunk_index_offset;
+                    continue;
+                }
                 uint32_t chunk_index = version_index->m_AssetChunkIndexes[chunk_index_offset];
                 TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
                 const uint32_t* block_index_ptr = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, chunk_hash);
@@ -6243,7 +7940,61 @@ static int WriteAssets(
         }
     }
 
-    int err = block_store_api->PreflightGet(block_store_api, *store_index->m_BlockCount, store_index->m_BlockHashes, 0);
+    // Preflight only the blocks the jobs below read, in the order the jobs are created, so a
+    // block store that prefetches has them ready in about the order they are asked for
+    uint32_t store_block_count = *store_index->m_BlockCount;
+    TLongtail_Hash* preflight_block_hashes = store_index->m_BlockHashes;
+    uint32_t preflight_block_count = store_block_count;
+    void* preflight_mem = 0;
+    if (store_block_count > 0)
+    {
+        preflight_mem = Longtail_Alloc("WriteAssets", (sizeof(TLongtail_Hash) + sizeof(uint8_t)) * store_block_count);
+        if (!preflight_mem)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            return ENOMEM;
+        }
+        preflight_block_hashes = (TLongtail_Hash*)preflight_mem;
+        uint8_t* preflight_block_added = (uint8_t*)&preflight_block_hashes[store_block_count];
+        memset(preflight_block_added, 0, store_block_count);
+        preflight_block_count = 0;
+        for (uint32_t j = 0; j < awl->m_BlockJobCount; ++j)
+        {
+            uint32_t asset_index = awl->m_BlockJobAssetIndexes[j];
+            TLongtail_Hash first_chunk_hash = GetFirstStoredChunkHash(version_index, asset_index);
+            const uint32_t* block_index_ptr = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, first_chunk_hash);
+            LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return EINVAL)
+            if (!preflight_block_added[*block_index_ptr])
+            {
+                preflight_block_added[*block_index_ptr] = 1;
+                preflight_block_hashes[preflight_block_count++] = store_index->m_BlockHashes[*block_index_ptr];
+            }
+        }
+        for (uint32_t a = 0; a < awl->m_AssetJobCount; ++a)
+        {
+            uint32_t asset_index = awl->m_AssetIndexJobs[a];
+            uint32_t chunk_index_start = version_index->m_AssetChunkIndexStarts[asset_index];
+            uint32_t chunk_index_end = chunk_index_start + version_index->m_AssetChunkCounts[asset_index];
+            for (uint32_t c = chunk_index_start; c < chunk_index_end; ++c)
+            {
+                if (IsZeroAssetChunk(version_index, c))
+                {
+                    continue;
+                }
+                TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[c]];
+                const uint32_t* block_index_ptr = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, chunk_hash);
+                LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return EINVAL)
+                if (!preflight_block_added[*block_index_ptr])
+                {
+                    preflight_block_added[*block_index_ptr] = 1;
+                    preflight_block_hashes[preflight_block_count++] = store_index->m_BlockHashes[*block_index_ptr];
+                }
+            }
+        }
+    }
+
+    int err = block_store_api->PreflightGet(block_store_api, preflight_block_count, preflight_block_hashes, 0);
+    Longtail_Free(preflight_mem);
     if (err)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "block_store_api->PreflightGet() failed with %d", err)
@@ -6270,7 +8021,7 @@ static int WriteAssets(
         while (j < awl->m_BlockJobCount)
         {
             uint32_t asset_index = awl->m_BlockJobAssetIndexes[j];
-            TLongtail_Hash first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[asset_index]]];
+            TLongtail_Hash first_chunk_hash = GetFirstStoredChunkHash(version_index, asset_index);
             const uint32_t* block_index_ptr = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, first_chunk_hash);
             LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return EINVAL)
             uint32_t block_index = *block_index_ptr;
@@ -6281,7 +8032,7 @@ static int WriteAssets(
             while (j < awl->m_BlockJobCount)
             {
                 uint32_t next_asset_index = awl->m_BlockJobAssetIndexes[j];
-                TLongtail_Hash next_first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[next_asset_index]]];
+                TLongtail_Hash next_first_chunk_hash = GetFirstStoredChunkHash(version_index, next_asset_index);
                 uint32_t* next_block_index = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, next_first_chunk_hash);
                 LONGTAIL_FATAL_ASSERT(ctx, next_block_index != 0, return EINVAL)
                 if (block_index != *next_block_index)
@@ -6310,7 +8061,7 @@ static int WriteAssets(
     while (j < awl->m_BlockJobCount)
     {
         uint32_t asset_index = awl->m_BlockJobAssetIndexes[j];
-        TLongtail_Hash first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[asset_index]]];
+        TLongtail_Hash first_chunk_hash = GetFirstStoredChunkHash(version_index, asset_index);
         const uint32_t* block_index_ptr = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, first_chunk_hash);
         LONGTAIL_FATAL_ASSERT(ctx, block_index_ptr, return EINVAL)
         uint32_t block_index = *block_index_ptr;
@@ -6337,6 +8088,7 @@ static int WriteAssets(
         job->m_BlockIndex = block_index;
         job->m_AssetIndexes = &awl->m_BlockJobAssetIndexes[j];
         job->m_RetainPermissions = retain_permssions;
+        job->m_StreamWrites = stream_writes;
         job->m_Err = EINVAL;
 
         job->m_AssetCount = 1;
@@ -6344,7 +8096,7 @@ static int WriteAssets(
         while (j < awl->m_BlockJobCount)
         {
             uint32_t next_asset_index = awl->m_BlockJobAssetIndexes[j];
-            TLongtail_Hash next_first_chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[next_asset_index]]];
+            TLongtail_Hash next_first_chunk_hash = GetFirstStoredChunkHash(version_index, next_asset_index);
             uint32_t* next_block_index = LongtailPrivate_LookupTable_Get(chunk_hash_to_block_index, next_first_chunk_hash);
             LONGTAIL_FATAL_ASSERT(ctx, next_block_index != 0, return EINVAL)
             if (block_index != *next_block_index)
@@ -6421,6 +8173,7 @@ Write Task Execute (When block_reador Tasks [block_readorCount] and WriteSync Ta
             chunk_hash_to_block_index,
             awl->m_AssetIndexJobs[a],
             retain_permssions,
+            stream_writes,
             job_group,
             &asset_jobs[a],
             0,
@@ -6550,6 +8303,7 @@ int Longtail_WriteVersion(
         version_index->m_AssetChunkCounts,
         version_index->m_AssetChunkIndexStarts,
         version_index->m_AssetChunkIndexes,
+        version_index,
         chunk_hash_to_block_index,
         &awl);
 
@@ -6572,7 +8326,8 @@ int Longtail_WriteVersion(
         version_path,
         chunk_hash_to_block_index,
         awl,
-        retain_permissions);
+        retain_permissions,
+        0);
     if (err)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "WriteAssets() failed with %d", err)
@@ -6754,12 +8509,18 @@ static int DiffHashes(
     return 0;
 }
 
-int Longtail_CreateStoreIndex(
+// Packs the chunks in blocks in the order of chunk_indexes. With optional_chunk_groups a group of chunks
+// (the new chunks of one asset) that would fit in a block of its own but not in what is left of a block that
+// is at least half full starts a new block, so the group is not split over more blocks than needed
+static int PackChunksInBlocks(
     struct Longtail_HashAPI* hash_api,
     uint32_t chunk_count,
+    const uint32_t* chunk_indexes,
     const TLongtail_Hash* chunk_hashes,
     const uint32_t* chunk_sizes,
     const uint32_t* optional_chunk_tags,
+    const uint32_t* optional_chunk_groups,
+    const uint64_t* optional_group_sizes,
     uint32_t max_block_size,
     uint32_t max_chunks_per_block,
     struct Longtail_StoreIndex** out_store_index)
@@ -6767,64 +8528,49 @@ int Longtail_CreateStoreIndex(
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(hash_api, "%p"),
         LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_indexes, "%p"),
         LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
         LONGTAIL_LOGFIELD(chunk_sizes, "%p"),
         LONGTAIL_LOGFIELD(optional_chunk_tags, "%p"),
+        LONGTAIL_LOGFIELD(optional_chunk_groups, "%p"),
+        LONGTAIL_LOGFIELD(optional_group_sizes, "%p"),
         LONGTAIL_LOGFIELD(max_block_size, "%u"),
         LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
         LONGTAIL_LOGFIELD(out_store_index, "%p")
-    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
-
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || hash_api != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_hashes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_sizes != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || max_block_size != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || max_chunks_per_block != 0, return EINVAL)
-    LONGTAIL_VALIDATE_INPUT(ctx, out_store_index != 0, return EINVAL)
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
 
-    if (chunk_count == 0)
-    {
-        int err = Longtail_CreateStoreIndexFromBlocks(0, 0, out_store_index);
-        if (err)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
-            return err;
-        }
-        return 0;
-    }
+    LONGTAIL_FATAL_ASSERT(ctx, (optional_chunk_groups == 0) == (optional_group_sizes == 0), return EINVAL)
 
-    size_t work_mem_size = (sizeof(uint32_t) * chunk_count) +
-        (sizeof(struct Longtail_BlockIndex*) * chunk_count) +
+    size_t work_mem_size = (sizeof(struct Longtail_BlockIndex*) * chunk_count) +
         (sizeof(uint32_t) * max_chunks_per_block);
-    void* work_mem = Longtail_Alloc("Longtail_CreateStoreIndex", work_mem_size);
+    void* work_mem = Longtail_Alloc("PackChunksInBlocks", work_mem_size);
     if (!work_mem)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return ENOMEM;
     }
-    uint32_t* tmp_chunk_indexes = (uint32_t*)work_mem;
-    struct Longtail_BlockIndex** tmp_block_indexes = (struct Longtail_BlockIndex**)&tmp_chunk_indexes[chunk_count];
+    struct Longtail_BlockIndex** tmp_block_indexes = (struct Longtail_BlockIndex**)work_mem;
     uint32_t* tmp_stored_chunk_indexes = (uint32_t*)&tmp_block_indexes[chunk_count];
-    uint32_t unique_chunk_count = GetUniqueHashes((uint32_t)chunk_count, chunk_hashes, tmp_chunk_indexes);
 
     uint32_t i = 0;
     uint32_t block_count = 0;
 
-    while (i < unique_chunk_count)
+    while (i < chunk_count)
     {
         uint32_t chunk_count_in_block = 0;
 
-        uint32_t chunk_index = tmp_chunk_indexes[i];
+        uint32_t chunk_index = chunk_indexes[i];
 
         uint32_t current_size = chunk_sizes[chunk_index];
         uint32_t current_tag = optional_chunk_tags ? optional_chunk_tags[chunk_index] : 0;
+        uint32_t current_group = optional_chunk_groups ? optional_chunk_groups[chunk_index] : 0;
 
         tmp_stored_chunk_indexes[chunk_count_in_block] = chunk_index;
         ++chunk_count_in_block;
 
-        while((i + 1) < unique_chunk_count)
+        while((i + 1) < chunk_count)
         {
-            chunk_index = tmp_chunk_indexes[(i + 1)];
+            chunk_index = chunk_indexes[(i + 1)];
             uint32_t chunk_size = chunk_sizes[chunk_index];
             uint32_t tag = optional_chunk_tags ? optional_chunk_tags[chunk_index] : 0;
 
@@ -6845,6 +8591,18 @@ int Longtail_CreateStoreIndex(
                 break;
             }
 
+            if (optional_chunk_groups && optional_chunk_groups[chunk_index] != current_group)
+            {
+                current_group = optional_chunk_groups[chunk_index];
+                uint64_t group_size = optional_group_sizes[current_group];
+                if (group_size <= max_block_size &&
+                    (current_size + group_size) > max_block_size &&
+                    current_size >= (max_block_size / 2))
+                {
+                    break;
+                }
+            }
+
             current_size += chunk_size;
             tmp_stored_chunk_indexes[chunk_count_in_block] = chunk_index;
             ++chunk_count_in_block;
@@ -6863,6 +8621,10 @@ int Longtail_CreateStoreIndex(
         if (err)
         {
             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateBlockIndex() failed with %d", err)
+            while (block_count > 0)
+            {
+                Longtail_Free(tmp_block_indexes[--block_count]);
+            }
             Longtail_Free(work_mem);
             return err;
         }
@@ -6878,7 +8640,6 @@ int Longtail_CreateStoreIndex(
     if (err)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
-        return err;
     }
 
     for (uint32_t b = 0; b < block_count; ++b)
@@ -6891,12 +8652,266 @@ int Longtail_CreateStoreIndex(
     return err;
 }
 
-int Longtail_CreateMissingContent(
+int Longtail_CreateStoreIndex(
+    struct Longtail_HashAPI* hash_api,
+    uint32_t chunk_count,
+    const TLongtail_Hash* chunk_hashes,
+    const uint32_t* chunk_sizes,
+    const uint32_t* optional_chunk_tags,
+    uint32_t max_block_size,
+    uint32_t max_chunks_per_block,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(chunk_count, "%u"),
+        LONGTAIL_LOGFIELD(chunk_hashes, "%p"),
+        LONGTAIL_LOGFIELD(chunk_sizes, "%p"),
+        LONGTAIL_LOGFIELD(optional_chunk_tags, "%p"),
+        LONGTAIL_LOGFIELD(max_block_size, "%u"),
+        LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
+        LONGTAIL_LOGFIELD(out_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || hash_api != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_hashes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || chunk_sizes != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || max_block_size != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, chunk_count == 0 || max_chunks_per_block != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, out_store_index != 0, return EINVAL)
+
+    if (chunk_count == 0)
+    {
+        int err = Longtail_CreateStoreIndexFromBlocks(0, 0, out_store_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_CreateStoreIndexFromBlocks() failed with %d", err)
+            return err;
+        }
+        return 0;
+    }
+
+    uint32_t* tmp_chunk_indexes = (uint32_t*)Longtail_Alloc("Longtail_CreateStoreIndex", sizeof(uint32_t) * chunk_count);
+    if (!tmp_chunk_indexes)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    uint32_t unique_chunk_count = GetUniqueHashes((uint32_t)chunk_count, chunk_hashes, tmp_chunk_indexes);
+
+    int err = PackChunksInBlocks(
+        hash_api,
+        unique_chunk_count,
+        tmp_chunk_indexes,
+        chunk_hashes,
+        chunk_sizes,
+        optional_chunk_tags,
+        0,
+        0,
+        max_block_size,
+        max_chunks_per_block,
+        out_store_index);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "PackChunksInBlocks() failed with %d", err)
+    }
+    Longtail_Free(tmp_chunk_indexes);
+    return err;
+}
+
+static const char* GetPathExtension(const char* path)
+{
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    const char* extension = strrchr(name, '.');
+    return extension ? extension : "";
+}
+
+static SORTFUNC(SortAssetsByLocality)
+{
+#if defined(LONGTAIL_ASSERTS)
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(context, "%p"),
+        LONGTAIL_LOGFIELD(a_ptr, "%p"),
+        LONGTAIL_LOGFIELD(b_ptr, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+#else
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+#endif // defined(LONGTAIL_ASSERTS)
+
+    LONGTAIL_FATAL_ASSERT(ctx, context != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, a_ptr != 0, return 0)
+    LONGTAIL_FATAL_ASSERT(ctx, b_ptr != 0, return 0)
+
+    const struct Longtail_VersionIndex* version_index = (const struct Longtail_VersionIndex*)context;
+    const uint32_t a_index = *(const uint32_t*)a_ptr;
+    const uint32_t b_index = *(const uint32_t*)b_ptr;
+
+    // Chunks with different tags never share a block so keep each tag together
+    const uint32_t a_tag = version_index->m_ChunkTags[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[a_index]]];
+    const uint32_t b_tag = version_index->m_ChunkTags[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[b_index]]];
+    if (a_tag != b_tag)
+    {
+        return (a_tag < b_tag) ? -1 : 1;
+    }
+
+    const char* a_path = &version_index->m_NameData[version_index->m_NameOffsets[a_index]];
+    const char* b_path = &version_index->m_NameData[version_index->m_NameOffsets[b_index]];
+    int extension_order = strcmp(GetPathExtension(a_path), GetPathExtension(b_path));
+    if (extension_order != 0)
+    {
+        return extension_order;
+    }
+    return strcmp(a_path, b_path);
+}
+
+// Orders the new chunks by asset, with assets sorted on tag, file extension and path,
+// and packs them so the new chunks of an asset end up in as few blocks as possible
+static int CreateLocalityMissingContent(
+    struct Longtail_HashAPI* hash_api,
+    const struct Longtail_VersionIndex* version_index,
+    const struct Longtail_LookupTable* chunk_index_lookup,
+    uint32_t added_hash_count,
+    const TLongtail_Hash* added_hashes,
+    uint32_t max_block_size,
+    uint32_t max_chunks_per_block,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(hash_api, "%p"),
+        LONGTAIL_LOGFIELD(version_index, "%p"),
+        LONGTAIL_LOGFIELD(chunk_index_lookup, "%p"),
+        LONGTAIL_LOGFIELD(added_hash_count, "%u"),
+        LONGTAIL_LOGFIELD(added_hashes, "%p"),
+        LONGTAIL_LOGFIELD(max_block_size, "%u"),
+        LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
+        LONGTAIL_LOGFIELD(out_store_index, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    uint32_t chunk_count = *version_index->m_ChunkCount;
+    uint32_t asset_count = *version_index->m_AssetCount;
+
+    size_t chunk_states_size = sizeof(uint8_t) * chunk_count;
+    size_t chunk_groups_size = sizeof(uint32_t) * chunk_count;
+    size_t ordered_chunk_indexes_size = sizeof(uint32_t) * added_hash_count;
+    size_t asset_indexes_size = sizeof(uint32_t) * asset_count;
+    size_t group_sizes_size = sizeof(uint64_t) * asset_count;
+    size_t work_mem_size =
+        group_sizes_size +
+        chunk_groups_size +
+        ordered_chunk_indexes_size +
+        asset_indexes_size +
+        chunk_states_size;
+    void* work_mem = Longtail_Alloc("CreateLocalityMissingContent", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    char* p = (char*)work_mem;
+    uint64_t* group_sizes = (uint64_t*)p;
+    p += group_sizes_size;
+    uint32_t* chunk_groups = (uint32_t*)p;
+    p += chunk_groups_size;
+    uint32_t* ordered_chunk_indexes = (uint32_t*)p;
+    p += ordered_chunk_indexes_size;
+    uint32_t* asset_indexes = (uint32_t*)p;
+    p += asset_indexes_size;
+    uint8_t* chunk_states = (uint8_t*)p;
+
+    // 0 = already stored, 1 = new, 2 = new and placed in order
+    memset(chunk_states, 0, chunk_states_size);
+    for (uint32_t j = 0; j < added_hash_count; ++j)
+    {
+        const uint32_t* chunk_index_ptr = LongtailPrivate_LookupTable_Get(chunk_index_lookup, added_hashes[j]);
+        LONGTAIL_FATAL_ASSERT(ctx, chunk_index_ptr, Longtail_Free(work_mem); return EINVAL)
+        chunk_states[*chunk_index_ptr] = 1;
+    }
+
+    uint32_t new_asset_count = 0;
+    for (uint32_t a = 0; a < asset_count; ++a)
+    {
+        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[a];
+        const uint32_t* asset_chunk_indexes = &version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[a]];
+        for (uint32_t c = 0; c < asset_chunk_count; ++c)
+        {
+            if (chunk_states[asset_chunk_indexes[c]] == 1)
+            {
+                asset_indexes[new_asset_count++] = a;
+                break;
+            }
+        }
+    }
+
+    QSORT(asset_indexes, (size_t)new_asset_count, sizeof(uint32_t), SortAssetsByLocality, (void*)version_index);
+
+    uint32_t ordered_chunk_count = 0;
+    for (uint32_t g = 0; g < new_asset_count; ++g)
+    {
+        uint32_t a = asset_indexes[g];
+        uint32_t asset_chunk_count = version_index->m_AssetChunkCounts[a];
+        const uint32_t* asset_chunk_indexes = &version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[a]];
+        group_sizes[g] = 0;
+        for (uint32_t c = 0; c < asset_chunk_count; ++c)
+        {
+            uint32_t chunk_index = asset_chunk_indexes[c];
+            if (chunk_states[chunk_index] != 1)
+            {
+                continue;
+            }
+            chunk_states[chunk_index] = 2;
+            chunk_groups[chunk_index] = g;
+            group_sizes[g] += version_index->m_ChunkSizes[chunk_index];
+            ordered_chunk_indexes[ordered_chunk_count++] = chunk_index;
+        }
+    }
+    LONGTAIL_FATAL_ASSERT(ctx, ordered_chunk_count == added_hash_count, Longtail_Free(work_mem); return EINVAL)
+
+    int err = PackChunksInBlocks(
+        hash_api,
+        ordered_chunk_count,
+        ordered_chunk_indexes,
+        version_index->m_ChunkHashes,
+        version_index->m_ChunkSizes,
+        version_index->m_ChunkTags,
+        chunk_groups,
+        group_sizes,
+        max_block_size,
+        max_chunks_per_block,
+        out_store_index);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "PackChunksInBlocks() failed with %d", err)
+    }
+    Longtail_Free(work_mem);
+    return err;
+}
+
+int Longtail_CreateMissingContent(
+    struct Longtail_HashAPI* hash_api,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* version_index,
+    uint32_t max_block_size,
+    uint32_t max_chunks_per_block,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    return Longtail_CreateMissingContentWithPacking(
+        hash_api,
+        store_index,
+        version_index,
+        max_block_size,
+        max_chunks_per_block,
+        LONGTAIL_BLOCK_PACKING_VERSION_ORDER,
+        out_store_index);
+}
+
+int Longtail_CreateMissingContentWithPacking(
     struct Longtail_HashAPI* hash_api,
     const struct Longtail_StoreIndex* store_index,
     const struct Longtail_VersionIndex* version_index,
     uint32_t max_block_size,
     uint32_t max_chunks_per_block,
+    uint32_t block_packing,
     struct Longtail_StoreIndex** out_store_index)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
@@ -6905,6 +8920,7 @@ int Longtail_CreateMissingContent(
         LONGTAIL_LOGFIELD(version_index, "%p"),
         LONGTAIL_LOGFIELD(max_block_size, "%u"),
         LONGTAIL_LOGFIELD(max_chunks_per_block, "%u"),
+        LONGTAIL_LOGFIELD(block_packing, "%u"),
         LONGTAIL_LOGFIELD(out_store_index, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
@@ -6913,22 +8929,34 @@ int Longtail_CreateMissingContent(
     LONGTAIL_VALIDATE_INPUT(ctx, version_index != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, max_block_size != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, max_chunks_per_block != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, block_packing == LONGTAIL_BLOCK_PACKING_VERSION_ORDER || block_packing == LONGTAIL_BLOCK_PACKING_LOCALITY, return EINVAL)
 
     uint32_t chunk_count = *version_index->m_ChunkCount;
     size_t added_hashes_size = sizeof(TLongtail_Hash) * chunk_count;
-    TLongtail_Hash* added_hashes = (TLongtail_Hash*)Longtail_Alloc("CreateMissingContent", added_hashes_size);
+    TLongtail_Hash* added_hashes = (TLongtail_Hash*)Longtail_Alloc("CreateMissingContent", added_hashes_size * 2);
     if (!added_hashes)
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
         return ENOMEM;
     }
 
+    // Zero chunks are never stored in a block
+    TLongtail_Hash* stored_chunk_hashes = &added_hashes[chunk_count];
+    uint32_t stored_chunk_count = 0;
+    for (uint32_t i = 0; i < chunk_count; ++i)
+    {
+        if (!Longtail_IsZeroChunk(version_index, i))
+        {
+            stored_chunk_hashes[stored_chunk_count++] = version_index->m_ChunkHashes[i];
+        }
+    }
+
     uint32_t added_hash_count = 0;
     int err = DiffHashes(
         store_index->m_ChunkHashes,
         *store_index->m_ChunkCount,
-        version_index->m_ChunkHashes,
-        chunk_count,
+        stored_chunk_hashes,
+        stored_chunk_count,
         &added_hash_count,
         added_hashes,
         0,
@@ -6980,6 +9008,26 @@ int Longtail_CreateMissingContent(
         LongtailPrivate_LookupTable_Put(chunk_index_lookup, version_index->m_ChunkHashes[i], i);
     }
 
+    if (block_packing == LONGTAIL_BLOCK_PACKING_LOCALITY)
+    {
+        err = CreateLocalityMissingContent(
+            hash_api,
+            version_index,
+            chunk_index_lookup,
+            added_hash_count,
+            added_hashes,
+            max_block_size,
+            max_chunks_per_block,
+            out_store_index);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "CreateLocalityMissingContent() failed with %d", err)
+        }
+        Longtail_Free(work_mem);
+        Longtail_Free(added_hashes);
+        return err;
+    }
+
     for (uint32_t j = 0; j < added_hash_count; ++j)
     {
         const uint32_t* chunk_index_ptr = LongtailPrivate_LookupTable_Get(chunk_index_lookup, added_hashes[j]);
@@ -7670,86 +9718,499 @@ int Longtail_CreateVersionDiff(
     {
         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Found %u added assets", target_added_count)
     }
-    if (modified_content_count > 0)
+    if (modified_content_count > 0)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching content for %u assets found", modified_content_count)
+    }
+    if (modified_permissions_count > 0)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching permission for %u assets found", modified_permissions_count)
+    }
+
+    size_t version_diff_size = GetVersionDiffSize(source_removed_count, target_added_count, modified_content_count, modified_permissions_count);
+    struct Longtail_VersionDiff* version_diff = (struct Longtail_VersionDiff*)Longtail_Alloc("CreateVersionDiff", version_diff_size);
+    if (!version_diff)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        Longtail_Free(work_mem);
+        return ENOMEM;
+    }
+    uint32_t* counts_ptr = (uint32_t*)(void*)&version_diff[1];
+    counts_ptr[0] = source_removed_count;
+    counts_ptr[1] = target_added_count;
+    counts_ptr[2] = modified_content_count;
+    counts_ptr[3] = modified_permissions_count;
+    InitVersionDiff(version_diff);
+
+    memmove(version_diff->m_SourceRemovedAssetIndexes, removed_source_asset_indexes, sizeof(uint32_t) * source_removed_count);
+    memmove(version_diff->m_TargetAddedAssetIndexes, added_target_asset_indexes, sizeof(uint32_t) * target_added_count);
+    memmove(version_diff->m_SourceContentModifiedAssetIndexes, modified_source_content_indexes, sizeof(uint32_t) * modified_content_count);
+    memmove(version_diff->m_TargetContentModifiedAssetIndexes, modified_target_content_indexes, sizeof(uint32_t) * modified_content_count);
+    memmove(version_diff->m_SourcePermissionsModifiedAssetIndexes, modified_source_permissions_indexes, sizeof(uint32_t) * modified_permissions_count);
+    memmove(version_diff->m_TargetPermissionsModifiedAssetIndexes, modified_target_permissions_indexes, sizeof(uint32_t) * modified_permissions_count);
+
+    QSORT(version_diff->m_SourceRemovedAssetIndexes, source_removed_count, sizeof(uint32_t), SortPathLongToShort, (void*)source_version);
+    QSORT(version_diff->m_TargetAddedAssetIndexes, target_added_count, sizeof(uint32_t), SortPathShortToLong, (void*)target_version);
+
+    Longtail_Free(work_mem);
+    *out_version_diff = version_diff;
+    return 0;
+}
+
+// struct Longtail_VersionDiff
+// {
+//     uint32_t* m_SourceRemovedCount;
+//     uint32_t* m_TargetAddedCount;
+//     uint32_t* m_ModifiedContentCount;
+//     uint32_t* m_ModifiedPermissionsCount;
+//     uint32_t* m_SourceRemovedAssetIndexes; // []
+//     uint32_t* m_TargetAddedAssetIndexes; // []
+//     uint32_t* m_SourceContentModifiedAssetIndexes; // []
+//     uint32_t* m_TargetContentModifiedAssetIndexes; // []
+//     uint32_t* m_SourcePermissionsModifiedAssetIndexes; // []
+//     uint32_t* m_TargetPermissionsModifiedAssetIndexes; // []
+// };
+
+// struct Longtail_VersionIndex
+// {
+//     uint32_t* m_Version;
+//     uint32_t* m_HashIdentifier;
+//     uint32_t* m_TargetChunkSize;
+//     uint32_t* m_AssetCount;
+//     uint32_t* m_ChunkCount;
+//     uint32_t* m_AssetChunkIndexCount;
+//     TLongtail_Hash* m_PathHashes;       // []
+//     TLongtail_Hash* m_ContentHashes;    // []
+//     uint64_t* m_AssetSizes;             // []
+//     uint32_t* m_AssetChunkCounts;       // []
+//     // uint64_t* m_CreationDates;       // []
+//     // uint64_t* m_ModificationDates;   // []
+//     uint32_t* m_AssetChunkIndexStarts;  // []
+//     uint32_t* m_AssetChunkIndexes;      // []
+//     TLongtail_Hash* m_ChunkHashes;      // []
+
+//     uint32_t* m_ChunkSizes;             // []
+//     uint32_t* m_ChunkTags;              // []
+
+//     uint32_t* m_NameOffsets;            // []
+//     uint32_t m_NameDataSize;
+//     uint16_t* m_Permissions;            // []
+//     char* m_NameData;
+// };
+
+// Makes room for an asset that is copied or renamed to full_asset_path rather than written
+static int PrepareAssetCopyTarget(struct Longtail_StorageAPI* version_storage_api, const char* full_asset_path)
+{
+    int err = EnsureParentPathExists(version_storage_api, full_asset_path);
+    if (err)
+    {
+        return err;
+    }
+    if (!version_storage_api->IsFile(version_storage_api, full_asset_path))
+    {
+        return 0;
+    }
+    uint16_t permissions = 0;
+    err = version_storage_api->GetPermissions(version_storage_api, full_asset_path, &permissions);
+    if (err)
+    {
+        return err;
+    }
+    if (!(permissions & Longtail_StorageAPI_UserWriteAccess))
+    {
+        err = version_storage_api->SetPermissions(version_storage_api, full_asset_path, permissions | (Longtail_StorageAPI_UserWriteAccess));
+        if (err)
+        {
+            return err;
+        }
+    }
+    return version_storage_api->RemoveFile(version_storage_api, full_asset_path);
+}
+
+// Copies, or renames if is_rename is set, source_path in version_path to the target asset
+static int CopyLocalAsset(
+    struct Longtail_StorageAPI* version_storage_api,
+    const struct Longtail_VersionIndex* target_version,
+    const char* version_path,
+    int retain_permissions,
+    const char* source_path,
+    uint32_t target_asset_index,
+    int is_rename)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(target_version, "%p"),
+        LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(retain_permissions, "%d"),
+        LONGTAIL_LOGFIELD(source_path, "%s"),
+        LONGTAIL_LOGFIELD(target_asset_index, "%u"),
+        LONGTAIL_LOGFIELD(is_rename, "%d")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    const char* target_path = &target_version->m_NameData[target_version->m_NameOffsets[target_asset_index]];
+    char* full_source_path = version_storage_api->ConcatPath(version_storage_api, version_path, source_path);
+    char* full_target_path = version_storage_api->ConcatPath(version_storage_api, version_path, target_path);
+    int err = PrepareAssetCopyTarget(version_storage_api, full_target_path);
+    if (!err)
+    {
+        err = is_rename ?
+            version_storage_api->RenameFile(version_storage_api, full_source_path, full_target_path) :
+            Longtail_Storage_CopyFile(version_storage_api, full_source_path, full_target_path);
+    }
+    if (!err && retain_permissions)
+    {
+        err = version_storage_api->SetPermissions(version_storage_api, full_target_path, (uint16_t)target_version->m_Permissions[target_asset_index]);
+    }
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "Failed to %s `%s` to `%s`, failed with %d", is_rename ? "rename" : "copy", full_source_path, full_target_path, err)
+    }
+    Longtail_Free(full_target_path);
+    Longtail_Free(full_source_path);
+    return err;
+}
+
+#define LOCAL_ASSET_WRITE_FROM_BLOCKS   0u
+#define LOCAL_ASSET_COPY                1u
+#define LOCAL_ASSET_RENAME              2u
+
+// Writes the assets in asset_indexes that have the content of a file in copy_source_version by copying that file,
+// or renaming it if version_diff removes it. Files whose path this change writes are not used. The assets that are
+// left to write from blocks, including the ones that failed to copy, are compacted to the start of asset_indexes.
+static int CopyLocalAssets(
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_VersionIndex* source_version,
+    const struct Longtail_VersionIndex* target_version,
+    const struct Longtail_VersionDiff* version_diff,
+    const struct Longtail_VersionIndex* copy_source_version,
+    const char* version_path,
+    int retain_permissions,
+    uint32_t asset_count,
+    uint32_t* asset_indexes,
+    uint32_t* out_asset_count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(source_version, "%p"),
+        LONGTAIL_LOGFIELD(target_version, "%p"),
+        LONGTAIL_LOGFIELD(version_diff, "%p"),
+        LONGTAIL_LOGFIELD(copy_source_version, "%p"),
+        LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(retain_permissions, "%d"),
+        LONGTAIL_LOGFIELD(asset_count, "%u"),
+        LONGTAIL_LOGFIELD(asset_indexes, "%p"),
+        LONGTAIL_LOGFIELD(out_asset_count, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    *out_asset_count = asset_count;
+
+    uint32_t copy_source_count = *copy_source_version->m_AssetCount;
+    if (asset_count == 0 || copy_source_count == 0 || *copy_source_version->m_HashIdentifier != *target_version->m_HashIdentifier)
+    {
+        return 0;
+    }
+
+    uint32_t remove_count = *version_diff->m_SourceRemovedCount;
+    size_t target_path_lookup_size = LongtailPrivate_LookupTable_GetSize(asset_count);
+    size_t removed_path_lookup_size = LongtailPrivate_LookupTable_GetSize(remove_count);
+    size_t content_lookup_size = LongtailPrivate_LookupTable_GetSize(copy_source_count);
+    size_t copy_sources_size = sizeof(uint32_t) * asset_count;
+    size_t modes_size = sizeof(uint8_t) * asset_count;
+    size_t renamed_size = sizeof(uint8_t) * copy_source_count;
+    size_t work_mem_size =
+        target_path_lookup_size +
+        removed_path_lookup_size +
+        content_lookup_size +
+        copy_sources_size +
+        modes_size +
+        renamed_size;
+    void* work_mem = Longtail_Alloc("CopyLocalAssets", work_mem_size);
+    if (!work_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    char* p = (char*)work_mem;
+    struct Longtail_LookupTable* target_path_lookup = LongtailPrivate_LookupTable_Create(p, asset_count, 0);
+    p += target_path_lookup_size;
+    struct Longtail_LookupTable* removed_path_lookup = LongtailPrivate_LookupTable_Create(p, remove_count, 0);
+    p += removed_path_lookup_size;
+    struct Longtail_LookupTable* content_lookup = LongtailPrivate_LookupTable_Create(p, copy_source_count, 0);
+    p += content_lookup_size;
+    uint32_t* copy_sources = (uint32_t*)p;
+    p += copy_sources_size;
+    uint8_t* modes = (uint8_t*)p;
+    p += modes_size;
+    uint8_t* renamed = (uint8_t*)p;
+
+    for (uint32_t i = 0; i < asset_count; ++i)
+    {
+        LongtailPrivate_LookupTable_PutUnique(target_path_lookup, target_version->m_PathHashes[asset_indexes[i]], i);
+    }
+    for (uint32_t r = 0; r < remove_count; ++r)
+    {
+        LongtailPrivate_LookupTable_PutUnique(removed_path_lookup, source_version->m_PathHashes[version_diff->m_SourceRemovedAssetIndexes[r]], r);
+    }
+
+    // Prefer files that are removed, they can be renamed instead of copied
+    for (uint32_t c = 0; c < copy_source_count; ++c)
+    {
+        const char* path = &copy_source_version->m_NameData[copy_source_version->m_NameOffsets[c]];
+        if (copy_source_version->m_AssetSizes[c] == 0 || IsDirPath(path))
+        {
+            continue;
+        }
+        TLongtail_Hash path_hash = copy_source_version->m_PathHashes[c];
+        if (LongtailPrivate_LookupTable_Get(target_path_lookup, path_hash))
+        {
+            // The file is overwritten by this change
+            continue;
+        }
+        uint32_t* existing = LongtailPrivate_LookupTable_PutUnique(content_lookup, copy_source_version->m_ContentHashes[c], c);
+        if (existing &&
+            LongtailPrivate_LookupTable_Get(removed_path_lookup, path_hash) &&
+            !LongtailPrivate_LookupTable_Get(removed_path_lookup, copy_source_version->m_PathHashes[*existing]))
+        {
+            *existing = c;
+        }
+    }
+
+    memset(renamed, 0, renamed_size);
+    uint32_t copy_count = 0;
+    for (uint32_t i = 0; i < asset_count; ++i)
+    {
+        uint32_t asset_index = asset_indexes[i];
+        modes[i] = LOCAL_ASSET_WRITE_FROM_BLOCKS;
+        const uint32_t* copy_source = LongtailPrivate_LookupTable_Get(content_lookup, target_version->m_ContentHashes[asset_index]);
+        if (!copy_source || copy_source_version->m_AssetSizes[*copy_source] != target_version->m_AssetSizes[asset_index])
+        {
+            continue;
+        }
+        const char* path = &target_version->m_NameData[target_version->m_NameOffsets[asset_index]];
+        if (IsDirPath(path))
+        {
+            continue;
+        }
+        copy_sources[i] = *copy_source;
+        modes[i] = LOCAL_ASSET_COPY;
+        if (!renamed[*copy_source] && LongtailPrivate_LookupTable_Get(removed_path_lookup, copy_source_version->m_PathHashes[*copy_source]))
+        {
+            renamed[*copy_source] = 1;
+            modes[i] = LOCAL_ASSET_RENAME;
+        }
+        ++copy_count;
+    }
+
+    // Copy before renaming so every copy still finds its source
+    for (uint8_t mode = LOCAL_ASSET_COPY; mode <= LOCAL_ASSET_RENAME && copy_count > 0; ++mode)
+    {
+        for (uint32_t i = 0; i < asset_count; ++i)
+        {
+            if (modes[i] != mode)
+            {
+                continue;
+            }
+            if (optional_cancel_api && optional_cancel_token && optional_cancel_api->IsCancelled(optional_cancel_api, optional_cancel_token) == ECANCELED)
+            {
+                LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Operation cancelled, failed with %d", ECANCELED)
+                Longtail_Free(work_mem);
+                return ECANCELED;
+            }
+            uint32_t copy_source = copy_sources[i];
+            const char* source_path = &copy_source_version->m_NameData[copy_source_version->m_NameOffsets[copy_source]];
+            if (CopyLocalAsset(version_storage_api, target_version, version_path, retain_permissions, source_path, asset_indexes[i], mode == LOCAL_ASSET_RENAME))
+            {
+                // Write it from blocks instead
+                modes[i] = LOCAL_ASSET_WRITE_FROM_BLOCKS;
+            }
+        }
+    }
+
+    uint32_t write_count = 0;
+    for (uint32_t i = 0; i < asset_count; ++i)
+    {
+        if (modes[i] == LOCAL_ASSET_WRITE_FROM_BLOCKS)
+        {
+            asset_indexes[write_count++] = asset_indexes[i];
+        }
+    }
+    *out_asset_count = write_count;
+    Longtail_Free(work_mem);
+    return 0;
+}
+
+// Moves the assets in asset_indexes with the same content as an earlier asset in the list to
+// out_duplicate_asset_indexes, with the asset to copy from in out_duplicate_source_asset_indexes.
+// The assets that are left to write are compacted to the start of asset_indexes.
+static int SplitDuplicateAssets(
+    const struct Longtail_VersionIndex* target_version,
+    uint32_t asset_count,
+    uint32_t* asset_indexes,
+    uint32_t* out_asset_count,
+    uint32_t* out_duplicate_asset_indexes,
+    uint32_t* out_duplicate_source_asset_indexes,
+    uint32_t* out_duplicate_count)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(target_version, "%p"),
+        LONGTAIL_LOGFIELD(asset_count, "%u"),
+        LONGTAIL_LOGFIELD(asset_indexes, "%p"),
+        LONGTAIL_LOGFIELD(out_asset_count, "%p"),
+        LONGTAIL_LOGFIELD(out_duplicate_asset_indexes, "%p"),
+        LONGTAIL_LOGFIELD(out_duplicate_source_asset_indexes, "%p"),
+        LONGTAIL_LOGFIELD(out_duplicate_count, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    *out_asset_count = asset_count;
+    *out_duplicate_count = 0;
+    if (asset_count < 2)
+    {
+        return 0;
+    }
+
+    void* content_lookup_mem = Longtail_Alloc("SplitDuplicateAssets", LongtailPrivate_LookupTable_GetSize(asset_count));
+    if (!content_lookup_mem)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
+    }
+    struct Longtail_LookupTable* content_lookup = LongtailPrivate_LookupTable_Create(content_lookup_mem, asset_count, 0);
+
+    uint32_t write_count = 0;
+    uint32_t duplicate_count = 0;
+    for (uint32_t i = 0; i < asset_count; ++i)
+    {
+        uint32_t asset_index = asset_indexes[i];
+        const char* path = &target_version->m_NameData[target_version->m_NameOffsets[asset_index]];
+        if (target_version->m_AssetSizes[asset_index] > 0 && !IsDirPath(path))
+        {
+            const uint32_t* first_asset_index = LongtailPrivate_LookupTable_PutUnique(content_lookup, target_version->m_ContentHashes[asset_index], asset_index);
+            if (first_asset_index)
+            {
+                out_duplicate_asset_indexes[duplicate_count] = asset_index;
+                out_duplicate_source_asset_indexes[duplicate_count] = *first_asset_index;
+                ++duplicate_count;
+                continue;
+            }
+        }
+        asset_indexes[write_count++] = asset_index;
+    }
+    Longtail_Free(content_lookup_mem);
+
+    *out_asset_count = write_count;
+    *out_duplicate_count = duplicate_count;
+    return 0;
+}
+
+// Writes the assets in asset_indexes from the blocks in block_store_api
+static int WriteAssetsFromBlocks(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* target_version,
+    const char* version_path,
+    int retain_permissions,
+    uint32_t asset_count,
+    const uint32_t* asset_indexes)
+{
+    MAKE_LOG_CONTEXT_FIELDS(ctx)
+        LONGTAIL_LOGFIELD(block_store_api, "%p"),
+        LONGTAIL_LOGFIELD(version_storage_api, "%p"),
+        LONGTAIL_LOGFIELD(job_api, "%p"),
+        LONGTAIL_LOGFIELD(progress_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_api, "%p"),
+        LONGTAIL_LOGFIELD(optional_cancel_token, "%p"),
+        LONGTAIL_LOGFIELD(store_index, "%p"),
+        LONGTAIL_LOGFIELD(target_version, "%p"),
+        LONGTAIL_LOGFIELD(version_path, "%s"),
+        LONGTAIL_LOGFIELD(retain_permissions, "%d"),
+        LONGTAIL_LOGFIELD(asset_count, "%u"),
+        LONGTAIL_LOGFIELD(asset_indexes, "%p")
+    MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_OFF)
+
+    uint32_t chunk_count = (uint32_t)*store_index->m_ChunkCount;
+    size_t chunk_hash_to_block_index_size = LongtailPrivate_LookupTable_GetSize(chunk_count);
+
+    void* work_mem = Longtail_Alloc("WriteAssetsFromBlocks", chunk_hash_to_block_index_size);
+    if (!work_mem)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching content for %u assets found", modified_content_count)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        return ENOMEM;
     }
-    if (modified_permissions_count > 0)
+
+    struct Longtail_LookupTable* chunk_hash_to_block_index = LongtailPrivate_LookupTable_Create(work_mem, chunk_count, 0);
+
+    uint32_t block_count = *store_index->m_BlockCount;
+    for (uint32_t b = 0; b < block_count; ++b)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_CreateVersionDiff: Mismatching permission for %u assets found", modified_permissions_count)
+        uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
+        uint32_t chunk_index_offset = store_index->m_BlockChunksOffsets[b];
+        for (uint32_t c = 0; c < block_chunk_count; ++c)
+        {
+            uint32_t chunk_index = chunk_index_offset + c;
+            TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[chunk_index];
+            LongtailPrivate_LookupTable_PutUnique(chunk_hash_to_block_index, chunk_hash, b);
+        }
     }
 
-    size_t version_diff_size = GetVersionDiffSize(source_removed_count, target_added_count, modified_content_count, modified_permissions_count);
-    struct Longtail_VersionDiff* version_diff = (struct Longtail_VersionDiff*)Longtail_Alloc("CreateVersionDiff", version_diff_size);
-    if (!version_diff)
+    struct AssetWriteList* awl;
+    int err = BuildAssetWriteList(
+        asset_count,
+        asset_indexes,
+        target_version->m_NameOffsets,
+        target_version->m_NameData,
+        target_version->m_ChunkHashes,
+        target_version->m_AssetChunkCounts,
+        target_version->m_AssetChunkIndexStarts,
+        target_version->m_AssetChunkIndexes,
+        target_version,
+        chunk_hash_to_block_index,
+        &awl);
+
+    if (err)
     {
-        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "BuildAssetWriteList() failed with %d", err)
         Longtail_Free(work_mem);
-        return ENOMEM;
+        return err;
     }
-    uint32_t* counts_ptr = (uint32_t*)(void*)&version_diff[1];
-    counts_ptr[0] = source_removed_count;
-    counts_ptr[1] = target_added_count;
-    counts_ptr[2] = modified_content_count;
-    counts_ptr[3] = modified_permissions_count;
-    InitVersionDiff(version_diff);
 
-    memmove(version_diff->m_SourceRemovedAssetIndexes, removed_source_asset_indexes, sizeof(uint32_t) * source_removed_count);
-    memmove(version_diff->m_TargetAddedAssetIndexes, added_target_asset_indexes, sizeof(uint32_t) * target_added_count);
-    memmove(version_diff->m_SourceContentModifiedAssetIndexes, modified_source_content_indexes, sizeof(uint32_t) * modified_content_count);
-    memmove(version_diff->m_TargetContentModifiedAssetIndexes, modified_target_content_indexes, sizeof(uint32_t) * modified_content_count);
-    memmove(version_diff->m_SourcePermissionsModifiedAssetIndexes, modified_source_permissions_indexes, sizeof(uint32_t) * modified_permissions_count);
-    memmove(version_diff->m_TargetPermissionsModifiedAssetIndexes, modified_target_permissions_indexes, sizeof(uint32_t) * modified_permissions_count);
+    err = WriteAssets(
+        block_store_api,
+        version_storage_api,
+        job_api,
+        progress_api,
+        optional_cancel_api,
+        optional_cancel_token,
+        store_index,
+        target_version,
+        version_path,
+        chunk_hash_to_block_index,
+        awl,
+        retain_permissions,
+        1);
 
-    QSORT(version_diff->m_SourceRemovedAssetIndexes, source_removed_count, sizeof(uint32_t), SortPathLongToShort, (void*)source_version);
-    QSORT(version_diff->m_TargetAddedAssetIndexes, target_added_count, sizeof(uint32_t), SortPathShortToLong, (void*)target_version);
+    Longtail_Free(awl);
+    awl = 0;
+
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, err == ECANCELED ?  LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WriteAssets() failed with %d", err)
+        Longtail_Free(work_mem);
+        return err;
+    }
 
     Longtail_Free(work_mem);
-    *out_version_diff = version_diff;
     return 0;
 }
 
-// struct Longtail_VersionDiff
-// {
-//     uint32_t* m_SourceRemovedCount;
-//     uint32_t* m_TargetAddedCount;
-//     uint32_t* m_ModifiedContentCount;
-//     uint32_t* m_ModifiedPermissionsCount;
-//     uint32_t* m_SourceRemovedAssetIndexes; // []
-//     uint32_t* m_TargetAddedAssetIndexes; // []
-//     uint32_t* m_SourceContentModifiedAssetIndexes; // []
-//     uint32_t* m_TargetContentModifiedAssetIndexes; // []
-//     uint32_t* m_SourcePermissionsModifiedAssetIndexes; // []
-//     uint32_t* m_TargetPermissionsModifiedAssetIndexes; // []
-// };
-
-// struct Longtail_VersionIndex
-// {
-//     uint32_t* m_Version;
-//     uint32_t* m_HashIdentifier;
-//     uint32_t* m_TargetChunkSize;
-//     uint32_t* m_AssetCount;
-//     uint32_t* m_ChunkCount;
-//     uint32_t* m_AssetChunkIndexCount;
-//     TLongtail_Hash* m_PathHashes;       // []
-//     TLongtail_Hash* m_ContentHashes;    // []
-//     uint64_t* m_AssetSizes;             // []
-//     uint32_t* m_AssetChunkCounts;       // []
-//     // uint64_t* m_CreationDates;       // []
-//     // uint64_t* m_ModificationDates;   // []
-//     uint32_t* m_AssetChunkIndexStarts;  // []
-//     uint32_t* m_AssetChunkIndexes;      // []
-//     TLongtail_Hash* m_ChunkHashes;      // []
-
-//     uint32_t* m_ChunkSizes;             // []
-//     uint32_t* m_ChunkTags;              // []
-
-//     uint32_t* m_NameOffsets;            // []
-//     uint32_t m_NameDataSize;
-//     uint16_t* m_Permissions;            // []
-//     char* m_NameData;
-// };
-
 int Longtail_ChangeVersion(
     struct Longtail_BlockStoreAPI* block_store_api,
     struct Longtail_StorageAPI* version_storage_api,
@@ -7764,6 +10225,39 @@ int Longtail_ChangeVersion(
     const struct Longtail_VersionDiff* version_diff,
     const char* version_path,
     int retain_permissions)
+{
+    return Longtail_ChangeVersionWithLocalCopy(
+        block_store_api,
+        version_storage_api,
+        hash_api,
+        job_api,
+        progress_api,
+        optional_cancel_api,
+        optional_cancel_token,
+        store_index,
+        source_version,
+        target_version,
+        version_diff,
+        version_path,
+        retain_permissions,
+        source_version);
+}
+
+int Longtail_ChangeVersionWithLocalCopy(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* source_version,
+    const struct Longtail_VersionIndex* target_version,
+    const struct Longtail_VersionDiff* version_diff,
+    const char* version_path,
+    int retain_permissions,
+    const struct Longtail_VersionIndex* copy_source_version)
 {
     MAKE_LOG_CONTEXT_FIELDS(ctx)
         LONGTAIL_LOGFIELD(block_store_api, "%p"),
@@ -7778,7 +10272,8 @@ int Longtail_ChangeVersion(
         LONGTAIL_LOGFIELD(target_version, "%p"),
         LONGTAIL_LOGFIELD(version_diff, "%p"),
         LONGTAIL_LOGFIELD(version_path, "%s"),
-        LONGTAIL_LOGFIELD(retain_permissions, "%d")
+        LONGTAIL_LOGFIELD(retain_permissions, "%d"),
+        LONGTAIL_LOGFIELD(copy_source_version, "%p")
     MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
 
     LONGTAIL_VALIDATE_INPUT(ctx, block_store_api != 0, return EINVAL)
@@ -7789,6 +10284,7 @@ int Longtail_ChangeVersion(
     LONGTAIL_VALIDATE_INPUT(ctx, source_version != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, target_version != 0, return EINVAL)
     LONGTAIL_VALIDATE_INPUT(ctx, version_diff != 0, return EINVAL)
+    LONGTAIL_VALIDATE_INPUT(ctx, copy_source_version != 0, return EINVAL)
 
     int err = EnsureParentPathExists(version_storage_api, version_path);
     if (err)
@@ -7807,14 +10303,67 @@ int Longtail_ChangeVersion(
         return err;
     }
 
+    uint32_t added_count = *version_diff->m_TargetAddedCount;
+    uint32_t modified_content_count = *version_diff->m_ModifiedContentCount;
+    uint32_t write_asset_count = added_count + modified_content_count;
+
+    LONGTAIL_FATAL_ASSERT(ctx, write_asset_count <= *target_version->m_AssetCount, return EINVAL);
+
+    // Assets that are written, followed by space for the assets that are copied from another written
+    // asset with the same content and the assets they are copied from
+    uint32_t* write_asset_indexes = 0;
+    uint32_t* duplicate_asset_indexes = 0;
+    uint32_t* duplicate_source_asset_indexes = 0;
+    if (write_asset_count > 0)
+    {
+        write_asset_indexes = (uint32_t*)Longtail_Alloc("ChangeVersion", sizeof(uint32_t) * write_asset_count * 3);
+        if (!write_asset_indexes)
+        {
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            return ENOMEM;
+        }
+        duplicate_asset_indexes = &write_asset_indexes[write_asset_count];
+        duplicate_source_asset_indexes = &duplicate_asset_indexes[write_asset_count];
+        for (uint32_t i = 0; i < added_count; ++i)
+        {
+            write_asset_indexes[i] = version_diff->m_TargetAddedAssetIndexes[i];
+        }
+        for (uint32_t i = 0; i < modified_content_count; ++i)
+        {
+            write_asset_indexes[added_count + i] = version_diff->m_TargetContentModifiedAssetIndexes[i];
+        }
+
+        // Local copies and renames go first, the files they copy from may be removed below
+        err = CopyLocalAssets(
+            version_storage_api,
+            optional_cancel_api,
+            optional_cancel_token,
+            source_version,
+            target_version,
+            version_diff,
+            copy_source_version,
+            version_path,
+            retain_permissions,
+            write_asset_count,
+            write_asset_indexes,
+            &write_asset_count);
+        if (err)
+        {
+            LONGTAIL_LOG(ctx, err == ECANCELED ? LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "CopyLocalAssets() failed with %d", err)
+            Longtail_Free(write_asset_indexes);
+            return err;
+        }
+    }
+
     uint32_t remove_count = *version_diff->m_SourceRemovedCount;
-    LONGTAIL_FATAL_ASSERT(ctx, remove_count <= *source_version->m_AssetCount, return EINVAL);
+    LONGTAIL_FATAL_ASSERT(ctx, remove_count <= *source_version->m_AssetCount, Longtail_Free(write_asset_indexes); return EINVAL);
     if (remove_count > 0)
     {
         uint32_t* remove_indexes = (uint32_t*)Longtail_Alloc("ChangeVersion", sizeof(uint32_t) * remove_count);
         if (!remove_indexes)
         {
             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+            Longtail_Free(write_asset_indexes);
             return ENOMEM;
         }
         memcpy(remove_indexes, version_diff->m_SourceRemovedAssetIndexes, sizeof(uint32_t) * remove_count);
@@ -7832,6 +10381,8 @@ int Longtail_ChangeVersion(
                 if (optional_cancel_api && optional_cancel_token && optional_cancel_api->IsCancelled(optional_cancel_api, optional_cancel_token) == ECANCELED)
                 {
                     LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Opeation cancelled, failed with %d", ECANCELED)
+                    Longtail_Free(remove_indexes);
+                    Longtail_Free(write_asset_indexes);
                     return ECANCELED;
                 }
             }
@@ -7850,6 +10401,7 @@ int Longtail_ChangeVersion(
                     if (!version_storage_api->IsDir(version_storage_api, full_asset_path))
                     {
                         remove_indexes[r] = 0xffffffff;
+                        ++successful_remove_count;
                         Longtail_Free(full_asset_path);
                         continue;
                     }
@@ -7860,6 +10412,7 @@ int Longtail_ChangeVersion(
                         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->GetPermissions() failed with %d", err)
                         Longtail_Free(full_asset_path);
                         Longtail_Free(remove_indexes);
+                        Longtail_Free(write_asset_indexes);
                         return err;
                     }
                     if (!(permissions & Longtail_StorageAPI_UserWriteAccess))
@@ -7870,6 +10423,7 @@ int Longtail_ChangeVersion(
                             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
                             Longtail_Free(full_asset_path);
                             Longtail_Free(remove_indexes);
+                            Longtail_Free(write_asset_indexes);
                             return err;
                         }
                     }
@@ -7881,6 +10435,7 @@ int Longtail_ChangeVersion(
                             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Can't to remove dir `%s`, failed with %d", full_asset_path, err)
                             Longtail_Free(full_asset_path);
                             Longtail_Free(remove_indexes);
+                            Longtail_Free(write_asset_indexes);
                             return err;
                         }
                         Longtail_Free(full_asset_path);
@@ -7892,7 +10447,9 @@ int Longtail_ChangeVersion(
                 {
                     if (!version_storage_api->IsFile(version_storage_api, full_asset_path))
                     {
+                        // Already gone, a local copy may have renamed it
                         remove_indexes[r] = 0xffffffff;
+                        ++successful_remove_count;
                         Longtail_Free(full_asset_path);
                         continue;
                     }
@@ -7903,6 +10460,7 @@ int Longtail_ChangeVersion(
                         LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->GetPermissions() failed with %d", err)
                         Longtail_Free(full_asset_path);
                         Longtail_Free(remove_indexes);
+                        Longtail_Free(write_asset_indexes);
                         return err;
                     }
                     if (!(permissions & Longtail_StorageAPI_UserWriteAccess))
@@ -7913,6 +10471,7 @@ int Longtail_ChangeVersion(
                             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "version_storage_api->SetPermissions() failed with %d", err)
                             Longtail_Free(full_asset_path);
                             Longtail_Free(remove_indexes);
+                            Longtail_Free(write_asset_indexes);
                             return err;
                         }
                     }
@@ -7924,6 +10483,7 @@ int Longtail_ChangeVersion(
                             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Can't to file dir `%s`, failed with %d", full_asset_path, err)
                             Longtail_Free(full_asset_path);
                             Longtail_Free(remove_indexes);
+                            Longtail_Free(write_asset_indexes);
                             return err;
                         }
                         Longtail_Free(full_asset_path);
@@ -7940,73 +10500,66 @@ int Longtail_ChangeVersion(
         Longtail_Free(remove_indexes);
     }
 
-    uint32_t added_count = *version_diff->m_TargetAddedCount;
-    uint32_t modified_content_count = *version_diff->m_ModifiedContentCount;
-    uint32_t write_asset_count = added_count + modified_content_count;
+    // Assets with the same content are written from blocks once
+    uint32_t duplicate_count = 0;
+    err = SplitDuplicateAssets(
+        target_version,
+        write_asset_count,
+        write_asset_indexes,
+        &write_asset_count,
+        duplicate_asset_indexes,
+        duplicate_source_asset_indexes,
+        &duplicate_count);
+    if (err)
+    {
+        LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "SplitDuplicateAssets() failed with %d", err)
+        Longtail_Free(write_asset_indexes);
+        return err;
+    }
 
-    LONGTAIL_FATAL_ASSERT(ctx, write_asset_count <= *target_version->m_AssetCount, return EINVAL);
     if (write_asset_count > 0)
     {
-        uint32_t chunk_count = (uint32_t)*store_index->m_ChunkCount;
-        size_t chunk_hash_to_block_index_size = LongtailPrivate_LookupTable_GetSize(chunk_count);
-        size_t asset_indexes_size = sizeof(uint32_t) * write_asset_count;
-        size_t work_mem_size = chunk_hash_to_block_index_size + asset_indexes_size;
-
-        void* work_mem = Longtail_Alloc("ChangeVersion", work_mem_size);
-        if (!work_mem)
-        {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
-            return ENOMEM;
-        }
-
-        char* p = (char*)work_mem;
-        struct Longtail_LookupTable* chunk_hash_to_block_index = LongtailPrivate_LookupTable_Create(p, chunk_count, 0);
-        p += chunk_hash_to_block_index_size;
-        uint32_t* asset_indexes = (uint32_t*)p;
-
-        uint32_t block_count = *store_index->m_BlockCount;
-        for (uint32_t b = 0; b < block_count; ++b)
-        {
-            uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
-            uint32_t chunk_index_offset = store_index->m_BlockChunksOffsets[b];
-            for (uint32_t c = 0; c < block_chunk_count; ++c)
+        err = WriteAssetsFromBlocks(
+            block_store_api,
+            version_storage_api,
+            job_api,
+            progress_api,
+            optional_cancel_api,
+            optional_cancel_token,
+            store_index,
+            target_version,
+            version_path,
+            retain_permissions,
+            write_asset_count,
+            write_asset_indexes);
+        if (err)
         {
-                uint32_t chunk_index = chunk_index_offset + c;
-                TLongtail_Hash chunk_hash = store_index->m_ChunkHashes[chunk_index];
-                LongtailPrivate_LookupTable_PutUnique(chunk_hash_to_block_index, chunk_hash, b);
-            }
+            LONGTAIL_LOG(ctx, err == ECANCELED ?  LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WriteAssetsFromBlocks() failed with %d", err)
+            Longtail_Free(write_asset_indexes);
+            return err;
         }
+    }
 
-        for (uint32_t i = 0; i < added_count; ++i)
-        {
-            asset_indexes[i] = version_diff->m_TargetAddedAssetIndexes[i];
-        }
-        for (uint32_t i = 0; i < modified_content_count; ++i)
+    uint32_t failed_duplicate_count = 0;
+    for (uint32_t d = 0; d < duplicate_count; ++d)
+    {
+        if (optional_cancel_api && optional_cancel_token && optional_cancel_api->IsCancelled(optional_cancel_api, optional_cancel_token) == ECANCELED)
         {
-            asset_indexes[added_count + i] = version_diff->m_TargetContentModifiedAssetIndexes[i];
+            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Operation cancelled, failed with %d", ECANCELED)
+            Longtail_Free(write_asset_indexes);
+            return ECANCELED;
         }
-
-        struct AssetWriteList* awl;
-        err = BuildAssetWriteList(
-            write_asset_count,
-            asset_indexes,
-            target_version->m_NameOffsets,
-            target_version->m_NameData,
-            target_version->m_ChunkHashes,
-            target_version->m_AssetChunkCounts,
-            target_version->m_AssetChunkIndexStarts,
-            target_version->m_AssetChunkIndexes,
-            chunk_hash_to_block_index,
-            &awl);
-
-        if (err)
+        uint32_t source_asset_index = duplicate_source_asset_indexes[d];
+        const char* source_path = &target_version->m_NameData[target_version->m_NameOffsets[source_asset_index]];
+        if (CopyLocalAsset(version_storage_api, target_version, version_path, retain_permissions, source_path, duplicate_asset_indexes[d], 0))
         {
-            LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "BuildAssetWriteList() failed with %d", err)
-            Longtail_Free(work_mem);
-            return err;
+            duplicate_asset_indexes[failed_duplicate_count++] = duplicate_asset_indexes[d];
         }
-
-        err = WriteAssets(
+    }
+    if (failed_duplicate_count > 0)
+    {
+        // The copies that failed are written from blocks like any other asset
+        err = WriteAssetsFromBlocks(
             block_store_api,
             version_storage_api,
             job_api,
@@ -8016,23 +10569,18 @@ int Longtail_ChangeVersion(
             store_index,
             target_version,
             version_path,
-            chunk_hash_to_block_index,
-            awl,
-            retain_permissions);
-
-        Longtail_Free(awl);
-        awl = 0;
-
+            retain_permissions,
+            failed_duplicate_count,
+            duplicate_asset_indexes);
         if (err)
         {
-            LONGTAIL_LOG(ctx, err == ECANCELED ?  LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WriteAssets() failed with %d", err)
-            Longtail_Free(work_mem);
+            LONGTAIL_LOG(ctx, err == ECANCELED ?  LONGTAIL_LOG_LEVEL_DEBUG : LONGTAIL_LOG_LEVEL_ERROR, "WriteAssetsFromBlocks() failed with %d", err)
+            Longtail_Free(write_asset_indexes);
             return err;
         }
-
-        Longtail_Free(work_mem);
-        work_mem = 0;
     }
+    Longtail_Free(write_asset_indexes);
+    write_asset_indexes = 0;
 
     if (retain_permissions)
     {
@@ -8606,6 +11154,10 @@ LONGTAIL_EXPORT int Longtail_ValidateStore(
     for (uint32_t chunk_index = 0; chunk_index < version_index_chunk_count; ++chunk_index)
     {
         TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[chunk_index];
+        if (Longtail_IsZeroChunk(version_index, chunk_index))
+        {
+            continue;
+        }
         if (LongtailPrivate_LookupTable_Get(content_chunk_lookup, chunk_hash) == 0)
         {
             LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_DEBUG, "Longtail_ValidateStore() content index does not contain chunk 0x%" PRIx64 "",
@@ -9088,7 +11640,7 @@ LONGTAIL_EXPORT int Longtail_CreateArchiveIndex(
     LONGTAIL_VALIDATE_INPUT(ctx, out_archive_index != 0, return EINVAL)
 
     size_t store_index_data_size = Longtail_GetStoreIndexDataSize(*store_index->m_BlockCount, *store_index->m_ChunkCount);
-    size_t version_index_data_size = Longtail_GetVersionIndexDataSize(*version_index->m_AssetCount, *version_index->m_ChunkCount, *version_index->m_AssetChunkIndexCount, version_index->m_NameDataSize);
+    size_t version_index_data_size = Longtail_GetVersionIndexDataSize(*version_index->m_Version, Longtail_VersionIndex_GetFlags(version_index), *version_index->m_AssetCount, *version_index->m_ChunkCount, *version_index->m_AssetChunkIndexCount, version_index->m_NameDataSize);
     size_t archive_data_index_size =
         sizeof(uint32_t) +
         sizeof(uint32_t) +
@@ -9268,11 +11820,14 @@ const uint16_t* Longtail_FileInfos_GetPermissions(const struct Longtail_FileInfo
 
 uint32_t Longtail_VersionIndex_GetVersion(const struct Longtail_VersionIndex* version_index) { return *version_index->m_Version; }
 uint32_t Longtail_VersionIndex_GetHashAPI(const struct Longtail_VersionIndex* version_index) { return *version_index->m_HashIdentifier; }
+uint32_t Longtail_VersionIndex_GetChunkerIdentifier(const struct Longtail_VersionIndex* version_index) { return version_index->m_ChunkerIdentifier ? *version_index->m_ChunkerIdentifier : 0u; }
+uint32_t Longtail_VersionIndex_GetFlags(const struct Longtail_VersionIndex* version_index) { return version_index->m_Flags ? *version_index->m_Flags : 0u; }
 uint32_t Longtail_VersionIndex_GetAssetCount(const struct Longtail_VersionIndex* version_index) { return *version_index->m_AssetCount; }
 uint32_t Longtail_VersionIndex_GetChunkCount(const struct Longtail_VersionIndex* version_index) { return *version_index->m_ChunkCount; }
 const TLongtail_Hash* Longtail_VersionIndex_GetChunkHashes(const struct Longtail_VersionIndex* version_index) { return version_index->m_ChunkHashes;}
 const uint32_t* Longtail_VersionIndex_GetChunkSizes(const struct Longtail_VersionIndex* version_index) { return version_index->m_ChunkSizes;}
 const uint32_t* Longtail_VersionIndex_GetChunkTags(const struct Longtail_VersionIndex* version_index) { return version_index->m_ChunkTags;}
+const uint32_t* Longtail_VersionIndex_GetAssetTargetChunkSizes(const struct Longtail_VersionIndex* version_index) { return version_index->m_AssetTargetChunkSizes; }
 
 uint32_t Longtail_StoreIndex_GetVersion(const struct Longtail_StoreIndex* store_index) { return *store_index->m_Version;}
 uint32_t Longtail_StoreIndex_GetHashIdentifier(const struct Longtail_StoreIndex* store_index) { return *store_index->m_HashIdentifier;}
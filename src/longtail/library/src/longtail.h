@@ -205,6 +205,7 @@ typedef int (*Longtail_Hash_BeginContextFunc)(struct Longtail_HashAPI* hash_api,
 typedef void (*Longtail_Hash_HashFunc)(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context, uint32_t length, const void* data);
 typedef uint64_t (*Longtail_Hash_EndContextFunc)(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context);
 typedef int (*Longtail_Hash_HashBufferFunc)(struct Longtail_HashAPI* hash_api, uint32_t length, const void* data, uint64_t* out_hash);
+typedef int (*Longtail_Hash_HashBuffersFunc)(struct Longtail_HashAPI* hash_api, uint32_t count, const uint32_t* lengths, const void* const* datas, uint64_t* out_hashes);
 
 struct Longtail_HashAPI {
   struct Longtail_API m_API;
@@ -213,6 +214,7 @@ struct Longtail_HashAPI {
   Longtail_Hash_HashFunc Hash;
   Longtail_Hash_EndContextFunc EndContext;
   Longtail_Hash_HashBufferFunc HashBuffer;
+  Longtail_Hash_HashBuffersFunc HashBuffers;  // Optional, hashes many buffers at once
 };
 
 LONGTAIL_EXPORT uint64_t Longtail_GetHashAPISize();
@@ -224,13 +226,16 @@ LONGTAIL_EXPORT struct Longtail_HashAPI* Longtail_MakeHashAPI(
     Longtail_Hash_BeginContextFunc begin_context_func,
     Longtail_Hash_HashFunc hash_func,
     Longtail_Hash_EndContextFunc end_context_func,
-    Longtail_Hash_HashBufferFunc hash_buffer_func);
+    Longtail_Hash_HashBufferFunc hash_buffer_func,
+    Longtail_Hash_HashBuffersFunc hash_buffers_func);
 
 LONGTAIL_EXPORT uint32_t Longtail_Hash_GetIdentifier(struct Longtail_HashAPI* hash_api);
 LONGTAIL_EXPORT int Longtail_Hash_BeginContext(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext* out_context);
 LONGTAIL_EXPORT void Longtail_Hash_Hash(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context, uint32_t length, const void* data);
 LONGTAIL_EXPORT uint64_t Longtail_Hash_EndContext(struct Longtail_HashAPI* hash_api, Longtail_HashAPI_HContext context);
 LONGTAIL_EXPORT int Longtail_Hash_HashBuffer(struct Longtail_HashAPI* hash_api, uint32_t length, const void* data, uint64_t* out_hash);
+// Same result as calling Longtail_Hash_HashBuffer for each buffer, uses HashBuffers if the hash api has it
+LONGTAIL_EXPORT int Longtail_Hash_HashBuffers(struct Longtail_HashAPI* hash_api, uint32_t count, const uint32_t* lengths, const void* const* datas, uint64_t* out_hashes);
 
 ////////////// Longtail_HashRegistryAPI
 
@@ -259,12 +264,14 @@ struct Longtail_CompressionAPI;
 typedef size_t (*Longtail_CompressionAPI_GetMaxCompressedSizeFunc)(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, size_t size);
 typedef int (*Longtail_CompressionAPI_CompressFunc)(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, const char* uncompressed, char* compressed, size_t uncompressed_size, size_t max_compressed_size, size_t* out_compressed_size);
 typedef int (*Longtail_CompressionAPI_DecompressFunc)(struct Longtail_CompressionAPI* compression_api, const char* compressed, char* uncompressed, size_t compressed_size, size_t max_uncompressed_size, size_t* out_uncompressed_size);
+typedef int (*Longtail_CompressionAPI_CompressWithWorkersFunc)(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, uint32_t extra_worker_count, const char* uncompressed, char* compressed, size_t uncompressed_size, size_t max_compressed_size, size_t* out_compressed_size);
 
 struct Longtail_CompressionAPI {
   struct Longtail_API m_API;
   Longtail_CompressionAPI_GetMaxCompressedSizeFunc GetMaxCompressedSize;
   Longtail_CompressionAPI_CompressFunc Compress;
   Longtail_CompressionAPI_DecompressFunc Decompress;
+  Longtail_CompressionAPI_CompressWithWorkersFunc CompressWithWorkers;  // Optional, may use extra_worker_count threads besides the calling thread
 };
 
 LONGTAIL_EXPORT uint64_t Longtail_GetCompressionAPISize();
@@ -276,6 +283,20 @@ LONGTAIL_EXPORT struct Longtail_CompressionAPI* Longtail_MakeCompressionAPI(
     Longtail_CompressionAPI_CompressFunc compress_func,
     Longtail_CompressionAPI_DecompressFunc decompress_func);
 
+// As Longtail_MakeCompressionAPI for compression APIs that can split a compression across
+// additional threads the caller lends them, compress_with_workers_func may be 0
+LONGTAIL_EXPORT struct Longtail_CompressionAPI* Longtail_MakeCompressionAPIWithWorkers(
+    void* mem,
+    Longtail_DisposeFunc dispose_func,
+    Longtail_CompressionAPI_GetMaxCompressedSizeFunc get_max_compressed_size_func,
+    Longtail_CompressionAPI_CompressFunc compress_func,
+    Longtail_CompressionAPI_DecompressFunc decompress_func,
+    Longtail_CompressionAPI_CompressWithWorkersFunc compress_with_workers_func);
+
+// Same result as Compress, compression APIs with CompressWithWorkers may use up to extra_worker_count
+// threads besides the calling thread, the caller keeps that many threads idle until it returns
+LONGTAIL_EXPORT int Longtail_CompressionAPI_CompressWithWorkers(struct Longtail_CompressionAPI* compression_api, uint32_t settings_id, uint32_t extra_worker_count, const char* uncompressed, char* compressed, size_t uncompressed_size, size_t max_compressed_size, size_t* out_compressed_size);
+
 ////////////// Longtail_CompressionRegistryAPI
 
 struct Longtail_CompressionRegistryAPI;
@@ -351,6 +372,8 @@ typedef int (*Longtail_Storage_UnlockFileFunc)(struct Longtail_StorageAPI* stora
 typedef char* (*Longtail_Storage_GetParentPathFunc)(struct Longtail_StorageAPI* storage_api, const char* path);
 typedef int (*Longtail_Storage_MapFileFunc)(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t offset, uint64_t length, Longtail_StorageAPI_HFileMap* out_file_map, const void** out_data_ptr);
 typedef void (*Longtail_Storage_UnmapFileFunc)(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HFileMap m);
+typedef int (*Longtail_Storage_CloneFileFunc)(struct Longtail_StorageAPI* storage_api, const char* source_path, const char* target_path);
+typedef int (*Longtail_Storage_StreamWrittenFunc)(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t offset, uint64_t length);
 
 struct Longtail_StorageAPI {
   struct Longtail_API m_API;
@@ -383,6 +406,16 @@ struct Longtail_StorageAPI {
   // Flags describing storage API capabilities. Set after creation.
   // Default: 0 (local filesystem semantics)
   uint32_t m_StorageFlags;
+
+  // Optional copy of a whole file that replaces target_path, set after creation by storage
+  // APIs that can copy without reading the file through the API, such as by cloning it.
+  // Default: 0, Longtail_Storage_CopyFile() copies with Read and Write
+  Longtail_Storage_CloneFileFunc CloneFile;
+
+  // Optional hint that a range was just written by a large sequential write and will not be read
+  // back soon, set after creation by storage APIs that can move it to disk and out of the cache.
+  // Default: 0, Longtail_Storage_StreamWritten() does nothing
+  Longtail_Storage_StreamWrittenFunc StreamWritten;
 };
 
 // Storage API flags (set via m_StorageFlags after creation)
@@ -447,6 +480,8 @@ LONGTAIL_EXPORT int Longtail_Storage_UnlockFile(struct Longtail_StorageAPI* stor
 LONGTAIL_EXPORT char* Longtail_Storage_GetParentPath(struct Longtail_StorageAPI* storage_api, const char* path);
 LONGTAIL_EXPORT int Longtail_Storage_MapFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t offset, uint64_t length, Longtail_StorageAPI_HFileMap* out_file_map, const void** out_data_ptr);
 LONGTAIL_EXPORT void Longtail_Storage_UnmapFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HFileMap m);
+LONGTAIL_EXPORT int Longtail_Storage_CopyFile(struct Longtail_StorageAPI* storage_api, const char* source_path, const char* target_path);
+LONGTAIL_EXPORT int Longtail_Storage_StreamWritten(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f, uint64_t offset, uint64_t length);
 
 ////////////// Longtail_ProgressAPI
 
@@ -538,6 +573,7 @@ typedef int (*Longtail_Chunker_CreateChunkerFunc)(struct Longtail_ChunkerAPI* ch
 typedef int (*Longtail_Chunker_NextChunkFunc)(struct Longtail_ChunkerAPI* chunker_api, Longtail_ChunkerAPI_HChunker chunker, Longtail_Chunker_Feeder feeder, void* feeder_context, struct Longtail_Chunker_ChunkRange* out_chunk_range);
 typedef int (*Longtail_Chunker_DisposeChunkerFunc)(struct Longtail_ChunkerAPI* chunker_api, Longtail_ChunkerAPI_HChunker chunker);
 typedef int (*Longtail_Chunker_NextChunkFromBufferFunc)(struct Longtail_ChunkerAPI* chunker_api, Longtail_ChunkerAPI_HChunker chunker, const void* buffer, uint64_t buffer_size, const void** out_next_chunk_start);
+typedef uint32_t (*Longtail_Chunker_GetIdentifierFunc)(struct Longtail_ChunkerAPI* chunker_api);
 
 struct Longtail_ChunkerAPI {
   struct Longtail_API m_API;
@@ -546,6 +582,7 @@ struct Longtail_ChunkerAPI {
   Longtail_Chunker_NextChunkFunc NextChunk;
   Longtail_Chunker_DisposeChunkerFunc DisposeChunker;
   Longtail_Chunker_NextChunkFromBufferFunc NextChunkFromBuffer;
+  Longtail_Chunker_GetIdentifierFunc GetIdentifier; // Optional, 0 for HPCDC
 };
 
 LONGTAIL_EXPORT uint64_t Longtail_GetChunkerAPISize();
@@ -559,11 +596,22 @@ LONGTAIL_EXPORT struct Longtail_ChunkerAPI* Longtail_MakeChunkerAPI(
     Longtail_Chunker_DisposeChunkerFunc dispose_chunker_func,
     Longtail_Chunker_NextChunkFromBufferFunc next_chunk_from_buffer);
 
+LONGTAIL_EXPORT struct Longtail_ChunkerAPI* Longtail_MakeChunkerAPIWithIdentifier(
+    void* mem,
+    Longtail_DisposeFunc dispose_func,
+    Longtail_Chunker_GetMinChunkSizeFunc get_min_chunk_size_func,
+    Longtail_Chunker_CreateChunkerFunc create_chunker_func,
+    Longtail_Chunker_NextChunkFunc next_chunk_func,
+    Longtail_Chunker_DisposeChunkerFunc dispose_chunker_func,
+    Longtail_Chunker_NextChunkFromBufferFunc next_chunk_from_buffer,
+    Longtail_Chunker_GetIdentifierFunc get_identifier_func);
+
 LONGTAIL_EXPORT int Longtail_Chunker_GetMinChunkSize(struct Longtail_ChunkerAPI* chunker_api, uint32_t* out_min_chunk_size);
 LONGTAIL_EXPORT int Longtail_Chunker_CreateChunker(struct Longtail_ChunkerAPI* chunker_api, uint32_t min_chunk_size, uint32_t avg_chunk_size, uint32_t max_chunk_size, Longtail_ChunkerAPI_HChunker* out_chunker);
 LONGTAIL_EXPORT int Longtail_Chunker_NextChunk(struct Longtail_ChunkerAPI* chunker_api, Longtail_ChunkerAPI_HChunker chunker, Longtail_Chunker_Feeder feeder, void* feeder_context, struct Longtail_Chunker_ChunkRange* out_chunk_range);
 LONGTAIL_EXPORT int Longtail_Chunker_DisposeChunker(struct Longtail_ChunkerAPI* chunker_api, Longtail_ChunkerAPI_HChunker chunker);
 LONGTAIL_EXPORT int Longtail_Chunker_NextChunkFromBuffer(struct Longtail_ChunkerAPI* chunker_api, Longtail_ChunkerAPI_HChunker chunker, const void* buffer, uint64_t buffer_size, const void** out_next_chunk_start);
+LONGTAIL_EXPORT uint32_t Longtail_Chunker_GetIdentifier(struct Longtail_ChunkerAPI* chunker_api);
 
 ////////////// Longtail_AsyncPutStoredBlockAPI
 
@@ -913,15 +961,60 @@ LONGTAIL_EXPORT int Longtail_GetFilesRecursively(
     const char* root_path,
     struct Longtail_FileInfos** out_file_infos);
 
+/*! @brief Get all files and directories in a path recursivley, reading directories in parallel.
+ *
+ * Same as Longtail_GetFilesRecursively() but all directories at the same depth are read as parallel jobs.
+ * The result is identical to Longtail_GetFilesRecursively(), @p path_filter_api is only called from the calling thread.
+ * Free the struct Longtail_FileInfos using Longtail_Free()
+ *
+ * @param[in] storage_api           An implementation of struct Longtail_StorageAPI interface.
+ * @param[in] optional_job_api      An implementation of struct Longtail_JobAPI interface or null to read directories on the calling thread
+ * @param[in] path_filter_api       An implementation of struct Longtail_PathFilter interface or null if no filtering is required
+ * @param[in] optional_cancel_api   An implementation of struct Longtail_CancelAPI interface or null if no cancelling is required
+ * @param[in] optional_cancel_token A cancel token or null if @p optional_cancel_api is null
+ * @param[in] root_path             Root path to search for files and directories - may not be null
+ * @param[out] out_file_infos       Pointer to a struct Longtail_FileInfos* pointer which will be set on success
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_GetFilesRecursivelyWithJobs(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_JobAPI* optional_job_api,
+    struct Longtail_PathFilterAPI* path_filter_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    struct Longtail_FileInfos** out_file_infos);
+
 LONGTAIL_EXPORT int Longtail_GetFilesFilteredByVersionIndex(
     struct Longtail_StorageAPI* storage_api,
+    struct Longtail_JobAPI* optional_job_api,
     struct Longtail_VersionIndex* version_index,
     struct Longtail_CancelAPI* optional_cancel_api,
     Longtail_CancelAPI_HCancelToken optional_cancel_token,
     const char* root_path,
     struct Longtail_FileInfos** out_file_infos);
 
+/*! @brief Create a struct Longtail_FileInfos from a list of paths.
+ *
+ * The file infos are allocated using Longtail_Alloc(), free them with Longtail_Free()
+ *
+ * @param[in] path_count            Number of paths
+ * @param[in] path_names            Array of @p path_count paths, relative to the root path the file infos are used with
+ * @param[in] file_sizes            Array with the size of each path
+ * @param[in] file_permissions      Array with the permissions of each path
+ * @param[out] out_file_infos       Pointer to a struct Longtail_FileInfos* pointer which will be set on success
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_MakeFileInfos(
+    uint32_t path_count,
+    const char* const* path_names,
+    const uint64_t* file_sizes,
+    const uint16_t* file_permissions,
+    struct Longtail_FileInfos** out_file_infos);
+
 /*! @brief Get the size of a constructedV VersionIndex.
+ *
+ * The size is for a version index chunked with HPCDC and without flags, use Longtail_GetVersionIndexSizeWithFormat() for other version indexes
  *
  * @param[in] asset_count             The number of assets (files and directories) in the index
  * @param[in] chunk_count             The number of chunks in the version index
@@ -935,9 +1028,29 @@ LONGTAIL_EXPORT size_t Longtail_GetVersionIndexSize(
     uint32_t asset_chunk_index_count,
     uint32_t path_data_size);
 
+/*! @brief Get the size of a constructed VersionIndex in the format used for a chunker and version index flags.
+ *
+ * @param[in] asset_count             The number of assets (files and directories) in the index
+ * @param[in] chunk_count             The number of chunks in the version index
+ * @param[in] asset_chunk_index_count The number of chunk indexes in the version index
+ * @param[in] path_data_size          The size of the path data
+ * @param[in] chunker_identifier      Identifier for the chunking algorithm, zero for HPCDC
+ * @param[in] flags                   LONGTAIL_VERSION_INDEX_FLAG_ flags of the version index, including LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES if it records per asset target chunk sizes
+ * @return                            The size in number of bytes of the version index
+ */
+LONGTAIL_EXPORT size_t Longtail_GetVersionIndexSizeWithFormat(
+    uint32_t asset_count,
+    uint32_t chunk_count,
+    uint32_t asset_chunk_index_count,
+    uint32_t path_data_size,
+    uint32_t chunker_identifier,
+    uint32_t flags);
+
 /*! @brief Create a version index for a struct Longtail_FileInfos.
  *
- * @param[in] mem                      The memory buffer to write the version index to
+ * The version index is chunked with HPCDC and has no flags, use Longtail_BuildVersionIndexWithChunkSizes() for other version indexes
+ *
+ * @param[in] mem                      The memory buffer to write the version index to, at least Longtail_GetVersionIndexSize() bytes
  * @param[in] mem_size                 The size of the memory buffer
  * @param[in] file_infos               Pointer to am initialized Longtail_FileInfos structure
  * @param[in] path_hashes              Array of hashes for each path in @p file_infos
@@ -972,6 +1085,49 @@ LONGTAIL_EXPORT int Longtail_BuildVersionIndex(
     uint32_t target_chunk_size,
     struct Longtail_VersionIndex** out_version_index);
 
+/*! @brief Create a version index for a struct Longtail_FileInfos with a chunker identifier, flags and optionally the target chunk size of each asset.
+ *
+ * @param[in] mem                      The memory buffer to write the version index to, at least Longtail_GetVersionIndexSizeWithFormat() bytes for @p chunker_identifier and @p flags
+ * @param[in] mem_size                 The size of the memory buffer
+ * @param[in] file_infos               Pointer to am initialized Longtail_FileInfos structure
+ * @param[in] path_hashes              Array of hashes for each path in @p file_infos
+ * @param[in] content_hashes           The has of each asset in @p file_infos
+ * @param[in] asset_chunk_index_starts Array with offset into @p asset_chunk_indexes where each asset list of chunks indexes begins
+ * @param[in] asset_chunk_counts       Array with number of chunks for each asset
+ * @param[in] asset_chunk_index_count  Number of entires in @p asset_chunk_indexes
+ * @param[in] asset_chunk_indexes      Array of all assets list of chunk indexes
+ * @param[in] chunk_count              Total number of unique chunks for all assets
+ * @param[in] chunk_sizes              Array with sizes of each chunk
+ * @param[in] chunk_hashes             Array with hashes of each chunk
+ * @param[in] optional_chunk_tags      Optional pointer with tag for each chunk, used to determine compression algorithm per chunk
+ * @param[in] optional_asset_target_chunk_sizes Optional pointer with the target chunk size each asset was chunked with, zero for @p target_chunk_size, sets LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES
+ * @param[in] hash_api_identifier      Identifier for the hashing algorithm used when hashing chunks and paths
+ * @param[in] chunker_identifier       Identifier for the chunking algorithm used when chunking the assets, zero for HPCDC
+ * @param[in] flags                    LONGTAIL_VERSION_INDEX_FLAG_ flags describing the chunks, zero for none
+ * @param[in] target_chunk_size        The target chunk size used when chunking the assets
+ * @param[in] out_version_index        Pointer to a struct Longtail_VersionIndex* pointer which will be set on success
+ */
+LONGTAIL_EXPORT int Longtail_BuildVersionIndexWithChunkSizes(
+    void* mem,
+    size_t mem_size,
+    const struct Longtail_FileInfos* file_infos,
+    const TLongtail_Hash* path_hashes,
+    const TLongtail_Hash* content_hashes,
+    const uint32_t* asset_chunk_index_starts,
+    const uint32_t* asset_chunk_counts,
+    uint32_t asset_chunk_index_count,
+    const uint32_t* asset_chunk_indexes,
+    uint32_t chunk_count,
+    const uint32_t* chunk_sizes,
+    const TLongtail_Hash* chunk_hashes,
+    const uint32_t* optional_chunk_tags,
+    const uint32_t* optional_asset_target_chunk_sizes,
+    uint32_t hash_api_identifier,
+    uint32_t chunker_identifier,
+    uint32_t flags,
+    uint32_t target_chunk_size,
+    struct Longtail_VersionIndex** out_version_index);
+
 /*! @brief Create a version index for a struct Longtail_FileInfos.
  *
  * All files are chunked and hashes to create a struct VersionIndex, allocated using Longtail_Alloc()
@@ -979,7 +1135,7 @@ LONGTAIL_EXPORT int Longtail_BuildVersionIndex(
  *
  * @param[in] storage_api           An implementation of struct Longtail_StorageAPI interface.
  * @param[in] hash_api              An implementation of struct Longtail_HashAPI interface.
- * @param[in] chunker_api           An implementation of struct Longtail_ChunkerAPI interface.
+ * @param[in] chunker_api           An implementation of struct Longtail_ChunkerAPI interface, its identifier is recorded in the version index
  * @param[in] job_api               An implementation of struct Longtail_JobAPI interface
  * @param[in] progress_api          An implementation of struct Longtail_JobAPI interface or null if no progress indication is required
  * @param[in] optional_cancel_api   An implementation of struct Longtail_CancelAPI interface or null if no cancelling is required
@@ -1007,6 +1163,74 @@ LONGTAIL_EXPORT int Longtail_CreateVersionIndex(
     int enable_file_map,
     struct Longtail_VersionIndex** out_version_index);
 
+/*! @brief Create a version index for a struct Longtail_FileInfos with a per-asset target chunk size.
+ *
+ * Same as Longtail_CreateVersionIndex() but each asset may be chunked with its own target chunk size.
+ * The resulting version index records @p target_chunk_size as its target chunk size and, if some asset
+ * is chunked with another target chunk size, the target chunk size of each asset in m_AssetTargetChunkSizes.
+ *
+ * @param[in] storage_api                       An implementation of struct Longtail_StorageAPI interface.
+ * @param[in] hash_api                          An implementation of struct Longtail_HashAPI interface.
+ * @param[in] chunker_api                       An implementation of struct Longtail_ChunkerAPI interface.
+ * @param[in] job_api                           An implementation of struct Longtail_JobAPI interface
+ * @param[in] progress_api                      An implementation of struct Longtail_JobAPI interface or null if no progress indication is required
+ * @param[in] optional_cancel_api               An implementation of struct Longtail_CancelAPI interface or null if no cancelling is required
+ * @param[in] optional_cancel_token             A cancel token or null if @p optional_cancel_api is null
+ * @param[in] root_path                         Root path for files in @p file_infos
+ * @param[in] file_infos                        Pointer to am initialized Longtail_FileInfos structure
+ * @param[in] optional_asset_tags               An array with a tag for each entry in @p file_infos, usually a compression tag, set to zero if no tags are wanted
+ * @param[in] optional_asset_target_chunk_sizes An array with a target chunk size for each entry in @p file_infos, zero entries use @p target_chunk_size, set to zero to use @p target_chunk_size for all assets
+ * @param[in] flags                             LONGTAIL_VERSION_INDEX_FLAG_ flags for the version index, with LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS all-zero chunks get the reserved zero chunk hash
+ * @param[in] target_chunk_size                 The default target size of chunks
+ * @param[in] enable_file_map                   Enable memory mapping when reading files, only has effect if storage_api supports memory mapping
+ * @param[out] out_version_index                Pointer to a struct Longtail_VersionIndex* pointer which will be set on success
+ * @return                                      Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_CreateVersionIndexWithChunkSizes(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    const struct Longtail_FileInfos* file_infos,
+    const uint32_t* optional_asset_tags,
+    const uint32_t* optional_asset_target_chunk_sizes,
+    uint32_t flags,
+    uint32_t target_chunk_size,
+    int enable_file_map,
+    struct Longtail_VersionIndex** out_version_index);
+
+/*! @brief Calculates a whole-file fingerprint for each asset in a struct Longtail_FileInfos.
+ *
+ * The fingerprint is the hash of the complete file content using @p hash_api, it does not depend on chunking.
+ * Reading and hashing a file is cheaper than chunking it, so a matching fingerprint recorded when the file
+ * was last indexed lets the caller reuse the chunks of the earlier version index. Directory entries get a zero fingerprint.
+ *
+ * @param[in] storage_api               An implementation of struct Longtail_StorageAPI interface.
+ * @param[in] hash_api                  An implementation of struct Longtail_HashAPI interface.
+ * @param[in] job_api                   An implementation of struct Longtail_JobAPI interface
+ * @param[in] progress_api              An implementation of struct Longtail_JobAPI interface or null if no progress indication is required
+ * @param[in] optional_cancel_api       An implementation of struct Longtail_CancelAPI interface or null if no cancelling is required
+ * @param[in] optional_cancel_token     A cancel token or null if @p optional_cancel_api is null
+ * @param[in] root_path                 Root path for files in @p file_infos
+ * @param[in] file_infos                Pointer to am initialized Longtail_FileInfos structure
+ * @param[out] out_fingerprints         Array with room for one fingerprint per entry in @p file_infos
+ * @return                              Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_GetFileFingerprints(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const char* root_path,
+    const struct Longtail_FileInfos* file_infos,
+    TLongtail_Hash* out_fingerprints);
+
 /*! @brief Merges (adds) the content of an version index on top of an existing version index.
  *
  * Creates a merged version of two version indexes. Matching file paths from @p overlay_version_index will
@@ -1093,7 +1317,8 @@ LONGTAIL_EXPORT int Longtail_ReadVersionIndex(
 
 /*! @brief Get the chunks required to go to @p version_index by applying @p version_diff.
  *
- * Gets all the chunks required to apply @p version_diff which is a subset of all chunks in @p version_index
+ * Gets all the chunks required to apply @p version_diff which is a subset of all chunks in @p version_index.
+ * Zero chunks are not stored in blocks and are not included.
  *
  * @param[in] version_index         Pointer to an initialized struct Longtail_VersionIndex - the version we will have after applying @p version_diff
  * @param[in] version_diff          Pointer to an initialized struct Longtail_VersionDiff - the version diff to be applied to get to @p version_index
@@ -1138,6 +1363,7 @@ LONGTAIL_EXPORT int Longtail_WriteContent(
  *
  * Any content in @p version_index that is not present in @p store_index will be included in @p out_store_index
  * Chunks that are not present in @p store_index will be bundled up in blocks according to @p max_block_size and @p max_chunks_per_block.
+ * Zero chunks are never missing, they are not stored in blocks.
  *
  * @param[in] hash_api              An implementation of struct Longtail_HashAPI interface. This must match the hashing api used to create both store index index and version index
  * @param[in] store_index           The known store index to check against
@@ -1155,6 +1381,36 @@ LONGTAIL_EXPORT int Longtail_CreateMissingContent(
     uint32_t max_chunks_per_block,
     struct Longtail_StoreIndex** out_store_index);
 
+// New chunks are packed in the order they appear in the version index
+#define LONGTAIL_BLOCK_PACKING_VERSION_ORDER 0u
+// New chunks are grouped per asset, with assets ordered by tag, file extension and path,
+// and the chunks of an asset are kept in as few blocks as possible
+#define LONGTAIL_BLOCK_PACKING_LOCALITY 1u
+
+/*! @brief Generate a store index with what is missing using a block packing strategy.
+ *
+ * Same as Longtail_CreateMissingContent() but @p block_packing selects how the missing chunks are bundled up in blocks.
+ * LONGTAIL_BLOCK_PACKING_LOCALITY keeps the chunks of each asset together and places assets of the same type and
+ * directory next to each other so reading a few assets touches fewer blocks and similar content is compressed together.
+ *
+ * @param[in] hash_api              An implementation of struct Longtail_HashAPI interface. This must match the hashing api used to create both store index index and version index
+ * @param[in] store_index           The known store index to check against
+ * @param[in] version_index         The version index content you test against @p store_index
+ * @param[in] max_block_size        The maximum size if bytes one block is allowed to be
+ * @param[in] max_chunks_per_block  The maximum number of chunks allowed inside one block
+ * @param[in] block_packing         LONGTAIL_BLOCK_PACKING_VERSION_ORDER or LONGTAIL_BLOCK_PACKING_LOCALITY
+ * @param[out] out_store_index      The resulting missing store index will be created and assigned to this pointer reference if successful
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_CreateMissingContentWithPacking(
+    struct Longtail_HashAPI* hash_api,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* version_index,
+    uint32_t max_block_size,
+    uint32_t max_chunks_per_block,
+    uint32_t block_packing,
+    struct Longtail_StoreIndex** out_store_index);
+
 /*! @brief Generates an array of all chunks missing in a store index.
  *
  * Any chunk hashes in @p chunk_hashes that is not present in @p store_index will be included in @p out_missing_chunk_hashes
@@ -1259,6 +1515,34 @@ LONGTAIL_EXPORT int Longtail_ChangeVersion(
     const char* version_path,
     int retain_permissions);
 
+/*! @brief Unpack and modify a version, copying content that is already local.
+ *
+ * Same as Longtail_ChangeVersion() but the assets to write are first looked up by content in @p copy_source_version.
+ * An asset with the content of a file in @p copy_source_version that this change does not write is copied from that
+ * file, or the file is renamed if @p version_diff removes it. Assets with the same content are written once and copied.
+ * Assets that can not be copied are written from blocks.
+ *
+ * Longtail_ChangeVersion() uses @p source_version as @p copy_source_version.
+ *
+ * @param[in] copy_source_version   Version index of the files in @p version_path that hold the content it lists, must use the same hashing as @p target_version
+ * @return                          Return code (errno style), zero on success
+ */
+LONGTAIL_EXPORT int Longtail_ChangeVersionWithLocalCopy(
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_StorageAPI* version_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    struct Longtail_CancelAPI* optional_cancel_api,
+    Longtail_CancelAPI_HCancelToken optional_cancel_token,
+    const struct Longtail_StoreIndex* store_index,
+    const struct Longtail_VersionIndex* source_version,
+    const struct Longtail_VersionIndex* target_version,
+    const struct Longtail_VersionDiff* version_diff,
+    const char* version_path,
+    int retain_permissions,
+    const struct Longtail_VersionIndex* copy_source_version);
+
 /*! @brief Get the size of the block index data.
  *
  * This size is just for the data of the block index excluding the struct Longtail_BlockIndex.
@@ -1701,6 +1985,8 @@ struct Longtail_VersionIndex {
   uint32_t* m_AssetCount;
   uint32_t* m_ChunkCount;
   uint32_t* m_AssetChunkIndexCount;
+  uint32_t* m_ChunkerIdentifier;    // From version 0.0.3, 0 for older versions, read with Longtail_VersionIndex_GetChunkerIdentifier()
+  uint32_t* m_Flags;                // From version 0.0.4, 0 for older versions, read with Longtail_VersionIndex_GetFlags()
   TLongtail_Hash* m_PathHashes;     // []
   TLongtail_Hash* m_ContentHashes;  // []
   uint64_t* m_AssetSizes;           // []
@@ -1713,6 +1999,7 @@ struct Longtail_VersionIndex {
 
   uint32_t* m_ChunkSizes;  // []
   uint32_t* m_ChunkTags;   // []
+  uint32_t* m_AssetTargetChunkSizes;  // [] Only with LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES, zero for assets chunked with m_TargetChunkSize
 
   uint32_t* m_NameOffsets;  // []
   uint32_t m_NameDataSize;
@@ -1720,6 +2007,14 @@ struct Longtail_VersionIndex {
   char* m_NameData;
 };
 
+/*! @brief Version index flag, all-zero chunks have the reserved hash from Longtail_GetZeroChunkHash() and are not stored in blocks.
+ */
+#define LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS 1u
+
+/*! @brief Version index flag, the version index records the target chunk size each asset was chunked with in m_AssetTargetChunkSizes.
+ */
+#define LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES 2u
+
 struct Longtail_ArchiveIndex {
   uint32_t* m_Version;
   uint32_t* m_IndexDataSize;
@@ -1741,14 +2036,39 @@ LONGTAIL_EXPORT int Longtail_ReadArchiveIndex(
 
 LONGTAIL_EXPORT uint32_t Longtail_VersionIndex_GetVersion(const struct Longtail_VersionIndex* version_index);
 LONGTAIL_EXPORT uint32_t Longtail_VersionIndex_GetHashAPI(const struct Longtail_VersionIndex* version_index);
+LONGTAIL_EXPORT uint32_t Longtail_VersionIndex_GetChunkerIdentifier(const struct Longtail_VersionIndex* version_index);
+LONGTAIL_EXPORT uint32_t Longtail_VersionIndex_GetFlags(const struct Longtail_VersionIndex* version_index);
 LONGTAIL_EXPORT uint32_t Longtail_VersionIndex_GetAssetCount(const struct Longtail_VersionIndex* version_index);
 LONGTAIL_EXPORT uint32_t Longtail_VersionIndex_GetChunkCount(const struct Longtail_VersionIndex* version_index);
 LONGTAIL_EXPORT const TLongtail_Hash* Longtail_VersionIndex_GetChunkHashes(const struct Longtail_VersionIndex* version_index);
 LONGTAIL_EXPORT const uint32_t* Longtail_VersionIndex_GetChunkSizes(const struct Longtail_VersionIndex* version_index);
 LONGTAIL_EXPORT const uint32_t* Longtail_VersionIndex_GetChunkTags(const struct Longtail_VersionIndex* version_index);
+LONGTAIL_EXPORT const uint32_t* Longtail_VersionIndex_GetAssetTargetChunkSizes(const struct Longtail_VersionIndex* version_index);
 
 LONGTAIL_EXPORT int Longtail_GetPathHash(struct Longtail_HashAPI* hash_api, const char* path, TLongtail_Hash* out_hash);
 
+/*! @brief Gets the reserved hash of an all-zero chunk.
+ *
+ * In version indexes with the LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS flag chunks that only contain zero bytes
+ * are not hashed with the hash api, they get a hash derived from their size.
+ * Zero chunks are never stored in a block, writing a version leaves their range of the asset as a hole in the file.
+ *
+ * @param[in] chunk_size            Size of the chunk in bytes
+ * @return                          The reserved hash of a zero chunk of @p chunk_size bytes
+ */
+LONGTAIL_EXPORT TLongtail_Hash Longtail_GetZeroChunkHash(uint32_t chunk_size);
+
+/*! @brief Checks if a chunk of a version index is an all-zero chunk.
+ *
+ * Only version indexes with the LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS flag have zero chunks, in older version
+ * indexes all-zero chunks are hashed and stored in blocks like any other chunk.
+ *
+ * @param[in] version_index         Pointer to an initialized struct Longtail_VersionIndex
+ * @param[in] chunk_index           Index of the chunk in @p version_index
+ * @return                          1 if the chunk has the reserved hash of a zero chunk of its size, 0 otherwise
+ */
+LONGTAIL_EXPORT int Longtail_IsZeroChunk(const struct Longtail_VersionIndex* version_index, uint32_t chunk_index);
+
 struct Longtail_VersionDiff {
   uint32_t* m_SourceRemovedCount;
   uint32_t* m_TargetAddedCount;
@@ -41,6 +41,7 @@ mkdir !DIST_DIR!\include\lib\brotli
 mkdir !DIST_DIR!\include\lib\cacheblockstore
 mkdir !DIST_DIR!\include\lib\compressblockstore
 mkdir !DIST_DIR!\include\lib\compressionregistry
+mkdir !DIST_DIR!\include\lib\fastcdcchunker
 mkdir !DIST_DIR!\include\lib\filestorage
 mkdir !DIST_DIR!\include\lib\fsblockstore
 mkdir !DIST_DIR!\include\lib\hpcdcchunker
@@ -49,13 +50,16 @@ mkdir !DIST_DIR!\include\lib\lrublockstore
 mkdir !DIST_DIR!\include\lib\memstorage
 mkdir !DIST_DIR!\include\lib\memtracer
 mkdir !DIST_DIR!\include\lib\meowhash
+mkdir !DIST_DIR!\include\lib\prefetchblockstore
 mkdir !DIST_DIR!\include\lib\ratelimitedprogress
 mkdir !DIST_DIR!\include\lib\lz4
 mkdir !DIST_DIR!\include\lib\zstd
 mkdir !DIST_DIR!\include\lib\shareblockstore
+mkdir !DIST_DIR!\include\lib\xxhash
 
 copy !BASE_DIR!src\longtail.h !DIST_DIR!\include\src\ >nul
 copy !BASE_DIR!lib\longtail_platform.h !DIST_DIR!\include\lib\ >nul
+copy !BASE_DIR!lib\fastcdcchunker\*.h !DIST_DIR!\include\lib\fastcdcchunker\ >nul
 copy !BASE_DIR!lib\filestorage\*.h !DIST_DIR!\include\lib\filestorage\ >nul
 copy !BASE_DIR!lib\archiveblockstore\*.h !DIST_DIR!\include\lib\archiveblockstore\ >nul
 copy !BASE_DIR!lib\atomiccancel\*.h !DIST_DIR!\include\lib\atomiccancel\ >nul
@@ -74,10 +78,12 @@ copy !BASE_DIR!lib\lrublockstore\*.h !DIST_DIR!\include\lib\lrublockstore\ >nul
 copy !BASE_DIR!lib\memstorage\*.h !DIST_DIR!\include\lib\memstorage\ >nul
 copy !BASE_DIR!lib\memtracer\*.h !DIST_DIR!\include\lib\memtracer\ >nul
 copy !BASE_DIR!lib\meowhash\*.h !DIST_DIR!\include\lib\meowhash\ >nul
+copy !BASE_DIR!lib\prefetchblockstore\*.h !DIST_DIR!\include\lib\prefetchblockstore\ >nul
 copy !BASE_DIR!lib\ratelimitedprogress\*.h !DIST_DIR!\include\lib\ratelimitedprogress\ >nul
 copy !BASE_DIR!lib\lz4\*.h !DIST_DIR!\include\lib\lz4\ >nul
 copy !BASE_DIR!lib\zstd\*.h !DIST_DIR!\include\lib\zstd\ >nul
 copy !BASE_DIR!lib\shareblockstore\*.h !DIST_DIR!\include\lib\shareblockstore\ >nul
+copy !BASE_DIR!lib\xxhash\*.h !DIST_DIR!\include\lib\xxhash\ >nul
 
 echo.
 echo dist-msvc created successfully.
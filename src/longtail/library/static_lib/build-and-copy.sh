@@ -41,6 +41,7 @@ LIB_SUBDIRS=(
   cacheblockstore
   compressblockstore
   compressionregistry
+  fastcdcchunker
   filestorage
   fsblockstore
   hpcdcchunker
@@ -50,8 +51,10 @@ LIB_SUBDIRS=(
   memstorage
   memtracer
   meowhash
+  prefetchblockstore
   ratelimitedprogress
   shareblockstore
+  xxhash
   zstd
 )
 
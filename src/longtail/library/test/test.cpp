@@ -0,0 +1,1496 @@
+#include "../src/longtail.h"
+#include "../lib/longtail_platform.h"
+#include "../lib/bikeshed/longtail_bikeshed.h"
+#include "../lib/compressblockstore/longtail_compressblockstore.h"
+#include "../lib/compressionregistry/longtail_full_compression_registry.h"
+#include "../lib/fastcdcchunker/longtail_fastcdcchunker.h"
+#include "../lib/filestorage/longtail_filestorage.h"
+#include "../lib/fsblockstore/longtail_fsblockstore.h"
+#include "../lib/hashregistry/longtail_full_hash_registry.h"
+#include "../lib/hpcdcchunker/longtail_hpcdcchunker.h"
+#include "../lib/hpcdcchunker/longtail_hpcdcchunker_scan.h"
+#include "../lib/lz4/longtail_lz4.h"
+#include "../lib/memstorage/longtail_memstorage.h"
+#include "../lib/prefetchblockstore/longtail_prefetchblockstore.h"
+#include "../lib/blake3/longtail_blake3.h"
+#include "../lib/xxhash/longtail_xxhash.h"
+#include "../lib/zstd/longtail_zstd.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+////////////// Test runner
+
+// A minimal runner, TEST() registers a test and a failing ASSERT_ returns from it
+
+typedef void (*TestFunc)();
+
+struct TestRegistration
+{
+    const char* m_Name;
+    TestFunc m_Func;
+    TestRegistration* m_Next;
+    TestRegistration(const char* name, TestFunc func);
+};
+
+static TestRegistration* g_FirstTest = 0;
+static TestRegistration** g_LastTest = &g_FirstTest;
+static int g_TestFailed = 0;
+
+TestRegistration::TestRegistration(const char* name, TestFunc func)
+    : m_Name(name)
+    , m_Func(func)
+    , m_Next(0)
+{
+    *g_LastTest = this;
+    g_LastTest = &m_Next;
+}
+
+static void TestFail(const char* file, int line, const char* expression)
+{
+    printf("%s:%d: Failure: %s\n", file, line, expression);
+    g_TestFailed = 1;
+}
+
+#define TEST(name) \
+    static void Test_##name(); \
+    static TestRegistration g_Registration_##name(#name, Test_##name); \
+    static void Test_##name()
+
+#define ASSERT_TRUE(expression) do { if (!(expression)) { TestFail(__FILE__, __LINE__, #expression); return; } } while (0)
+#define ASSERT_FALSE(expression) ASSERT_TRUE(!(expression))
+#define ASSERT_EQ(a, b) ASSERT_TRUE((a) == (b))
+#define ASSERT_NE(a, b) ASSERT_TRUE((a) != (b))
+
+static void TestLog(struct Longtail_LogContext* log_context, const char* str)
+{
+    fprintf(stderr, "%s(%d): %s\n", log_context->function, log_context->line, str);
+}
+
+// Set LONGTAIL_TEST_LOG to log warnings and errors from the library
+int main(int argc, char** argv)
+{
+    Longtail_SetLog(TestLog, 0);
+    Longtail_SetLogLevel(getenv("LONGTAIL_TEST_LOG") ? LONGTAIL_LOG_LEVEL_WARNING : LONGTAIL_LOG_LEVEL_OFF);
+    const char* filter = argc > 1 ? argv[1] : 0;
+    int run_count = 0;
+    int failed_count = 0;
+    for (TestRegistration* test = g_FirstTest; test; test = test->m_Next)
+    {
+        if (filter && strstr(test->m_Name, filter) == 0)
+        {
+            continue;
+        }
+        printf("[ RUN    ] %s\n", test->m_Name);
+        fflush(stdout);
+        g_TestFailed = 0;
+        test->m_Func();
+        printf("%s %s\n", g_TestFailed ? "[ FAILED ]" : "[     OK ]", test->m_Name);
+        ++run_count;
+        failed_count += g_TestFailed;
+    }
+    printf("%d tests, %d failed\n", run_count, failed_count);
+    return failed_count == 0 ? 0 : 1;
+}
+
+////////////// Helpers
+
+static void FillRandom(uint8_t* data, size_t size, uint32_t seed)
+{
+    uint32_t x = seed | 1u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        data[i] = (uint8_t)x;
+    }
+}
+
+static void FillText(uint8_t* data, size_t size, uint32_t seed)
+{
+    static const char* words[] = { "mesh ", "texture ", "level ", "actor ", "material ", "sound ", "0.5 ", "\n" };
+    uint32_t x = seed | 1u;
+    size_t offset = 0;
+    while (offset < size)
+    {
+        x = x * 1664525u + 1013904223u;
+        const char* word = words[(x >> 24) & 7];
+        size_t length = strlen(word);
+        length = length < size - offset ? length : size - offset;
+        memcpy(&data[offset], word, length);
+        offset += length;
+    }
+}
+
+static int WriteTestFile(struct Longtail_StorageAPI* storage_api, const char* path, const std::vector<uint8_t>& data)
+{
+    int err = EnsureParentPathExists(storage_api, path);
+    if (err)
+    {
+        return err;
+    }
+    Longtail_StorageAPI_HOpenFile f;
+    err = storage_api->OpenWriteFile(storage_api, path, 0, &f);
+    if (err)
+    {
+        return err;
+    }
+    if (!data.empty())
+    {
+        err = storage_api->Write(storage_api, f, 0, data.size(), &data[0]);
+    }
+    storage_api->CloseFile(storage_api, f);
+    return err;
+}
+
+static int ReadTestFile(struct Longtail_StorageAPI* storage_api, const char* path, std::vector<uint8_t>& out_data)
+{
+    Longtail_StorageAPI_HOpenFile f;
+    int err = storage_api->OpenReadFile(storage_api, path, &f);
+    if (err)
+    {
+        return err;
+    }
+    uint64_t size;
+    err = storage_api->GetSize(storage_api, f, &size);
+    if (!err)
+    {
+        out_data.resize((size_t)size);
+        if (size > 0)
+        {
+            err = storage_api->Read(storage_api, f, 0, size, &out_data[0]);
+        }
+    }
+    storage_api->CloseFile(storage_api, f);
+    return err;
+}
+
+static std::string JoinPath(const char* folder, const char* path)
+{
+    return std::string(folder) + "/" + path;
+}
+
+// Checks that every file in source_path has the same content in target_path
+static bool FoldersMatch(struct Longtail_StorageAPI* storage_api, const char* source_path, const char* target_path)
+{
+    struct Longtail_FileInfos* source_file_infos;
+    if (Longtail_GetFilesRecursively(storage_api, 0, 0, 0, source_path, &source_file_infos))
+    {
+        return false;
+    }
+    struct Longtail_FileInfos* target_file_infos;
+    if (Longtail_GetFilesRecursively(storage_api, 0, 0, 0, target_path, &target_file_infos))
+    {
+        Longtail_Free(source_file_infos);
+        return false;
+    }
+    bool match = source_file_infos->m_Count == target_file_infos->m_Count;
+    for (uint32_t f = 0; match && f < source_file_infos->m_Count; ++f)
+    {
+        const char* path = Longtail_FileInfos_GetPath(source_file_infos, f);
+        if (path[strlen(path) - 1] == '/')
+        {
+            continue;
+        }
+        std::vector<uint8_t> source_data;
+        std::vector<uint8_t> target_data;
+        match = ReadTestFile(storage_api, JoinPath(source_path, path).c_str(), source_data) == 0 &&
+            ReadTestFile(storage_api, JoinPath(target_path, path).c_str(), target_data) == 0 &&
+            source_data == target_data;
+    }
+    Longtail_Free(target_file_infos);
+    Longtail_Free(source_file_infos);
+    return match;
+}
+
+struct TestAsyncPutStoredBlockComplete
+{
+    struct Longtail_AsyncPutStoredBlockAPI m_API;
+    HLongtail_Sema m_Sema;
+    int m_Err;
+
+    TestAsyncPutStoredBlockComplete()
+        : m_Err(EINVAL)
+    {
+        memset(&m_API, 0, sizeof(m_API));
+        m_API.OnComplete = OnComplete;
+        Longtail_CreateSema(Longtail_Alloc("Test", Longtail_GetSemaSize()), 0, &m_Sema);
+    }
+    ~TestAsyncPutStoredBlockComplete()
+    {
+        Longtail_DeleteSema(m_Sema);
+        Longtail_Free(m_Sema);
+    }
+    static void OnComplete(struct Longtail_AsyncPutStoredBlockAPI* async_complete_api, int err)
+    {
+        TestAsyncPutStoredBlockComplete* cb = (TestAsyncPutStoredBlockComplete*)async_complete_api;
+        cb->m_Err = err;
+        Longtail_PostSema(cb->m_Sema, 1);
+    }
+    int Wait()
+    {
+        Longtail_WaitSema(m_Sema, LONGTAIL_TIMEOUT_INFINITE);
+        return m_Err;
+    }
+};
+
+struct TestAsyncGetStoredBlockComplete
+{
+    struct Longtail_AsyncGetStoredBlockAPI m_API;
+    HLongtail_Sema m_Sema;
+    struct Longtail_StoredBlock* m_StoredBlock;
+    int m_Err;
+
+    TestAsyncGetStoredBlockComplete()
+        : m_StoredBlock(0)
+        , m_Err(EINVAL)
+    {
+        memset(&m_API, 0, sizeof(m_API));
+        m_API.OnComplete = OnComplete;
+        Longtail_CreateSema(Longtail_Alloc("Test", Longtail_GetSemaSize()), 0, &m_Sema);
+    }
+    ~TestAsyncGetStoredBlockComplete()
+    {
+        Longtail_DeleteSema(m_Sema);
+        Longtail_Free(m_Sema);
+    }
+    static void OnComplete(struct Longtail_AsyncGetStoredBlockAPI* async_complete_api, struct Longtail_StoredBlock* stored_block, int err)
+    {
+        TestAsyncGetStoredBlockComplete* cb = (TestAsyncGetStoredBlockComplete*)async_complete_api;
+        cb->m_StoredBlock = stored_block;
+        cb->m_Err = err;
+        Longtail_PostSema(cb->m_Sema, 1);
+    }
+    int Wait()
+    {
+        Longtail_WaitSema(m_Sema, LONGTAIL_TIMEOUT_INFINITE);
+        return m_Err;
+    }
+};
+
+struct TestAsyncGetExistingContentComplete
+{
+    struct Longtail_AsyncGetExistingContentAPI m_API;
+    HLongtail_Sema m_Sema;
+    struct Longtail_StoreIndex* m_StoreIndex;
+    int m_Err;
+
+    TestAsyncGetExistingContentComplete()
+        : m_StoreIndex(0)
+        , m_Err(EINVAL)
+    {
+        memset(&m_API, 0, sizeof(m_API));
+        m_API.OnComplete = OnComplete;
+        Longtail_CreateSema(Longtail_Alloc("Test", Longtail_GetSemaSize()), 0, &m_Sema);
+    }
+    ~TestAsyncGetExistingContentComplete()
+    {
+        Longtail_DeleteSema(m_Sema);
+        Longtail_Free(m_Sema);
+    }
+    static void OnComplete(struct Longtail_AsyncGetExistingContentAPI* async_complete_api, struct Longtail_StoreIndex* store_index, int err)
+    {
+        TestAsyncGetExistingContentComplete* cb = (TestAsyncGetExistingContentComplete*)async_complete_api;
+        cb->m_StoreIndex = store_index;
+        cb->m_Err = err;
+        Longtail_PostSema(cb->m_Sema, 1);
+    }
+    int Wait()
+    {
+        Longtail_WaitSema(m_Sema, LONGTAIL_TIMEOUT_INFINITE);
+        return m_Err;
+    }
+};
+
+struct TestAsyncFlushComplete
+{
+    struct Longtail_AsyncFlushAPI m_API;
+    HLongtail_Sema m_Sema;
+    int m_Err;
+
+    TestAsyncFlushComplete()
+        : m_Err(EINVAL)
+    {
+        memset(&m_API, 0, sizeof(m_API));
+        m_API.OnComplete = OnComplete;
+        Longtail_CreateSema(Longtail_Alloc("Test", Longtail_GetSemaSize()), 0, &m_Sema);
+    }
+    ~TestAsyncFlushComplete()
+    {
+        Longtail_DeleteSema(m_Sema);
+        Longtail_Free(m_Sema);
+    }
+    static void OnComplete(struct Longtail_AsyncFlushAPI* async_complete_api, int err)
+    {
+        TestAsyncFlushComplete* cb = (TestAsyncFlushComplete*)async_complete_api;
+        cb->m_Err = err;
+        Longtail_PostSema(cb->m_Sema, 1);
+    }
+    int Wait()
+    {
+        Longtail_WaitSema(m_Sema, LONGTAIL_TIMEOUT_INFINITE);
+        return m_Err;
+    }
+};
+
+static int PutStoredBlock(struct Longtail_BlockStoreAPI* block_store_api, struct Longtail_StoredBlock* stored_block)
+{
+    TestAsyncPutStoredBlockComplete put_cb;
+    int err = block_store_api->PutStoredBlock(block_store_api, stored_block, &put_cb.m_API);
+    return err ? err : put_cb.Wait();
+}
+
+static int GetStoredBlock(struct Longtail_BlockStoreAPI* block_store_api, TLongtail_Hash block_hash, struct Longtail_StoredBlock** out_stored_block)
+{
+    TestAsyncGetStoredBlockComplete get_cb;
+    int err = block_store_api->GetStoredBlock(block_store_api, block_hash, &get_cb.m_API);
+    if (!err)
+    {
+        err = get_cb.Wait();
+    }
+    *out_stored_block = get_cb.m_StoredBlock;
+    return err;
+}
+
+static int GetExistingContent(struct Longtail_BlockStoreAPI* block_store_api, uint32_t chunk_count, const TLongtail_Hash* chunk_hashes, struct Longtail_StoreIndex** out_store_index)
+{
+    TestAsyncGetExistingContentComplete get_existing_cb;
+    int err = block_store_api->GetExistingContent(block_store_api, chunk_count, chunk_hashes, 0, &get_existing_cb.m_API);
+    if (!err)
+    {
+        err = get_existing_cb.Wait();
+    }
+    *out_store_index = get_existing_cb.m_StoreIndex;
+    return err;
+}
+
+static int FlushBlockStore(struct Longtail_BlockStoreAPI* block_store_api)
+{
+    TestAsyncFlushComplete flush_cb;
+    int err = block_store_api->Flush(block_store_api, &flush_cb.m_API);
+    return err ? err : flush_cb.Wait();
+}
+
+static struct Longtail_StoredBlock* CreateTestBlock(TLongtail_Hash block_hash, uint32_t tag, const std::vector<uint8_t>& data, uint32_t chunk_count)
+{
+    std::vector<TLongtail_Hash> chunk_hashes(chunk_count);
+    std::vector<uint32_t> chunk_sizes(chunk_count);
+    uint32_t chunk_size = (uint32_t)data.size() / chunk_count;
+    for (uint32_t c = 0; c < chunk_count; ++c)
+    {
+        chunk_hashes[c] = block_hash + 1 + c;
+        chunk_sizes[c] = (c == chunk_count - 1) ? (uint32_t)data.size() - chunk_size * c : chunk_size;
+    }
+    struct Longtail_StoredBlock* stored_block;
+    if (Longtail_CreateStoredBlock(block_hash, 0, chunk_count, tag, &chunk_hashes[0], &chunk_sizes[0], (uint32_t)data.size(), &stored_block))
+    {
+        return 0;
+    }
+    memcpy(stored_block->m_BlockData, &data[0], data.size());
+    return stored_block;
+}
+
+static int CreateVersionIndexForFolder(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    const char* root_path,
+    uint32_t tag,
+    const uint32_t* optional_asset_target_chunk_sizes,
+    uint32_t flags,
+    uint32_t target_chunk_size,
+    struct Longtail_VersionIndex** out_version_index)
+{
+    struct Longtail_FileInfos* file_infos;
+    int err = Longtail_GetFilesRecursively(storage_api, 0, 0, 0, root_path, &file_infos);
+    if (err)
+    {
+        return err;
+    }
+    std::vector<uint32_t> tags(file_infos->m_Count + 1, tag);
+    err = Longtail_CreateVersionIndexWithChunkSizes(
+        storage_api,
+        hash_api,
+        chunker_api,
+        job_api,
+        0,
+        0,
+        0,
+        root_path,
+        file_infos,
+        &tags[0],
+        optional_asset_target_chunk_sizes,
+        flags,
+        target_chunk_size,
+        0,
+        out_version_index);
+    Longtail_Free(file_infos);
+    return err;
+}
+
+static int CreateEmptyVersionIndex(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    uint32_t target_chunk_size,
+    struct Longtail_VersionIndex** out_version_index)
+{
+    struct Longtail_FileInfos* file_infos;
+    int err = Longtail_MakeFileInfos(0, 0, 0, 0, &file_infos);
+    if (err)
+    {
+        return err;
+    }
+    err = Longtail_CreateVersionIndex(storage_api, hash_api, chunker_api, job_api, 0, 0, 0, "", file_infos, 0, target_chunk_size, 0, out_version_index);
+    Longtail_Free(file_infos);
+    return err;
+}
+
+// Uploads the content of version_index in source_path to block_store_api
+static int WriteVersionContent(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_VersionIndex* version_index,
+    const char* source_path,
+    uint32_t block_packing,
+    struct Longtail_StoreIndex** out_store_index)
+{
+    struct Longtail_StoreIndex* existing_store_index;
+    int err = GetExistingContent(block_store_api, *version_index->m_ChunkCount, version_index->m_ChunkHashes, &existing_store_index);
+    if (err)
+    {
+        return err;
+    }
+    struct Longtail_StoreIndex* missing_store_index;
+    err = Longtail_CreateMissingContentWithPacking(hash_api, existing_store_index, version_index, 65536, 1024, block_packing, &missing_store_index);
+    if (!err)
+    {
+        err = Longtail_WriteContent(storage_api, block_store_api, job_api, 0, 0, 0, missing_store_index, version_index, source_path);
+    }
+    if (!err)
+    {
+        err = FlushBlockStore(block_store_api);
+    }
+    if (!err)
+    {
+        err = Longtail_MergeStoreIndex(existing_store_index, missing_store_index, out_store_index);
+    }
+    Longtail_Free(missing_store_index);
+    Longtail_Free(existing_store_index);
+    return err;
+}
+
+// Changes the version in target_path from source_version to target_version, copying local content if copy_source_version is set
+static int PullVersion(
+    struct Longtail_StorageAPI* storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_BlockStoreAPI* block_store_api,
+    struct Longtail_VersionIndex* source_version,
+    struct Longtail_VersionIndex* target_version,
+    const char* target_path,
+    struct Longtail_VersionIndex* copy_source_version)
+{
+    struct Longtail_VersionDiff* version_diff;
+    int err = Longtail_CreateVersionDiff(hash_api, source_version, target_version, &version_diff);
+    if (err)
+    {
+        return err;
+    }
+    std::vector<TLongtail_Hash> required_chunk_hashes(*target_version->m_ChunkCount + 1);
+    uint32_t required_chunk_count;
+    err = Longtail_GetRequiredChunkHashes(target_version, version_diff, &required_chunk_count, &required_chunk_hashes[0]);
+    struct Longtail_StoreIndex* store_index = 0;
+    if (!err)
+    {
+        err = GetExistingContent(block_store_api, required_chunk_count, &required_chunk_hashes[0], &store_index);
+    }
+    if (!err && copy_source_version == 0)
+    {
+        err = Longtail_ChangeVersion(
+            block_store_api,
+            storage_api,
+            hash_api,
+            job_api,
+            0,
+            0,
+            0,
+            store_index,
+            source_version,
+            target_version,
+            version_diff,
+            target_path,
+            1);
+    }
+    else if (!err)
+    {
+        err = Longtail_ChangeVersionWithLocalCopy(
+            block_store_api,
+            storage_api,
+            hash_api,
+            job_api,
+            0,
+            0,
+            0,
+            store_index,
+            source_version,
+            target_version,
+            version_diff,
+            target_path,
+            1,
+            copy_source_version);
+    }
+    Longtail_Free(store_index);
+    Longtail_Free(version_diff);
+    return err;
+}
+
+// Shared setup for tests that submit and pull versions through an in-memory block store
+struct TestEnvironment
+{
+    struct Longtail_StorageAPI* m_StorageAPI;
+    struct Longtail_HashRegistryAPI* m_HashRegistryAPI;
+    struct Longtail_HashAPI* m_HashAPI;
+    struct Longtail_JobAPI* m_JobAPI;
+    struct Longtail_CompressionRegistryAPI* m_CompressionRegistryAPI;
+    struct Longtail_BlockStoreAPI* m_FSBlockStoreAPI;
+    struct Longtail_BlockStoreAPI* m_BlockStoreAPI;
+    struct Longtail_ChunkerAPI* m_ChunkerAPI;
+
+    TestEnvironment(uint32_t worker_count = 4)
+    {
+        m_StorageAPI = Longtail_CreateInMemStorageAPI();
+        m_HashRegistryAPI = Longtail_CreateFullHashRegistry();
+        m_HashAPI = 0;
+        m_HashRegistryAPI->GetHashAPI(m_HashRegistryAPI, Longtail_GetBlake3HashType(), &m_HashAPI);
+        m_JobAPI = Longtail_CreateBikeshedJobAPI(worker_count, 0);
+        m_CompressionRegistryAPI = Longtail_CreateFullCompressionRegistry();
+        m_FSBlockStoreAPI = Longtail_CreateFSBlockStoreAPI(m_JobAPI, m_StorageAPI, "store", 0, 0);
+        m_BlockStoreAPI = Longtail_CreateCompressBlockStoreAPIWithWorkers(m_FSBlockStoreAPI, m_CompressionRegistryAPI, 2);
+        m_ChunkerAPI = Longtail_CreateHPCDCChunkerAPI();
+    }
+    ~TestEnvironment()
+    {
+        SAFE_DISPOSE_API(m_ChunkerAPI);
+        SAFE_DISPOSE_API(m_BlockStoreAPI);
+        SAFE_DISPOSE_API(m_FSBlockStoreAPI);
+        SAFE_DISPOSE_API(m_CompressionRegistryAPI);
+        SAFE_DISPOSE_API(m_JobAPI);
+        SAFE_DISPOSE_API(m_HashRegistryAPI);
+        SAFE_DISPOSE_API(m_StorageAPI);
+    }
+    bool IsValid() const
+    {
+        return m_StorageAPI && m_HashAPI && m_JobAPI && m_CompressionRegistryAPI && m_FSBlockStoreAPI && m_BlockStoreAPI && m_ChunkerAPI;
+    }
+};
+
+////////////// Compression with workers
+
+TEST(CompressWithWorkersRoundTrip)
+{
+    struct Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
+    ASSERT_TRUE(compression_registry);
+
+    std::vector<uint8_t> data(5 * 1024 * 1024);
+    FillText(&data[0], data.size(), 1);
+
+    const uint32_t compression_types[] = { Longtail_GetZStdDefaultQuality(), Longtail_GetLZ4DefaultQuality() };
+    for (uint32_t t = 0; t < 2; ++t)
+    {
+        struct Longtail_CompressionAPI* compression_api;
+        uint32_t settings;
+        ASSERT_EQ(0, compression_registry->GetCompressionAPI(compression_registry, compression_types[t], &compression_api, &settings));
+        size_t max_compressed_size = compression_api->GetMaxCompressedSize(compression_api, settings, data.size());
+        for (uint32_t extra_worker_count = 0; extra_worker_count < 4; extra_worker_count += 3)
+        {
+            std::vector<char> compressed(max_compressed_size);
+            size_t compressed_size;
+            ASSERT_EQ(0, Longtail_CompressionAPI_CompressWithWorkers(compression_api, settings, extra_worker_count, (const char*)&data[0], &compressed[0], data.size(), max_compressed_size, &compressed_size));
+            ASSERT_TRUE(compressed_size < data.size());
+
+            std::vector<uint8_t> decompressed(data.size());
+            size_t decompressed_size;
+            ASSERT_EQ(0, compression_api->Decompress(compression_api, &compressed[0], (char*)&decompressed[0], compressed_size, decompressed.size(), &decompressed_size));
+            ASSERT_EQ(data.size(), decompressed_size);
+            ASSERT_TRUE(data == decompressed);
+        }
+    }
+    SAFE_DISPOSE_API(compression_registry);
+}
+
+TEST(CompressBlockStoreWithWorkersRoundTrip)
+{
+    TestEnvironment env;
+    ASSERT_TRUE(env.IsValid());
+
+    const uint32_t block_count = 12;
+    std::vector<std::vector<uint8_t> > block_datas(block_count);
+    for (uint32_t b = 0; b < block_count; ++b)
+    {
+        block_datas[b].resize(3 * 1024 * 1024 + b * 4096);
+        FillText(&block_datas[b][0], block_datas[b].size(), b + 1);
+    }
+
+    std::vector<TestAsyncPutStoredBlockComplete> put_cbs(block_count);
+    std::vector<struct Longtail_StoredBlock*> stored_blocks(block_count);
+    for (uint32_t b = 0; b < block_count; ++b)
+    {
+        stored_blocks[b] = CreateTestBlock(0x1000 * (b + 1), Longtail_GetZStdDefaultQuality(), block_datas[b], 4);
+        ASSERT_TRUE(stored_blocks[b]);
+        ASSERT_EQ(0, env.m_BlockStoreAPI->PutStoredBlock(env.m_BlockStoreAPI, stored_blocks[b], &put_cbs[b].m_API));
+    }
+    for (uint32_t b = 0; b < block_count; ++b)
+    {
+        ASSERT_EQ(0, put_cbs[b].Wait());
+        stored_blocks[b]->Dispose(stored_blocks[b]);
+    }
+    ASSERT_EQ(0, FlushBlockStore(env.m_BlockStoreAPI));
+
+    for (uint32_t b = 0; b < block_count; ++b)
+    {
+        struct Longtail_StoredBlock* stored_block;
+        ASSERT_EQ(0, GetStoredBlock(env.m_BlockStoreAPI, 0x1000 * (b + 1), &stored_block));
+        ASSERT_EQ(block_datas[b].size(), stored_block->m_BlockChunksDataSize);
+        ASSERT_EQ(0, memcmp(stored_block->m_BlockData, &block_datas[b][0], block_datas[b].size()));
+        stored_block->Dispose(stored_block);
+    }
+}
+
+////////////// Adaptive compression
+
+TEST(AdaptiveCompressBlockStoreKeepsBlockTag)
+{
+    TestEnvironment env;
+    ASSERT_TRUE(env.IsValid());
+    struct Longtail_BlockStoreAPI* block_store_api = Longtail_CreateAdaptiveCompressBlockStoreAPI(env.m_FSBlockStoreAPI, env.m_CompressionRegistryAPI, 0, 5);
+    ASSERT_TRUE(block_store_api);
+
+    const uint32_t tag = Longtail_GetZStdDefaultQuality();
+    std::vector<uint8_t> random_data(1024 * 1024);
+    FillRandom(&random_data[0], random_data.size(), 7);
+    std::vector<uint8_t> text_data(1024 * 1024);
+    FillText(&text_data[0], text_data.size(), 7);
+
+    struct Longtail_StoredBlock* random_block = CreateTestBlock(0x100, tag, random_data, 3);
+    struct Longtail_StoredBlock* text_block = CreateTestBlock(0x200, tag, text_data, 3);
+    ASSERT_TRUE(random_block && text_block);
+    ASSERT_EQ(0, PutStoredBlock(block_store_api, random_block));
+    ASSERT_EQ(0, PutStoredBlock(block_store_api, text_block));
+    random_block->Dispose(random_block);
+    text_block->Dispose(text_block);
+    ASSERT_EQ(0, FlushBlockStore(block_store_api));
+
+    // The backing store sees the original tag for both blocks, only the random one is stored as is
+    struct Longtail_StoredBlock* raw_block;
+    ASSERT_EQ(0, GetStoredBlock(env.m_FSBlockStoreAPI, 0x100, &raw_block));
+    ASSERT_EQ(tag, *raw_block->m_BlockIndex->m_Tag);
+    ASSERT_EQ(random_data.size() + 8, raw_block->m_BlockChunksDataSize);
+    ASSERT_EQ(0xffffffffu, ((const uint32_t*)raw_block->m_BlockData)[1]);
+    raw_block->Dispose(raw_block);
+
+    ASSERT_EQ(0, GetStoredBlock(env.m_FSBlockStoreAPI, 0x200, &raw_block));
+    ASSERT_EQ(tag, *raw_block->m_BlockIndex->m_Tag);
+    ASSERT_TRUE(raw_block->m_BlockChunksDataSize < text_data.size() / 2);
+    raw_block->Dispose(raw_block);
+
+    struct Longtail_StoredBlock* stored_block;
+    ASSERT_EQ(0, GetStoredBlock(block_store_api, 0x100, &stored_block));
+    ASSERT_EQ(tag, *stored_block->m_BlockIndex->m_Tag);
+    ASSERT_EQ(random_data.size(), stored_block->m_BlockChunksDataSize);
+    ASSERT_EQ(0, memcmp(stored_block->m_BlockData, &random_data[0], random_data.size()));
+    stored_block->Dispose(stored_block);
+
+    ASSERT_EQ(0, GetStoredBlock(block_store_api, 0x200, &stored_block));
+    ASSERT_EQ(text_data.size(), stored_block->m_BlockChunksDataSize);
+    ASSERT_EQ(0, memcmp(stored_block->m_BlockData, &text_data[0], text_data.size()));
+    stored_block->Dispose(stored_block);
+
+    SAFE_DISPOSE_API(block_store_api);
+}
+
+////////////// Version index formats and per asset chunk sizes
+
+TEST(VersionIndexSizeWithFormat)
+{
+    size_t size = Longtail_GetVersionIndexSize(3, 10, 12, 64);
+    ASSERT_EQ(size, Longtail_GetVersionIndexSizeWithFormat(3, 10, 12, 64, Longtail_GetHPCDCChunkerType(), 0));
+    size_t chunker_size = Longtail_GetVersionIndexSizeWithFormat(3, 10, 12, 64, Longtail_GetFastCDCChunkerType(), 0);
+    ASSERT_EQ(size + sizeof(uint32_t), chunker_size);
+    size_t flags_size = Longtail_GetVersionIndexSizeWithFormat(3, 10, 12, 64, 0, LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS);
+    ASSERT_EQ(size + 2 * sizeof(uint32_t), flags_size);
+    size_t chunk_sizes_size = Longtail_GetVersionIndexSizeWithFormat(3, 10, 12, 64, 0, LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES);
+    ASSERT_EQ(flags_size + 3 * sizeof(uint32_t), chunk_sizes_size);
+}
+
+TEST(BuildVersionIndexKeepsHPCDCFormat)
+{
+    const char* path = "file.bin";
+    uint64_t file_size = 100;
+    uint16_t permissions = 0644;
+    struct Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_MakeFileInfos(1, &path, &file_size, &permissions, &file_infos));
+
+    TLongtail_Hash path_hash = 1;
+    TLongtail_Hash content_hash = 2;
+    uint32_t asset_chunk_index_start = 0;
+    uint32_t asset_chunk_count = 1;
+    uint32_t asset_chunk_index = 0;
+    uint32_t chunk_size = 100;
+    TLongtail_Hash chunk_hash = 3;
+    uint32_t chunk_tag = 0;
+
+    size_t size = Longtail_GetVersionIndexSize(1, 1, 1, file_infos->m_PathDataSize);
+    std::vector<uint8_t> mem(size);
+    struct Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, Longtail_BuildVersionIndex(&mem[0], size, file_infos, &path_hash, &content_hash, &asset_chunk_index_start, &asset_chunk_count, 1, &asset_chunk_index, 1, &chunk_size, &chunk_hash, &chunk_tag, Longtail_GetBlake3HashType(), 32768, &version_index));
+    ASSERT_EQ(0u, Longtail_VersionIndex_GetChunkerIdentifier(version_index));
+    ASSERT_EQ(0u, Longtail_VersionIndex_GetFlags(version_index));
+    ASSERT_EQ((uint32_t)((0u << 24) | (0u << 16) | 2u), Longtail_VersionIndex_GetVersion(version_index));
+    ASSERT_EQ(0, version_index->m_ChunkerIdentifier);
+    ASSERT_EQ(0, version_index->m_Flags);
+
+    uint32_t asset_target_chunk_size = 16384;
+    size_t sized_size = Longtail_GetVersionIndexSizeWithFormat(1, 1, 1, file_infos->m_PathDataSize, Longtail_GetFastCDCChunkerType(), LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES);
+    std::vector<uint8_t> sized_mem(sized_size);
+    struct Longtail_VersionIndex* sized_version_index;
+    ASSERT_EQ(0, Longtail_BuildVersionIndexWithChunkSizes(&sized_mem[0], sized_size, file_infos, &path_hash, &content_hash, &asset_chunk_index_start, &asset_chunk_count, 1, &asset_chunk_index, 1, &chunk_size, &chunk_hash, &chunk_tag, &asset_target_chunk_size, Longtail_GetBlake3HashType(), Longtail_GetFastCDCChunkerType(), LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES, 32768, &sized_version_index));
+    ASSERT_EQ(Longtail_GetFastCDCChunkerType(), Longtail_VersionIndex_GetChunkerIdentifier(sized_version_index));
+    ASSERT_EQ(LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES, Longtail_VersionIndex_GetFlags(sized_version_index));
+    ASSERT_EQ(16384u, Longtail_VersionIndex_GetAssetTargetChunkSizes(sized_version_index)[0]);
+
+    Longtail_Free(file_infos);
+}
+
+TEST(VersionIndexAssetTargetChunkSizesRoundTrip)
+{
+    TestEnvironment env;
+    ASSERT_TRUE(env.IsValid());
+
+    std::vector<uint8_t> data(512 * 1024);
+    FillRandom(&data[0], data.size(), 3);
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "source/a.bin", data));
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "source/b.bin", data));
+
+    struct Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(env.m_StorageAPI, 0, 0, 0, "source", &file_infos));
+    ASSERT_EQ(2u, file_infos->m_Count);
+    std::vector<uint32_t> asset_target_chunk_sizes(2, 0);
+    asset_target_chunk_sizes[1] = 8192;
+
+    struct Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndexWithChunkSizes(env.m_StorageAPI, env.m_HashAPI, env.m_ChunkerAPI, env.m_JobAPI, 0, 0, 0, "source", file_infos, 0, &asset_target_chunk_sizes[0], 0, 65536, 0, &version_index));
+    ASSERT_EQ(LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES, Longtail_VersionIndex_GetFlags(version_index));
+    const uint32_t* recorded_chunk_sizes = Longtail_VersionIndex_GetAssetTargetChunkSizes(version_index);
+    ASSERT_TRUE(recorded_chunk_sizes);
+    ASSERT_EQ(0u, recorded_chunk_sizes[0]);
+    ASSERT_EQ(8192u, recorded_chunk_sizes[1]);
+    // The same content chunked with a smaller target chunk size ends up in more chunks
+    ASSERT_TRUE(version_index->m_AssetChunkCounts[1] > version_index->m_AssetChunkCounts[0]);
+
+    void* buffer;
+    size_t buffer_size;
+    ASSERT_EQ(0, Longtail_WriteVersionIndexToBuffer(version_index, &buffer, &buffer_size));
+    struct Longtail_VersionIndex* read_version_index;
+    ASSERT_EQ(0, Longtail_ReadVersionIndexFromBuffer(buffer, buffer_size, &read_version_index));
+    ASSERT_EQ(LONGTAIL_VERSION_INDEX_FLAG_ASSET_CHUNK_SIZES, Longtail_VersionIndex_GetFlags(read_version_index));
+    ASSERT_EQ(8192u, Longtail_VersionIndex_GetAssetTargetChunkSizes(read_version_index)[1]);
+    ASSERT_EQ(*version_index->m_ChunkCount, *read_version_index->m_ChunkCount);
+    Longtail_Free(read_version_index);
+    Longtail_Free(buffer);
+
+    // Without per asset sizes the version index keeps the 0.0.2 format
+    struct Longtail_VersionIndex* plain_version_index;
+    ASSERT_EQ(0, Longtail_CreateVersionIndex(env.m_StorageAPI, env.m_HashAPI, env.m_ChunkerAPI, env.m_JobAPI, 0, 0, 0, "source", file_infos, 0, 65536, 0, &plain_version_index));
+    ASSERT_EQ(0u, Longtail_VersionIndex_GetFlags(plain_version_index));
+    ASSERT_EQ(0, Longtail_VersionIndex_GetAssetTargetChunkSizes(plain_version_index));
+    ASSERT_EQ(0, plain_version_index->m_Flags);
+    Longtail_Free(plain_version_index);
+
+    Longtail_Free(version_index);
+    Longtail_Free(file_infos);
+}
+
+////////////// Trained zstd dictionaries
+
+TEST(ZStdDictionaryProbeAndCompress)
+{
+    std::vector<char> samples(64 * 2000);
+    std::vector<size_t> sample_sizes(2000);
+    size_t offset = 0;
+    for (uint32_t i = 0; i < 2000; ++i)
+    {
+        int length = snprintf(&samples[offset], 64, "{\"name\":\"asset_%u\",\"type\":\"mesh\",\"lod\":%u}", i, i % 4);
+        sample_sizes[i] = (size_t)length;
+        offset += (size_t)length;
+    }
+    void* dictionary;
+    size_t dictionary_size;
+    ASSERT_EQ(0, Longtail_TrainZStdDictionary(&samples[0], &sample_sizes[0], 2000, 4096, &dictionary, &dictionary_size));
+
+    std::vector<uint32_t> ids;
+    for (uint32_t probe = 0; probe < 64; ++probe)
+    {
+        uint32_t id;
+        ASSERT_EQ(0, Longtail_ProbeZStdDictionaryID(dictionary, dictionary_size, probe, &id));
+        ASSERT_TRUE(id >= 32768 && id <= 65535);
+        ASSERT_TRUE(std::find(ids.begin(), ids.end(), id) == ids.end());
+        ids.push_back(id);
+    }
+    uint32_t id;
+    ASSERT_EQ(0, Longtail_ProbeZStdDictionaryID(dictionary, dictionary_size, 0, &id));
+    ASSERT_EQ(ids[0], id);
+
+    struct Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
+    ASSERT_TRUE(compression_registry);
+    uint32_t added_id;
+    ASSERT_EQ(0, Longtail_AddZStdDictionary(compression_registry, dictionary, dictionary_size, &added_id));
+    ASSERT_EQ(id, added_id);
+    ASSERT_EQ(0, Longtail_AddZStdDictionary(compression_registry, dictionary, dictionary_size, &added_id));
+    ASSERT_TRUE(Longtail_HasZStdDictionary(compression_registry, id));
+
+    // A different dictionary with a colliding id is rejected until it moves on to its next probe
+    std::vector<char> other_dictionary((const char*)dictionary, (const char*)dictionary + dictionary_size);
+    other_dictionary[dictionary_size - 1] ^= 1;
+    ASSERT_EQ(EEXIST, Longtail_AddZStdDictionary(compression_registry, &other_dictionary[0], dictionary_size, &added_id));
+    uint32_t other_id;
+    ASSERT_EQ(0, Longtail_ProbeZStdDictionaryID(&other_dictionary[0], dictionary_size, 1, &other_id));
+    ASSERT_EQ(0, Longtail_AddZStdDictionary(compression_registry, &other_dictionary[0], dictionary_size, &added_id));
+    ASSERT_EQ(other_id, added_id);
+
+    uint32_t compression_type = Longtail_GetZStdDictionaryCompressionType(id, Longtail_GetZStdDefaultQuality());
+    ASSERT_EQ(id, Longtail_GetZStdDictionaryCompressionTypeID(compression_type));
+    struct Longtail_CompressionAPI* compression_api;
+    uint32_t settings;
+    ASSERT_EQ(0, compression_registry->GetCompressionAPI(compression_registry, compression_type, &compression_api, &settings));
+    const char* sample = &samples[sample_sizes[0]];
+    size_t max_compressed_size = compression_api->GetMaxCompressedSize(compression_api, settings, sample_sizes[1]);
+    std::vector<char> compressed(max_compressed_size);
+    size_t compressed_size;
+    ASSERT_EQ(0, compression_api->Compress(compression_api, settings, sample, &compressed[0], sample_sizes[1], max_compressed_size, &compressed_size));
+    std::vector<char> decompressed(sample_sizes[1]);
+    size_t decompressed_size;
+    ASSERT_EQ(0, compression_api->Decompress(compression_api, &compressed[0], &decompressed[0], compressed_size, decompressed.size(), &decompressed_size));
+    ASSERT_EQ(sample_sizes[1], decompressed_size);
+    ASSERT_EQ(0, memcmp(sample, &decompressed[0], decompressed_size));
+
+    SAFE_DISPOSE_API(compression_registry);
+    Longtail_Free(dictionary);
+}
+
+////////////// File infos
+
+TEST(MakeFileInfos)
+{
+    const char* paths[] = { "a.txt", "folder/", "folder/b.bin" };
+    const uint64_t sizes[] = { 10, 0, 1234567 };
+    const uint16_t permissions[] = { 0644, 0755, 0600 };
+    struct Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_MakeFileInfos(3, paths, sizes, permissions, &file_infos));
+    ASSERT_EQ(3u, Longtail_FileInfos_GetCount(file_infos));
+    for (uint32_t f = 0; f < 3; ++f)
+    {
+        ASSERT_EQ(0, strcmp(paths[f], Longtail_FileInfos_GetPath(file_infos, f)));
+        ASSERT_EQ(sizes[f], Longtail_FileInfos_GetSize(file_infos, f));
+        ASSERT_EQ(permissions[f], file_infos->m_Permissions[f]);
+    }
+    Longtail_Free(file_infos);
+}
+
+////////////// Chunking
+
+TEST(ChunkingAcrossPartsIsIndependentOfWorkers)
+{
+    struct Longtail_StorageAPI* storage_api = Longtail_CreateInMemStorageAPI();
+    struct Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    struct Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    ASSERT_TRUE(storage_api && hash_api && chunker_api);
+
+    // Larger than target_chunk_size * 1024 so the asset is chunked in parts
+    const uint32_t target_chunk_size = 4096;
+    std::vector<uint8_t> data(target_chunk_size * 1024 * 3 + 12345);
+    FillRandom(&data[0], data.size(), 11);
+    ASSERT_EQ(0, WriteTestFile(storage_api, "source/big.bin", data));
+
+    struct Longtail_VersionIndex* version_indexes[2];
+    const uint32_t worker_counts[2] = { 1, 8 };
+    for (uint32_t v = 0; v < 2; ++v)
+    {
+        struct Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(worker_counts[v], 0);
+        ASSERT_TRUE(job_api);
+        ASSERT_EQ(0, CreateVersionIndexForFolder(storage_api, hash_api, chunker_api, job_api, "source", 0, 0, 0, target_chunk_size, &version_indexes[v]));
+        SAFE_DISPOSE_API(job_api);
+    }
+    ASSERT_EQ(*version_indexes[0]->m_ChunkCount, *version_indexes[1]->m_ChunkCount);
+    ASSERT_EQ(0, memcmp(version_indexes[0]->m_ChunkHashes, version_indexes[1]->m_ChunkHashes, sizeof(TLongtail_Hash) * *version_indexes[0]->m_ChunkCount));
+    ASSERT_EQ(version_indexes[0]->m_ContentHashes[0], version_indexes[1]->m_ContentHashes[0]);
+
+    uint64_t total_size = 0;
+    for (uint32_t c = 0; c < *version_indexes[0]->m_ChunkCount; ++c)
+    {
+        total_size += version_indexes[0]->m_ChunkSizes[c];
+    }
+    ASSERT_EQ(data.size(), total_size);
+
+    Longtail_Free(version_indexes[1]);
+    Longtail_Free(version_indexes[0]);
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(hash_api);
+    SAFE_DISPOSE_API(storage_api);
+}
+
+#if defined(HPCDCSCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+TEST(HPCDCScanSIMDMatchesScalar)
+{
+    std::vector<uint32_t> table(256);
+    FillRandom((uint8_t*)&table[0], table.size() * sizeof(uint32_t), 5);
+    std::vector<uint8_t> data(1024 * 1024);
+    FillRandom(&data[0], data.size(), 9);
+
+    struct HPCDCScanParams params;
+    params.table = &table[0];
+    params.discriminator = 1021;
+    params.mod_magic = HPCDCScan_ModMagic(params.discriminator);
+
+    HPCDCScan_Func scan_funcs[3] = { 0, 0, 0 };
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        scan_funcs[0] = HPCDCScan_SSE41;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        scan_funcs[1] = HPCDCScan_AVX2;
+    }
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl"))
+    {
+        scan_funcs[2] = HPCDCScan_AVX512;
+    }
+    for (uint32_t f = 0; f < 3; ++f)
+    {
+        if (scan_funcs[f] == 0)
+        {
+            continue;
+        }
+        uint32_t scalar_pos = HPCDCScanWindowSize;
+        uint32_t scalar_hash = 0;
+        uint32_t simd_pos = HPCDCScanWindowSize;
+        uint32_t simd_hash = 0;
+        while (scalar_pos < data.size())
+        {
+            scalar_pos = HPCDCScan_Scalar(&params, &data[0], scalar_pos, (uint32_t)data.size(), &scalar_hash);
+            simd_pos = scan_funcs[f](&params, &data[0], simd_pos, (uint32_t)data.size(), &simd_hash);
+            ASSERT_EQ(scalar_pos, simd_pos);
+            ASSERT_EQ(scalar_hash, simd_hash);
+        }
+    }
+}
+#endif // defined(HPCDCSCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+
+TEST(ChunkerIdentifier)
+{
+    struct Longtail_ChunkerAPI* hpcdc_chunker_api = Longtail_CreateHPCDCChunkerAPI();
+    struct Longtail_ChunkerAPI* fastcdc_chunker_api = Longtail_CreateFastCDCChunkerAPI();
+    ASSERT_TRUE(hpcdc_chunker_api && fastcdc_chunker_api);
+    ASSERT_EQ(Longtail_GetHPCDCChunkerType(), Longtail_Chunker_GetIdentifier(hpcdc_chunker_api));
+    ASSERT_EQ(Longtail_GetFastCDCChunkerType(), Longtail_Chunker_GetIdentifier(fastcdc_chunker_api));
+    ASSERT_NE(Longtail_GetHPCDCChunkerType(), Longtail_GetFastCDCChunkerType());
+    SAFE_DISPOSE_API(fastcdc_chunker_api);
+    SAFE_DISPOSE_API(hpcdc_chunker_api);
+}
+
+TEST(FastCDCVersionRoundTrip)
+{
+    TestEnvironment env;
+    ASSERT_TRUE(env.IsValid());
+    struct Longtail_ChunkerAPI* chunker_api = Longtail_CreateFastCDCChunkerAPI();
+    ASSERT_TRUE(chunker_api);
+
+    std::vector<uint8_t> data(700 * 1024);
+    FillText(&data[0], data.size(), 21);
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "source/text.txt", data));
+    FillRandom(&data[0], data.size(), 21);
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "source/sub/random.bin", data));
+
+    struct Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, CreateVersionIndexForFolder(env.m_StorageAPI, env.m_HashAPI, chunker_api, env.m_JobAPI, "source", Longtail_GetZStdDefaultQuality(), 0, 0, 16384, &version_index));
+    ASSERT_EQ(Longtail_GetFastCDCChunkerType(), Longtail_VersionIndex_GetChunkerIdentifier(version_index));
+    ASSERT_EQ((uint32_t)((0u << 24) | (0u << 16) | 3u), Longtail_VersionIndex_GetVersion(version_index));
+
+    struct Longtail_StoreIndex* store_index;
+    ASSERT_EQ(0, WriteVersionContent(env.m_StorageAPI, env.m_HashAPI, env.m_JobAPI, env.m_BlockStoreAPI, version_index, "source", LONGTAIL_BLOCK_PACKING_VERSION_ORDER, &store_index));
+    ASSERT_EQ(0, Longtail_WriteVersion(env.m_BlockStoreAPI, env.m_StorageAPI, env.m_JobAPI, 0, 0, 0, store_index, version_index, "target", 1));
+    ASSERT_TRUE(FoldersMatch(env.m_StorageAPI, "source", "target"));
+
+    Longtail_Free(store_index);
+    Longtail_Free(version_index);
+    SAFE_DISPOSE_API(chunker_api);
+}
+
+////////////// Hashing
+
+TEST(HashBuffersMatchesHashBuffer)
+{
+    struct Longtail_HashRegistryAPI* hash_registry = Longtail_CreateFullHashRegistry();
+    ASSERT_TRUE(hash_registry);
+
+    const uint32_t buffer_count = 37;
+    std::vector<uint8_t> data(buffer_count * 2048);
+    FillRandom(&data[0], data.size(), 13);
+    std::vector<uint32_t> lengths(buffer_count);
+    std::vector<const void*> datas(buffer_count);
+    uint32_t offset = 0;
+    for (uint32_t b = 0; b < buffer_count; ++b)
+    {
+        lengths[b] = (b * 97) % 2048;
+        datas[b] = &data[offset];
+        offset += lengths[b];
+    }
+
+    const uint32_t hash_types[] = { Longtail_GetBlake3HashType(), Longtail_GetXXH3HashType() };
+    for (uint32_t t = 0; t < 2; ++t)
+    {
+        struct Longtail_HashAPI* hash_api;
+        ASSERT_EQ(0, hash_registry->GetHashAPI(hash_registry, hash_types[t], &hash_api));
+        std::vector<uint64_t> hashes(buffer_count);
+        ASSERT_EQ(0, Longtail_Hash_HashBuffers(hash_api, buffer_count, &lengths[0], &datas[0], &hashes[0]));
+        for (uint32_t b = 0; b < buffer_count; ++b)
+        {
+            uint64_t hash;
+            ASSERT_EQ(0, Longtail_Hash_HashBuffer(hash_api, lengths[b], datas[b], &hash));
+            ASSERT_EQ(hash, hashes[b]);
+        }
+    }
+    SAFE_DISPOSE_API(hash_registry);
+}
+
+TEST(XXH3HashAPI)
+{
+    struct Longtail_HashRegistryAPI* hash_registry = Longtail_CreateFullHashRegistry();
+    ASSERT_TRUE(hash_registry);
+    struct Longtail_HashAPI* hash_api;
+    ASSERT_EQ(0, hash_registry->GetHashAPI(hash_registry, Longtail_GetXXH3HashType(), &hash_api));
+    ASSERT_EQ(Longtail_GetXXH3HashType(), Longtail_Hash_GetIdentifier(hash_api));
+
+    std::vector<uint8_t> data(100000);
+    FillRandom(&data[0], data.size(), 17);
+    uint64_t hash;
+    ASSERT_EQ(0, Longtail_Hash_HashBuffer(hash_api, (uint32_t)data.size(), &data[0], &hash));
+
+    // Hashing in pieces gives the same hash as hashing the whole buffer
+    Longtail_HashAPI_HContext context;
+    ASSERT_EQ(0, Longtail_Hash_BeginContext(hash_api, &context));
+    Longtail_Hash_Hash(hash_api, context, 1000, &data[0]);
+    Longtail_Hash_Hash(hash_api, context, 49000, &data[1000]);
+    Longtail_Hash_Hash(hash_api, context, 50000, &data[50000]);
+    ASSERT_EQ(hash, Longtail_Hash_EndContext(hash_api, context));
+
+    data[50000] ^= 1;
+    uint64_t changed_hash;
+    ASSERT_EQ(0, Longtail_Hash_HashBuffer(hash_api, (uint32_t)data.size(), &data[0], &changed_hash));
+    ASSERT_NE(hash, changed_hash);
+    SAFE_DISPOSE_API(hash_registry);
+}
+
+TEST(FileFingerprints)
+{
+    TestEnvironment env;
+    ASSERT_TRUE(env.IsValid());
+
+    std::vector<uint8_t> data(300 * 1024);
+    FillRandom(&data[0], data.size(), 19);
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "source/folder/a.bin", data));
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "source/empty.bin", std::vector<uint8_t>()));
+
+    struct Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(env.m_StorageAPI, 0, 0, 0, "source", &file_infos));
+    std::vector<TLongtail_Hash> fingerprints(file_infos->m_Count);
+    ASSERT_EQ(0, Longtail_GetFileFingerprints(env.m_StorageAPI, env.m_HashAPI, env.m_JobAPI, 0, 0, 0, "source", file_infos, &fingerprints[0]));
+    for (uint32_t f = 0; f < file_infos->m_Count; ++f)
+    {
+        const char* path = Longtail_FileInfos_GetPath(file_infos, f);
+        if (strcmp(path, "folder/") == 0)
+        {
+            ASSERT_EQ(0u, fingerprints[f]);
+        }
+        else if (strcmp(path, "folder/a.bin") == 0)
+        {
+            uint64_t hash;
+            ASSERT_EQ(0, Longtail_Hash_HashBuffer(env.m_HashAPI, (uint32_t)data.size(), &data[0], &hash));
+            ASSERT_EQ(hash, fingerprints[f]);
+        }
+    }
+    Longtail_Free(file_infos);
+}
+
+////////////// File system
+
+#if defined(__linux__)
+TEST(IOUringStorageRead)
+{
+    struct Longtail_StorageAPI* io_uring_storage_api = Longtail_CreateFSStorageAPIWithIOUring(16, 1024 * 1024);
+    if (io_uring_storage_api == 0)
+    {
+        printf("io_uring is not available, skipping\n");
+        return;
+    }
+    struct Longtail_StorageAPI* storage_api = Longtail_CreateFSStorageAPI();
+    ASSERT_TRUE(storage_api);
+
+    char* temp_folder = Longtail_GetTempFolder();
+    ASSERT_TRUE(temp_folder);
+    char file_name[64];
+    snprintf(file_name, sizeof(file_name), "longtail_test_io_uring_%u.bin", (uint32_t)Longtail_GetProcessIdentity());
+    char* path = Longtail_ConcatPath(temp_folder, file_name);
+    std::vector<uint8_t> data(3 * 1024 * 1024 + 777);
+    FillRandom(&data[0], data.size(), 23);
+    ASSERT_EQ(0, WriteTestFile(storage_api, path, data));
+
+    Longtail_StorageAPI_HOpenFile f;
+    ASSERT_EQ(0, io_uring_storage_api->OpenReadFile(io_uring_storage_api, path, &f));
+    std::vector<uint8_t> read_data(data.size());
+    ASSERT_EQ(0, io_uring_storage_api->Read(io_uring_storage_api, f, 0, data.size(), &read_data[0]));
+    ASSERT_TRUE(data == read_data);
+    std::vector<uint8_t> part(100000);
+    ASSERT_EQ(0, io_uring_storage_api->Read(io_uring_storage_api, f, 12345, part.size(), &part[0]));
+    ASSERT_EQ(0, memcmp(&part[0], &data[12345], part.size()));
+    io_uring_storage_api->CloseFile(io_uring_storage_api, f);
+
+    Longtail_RemoveFile(path);
+    Longtail_Free(path);
+    Longtail_Free(temp_folder);
+    SAFE_DISPOSE_API(storage_api);
+    SAFE_DISPOSE_API(io_uring_storage_api);
+}
+#endif // defined(__linux__)
+
+TEST(GetFilesRecursivelyWithJobsMatchesGetFilesRecursively)
+{
+    TestEnvironment env;
+    ASSERT_TRUE(env.IsValid());
+
+    std::vector<uint8_t> data(100);
+    for (uint32_t d = 0; d < 6; ++d)
+    {
+        for (uint32_t f = 0; f < 5; ++f)
+        {
+            char path[128];
+            snprintf(path, sizeof(path), "source/dir%u/sub%u/file%u.txt", d, f % 2, f);
+            data.resize(100 + d * 10 + f);
+            ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, path, data));
+        }
+    }
+
+    struct Longtail_FileInfos* file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursively(env.m_StorageAPI, 0, 0, 0, "source", &file_infos));
+    struct Longtail_FileInfos* job_file_infos;
+    ASSERT_EQ(0, Longtail_GetFilesRecursivelyWithJobs(env.m_StorageAPI, env.m_JobAPI, 0, 0, 0, "source", &job_file_infos));
+    ASSERT_EQ(file_infos->m_Count, job_file_infos->m_Count);
+    for (uint32_t f = 0; f < file_infos->m_Count; ++f)
+    {
+        ASSERT_EQ(0, strcmp(Longtail_FileInfos_GetPath(file_infos, f), Longtail_FileInfos_GetPath(job_file_infos, f)));
+        ASSERT_EQ(Longtail_FileInfos_GetSize(file_infos, f), Longtail_FileInfos_GetSize(job_file_infos, f));
+    }
+    Longtail_Free(job_file_infos);
+    Longtail_Free(file_infos);
+}
+
+////////////// Block packing and store indexes
+
+TEST(CreateMissingContentWithLocalityPacking)
+{
+    TestEnvironment env;
+    ASSERT_TRUE(env.IsValid());
+
+    std::vector<uint8_t> data(20 * 1024);
+    const char* paths[] = { "source/b/mesh.bin", "source/a/texture.png", "source/a/mesh.bin", "source/c/sound.wav" };
+    for (uint32_t f = 0; f < 4; ++f)
+    {
+        FillRandom(&data[0], data.size(), 31 + f);
+        ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, paths[f], data));
+    }
+    struct Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, CreateVersionIndexForFolder(env.m_StorageAPI, env.m_HashAPI, env.m_ChunkerAPI, env.m_JobAPI, "source", 0, 0, 0, 4096, &version_index));
+
+    struct Longtail_StoreIndex* empty_store_index;
+    ASSERT_EQ(0, Longtail_CreateStoreIndexFromBlocks(0, 0, &empty_store_index));
+    struct Longtail_StoreIndex* store_index;
+    ASSERT_EQ(0, Longtail_CreateMissingContentWithPacking(env.m_HashAPI, empty_store_index, version_index, 48 * 1024, 1024, LONGTAIL_BLOCK_PACKING_LOCALITY, &store_index));
+    ASSERT_EQ(*version_index->m_ChunkCount, *store_index->m_ChunkCount);
+
+    // Every asset fits in a block so all of its chunks end up in the same block
+    for (uint32_t a = 0; a < *version_index->m_AssetCount; ++a)
+    {
+        uint32_t chunk_count = version_index->m_AssetChunkCounts[a];
+        if (chunk_count == 0)
+        {
+            continue;
+        }
+        uint32_t asset_block = 0xffffffffu;
+        for (uint32_t c = 0; c < chunk_count; ++c)
+        {
+            TLongtail_Hash chunk_hash = version_index->m_ChunkHashes[version_index->m_AssetChunkIndexes[version_index->m_AssetChunkIndexStarts[a] + c]];
+            uint32_t chunk_block = 0xffffffffu;
+            for (uint32_t b = 0; b < *store_index->m_BlockCount && chunk_block == 0xffffffffu; ++b)
+            {
+                uint32_t block_chunk_start = store_index->m_BlockChunksOffsets[b];
+                for (uint32_t bc = 0; bc < store_index->m_BlockChunkCounts[b]; ++bc)
+                {
+                    if (store_index->m_ChunkHashes[block_chunk_start + bc] == chunk_hash)
+                    {
+                        chunk_block = b;
+                        break;
+                    }
+                }
+            }
+            ASSERT_NE(0xffffffffu, chunk_block);
+            if (asset_block == 0xffffffffu)
+            {
+                asset_block = chunk_block;
+            }
+            ASSERT_EQ(asset_block, chunk_block);
+        }
+    }
+
+    Longtail_Free(store_index);
+    Longtail_Free(empty_store_index);
+    Longtail_Free(version_index);
+}
+
+TEST(SplitStoreIndex)
+{
+    struct Longtail_HashAPI* hash_api = Longtail_CreateBlake3HashAPI();
+    ASSERT_TRUE(hash_api);
+    const uint32_t chunk_count = 1000;
+    std::vector<TLongtail_Hash> chunk_hashes(chunk_count);
+    std::vector<uint32_t> chunk_sizes(chunk_count);
+    for (uint32_t c = 0; c < chunk_count; ++c)
+    {
+        chunk_hashes[c] = 0x10000 + c;
+        chunk_sizes[c] = 1000 + c;
+    }
+    struct Longtail_StoreIndex* store_index;
+    ASSERT_EQ(0, Longtail_CreateStoreIndex(hash_api, chunk_count, &chunk_hashes[0], &chunk_sizes[0], 0, 16 * 1024, 16, &store_index));
+
+    struct Longtail_StoreIndex** split_store_indexes;
+    uint64_t split_count;
+    ASSERT_EQ(0, Longtail_SplitStoreIndex(store_index, 2048, &split_store_indexes, &split_count));
+    ASSERT_TRUE(split_count > 1);
+    uint32_t block_count = 0;
+    uint32_t split_chunk_count = 0;
+    for (uint64_t s = 0; s < split_count; ++s)
+    {
+        block_count += *split_store_indexes[s]->m_BlockCount;
+        split_chunk_count += *split_store_indexes[s]->m_ChunkCount;
+        Longtail_Free(split_store_indexes[s]);
+    }
+    Longtail_Free(split_store_indexes);
+    ASSERT_EQ(*store_index->m_BlockCount, block_count);
+    ASSERT_EQ(*store_index->m_ChunkCount, split_chunk_count);
+
+    Longtail_Free(store_index);
+    SAFE_DISPOSE_API(hash_api);
+}
+
+TEST(MergeVersionIndexWithRemovedFiles)
+{
+    TestEnvironment env;
+    ASSERT_TRUE(env.IsValid());
+
+    std::vector<uint8_t> data(1000);
+    FillRandom(&data[0], data.size(), 41);
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "base/a.bin", data));
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "base/b.bin", data));
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "base/c.bin", data));
+    FillRandom(&data[0], data.size(), 43);
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "overlay/d.bin", data));
+
+    struct Longtail_VersionIndex* base_version_index;
+    ASSERT_EQ(0, CreateVersionIndexForFolder(env.m_StorageAPI, env.m_HashAPI, env.m_ChunkerAPI, env.m_JobAPI, "base", 0, 0, 0, 4096, &base_version_index));
+    struct Longtail_VersionIndex* overlay_version_index;
+    ASSERT_EQ(0, CreateVersionIndexForFolder(env.m_StorageAPI, env.m_HashAPI, env.m_ChunkerAPI, env.m_JobAPI, "overlay", 0, 0, 0, 4096, &overlay_version_index));
+
+    TLongtail_Hash removed_path_hash;
+    ASSERT_EQ(0, Longtail_GetPathHash(env.m_HashAPI, "b.bin", &removed_path_hash));
+    struct Longtail_VersionIndex* merged_version_index;
+    ASSERT_EQ(0, Longtail_MergeVersionIndex(base_version_index, overlay_version_index, &removed_path_hash, 1, &merged_version_index));
+
+    std::vector<std::string> paths;
+    for (uint32_t a = 0; a < *merged_version_index->m_AssetCount; ++a)
+    {
+        paths.push_back(&merged_version_index->m_NameData[merged_version_index->m_NameOffsets[a]]);
+    }
+    std::sort(paths.begin(), paths.end());
+    ASSERT_EQ(3u, paths.size());
+    ASSERT_TRUE(paths[0] == "a.bin");
+    ASSERT_TRUE(paths[1] == "c.bin");
+    ASSERT_TRUE(paths[2] == "d.bin");
+
+    Longtail_Free(merged_version_index);
+    Longtail_Free(overlay_version_index);
+    Longtail_Free(base_version_index);
+}
+
+////////////// Pull
+
+TEST(PrefetchBlockStoreChangeVersion)
+{
+    TestEnvironment env;
+    ASSERT_TRUE(env.IsValid());
+
+    std::vector<uint8_t> data(200 * 1024);
+    for (uint32_t f = 0; f < 8; ++f)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "source/file%u.txt", f);
+        FillText(&data[0], data.size(), 51 + f);
+        ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, path, data));
+    }
+    struct Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, CreateVersionIndexForFolder(env.m_StorageAPI, env.m_HashAPI, env.m_ChunkerAPI, env.m_JobAPI, "source", Longtail_GetZStdDefaultQuality(), 0, 0, 16384, &version_index));
+    struct Longtail_StoreIndex* store_index;
+    ASSERT_EQ(0, WriteVersionContent(env.m_StorageAPI, env.m_HashAPI, env.m_JobAPI, env.m_BlockStoreAPI, version_index, "source", LONGTAIL_BLOCK_PACKING_LOCALITY, &store_index));
+
+    struct Longtail_BlockStoreAPI* prefetch_block_store_api = Longtail_CreatePrefetchBlockStoreAPI(env.m_BlockStoreAPI, 2, 256 * 1024);
+    ASSERT_TRUE(prefetch_block_store_api);
+    struct Longtail_VersionIndex* empty_version_index;
+    ASSERT_EQ(0, CreateEmptyVersionIndex(env.m_StorageAPI, env.m_HashAPI, env.m_ChunkerAPI, env.m_JobAPI, 16384, &empty_version_index));
+    ASSERT_EQ(0, PullVersion(env.m_StorageAPI, env.m_HashAPI, env.m_JobAPI, prefetch_block_store_api, empty_version_index, version_index, "target", 0));
+    ASSERT_TRUE(FoldersMatch(env.m_StorageAPI, "source", "target"));
+
+    SAFE_DISPOSE_API(prefetch_block_store_api);
+    Longtail_Free(empty_version_index);
+    Longtail_Free(store_index);
+    Longtail_Free(version_index);
+}
+
+TEST(StreamWrittenHint)
+{
+    struct Longtail_StorageAPI* mem_storage_api = Longtail_CreateInMemStorageAPI();
+    struct Longtail_StorageAPI* fs_storage_api = Longtail_CreateFSStorageAPI();
+    ASSERT_TRUE(mem_storage_api && fs_storage_api);
+    ASSERT_EQ(0, mem_storage_api->StreamWritten);
+    ASSERT_NE(0, fs_storage_api->StreamWritten);
+
+    std::vector<uint8_t> data(64 * 1024);
+    FillRandom(&data[0], data.size(), 61);
+    ASSERT_EQ(0, WriteTestFile(mem_storage_api, "file.bin", data));
+    Longtail_StorageAPI_HOpenFile f;
+    ASSERT_EQ(0, mem_storage_api->OpenWriteFile(mem_storage_api, "file.bin", data.size(), &f));
+    ASSERT_EQ(0, mem_storage_api->Write(mem_storage_api, f, 0, data.size(), &data[0]));
+    ASSERT_EQ(0, Longtail_Storage_StreamWritten(mem_storage_api, f, 0, data.size()));
+    mem_storage_api->CloseFile(mem_storage_api, f);
+
+    char* temp_folder = Longtail_GetTempFolder();
+    ASSERT_TRUE(temp_folder);
+    char file_name[64];
+    snprintf(file_name, sizeof(file_name), "longtail_test_stream_%u.bin", (uint32_t)Longtail_GetProcessIdentity());
+    char* path = Longtail_ConcatPath(temp_folder, file_name);
+    std::vector<uint8_t> big_data(20 * 1024 * 1024);
+    FillRandom(&big_data[0], big_data.size(), 63);
+    ASSERT_EQ(0, fs_storage_api->OpenWriteFile(fs_storage_api, path, big_data.size(), &f));
+    for (size_t offset = 0; offset < big_data.size(); offset += 4 * 1024 * 1024)
+    {
+        ASSERT_EQ(0, fs_storage_api->Write(fs_storage_api, f, offset, 4 * 1024 * 1024, &big_data[offset]));
+        ASSERT_EQ(0, Longtail_Storage_StreamWritten(fs_storage_api, f, offset, 4 * 1024 * 1024));
+    }
+    fs_storage_api->CloseFile(fs_storage_api, f);
+    std::vector<uint8_t> read_data;
+    ASSERT_EQ(0, ReadTestFile(fs_storage_api, path, read_data));
+    ASSERT_TRUE(big_data == read_data);
+
+    Longtail_RemoveFile(path);
+    Longtail_Free(path);
+    Longtail_Free(temp_folder);
+    SAFE_DISPOSE_API(fs_storage_api);
+    SAFE_DISPOSE_API(mem_storage_api);
+}
+
+TEST(ZeroChunksRoundTrip)
+{
+    TestEnvironment env;
+    ASSERT_TRUE(env.IsValid());
+
+    std::vector<uint8_t> data(1024 * 1024);
+    FillRandom(&data[0], 256 * 1024, 71);
+    FillRandom(&data[768 * 1024], 256 * 1024, 73);
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "source/sparse.bin", data));
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "source/zeros.bin", std::vector<uint8_t>(300 * 1024, 0)));
+
+    struct Longtail_VersionIndex* version_index;
+    ASSERT_EQ(0, CreateVersionIndexForFolder(env.m_StorageAPI, env.m_HashAPI, env.m_ChunkerAPI, env.m_JobAPI, "source", Longtail_GetZStdDefaultQuality(), 0, LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS, 16384, &version_index));
+    ASSERT_EQ(LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS, Longtail_VersionIndex_GetFlags(version_index));
+    uint32_t zero_chunk_count = 0;
+    for (uint32_t c = 0; c < *version_index->m_ChunkCount; ++c)
+    {
+        if (Longtail_IsZeroChunk(version_index, c))
+        {
+            ASSERT_EQ(Longtail_GetZeroChunkHash(version_index->m_ChunkSizes[c]), version_index->m_ChunkHashes[c]);
+            ++zero_chunk_count;
+        }
+    }
+    ASSERT_TRUE(zero_chunk_count > 0);
+    ASSERT_NE(Longtail_GetZeroChunkHash(4096), Longtail_GetZeroChunkHash(8192));
+
+    struct Longtail_StoreIndex* store_index;
+    ASSERT_EQ(0, WriteVersionContent(env.m_StorageAPI, env.m_HashAPI, env.m_JobAPI, env.m_BlockStoreAPI, version_index, "source", LONGTAIL_BLOCK_PACKING_VERSION_ORDER, &store_index));
+    ASSERT_EQ(*version_index->m_ChunkCount - zero_chunk_count, *store_index->m_ChunkCount);
+
+    struct Longtail_VersionIndex* empty_version_index;
+    ASSERT_EQ(0, CreateEmptyVersionIndex(env.m_StorageAPI, env.m_HashAPI, env.m_ChunkerAPI, env.m_JobAPI, 16384, &empty_version_index));
+    ASSERT_EQ(0, PullVersion(env.m_StorageAPI, env.m_HashAPI, env.m_JobAPI, env.m_BlockStoreAPI, empty_version_index, version_index, "target", 0));
+    ASSERT_TRUE(FoldersMatch(env.m_StorageAPI, "source", "target"));
+
+    Longtail_Free(empty_version_index);
+    Longtail_Free(store_index);
+    Longtail_Free(version_index);
+}
+
+TEST(ChangeVersionWithLocalCopy)
+{
+    TestEnvironment env;
+    ASSERT_TRUE(env.IsValid());
+
+    std::vector<uint8_t> data(150 * 1024);
+    FillRandom(&data[0], data.size(), 81);
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "v1/original.bin", data));
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "v2/moved/renamed.bin", data));
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "v2/duplicate.bin", data));
+    std::vector<uint8_t> other_data(40 * 1024);
+    FillRandom(&other_data[0], other_data.size(), 83);
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "v2/new.bin", other_data));
+
+    struct Longtail_VersionIndex* v1_version_index;
+    ASSERT_EQ(0, CreateVersionIndexForFolder(env.m_StorageAPI, env.m_HashAPI, env.m_ChunkerAPI, env.m_JobAPI, "v1", 0, 0, 0, 16384, &v1_version_index));
+    struct Longtail_VersionIndex* v2_version_index;
+    ASSERT_EQ(0, CreateVersionIndexForFolder(env.m_StorageAPI, env.m_HashAPI, env.m_ChunkerAPI, env.m_JobAPI, "v2", 0, 0, 0, 16384, &v2_version_index));
+
+    // Only the new file is uploaded, the moved and duplicated content has to come from the local copy
+    struct Longtail_StoreIndex* store_index;
+    ASSERT_EQ(0, WriteVersionContent(env.m_StorageAPI, env.m_HashAPI, env.m_JobAPI, env.m_BlockStoreAPI, v2_version_index, "v2", LONGTAIL_BLOCK_PACKING_VERSION_ORDER, &store_index));
+    Longtail_Free(store_index);
+
+    ASSERT_EQ(0, WriteTestFile(env.m_StorageAPI, "target/original.bin", data));
+    ASSERT_EQ(0, Longtail_Storage_CopyFile(env.m_StorageAPI, "target/original.bin", "copy.bin"));
+    std::vector<uint8_t> copied_data;
+    ASSERT_EQ(0, ReadTestFile(env.m_StorageAPI, "copy.bin", copied_data));
+    ASSERT_TRUE(copied_data == data);
+
+    ASSERT_EQ(0, PullVersion(env.m_StorageAPI, env.m_HashAPI, env.m_JobAPI, env.m_BlockStoreAPI, v1_version_index, v2_version_index, "target", v1_version_index));
+    ASSERT_TRUE(FoldersMatch(env.m_StorageAPI, "v2", "target"));
+    ASSERT_FALSE(env.m_StorageAPI->IsFile(env.m_StorageAPI, "target/original.bin"));
+
+    Longtail_Free(v2_version_index);
+    Longtail_Free(v1_version_index);
+}
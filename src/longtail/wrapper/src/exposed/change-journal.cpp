@@ -0,0 +1,69 @@
+#include "../util/change-journal.h"
+#include "main.h"
+
+// Opens a change journal for LocalRootPath, returns null if the platform has
+// no change journal or it could not be started, the caller then has to find
+// changes by scanning the workspace
+DLL_EXPORT ChangeJournal* OpenChangeJournal(
+    const char* LocalRootPath,
+    int LogLevel) {
+  SetLogging(LogLevel);
+
+  ChangeJournal* journal = nullptr;
+  int err = CreateChangeJournal(LocalRootPath, &journal);
+  if (err) {
+    if (err != ENOTSUP) {
+      std::cerr << "Failed to open change journal for " << LocalRootPath << ", " << err << std::endl;
+    }
+    return nullptr;
+  }
+  return journal;
+}
+
+DLL_EXPORT ChangeJournalChanges* GetChangeJournalChanges(
+    ChangeJournal* Journal,
+    uint64_t Cursor) {
+  if (!Journal) {
+    return nullptr;
+  }
+
+  uint64_t cursor = 0;
+  bool full_scan_required = true;
+  std::vector<std::string> paths;
+  int err = ReadChangeJournal(Journal, Cursor, &cursor, &full_scan_required, paths);
+  if (err) {
+    return nullptr;
+  }
+
+  // The paths are stored in the same allocation, after the array of pointers
+  size_t path_data_size = 0;
+  for (const std::string& path : paths) {
+    path_data_size += path.size() + 1;
+  }
+  size_t size = sizeof(ChangeJournalChanges) + sizeof(const char*) * paths.size() + path_data_size;
+  ChangeJournalChanges* changes = (ChangeJournalChanges*)Longtail_Alloc(0, size);
+  if (!changes) {
+    return nullptr;
+  }
+  changes->Cursor = cursor;
+  changes->FullScanRequired = full_scan_required ? 1 : 0;
+  changes->NumPaths = (uint32_t)paths.size();
+  changes->Paths = (const char**)&changes[1];
+  char* path_data = (char*)&changes->Paths[paths.size()];
+  for (size_t i = 0; i < paths.size(); ++i) {
+    memcpy(path_data, paths[i].c_str(), paths[i].size() + 1);
+    changes->Paths[i] = path_data;
+    path_data += paths[i].size() + 1;
+  }
+  return changes;
+}
+
+DLL_EXPORT void FreeChangeJournalChanges(ChangeJournalChanges* Changes) {
+  if (Changes) {
+    Longtail_Free(Changes);
+  }
+}
+
+DLL_EXPORT void CloseChangeJournal(ChangeJournal* Journal) {
+  DisposeChangeJournal(Journal);
+}
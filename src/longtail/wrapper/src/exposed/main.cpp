@@ -68,6 +68,22 @@ uint32_t ParseCompressionType(const char* compression_algorithm) {
   if (strcmp("zstd_low", compression_algorithm) == 0) {
     return Longtail_GetZStdLowQuality();
   }
+  // Dictionary id zero is resolved to the repository dictionary at submit
+  if (strcmp("zstd_dict", compression_algorithm) == 0) {
+    return Longtail_GetZStdDictionaryCompressionType(0, Longtail_GetZStdDefaultQuality());
+  }
+  if (strcmp("zstd_dict_min", compression_algorithm) == 0) {
+    return Longtail_GetZStdDictionaryCompressionType(0, Longtail_GetZStdMinQuality());
+  }
+  if (strcmp("zstd_dict_max", compression_algorithm) == 0) {
+    return Longtail_GetZStdDictionaryCompressionType(0, Longtail_GetZStdMaxQuality());
+  }
+  if (strcmp("zstd_dict_high", compression_algorithm) == 0) {
+    return Longtail_GetZStdDictionaryCompressionType(0, Longtail_GetZStdHighQuality());
+  }
+  if (strcmp("zstd_dict_low", compression_algorithm) == 0) {
+    return Longtail_GetZStdDictionaryCompressionType(0, Longtail_GetZStdLowQuality());
+  }
   return 0xffffffff;
 }
 
@@ -81,9 +97,33 @@ uint32_t ParseHashingType(const char* hashing_type) {
   if (strcmp("meow", hashing_type) == 0) {
     return Longtail_GetMeowHashType();
   }
+  if (strcmp("xxh3", hashing_type) == 0) {
+    return Longtail_GetXXH3HashType();
+  }
   return 0xffffffff;
 }
 
+uint32_t ParseChunkingType(const char* chunking_type) {
+  if (0 == chunking_type || (strcmp("hpcdc", chunking_type) == 0)) {
+    return Longtail_GetHPCDCChunkerType();
+  }
+  if (strcmp("fastcdc", chunking_type) == 0) {
+    return Longtail_GetFastCDCChunkerType();
+  }
+  return 0xffffffff;
+}
+
+// Chunker types are the identifiers recorded in version indexes, returns 0 for unknown types
+struct Longtail_ChunkerAPI* CreateChunkerAPI(uint32_t chunker_type) {
+  if (chunker_type == Longtail_GetHPCDCChunkerType()) {
+    return Longtail_CreateHPCDCChunkerAPI();
+  }
+  if (chunker_type == Longtail_GetFastCDCChunkerType()) {
+    return Longtail_CreateFastCDCChunkerAPI();
+  }
+  return 0;
+}
+
 void SetHandleStep(WrapperAsyncHandle* handle, const char* step) {
   LONGTAIL_LOG(0, LONGTAIL_LOG_LEVEL_DEBUG, "SetHandleStep: %s", step);
   if (handle->changingStep) {
@@ -11,6 +11,7 @@
 #include <compressblockstore/longtail_compressblockstore.h>
 #include <compressionregistry/longtail_full_compression_registry.h>
 #include <curl/curl.h>
+#include <fastcdcchunker/longtail_fastcdcchunker.h>
 #include <filestorage/longtail_filestorage.h>
 #include <fsblockstore/longtail_fsblockstore.h>
 #include <hashregistry/longtail_full_hash_registry.h>
@@ -20,6 +21,7 @@
 #include <lz4/longtail_lz4.h>
 #include <meowhash/longtail_meowhash.h>
 #include <ratelimitedprogress/longtail_ratelimitedprogress.h>
+#include <xxhash/longtail_xxhash.h>
 #include <zstd/longtail_zstd.h>
 
 #include <chrono>
@@ -40,6 +42,8 @@ bool IsHandleCanceled(WrapperAsyncHandle* handle);
 
 uint32_t ParseCompressionType(const char* compression_algorithm);
 uint32_t ParseHashingType(const char* hashing_type);
+uint32_t ParseChunkingType(const char* chunking_type);
+struct Longtail_ChunkerAPI* CreateChunkerAPI(uint32_t chunker_type);
 
 void SetLogging(int level);
 
@@ -50,10 +54,15 @@ int32_t SubmitSync(
     const char* Message,
     uint32_t TargetChunkSize,
     uint32_t TargetBlockSize,
+    uint32_t MinTargetBlockSize,
+    uint32_t MaxTargetBlockSize,
     uint32_t MaxChunksPerBlock,
     uint32_t MinBlockUsagePercent,
     const char* HashingAlgo,
+    const char* ChunkingAlgo,
     const char* CompressionAlgo,
+    uint32_t MinCompressionSavingPercent,
+    uint64_t ReadCacheSize,
     bool EnableMmapIndexing,
     bool EnableMmapBlockStore,
     const char* LocalRootPath,
@@ -74,6 +83,8 @@ int32_t SubmitSync(
     const char* WorkspaceId,
     uint32_t NumModifications,
     const Checkpoint::Modification* Modifications,
+    uint32_t NumAssetPolicies,
+    const Checkpoint::AssetPolicy* AssetPolicies,
     WrapperAsyncHandle* handle);
 
 int32_t PullSync(
@@ -92,6 +103,15 @@ int32_t PullSync(
     const char* S3AccessKeyId,
     const char* S3SecretAccessKey,
     const char* S3SessionToken,
+    const char* CachePath,
+    uint32_t MaxFetchDepth,
+    int32_t BaseChangelist,
+    int32_t Changelist,
+    uint32_t NumRemovedPaths,
+    const char** RemovedPaths,
+    bool MaterializeOnly,
+    uint32_t NumAssetPolicies,
+    const Checkpoint::AssetPolicy* AssetPolicies,
     WrapperAsyncHandle* handle);
 
 // Extended handle for ReadFileFromVersion that includes the file data
@@ -103,3 +123,16 @@ struct ReadFileAsyncHandle {
 
 // ReadFileFromVersionAsync, FreeReadFileHandle, GetReadFileData, GetReadFileSize
 // are defined in read-file.cpp with DLL_EXPORT
+
+// Result of GetChangeJournalChanges, Paths holds NumPaths paths relative to the
+// workspace root. If FullScanRequired is set the journal does not cover
+// everything since the cursor that was passed in and Paths is empty.
+struct ChangeJournalChanges {
+  uint64_t Cursor;
+  uint32_t FullScanRequired;
+  uint32_t NumPaths;
+  const char** Paths;
+};
+
+// OpenChangeJournal, GetChangeJournalChanges, FreeChangeJournalChanges and
+// CloseChangeJournal are defined in change-journal.cpp with DLL_EXPORT
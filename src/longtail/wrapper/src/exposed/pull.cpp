@@ -1,11 +1,134 @@
 #include <lrublockstore/longtail_lrublockstore.h>
 #include <shareblockstore/longtail_shareblockstore.h>
 #include <cacheblockstore/longtail_cacheblockstore.h>
+#include <prefetchblockstore/longtail_prefetchblockstore.h>
 
+#include "../util/asset-policy.h"
 #include "../util/existing-content.h"
+#include "../util/index-cache.h"
+#include "../util/link-estimate.h"
+#include "../util/materialized-version.h"
 #include "../util/progress.h"
+#include "../util/zstd-dictionary.h"
 #include "main.h"
 
+// Upper bounds for the blocks held between the fetch and decompress stages and
+// between the decompress and write stages of the download
+static const uint64_t PullFetchedQueueSize = 256ull * 1024ull * 1024ull;
+static const uint64_t PullDecompressedQueueSize = 256ull * 1024ull * 1024ull;
+
+// Folds the remote version onto the materialized version of BaseChangelist and
+// records the result as the materialized version of Changelist without touching
+// the local files, used to catch up with changelists synced without a pull
+static int MaterializeVersionSync(
+    const char* VersionIndex,
+    const char* LocalRootPath,
+    const char* RemoteBasePath,
+    const char* StorageType,
+    const char* GatewayUrl,
+    const char* JWT,
+    uint64_t JWTExpirationMs,
+    const char* S3Endpoint,
+    const char* S3Region,
+    const char* S3Bucket,
+    const char* S3AccessKeyId,
+    const char* S3SecretAccessKey,
+    const char* S3SessionToken,
+    int32_t BaseChangelist,
+    int32_t Changelist,
+    uint32_t NumRemovedPaths,
+    const char** RemovedPaths,
+    WrapperAsyncHandle* handle) {
+  struct Longtail_HashRegistryAPI* hash_registry = Longtail_CreateFullHashRegistry();
+  struct Longtail_StorageAPI* file_storage_api = Longtail_CreateFSStorageAPI();
+  struct Longtail_StorageAPI* remote_storage_api;
+  if (StorageType && strcmp(StorageType, "gateway") == 0) {
+    remote_storage_api = CreateGatewayStorageAPI(GatewayUrl, JWT, handle, JWTExpirationMs);
+  } else {
+    remote_storage_api = CreateS3StorageAPI(S3Endpoint, S3Region, S3Bucket, S3AccessKeyId, S3SecretAccessKey, S3SessionToken, handle, JWTExpirationMs);
+  }
+
+  std::stringstream version_index_stream;
+  version_index_stream << std::string(RemoteBasePath) << std::string("/versions/") << VersionIndex;
+  std::string remote_version_index_path = version_index_stream.str().c_str();
+
+  SetHandleStep(handle, "Fetching version data");
+
+  struct Longtail_VersionIndex* remote_version_index = 0;
+  int err = Longtail_ReadVersionIndex(remote_storage_api, remote_version_index_path.c_str(), &remote_version_index);
+  if (err) {
+    SetHandleStep(handle, "Failed to read version index");
+    handle->error = err;
+    handle->completed = 1;
+    SAFE_DISPOSE_API(remote_storage_api);
+    SAFE_DISPOSE_API(file_storage_api);
+    SAFE_DISPOSE_API(hash_registry);
+    return err;
+  }
+
+  SetHandleStep(handle, "Materializing version");
+
+  struct Longtail_HashAPI* hash_api;
+  struct Longtail_VersionIndex* base_version_index = 0;
+  struct Longtail_VersionIndex* materialized_version_index = 0;
+  err = hash_registry->GetHashAPI(hash_registry, *remote_version_index->m_HashIdentifier, &hash_api);
+  if (!err) {
+    err = ReadMaterializedVersion(file_storage_api, hash_api, LocalRootPath, BaseChangelist, &base_version_index);
+  }
+  if (!err) {
+    err = FoldVersionIndex(hash_api, base_version_index, remote_version_index, NumRemovedPaths, RemovedPaths, &materialized_version_index);
+  }
+  Longtail_Free(base_version_index);
+  Longtail_Free(remote_version_index);
+  if (err) {
+    SetHandleStep(handle, "Failed to materialize version");
+    handle->error = err;
+    handle->completed = 1;
+    SAFE_DISPOSE_API(remote_storage_api);
+    SAFE_DISPOSE_API(file_storage_api);
+    SAFE_DISPOSE_API(hash_registry);
+    return err;
+  }
+
+  WriteMaterializedVersion(file_storage_api, LocalRootPath, Changelist, materialized_version_index);
+
+  SetHandleStep(handle, "Completed");
+  handle->error = 0;
+  handle->completed = 1;
+
+  Longtail_Free(materialized_version_index);
+  SAFE_DISPOSE_API(remote_storage_api);
+  SAFE_DISPOSE_API(file_storage_api);
+  SAFE_DISPOSE_API(hash_registry);
+  return 0;
+}
+
+// Records the files of version_index in the local index cache except the files
+// in unchanged_path_hashes, which were never compared to the local files
+static void UpdateSyncedIndexCache(
+    struct Longtail_StorageAPI* file_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    const char* local_root_path,
+    const struct Longtail_VersionIndex* version_index,
+    const std::unordered_set<TLongtail_Hash>& unchanged_path_hashes,
+    const LocalFileFingerprints* fingerprints,
+    uint32_t num_asset_policies,
+    const Checkpoint::AssetPolicy* asset_policies) {
+  if (unchanged_path_hashes.empty()) {
+    UpdateLocalIndexCache(file_storage_api, hash_api, local_root_path, version_index, fingerprints, num_asset_policies, asset_policies);
+    return;
+  }
+  struct Longtail_VersionIndex* changed_version_index = 0;
+  int err = FilterVersionIndex(version_index, unchanged_path_hashes, &changed_version_index);
+  if (err) {
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to filter version for the local index cache, %d", err)
+    return;
+  }
+  UpdateLocalIndexCache(file_storage_api, hash_api, local_root_path, changed_version_index, fingerprints, num_asset_policies, asset_policies);
+  Longtail_Free(changed_version_index);
+}
+
 int PullSync(
     const char* VersionIndex,
     bool EnableMmapIndexing,
@@ -23,18 +146,55 @@ int PullSync(
     const char* S3SecretAccessKey,
     const char* S3SessionToken,
     const char* CachePath,
+    uint32_t MaxFetchDepth,
+    int32_t BaseChangelist,
+    int32_t Changelist,
+    uint32_t NumRemovedPaths,
+    const char** RemovedPaths,
+    bool MaterializeOnly,
+    uint32_t NumAssetPolicies,
+    const Checkpoint::AssetPolicy* AssetPolicies,
     WrapperAsyncHandle* handle) {
+  if (MaterializeOnly) {
+    return MaterializeVersionSync(
+        VersionIndex,
+        LocalRootPath,
+        RemoteBasePath,
+        StorageType,
+        GatewayUrl,
+        JWT,
+        JWTExpirationMs,
+        S3Endpoint,
+        S3Region,
+        S3Bucket,
+        S3AccessKeyId,
+        S3SecretAccessKey,
+        S3SessionToken,
+        BaseChangelist,
+        Changelist,
+        NumRemovedPaths,
+        RemovedPaths,
+        handle);
+  }
+
   struct Longtail_HashRegistryAPI* hash_registry = Longtail_CreateFullHashRegistry();
   struct Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(Longtail_GetCPUCount(), 0);
   struct Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
 
-  struct Longtail_StorageAPI* file_storage_api = Longtail_CreateFSStorageAPI();
+  struct Longtail_StorageAPI* file_storage_api = Longtail_CreateFSStorageAPIWithIOUring(32, 0);
+  if (file_storage_api == 0) {
+    file_storage_api = Longtail_CreateFSStorageAPI();
+  }
   struct Longtail_StorageAPI* remote_storage_api;
   if (StorageType && strcmp(StorageType, "gateway") == 0) {
     remote_storage_api = CreateGatewayStorageAPI(GatewayUrl, JWT, handle, JWTExpirationMs);
   } else {
     remote_storage_api = CreateS3StorageAPI(S3Endpoint, S3Region, S3Bucket, S3AccessKeyId, S3SecretAccessKey, S3SessionToken, handle, JWTExpirationMs);
   }
+  remote_storage_api = CreateLinkEstimateStorageAPI(
+      remote_storage_api,
+      GetLinkEstimatesPath(LocalRootPath),
+      GetLinkBackendKey(StorageType, GatewayUrl, S3Endpoint, S3Bucket));
 
   struct Longtail_BlockStoreAPI* store_block_remotestore_api = Longtail_CreateFSBlockStoreAPI(
       job_api,
@@ -71,6 +231,11 @@ int PullSync(
   struct Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateLRUBlockStoreAPI(compress_block_store_api, 32);
   struct Longtail_BlockStoreAPI* store_block_store_api = Longtail_CreateShareBlockStoreAPI(lru_block_store_api);
 
+  // The remote store index is only needed once the local files are indexed,
+  // download it in the meantime
+  struct StoreIndexPrefetch store_index_prefetch;
+  StartStoreIndexPrefetch(&store_index_prefetch, store_block_remotestore_api);
+
   std::stringstream version_index_stream;
   version_index_stream << std::string(RemoteBasePath) << std::string("/versions/") << VersionIndex;
   std::string remote_version_index_path = version_index_stream.str().c_str();
@@ -83,6 +248,29 @@ int PullSync(
     SetHandleStep(handle, "Failed to read version index");
     handle->error = err;
     handle->completed = 1;
+    WaitStoreIndexPrefetch(&store_index_prefetch);
+    SAFE_DISPOSE_API(store_block_store_api);
+    SAFE_DISPOSE_API(lru_block_store_api);
+    SAFE_DISPOSE_API(compress_block_store_api);
+    SAFE_DISPOSE_API(cache_block_store_api);
+    SAFE_DISPOSE_API(local_cache_store_api);
+    SAFE_DISPOSE_API(cache_storage_api);
+    SAFE_DISPOSE_API(store_block_remotestore_api);
+    SAFE_DISPOSE_API(remote_storage_api);
+    SAFE_DISPOSE_API(file_storage_api);
+    SAFE_DISPOSE_API(compression_registry);
+    SAFE_DISPOSE_API(hash_registry);
+    SAFE_DISPOSE_API(job_api);
+    return err;
+  }
+
+  err = LoadZStdDictionaries(remote_storage_api, RemoteBasePath, compression_registry, remote_version_index);
+  if (err) {
+    SetHandleStep(handle, "Failed to load compression dictionaries");
+    handle->error = err;
+    handle->completed = 1;
+    Longtail_Free(remote_version_index);
+    WaitStoreIndexPrefetch(&store_index_prefetch);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(lru_block_store_api);
     SAFE_DISPOSE_API(compress_block_store_api);
@@ -106,6 +294,7 @@ int PullSync(
     handle->error = err;
     handle->completed = 1;
     Longtail_Free(remote_version_index);
+    WaitStoreIndexPrefetch(&store_index_prefetch);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(lru_block_store_api);
     SAFE_DISPOSE_API(compress_block_store_api);
@@ -121,12 +310,18 @@ int PullSync(
     return err;
   }
 
-  struct Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+  // Local files are chunked with the chunker that created the remote version so
+  // unchanged files get the same chunks
+  uint32_t chunker_type = Longtail_VersionIndex_GetChunkerIdentifier(remote_version_index);
+  struct Longtail_ChunkerAPI* chunker_api = CreateChunkerAPI(chunker_type);
   if (!chunker_api) {
-    SetHandleStep(handle, "Failed to get chunker API");
+    bool is_known_chunker = chunker_type == Longtail_GetHPCDCChunkerType() || chunker_type == Longtail_GetFastCDCChunkerType();
+    err = is_known_chunker ? ENOMEM : ENOTSUP;
+    SetHandleStep(handle, is_known_chunker ? "Failed to allocate memory for chunker API" : "Version was chunked with an unsupported chunker");
     handle->error = err;
     handle->completed = 1;
     Longtail_Free(remote_version_index);
+    WaitStoreIndexPrefetch(&store_index_prefetch);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(lru_block_store_api);
     SAFE_DISPOSE_API(compress_block_store_api);
@@ -139,29 +334,78 @@ int PullSync(
     SAFE_DISPOSE_API(compression_registry);
     SAFE_DISPOSE_API(hash_registry);
     SAFE_DISPOSE_API(job_api);
-    return ENOMEM;
+    return err;
   }
 
+  // Fold the version onto the materialized version of the changelist the workspace
+  // is synced to. Files the version did not change since then already have their
+  // content or a local edit, they are neither indexed nor written.
+  struct Longtail_VersionIndex* base_version_index = 0;
+  struct Longtail_VersionIndex* materialized_version_index = 0;
+  std::unordered_set<TLongtail_Hash> unchanged_path_hashes;
+  if (Changelist >= 0) {
+    err = ReadMaterializedVersion(file_storage_api, hash_api, LocalRootPath, BaseChangelist, &base_version_index);
+    if (!err) {
+      err = FoldVersionIndex(hash_api, base_version_index, remote_version_index, NumRemovedPaths, RemovedPaths, &materialized_version_index);
+    }
+    if (!err && base_version_index) {
+      unchanged_path_hashes = GetUnchangedAssets(base_version_index, materialized_version_index);
+    }
+    if (err) {
+      struct Longtail_LogContextFmt_Private* ctx = 0;
+      LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "No materialized version of changelist %d to fold version onto, %d", BaseChangelist, err)
+      Longtail_Free(base_version_index);
+      base_version_index = 0;
+      materialized_version_index = 0;
+      err = 0;
+    }
+  }
+
+  // The local files are diffed against the full materialized version when there is
+  // one so files removed since the base changelist are removed by the change, or
+  // renamed to where the version moved their content. Without one the remote
+  // version only holds the files its changelist touched.
+  const struct Longtail_VersionIndex* target_version_index = materialized_version_index ? materialized_version_index : remote_version_index;
+
   struct Longtail_VersionIndex* local_version_index = 0;
   uint32_t target_chunk_size = *remote_version_index->m_TargetChunkSize;
 
   SetHandleStep(handle, "Scanning local files");
 
-  struct Longtail_FileInfos* file_infos;
+  struct Longtail_FileInfos* file_infos = 0;
+  struct Longtail_FileInfos* base_file_infos = 0;
   err = Longtail_GetFilesFilteredByVersionIndex(
       file_storage_api,
-      remote_version_index,
+      job_api,
+      (struct Longtail_VersionIndex*)target_version_index,
       0,
       0,
       LocalRootPath,
       &file_infos);
+  if (!err && base_version_index) {
+    err = Longtail_GetFilesFilteredByVersionIndex(
+        file_storage_api,
+        job_api,
+        base_version_index,
+        0,
+        0,
+        LocalRootPath,
+        &base_file_infos);
+    if (err) {
+      Longtail_Free(file_infos);
+    }
+  }
+  Longtail_Free(base_version_index);
+  base_version_index = 0;
 
   if (err) {
     SetHandleStep(handle, "Failed to scan local files for diff");
     handle->error = err;
     handle->completed = 1;
+    Longtail_Free(materialized_version_index);
     Longtail_Free(remote_version_index);
     SAFE_DISPOSE_API(chunker_api);
+    WaitStoreIndexPrefetch(&store_index_prefetch);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(lru_block_store_api);
     SAFE_DISPOSE_API(compress_block_store_api);
@@ -177,40 +421,104 @@ int PullSync(
     return err;
   }
 
+  if (!unchanged_path_hashes.empty() || base_file_infos) {
+    std::vector<const char*> changed_paths;
+    std::vector<uint64_t> changed_sizes;
+    std::vector<uint16_t> changed_permissions;
+    for (uint32_t i = 0; i < file_infos->m_Count; ++i) {
+      const char* path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[i]];
+      TLongtail_Hash path_hash;
+      if (Longtail_GetPathHash(hash_api, path, &path_hash) == 0 && unchanged_path_hashes.count(path_hash) != 0) {
+        continue;
+      }
+      changed_paths.push_back(path);
+      changed_sizes.push_back(file_infos->m_Sizes[i]);
+      changed_permissions.push_back(file_infos->m_Permissions[i]);
+    }
+    // Files of the base changelist that are gone from the version. Directories are
+    // left to the caller, they may still hold files that are not part of the version.
+    if (base_file_infos) {
+      std::unordered_set<TLongtail_Hash> target_path_hashes(
+          target_version_index->m_PathHashes,
+          target_version_index->m_PathHashes + *target_version_index->m_AssetCount);
+      for (uint32_t i = 0; i < base_file_infos->m_Count; ++i) {
+        const char* path = &base_file_infos->m_PathData[base_file_infos->m_PathStartOffsets[i]];
+        size_t path_length = strlen(path);
+        TLongtail_Hash path_hash;
+        if ((path_length > 0 && path[path_length - 1] == '/') ||
+            Longtail_GetPathHash(hash_api, path, &path_hash) != 0 ||
+            target_path_hashes.count(path_hash) != 0) {
+          continue;
+        }
+        changed_paths.push_back(path);
+        changed_sizes.push_back(base_file_infos->m_Sizes[i]);
+        changed_permissions.push_back(base_file_infos->m_Permissions[i]);
+      }
+    }
+    struct Longtail_FileInfos* changed_file_infos = 0;
+    if (Longtail_MakeFileInfos(
+            (uint32_t)changed_paths.size(),
+            changed_paths.empty() ? nullptr : changed_paths.data(),
+            changed_sizes.empty() ? nullptr : changed_sizes.data(),
+            changed_permissions.empty() ? nullptr : changed_permissions.data(),
+            &changed_file_infos) == 0) {
+      Longtail_Free(file_infos);
+      file_infos = changed_file_infos;
+    } else {
+      unchanged_path_hashes.clear();
+    }
+    Longtail_Free(base_file_infos);
+    base_file_infos = 0;
+  }
+
   uint32_t* tags = file_infos->m_Count == 0 ? nullptr : (uint32_t*)Longtail_Alloc(0, sizeof(uint32_t) * file_infos->m_Count);
   for (uint32_t i = 0; i < file_infos->m_Count; ++i) {
     tags[i] = 0;
   }
 
+  // Local files must be chunked and hashed the way submit did it or unchanged
+  // files would get different content hashes and be downloaded again. The version
+  // records the target chunk size submit used for each file, the local policies
+  // only apply to files it does not have. Versions submitted before zero chunks
+  // were reserved hash them like any other chunk.
+  uint32_t* chunk_sizes = file_infos->m_Count == 0 ? nullptr : (uint32_t*)Longtail_Alloc(0, sizeof(uint32_t) * file_infos->m_Count);
+  ResolveVersionChunkSizes(hash_api, target_version_index, file_infos, NumAssetPolicies, AssetPolicies, chunk_sizes);
+
+  // Files unchanged since the last pull reuse their cached chunks instead of being read again
+  LocalFileFingerprints local_fingerprints;
   struct Longtail_ProgressAPI* progress = MakeProgressAPI("Indexing local files", handle);
   if (progress) {
-    err = Longtail_CreateVersionIndex(
+    err = CreateCachedLocalVersionIndex(
         file_storage_api,
         hash_api,
         chunker_api,
         job_api,
         progress,
-        0,
-        0,
         LocalRootPath,
         file_infos,
         tags,
+        chunk_sizes,
+        Longtail_VersionIndex_GetFlags(target_version_index) & LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS,
         target_chunk_size,
         EnableMmapIndexing,
-        &local_version_index);
+        &local_version_index,
+        &local_fingerprints);
     SAFE_DISPOSE_API(progress);
   } else {
     err = ENOMEM;
   }
 
+  Longtail_Free(chunk_sizes);
   Longtail_Free(tags);
   Longtail_Free(file_infos);
   if (err) {
     SetHandleStep(handle, "Failed to create local version index");
     handle->error = err;
     handle->completed = 1;
+    Longtail_Free(materialized_version_index);
     Longtail_Free(remote_version_index);
     SAFE_DISPOSE_API(chunker_api);
+    WaitStoreIndexPrefetch(&store_index_prefetch);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(lru_block_store_api);
     SAFE_DISPOSE_API(compress_block_store_api);
@@ -226,21 +534,64 @@ int PullSync(
     return err;
   }
 
+  // The files the version did not change are taken as they are in the version
+  if (!unchanged_path_hashes.empty()) {
+    std::vector<TLongtail_Hash> changed_path_hashes;
+    for (uint32_t a = 0; a < *target_version_index->m_AssetCount; ++a) {
+      if (unchanged_path_hashes.count(target_version_index->m_PathHashes[a]) == 0) {
+        changed_path_hashes.push_back(target_version_index->m_PathHashes[a]);
+      }
+    }
+    struct Longtail_VersionIndex* synced_version_index = 0;
+    err = Longtail_MergeVersionIndex(
+        target_version_index,
+        local_version_index,
+        changed_path_hashes.empty() ? nullptr : changed_path_hashes.data(),
+        changed_path_hashes.size(),
+        &synced_version_index);
+    Longtail_Free(local_version_index);
+    local_version_index = synced_version_index;
+    if (err) {
+      SetHandleStep(handle, "Failed to create local version index");
+      handle->error = err;
+      handle->completed = 1;
+      Longtail_Free(materialized_version_index);
+      Longtail_Free(remote_version_index);
+      SAFE_DISPOSE_API(chunker_api);
+      WaitStoreIndexPrefetch(&store_index_prefetch);
+      SAFE_DISPOSE_API(store_block_store_api);
+      SAFE_DISPOSE_API(lru_block_store_api);
+      SAFE_DISPOSE_API(compress_block_store_api);
+      SAFE_DISPOSE_API(cache_block_store_api);
+      SAFE_DISPOSE_API(local_cache_store_api);
+      SAFE_DISPOSE_API(cache_storage_api);
+      SAFE_DISPOSE_API(store_block_remotestore_api);
+      SAFE_DISPOSE_API(remote_storage_api);
+      SAFE_DISPOSE_API(file_storage_api);
+      SAFE_DISPOSE_API(compression_registry);
+      SAFE_DISPOSE_API(hash_registry);
+      SAFE_DISPOSE_API(job_api);
+      return err;
+    }
+  }
+
   SetHandleStep(handle, "Comparing versions");
 
   struct Longtail_VersionDiff* version_diff;
   err = Longtail_CreateVersionDiff(
       hash_api,
       local_version_index,
-      remote_version_index,
+      target_version_index,
       &version_diff);
   if (err) {
     SetHandleStep(handle, "Failed to create diff from local to remote");
     handle->error = err;
     handle->completed = 1;
     Longtail_Free(local_version_index);
+    Longtail_Free(materialized_version_index);
     Longtail_Free(remote_version_index);
     SAFE_DISPOSE_API(chunker_api);
+    WaitStoreIndexPrefetch(&store_index_prefetch);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(lru_block_store_api);
     SAFE_DISPOSE_API(compress_block_store_api);
@@ -256,21 +607,32 @@ int PullSync(
     return err;
   }
 
-  // For Checkpoint, versions are incremental so the diff will pick up false positives
-  // for removals. This will override prevents ChangeVersion from deleting files
-  *version_diff->m_SourceRemovedCount = 0;
+  // For Checkpoint, versions are incremental so without a materialized version the
+  // diff will pick up false positives for removals. This override prevents
+  // ChangeVersion from deleting files, removed files are deleted by the caller
+  // which knows the removed paths
+  if (!materialized_version_index) {
+    *version_diff->m_SourceRemovedCount = 0;
+  }
 
-  if ((*version_diff->m_ModifiedContentCount == 0) &&
+  if ((*version_diff->m_SourceRemovedCount == 0) &&
+      (*version_diff->m_ModifiedContentCount == 0) &&
       (*version_diff->m_TargetAddedCount == 0) &&
       (*version_diff->m_ModifiedPermissionsCount == 0 /*|| !retain_permissions*/))  // TODO
   {
+    UpdateSyncedIndexCache(file_storage_api, hash_api, LocalRootPath, local_version_index, unchanged_path_hashes, &local_fingerprints, NumAssetPolicies, AssetPolicies);
+    if (materialized_version_index) {
+      WriteMaterializedVersion(file_storage_api, LocalRootPath, Changelist, materialized_version_index);
+    }
     SetHandleStep(handle, "Completed");
     handle->error = 0;
     handle->completed = 1;
     Longtail_Free(version_diff);
     Longtail_Free(local_version_index);
+    Longtail_Free(materialized_version_index);
     Longtail_Free(remote_version_index);
     SAFE_DISPOSE_API(chunker_api);
+    WaitStoreIndexPrefetch(&store_index_prefetch);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(lru_block_store_api);
     SAFE_DISPOSE_API(compress_block_store_api);
@@ -287,9 +649,9 @@ int PullSync(
   }
 
   uint32_t required_chunk_count;
-  TLongtail_Hash* required_chunk_hashes = (TLongtail_Hash*)Longtail_Alloc(0, sizeof(TLongtail_Hash) * (*remote_version_index->m_ChunkCount));
+  TLongtail_Hash* required_chunk_hashes = (TLongtail_Hash*)Longtail_Alloc(0, sizeof(TLongtail_Hash) * (*target_version_index->m_ChunkCount));
   err = Longtail_GetRequiredChunkHashes(
-      remote_version_index,
+      target_version_index,
       version_diff,
       &required_chunk_count,
       required_chunk_hashes);
@@ -300,8 +662,10 @@ int PullSync(
     Longtail_Free(required_chunk_hashes);
     Longtail_Free(version_diff);
     Longtail_Free(local_version_index);
+    Longtail_Free(materialized_version_index);
     Longtail_Free(remote_version_index);
     SAFE_DISPOSE_API(chunker_api);
+    WaitStoreIndexPrefetch(&store_index_prefetch);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(lru_block_store_api);
     SAFE_DISPOSE_API(compress_block_store_api);
@@ -318,6 +682,7 @@ int PullSync(
   }
 
   struct Longtail_StoreIndex* required_version_store_index;
+  WaitStoreIndexPrefetch(&store_index_prefetch);
   err = SyncGetExistingContent(
       store_block_store_api,
       required_chunk_count,
@@ -331,6 +696,7 @@ int PullSync(
     Longtail_Free(required_chunk_hashes);
     Longtail_Free(version_diff);
     Longtail_Free(local_version_index);
+    Longtail_Free(materialized_version_index);
     Longtail_Free(remote_version_index);
     SAFE_DISPOSE_API(chunker_api);
     SAFE_DISPOSE_API(store_block_store_api);
@@ -350,10 +716,52 @@ int PullSync(
 
   Longtail_Free(required_chunk_hashes);
 
-  progress = MakeProgressAPI("Downloading files", handle);
+  // High latency links get more fetch workers so the fetches overlap
+  uint32_t fetch_depth = Longtail_GetCPUCount();
+  if (MaxFetchDepth > fetch_depth) {
+    uint64_t required_chunk_bytes = 0;
+    uint32_t required_chunk_count_in_blocks = *required_version_store_index->m_ChunkCount;
+    for (uint32_t c = 0; c < required_chunk_count_in_blocks; ++c) {
+      required_chunk_bytes += required_version_store_index->m_ChunkSizes[c];
+    }
+    uint32_t required_block_count = *required_version_store_index->m_BlockCount;
+    // Uncompressed size, so the depth errs on the low side for compressed blocks
+    uint64_t average_block_size = required_block_count ? required_chunk_bytes / required_block_count : 0;
+    LinkEstimate link_estimate;
+    GetLinkEstimate(remote_storage_api, &link_estimate);
+    fetch_depth = ChooseFetchDepth(link_estimate, average_block_size, fetch_depth, MaxFetchDepth);
+  }
+
+  // The download runs as a pipeline, fetch workers get the compressed blocks,
+  // decompress workers (one per core) unpack them and the job API workers write
+  // them. Each stage works ahead of the next in the order ChangeVersion
+  // preflights the blocks, up to the size of the queue between them.
+  struct Longtail_BlockStoreAPI* fetch_stage_api = Longtail_CreatePrefetchBlockStoreAPI(
+      block_source_api,
+      fetch_depth,
+      PullFetchedQueueSize);
+  struct Longtail_BlockStoreAPI* pipeline_compress_block_store_api = Longtail_CreateCompressBlockStoreAPI(
+      fetch_stage_api,
+      compression_registry);
+  struct Longtail_BlockStoreAPI* decompress_stage_api = Longtail_CreatePrefetchBlockStoreAPI(
+      pipeline_compress_block_store_api,
+      Longtail_GetCPUCount(),
+      PullDecompressedQueueSize);
+  struct Longtail_BlockStoreAPI* pipeline_lru_block_store_api = Longtail_CreateLRUBlockStoreAPI(decompress_stage_api, 32);
+  struct Longtail_BlockStoreAPI* pipeline_block_store_api = Longtail_CreateShareBlockStoreAPI(pipeline_lru_block_store_api);
+
+  // Moved and duplicated files are copied from local files with the same content
+  // instead of being written from blocks. Files the version did not change were
+  // never compared to the local files so they are not copied from.
+  struct Longtail_VersionIndex* copy_source_version_index = 0;
+  if (!unchanged_path_hashes.empty()) {
+    err = FilterVersionIndex(local_version_index, unchanged_path_hashes, &copy_source_version_index);
+  }
+
+  progress = (!err && pipeline_block_store_api) ? MakeProgressAPI("Downloading files", handle) : 0;
   if (progress) {
-    err = Longtail_ChangeVersion(
-        store_block_store_api,
+    err = Longtail_ChangeVersionWithLocalCopy(
+        pipeline_block_store_api,
         file_storage_api,
         hash_api,
         job_api,
@@ -362,14 +770,21 @@ int PullSync(
         0,
         required_version_store_index,
         local_version_index,
-        remote_version_index,
+        target_version_index,
         version_diff,
         LocalRootPath,
-        /*retain_permissions*/ true ? 1 : 0);
+        /*retain_permissions*/ true ? 1 : 0,
+        copy_source_version_index ? copy_source_version_index : local_version_index);
     SAFE_DISPOSE_API(progress);
-  } else {
+  } else if (!err) {
     err = ENOMEM;
   }
+  Longtail_Free(copy_source_version_index);
+  SAFE_DISPOSE_API(pipeline_block_store_api);
+  SAFE_DISPOSE_API(pipeline_lru_block_store_api);
+  SAFE_DISPOSE_API(decompress_stage_api);
+  SAFE_DISPOSE_API(pipeline_compress_block_store_api);
+  SAFE_DISPOSE_API(fetch_stage_api);
 
   if (err) {
     SetHandleStep(handle, "Failed to update version");
@@ -378,6 +793,7 @@ int PullSync(
     Longtail_Free(version_diff);
     Longtail_Free(local_version_index);
     Longtail_Free(required_version_store_index);
+    Longtail_Free(materialized_version_index);
     Longtail_Free(remote_version_index);
     SAFE_DISPOSE_API(chunker_api);
     SAFE_DISPOSE_API(store_block_store_api);
@@ -395,6 +811,11 @@ int PullSync(
     return err;
   }
 
+  UpdateSyncedIndexCache(file_storage_api, hash_api, LocalRootPath, target_version_index, unchanged_path_hashes, &local_fingerprints, NumAssetPolicies, AssetPolicies);
+  if (materialized_version_index) {
+    WriteMaterializedVersion(file_storage_api, LocalRootPath, Changelist, materialized_version_index);
+  }
+
   SetHandleStep(handle, "Completed");
   handle->error = 0;
   handle->completed = 1;
@@ -402,6 +823,7 @@ int PullSync(
   Longtail_Free(version_diff);
   Longtail_Free(local_version_index);
   Longtail_Free(required_version_store_index);
+  Longtail_Free(materialized_version_index);
   Longtail_Free(remote_version_index);
   SAFE_DISPOSE_API(chunker_api);
   SAFE_DISPOSE_API(store_block_store_api);
@@ -439,6 +861,14 @@ PullAsync(
     const char* S3SecretAccessKey,
     const char* S3SessionToken,
     const char* CachePath,
+    uint32_t MaxFetchDepth,
+    int32_t BaseChangelist,
+    int32_t Changelist,
+    uint32_t NumRemovedPaths,
+    const char** RemovedPaths,
+    bool MaterializeOnly,
+    uint32_t NumAssetPolicies,
+    const Checkpoint::AssetPolicy* AssetPolicies,
     int LogLevel = 4) {
   SetLogging(LogLevel);
 
@@ -469,6 +899,14 @@ PullAsync(
         S3SecretAccessKey,
         S3SessionToken,
         CachePath,
+        MaxFetchDepth,
+        BaseChangelist,
+        Changelist,
+        NumRemovedPaths,
+        RemovedPaths,
+        MaterializeOnly,
+        NumAssetPolicies,
+        AssetPolicies,
         handle);
 
     if (err) {
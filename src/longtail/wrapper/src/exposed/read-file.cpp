@@ -4,6 +4,7 @@
 #include <unordered_map>
 
 #include "../util/existing-content.h"
+#include "../util/zstd-dictionary.h"
 #include "main.h"
 
 // Structure to hold the result of reading a file
@@ -122,6 +123,23 @@ static int ReadFileFromVersionSync(
     return err;
   }
 
+  err = LoadZStdDictionaries(remote_storage_api, RemoteBasePath, compression_registry, version_index);
+  if (err) {
+    SetHandleStep(handle, "Failed to load compression dictionaries");
+    handle->error = err;
+    handle->completed = 1;
+    Longtail_Free(version_index);
+    SAFE_DISPOSE_API(store_block_store_api);
+    SAFE_DISPOSE_API(lru_block_store_api);
+    SAFE_DISPOSE_API(compress_block_store_api);
+    SAFE_DISPOSE_API(store_block_remotestore_api);
+    SAFE_DISPOSE_API(remote_storage_api);
+    SAFE_DISPOSE_API(compression_registry);
+    SAFE_DISPOSE_API(hash_registry);
+    SAFE_DISPOSE_API(job_api);
+    return err;
+  }
+
   // Get the hash API for this version
   uint32_t hashing_type = *version_index->m_HashIdentifier;
   struct Longtail_HashAPI* hash_api;
@@ -274,6 +292,9 @@ static int ReadFileFromVersionSync(
     return ENOMEM;
   }
 
+  // Zero chunks are not stored in any block and are left as zeros
+  memset(file_data, 0, (size_t)file_size);
+
   // Read chunks and assemble file
   SetHandleStep(handle, "Downloading file content");
   uint64_t file_offset = 0;
@@ -282,6 +303,10 @@ static int ReadFileFromVersionSync(
   std::map<TLongtail_Hash, std::vector<uint32_t>> block_to_chunks;
   for (uint32_t i = 0; i < chunk_count; ++i) {
     TLongtail_Hash chunk_hash = chunk_hashes[i];
+    uint32_t chunk_index = version_index->m_AssetChunkIndexes[chunk_index_start + i];
+    if (Longtail_IsZeroChunk(version_index, chunk_index)) {
+      continue;
+    }
     auto chunk_it = chunk_hash_to_index.find(chunk_hash);
     if (chunk_it == chunk_hash_to_index.end()) {
       SetHandleStep(handle, "Chunk not found in store");
@@ -0,0 +1,491 @@
+#include <blockstorestorage/longtail_blockstorestorage.h>
+#include <lrublockstore/longtail_lrublockstore.h>
+#include <shareblockstore/longtail_shareblockstore.h>
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../util/flush.h"
+#include "../util/zstd-dictionary.h"
+#include "main.h"
+
+static void FreeVersionIndexes(std::vector<struct Longtail_VersionIndex*>& version_indexes) {
+  for (struct Longtail_VersionIndex* version_index : version_indexes) {
+    Longtail_Free(version_index);
+  }
+  version_indexes.clear();
+}
+
+// Rewrites the chunks the given versions use out of blocks that they use less
+// than MinBlockUsagePercent of into new dense blocks and adds the new blocks to
+// store.lsi. The old blocks are left in place for older versions, pulls pick
+// the new blocks since they favour the blocks they use the most of.
+int Repack(
+    const char* RemoteBasePath,
+    const char* StorageType,
+    const char* LocalStoragePath,
+    const char* S3Endpoint,
+    const char* S3Region,
+    const char* S3Bucket,
+    const char* S3AccessKeyId,
+    const char* S3SecretAccessKey,
+    const char* S3SessionToken,
+    uint32_t NumVersionIndexes,
+    const char** VersionIndexNames,
+    uint32_t MinBlockUsagePercent,
+    uint32_t TargetBlockSize,
+    uint32_t MaxChunksPerBlock,
+    WrapperAsyncHandle* handle) {
+  // Same backend selection as the server-side merge
+  struct Longtail_StorageAPI* remote_storage_api;
+  std::string basePath = RemoteBasePath;
+  if (StorageType && strcmp(StorageType, "local") == 0) {
+    remote_storage_api = Longtail_CreateFSStorageAPI();
+    basePath = std::string(LocalStoragePath) + RemoteBasePath;
+  } else {
+    remote_storage_api = CreateS3StorageAPI(S3Endpoint, S3Region, S3Bucket, S3AccessKeyId, S3SecretAccessKey, S3SessionToken);
+  }
+
+  if (!remote_storage_api) {
+    SetHandleStep(handle, "Failed to create storage api");
+    handle->error = ENOMEM;
+    handle->completed = 1;
+    return ENOMEM;
+  }
+
+  std::string LockFilePath = basePath + std::string("/store.lsi.sync");
+  std::string StoreFilePath = basePath + std::string("/store.lsi");
+
+  if (!remote_storage_api->IsFile(remote_storage_api, StoreFilePath.c_str())) {
+    // Nothing has been submitted, there are no blocks to repack
+    strncpy(handle->result, "{\"sparseBlocks\":0,\"newBlocks\":0,\"repackedBytes\":0}", sizeof(handle->result) - 1);
+    SetHandleStep(handle, "Completed");
+    handle->error = 0;
+    handle->completed = 1;
+    SAFE_DISPOSE_API(remote_storage_api);
+    return 0;
+  }
+
+  SetHandleStep(handle, "Reading store index");
+
+  struct Longtail_StoreIndex* store_index;
+  int err = Longtail_ReadStoreIndex(remote_storage_api, StoreFilePath.c_str(), &store_index);
+  if (err) {
+    SetHandleStep(handle, "Failed to read the store index");
+    handle->error = err;
+    handle->completed = 1;
+    SAFE_DISPOSE_API(remote_storage_api);
+    return err;
+  }
+
+  SetHandleStep(handle, "Reading version indexes");
+
+  std::vector<struct Longtail_VersionIndex*> version_indexes;
+  for (uint32_t i = 0; i < NumVersionIndexes; ++i) {
+    std::string version_index_path = basePath + std::string("/versions/") + VersionIndexNames[i];
+    struct Longtail_VersionIndex* version_index;
+    err = Longtail_ReadVersionIndex(remote_storage_api, version_index_path.c_str(), &version_index);
+    if (!err) {
+      version_indexes.push_back(version_index);
+    }
+    if (err) {
+      SetHandleStep(handle, "Failed to read version index");
+      handle->error = err;
+      handle->completed = 1;
+      FreeVersionIndexes(version_indexes);
+      Longtail_Free(store_index);
+      SAFE_DISPOSE_API(remote_storage_api);
+      return err;
+    }
+  }
+
+  // A block is sparse if the versions use some, but less than
+  // MinBlockUsagePercent, of the data in it
+  std::unordered_set<TLongtail_Hash> used_chunks;
+  for (struct Longtail_VersionIndex* version_index : version_indexes) {
+    used_chunks.insert(version_index->m_ChunkHashes, version_index->m_ChunkHashes + *version_index->m_ChunkCount);
+  }
+
+  uint32_t sparse_block_count = 0;
+  uint32_t block_count = *store_index->m_BlockCount;
+  for (uint32_t b = 0; b < block_count; ++b) {
+    uint32_t chunk_offset = store_index->m_BlockChunksOffsets[b];
+    uint32_t block_chunk_count = store_index->m_BlockChunkCounts[b];
+    uint64_t block_size = 0;
+    uint64_t block_use = 0;
+    for (uint32_t c = chunk_offset; c < chunk_offset + block_chunk_count; ++c) {
+      block_size += store_index->m_ChunkSizes[c];
+      if (used_chunks.count(store_index->m_ChunkHashes[c])) {
+        block_use += store_index->m_ChunkSizes[c];
+      }
+    }
+    if (block_use > 0 && (block_use * 100) < (block_size * MinBlockUsagePercent)) {
+      ++sparse_block_count;
+    }
+  }
+
+  if (sparse_block_count == 0) {
+    strncpy(handle->result, "{\"sparseBlocks\":0,\"newBlocks\":0,\"repackedBytes\":0}", sizeof(handle->result) - 1);
+    SetHandleStep(handle, "Completed");
+    handle->error = 0;
+    handle->completed = 1;
+    FreeVersionIndexes(version_indexes);
+    Longtail_Free(store_index);
+    SAFE_DISPOSE_API(remote_storage_api);
+    return 0;
+  }
+
+  // The chunks that are in a block the versions use enough of do not need to
+  // be rewritten
+  std::vector<TLongtail_Hash> used_chunk_hashes(used_chunks.begin(), used_chunks.end());
+  struct Longtail_StoreIndex* known_store_index;
+  err = Longtail_GetExistingStoreIndex(
+      store_index,
+      (uint32_t)used_chunk_hashes.size(),
+      used_chunk_hashes.data(),
+      MinBlockUsagePercent,
+      &known_store_index);
+  if (err) {
+    SetHandleStep(handle, "Failed to find dense blocks");
+    handle->error = err;
+    handle->completed = 1;
+    FreeVersionIndexes(version_indexes);
+    Longtail_Free(store_index);
+    SAFE_DISPOSE_API(remote_storage_api);
+    return err;
+  }
+
+  struct Longtail_StoreIndex* added_store_index;
+  err = Longtail_CreateStoreIndexFromBlocks(0, 0, &added_store_index);
+  if (err) {
+    SetHandleStep(handle, "Failed to create store index");
+    handle->error = err;
+    handle->completed = 1;
+    Longtail_Free(known_store_index);
+    FreeVersionIndexes(version_indexes);
+    Longtail_Free(store_index);
+    SAFE_DISPOSE_API(remote_storage_api);
+    return err;
+  }
+
+  struct Longtail_HashRegistryAPI* hash_registry = Longtail_CreateFullHashRegistry();
+  struct Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(Longtail_GetCPUCount(), 0);
+  struct Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
+
+  struct Longtail_HashAPI* hash_api;
+  err = hash_registry->GetHashAPI(hash_registry, *store_index->m_HashIdentifier, &hash_api);
+  if (err) {
+    SetHandleStep(handle, "Failed to get hash API");
+    handle->error = err;
+    handle->completed = 1;
+    Longtail_Free(added_store_index);
+    Longtail_Free(known_store_index);
+    FreeVersionIndexes(version_indexes);
+    Longtail_Free(store_index);
+    SAFE_DISPOSE_API(compression_registry);
+    SAFE_DISPOSE_API(job_api);
+    SAFE_DISPOSE_API(hash_registry);
+    SAFE_DISPOSE_API(remote_storage_api);
+    return err;
+  }
+
+  struct Longtail_BlockStoreAPI* store_block_fsstore_api = Longtail_CreateFSBlockStoreAPI(
+      job_api,
+      remote_storage_api,
+      basePath.c_str(),
+      0,
+      0);
+  struct Longtail_BlockStoreAPI* compress_block_store_api = Longtail_CreateCompressBlockStoreAPI(
+      store_block_fsstore_api,
+      compression_registry);
+  // Chunks of one sparse block are usually read by several asset reads in a row
+  struct Longtail_BlockStoreAPI* lru_block_store_api = Longtail_CreateLRUBlockStoreAPI(compress_block_store_api, 32);
+  struct Longtail_BlockStoreAPI* read_block_store_api = Longtail_CreateShareBlockStoreAPI(lru_block_store_api);
+
+  uint64_t repacked_bytes = 0;
+  for (size_t v = 0; v < version_indexes.size(); ++v) {
+    struct Longtail_VersionIndex* version_index = version_indexes[v];
+
+    SetHandleStep(handle, "Repacking blocks");
+
+    err = LoadZStdDictionaries(remote_storage_api, basePath.c_str(), compression_registry, version_index);
+    if (err) {
+      SetHandleStep(handle, "Failed to load compression dictionaries");
+      break;
+    }
+
+    struct Longtail_StoreIndex* missing_store_index;
+    err = Longtail_CreateMissingContentWithPacking(
+        hash_api,
+        known_store_index,
+        version_index,
+        TargetBlockSize,
+        MaxChunksPerBlock,
+        LONGTAIL_BLOCK_PACKING_LOCALITY,
+        &missing_store_index);
+    if (err) {
+      SetHandleStep(handle, "Failed to create repacked store index");
+      break;
+    }
+
+    if (*missing_store_index->m_ChunkCount == 0) {
+      Longtail_Free(missing_store_index);
+      continue;
+    }
+
+    // The version is read back out of the existing blocks and written as the
+    // content of the new blocks
+    struct Longtail_StorageAPI* block_store_storage_api = Longtail_CreateBlockStoreStorageAPI(
+        hash_api,
+        job_api,
+        read_block_store_api,
+        store_index,
+        version_index);
+    if (!block_store_storage_api) {
+      err = ENOMEM;
+      SetHandleStep(handle, "Failed to create block store storage api");
+      Longtail_Free(missing_store_index);
+      break;
+    }
+
+    err = Longtail_WriteContent(
+        block_store_storage_api,
+        compress_block_store_api,
+        job_api,
+        0,
+        0,
+        0,
+        missing_store_index,
+        version_index,
+        "");
+    SAFE_DISPOSE_API(block_store_storage_api);
+    if (err) {
+      SetHandleStep(handle, "Failed to write repacked blocks");
+      Longtail_Free(missing_store_index);
+      break;
+    }
+
+    for (uint32_t c = 0; c < *missing_store_index->m_ChunkCount; ++c) {
+      repacked_bytes += missing_store_index->m_ChunkSizes[c];
+    }
+
+    struct Longtail_StoreIndex* merged_store_index;
+    err = Longtail_MergeStoreIndex(known_store_index, missing_store_index, &merged_store_index);
+    if (!err) {
+      Longtail_Free(known_store_index);
+      known_store_index = merged_store_index;
+      err = Longtail_MergeStoreIndex(added_store_index, missing_store_index, &merged_store_index);
+    }
+    Longtail_Free(missing_store_index);
+    if (err) {
+      SetHandleStep(handle, "Failed to merge repacked store index");
+      break;
+    }
+    Longtail_Free(added_store_index);
+    added_store_index = merged_store_index;
+  }
+
+  if (!err) {
+    SetHandleStep(handle, "Flushing uploads");
+
+    struct SyncFlush flushCB;
+    err = SyncFlush_Init(&flushCB);
+    if (err) {
+      SetHandleStep(handle, "Failed create SyncFlush");
+    } else {
+      err = Longtail_BlockStore_Flush(compress_block_store_api, &flushCB.m_API);
+      if (err) {
+        SetHandleStep(handle, "Failed flush compression block store");
+      } else {
+        SyncFlush_Wait(&flushCB);
+        err = flushCB.m_Err;
+        if (err) {
+          SetHandleStep(handle, "Failed flush compression block store");
+        }
+      }
+      SAFE_DISPOSE_API(&flushCB.m_API);
+    }
+  }
+
+  SAFE_DISPOSE_API(read_block_store_api);
+  SAFE_DISPOSE_API(lru_block_store_api);
+  SAFE_DISPOSE_API(compress_block_store_api);
+  SAFE_DISPOSE_API(store_block_fsstore_api);
+  SAFE_DISPOSE_API(compression_registry);
+  SAFE_DISPOSE_API(job_api);
+  SAFE_DISPOSE_API(hash_registry);
+  Longtail_Free(known_store_index);
+  FreeVersionIndexes(version_indexes);
+  Longtail_Free(store_index);
+
+  if (err) {
+    handle->error = err;
+    handle->completed = 1;
+    Longtail_Free(added_store_index);
+    SAFE_DISPOSE_API(remote_storage_api);
+    return err;
+  }
+
+  uint32_t new_block_count = *added_store_index->m_BlockCount;
+
+  // The new blocks are only used once they are in store.lsi, which is updated
+  // under the same lock as the merge of a submit so no submit is lost
+  SetHandleStep(handle, "Updating store index");
+
+  while (remote_storage_api->IsFile(remote_storage_api, LockFilePath.c_str())) {
+    Longtail_Sleep(100000);  // sleep for 100ms
+  }
+
+  Longtail_StorageAPI_HOpenFile out_open_file;
+  err = Longtail_Storage_OpenWriteFile(remote_storage_api, LockFilePath.c_str(), 0, &out_open_file);
+  if (err) {
+    SetHandleStep(handle, "Failed to open lock file for writing");
+    handle->error = err;
+    handle->completed = 1;
+    Longtail_Free(added_store_index);
+    SAFE_DISPOSE_API(remote_storage_api);
+    return err;
+  }
+
+  err = Longtail_Storage_Write(remote_storage_api, out_open_file, 0, 4, "lock");
+  Longtail_Storage_CloseFile(remote_storage_api, out_open_file);
+  if (err) {
+    SetHandleStep(handle, "Failed to write lock file");
+    handle->error = err;
+    handle->completed = 1;
+    Longtail_Storage_RemoveFile(remote_storage_api, LockFilePath.c_str());
+    Longtail_Free(added_store_index);
+    SAFE_DISPOSE_API(remote_storage_api);
+    return err;
+  }
+
+  // Submits may have been merged while the blocks were written
+  struct Longtail_StoreIndex* current_store_index;
+  err = Longtail_ReadStoreIndex(remote_storage_api, StoreFilePath.c_str(), &current_store_index);
+  if (err) {
+    SetHandleStep(handle, "Failed to read the existing store index");
+    handle->error = err;
+    handle->completed = 1;
+    int removeError = Longtail_Storage_RemoveFile(remote_storage_api, LockFilePath.c_str());
+    if (removeError) {
+      SetHandleStep(handle, "Failed to read the existing store index AND failed to remove lock file");
+    }
+    Longtail_Free(added_store_index);
+    SAFE_DISPOSE_API(remote_storage_api);
+    return err;
+  }
+
+  struct Longtail_StoreIndex* merged_store_index;
+  err = Longtail_MergeStoreIndex(current_store_index, added_store_index, &merged_store_index);
+  Longtail_Free(current_store_index);
+  Longtail_Free(added_store_index);
+  if (err) {
+    SetHandleStep(handle, "Failed to merge store indexes");
+    handle->error = err;
+    handle->completed = 1;
+    int removeError = Longtail_Storage_RemoveFile(remote_storage_api, LockFilePath.c_str());
+    if (removeError) {
+      SetHandleStep(handle, "Failed to merge store indexes AND failed to remove lock file");
+    }
+    SAFE_DISPOSE_API(remote_storage_api);
+    return err;
+  }
+
+  err = Longtail_WriteStoreIndex(remote_storage_api, merged_store_index, StoreFilePath.c_str());
+  Longtail_Free(merged_store_index);
+  if (err) {
+    SetHandleStep(handle, "Failed to write merged store index");
+    handle->error = err;
+    handle->completed = 1;
+    int removeError = Longtail_Storage_RemoveFile(remote_storage_api, LockFilePath.c_str());
+    if (removeError) {
+      SetHandleStep(handle, "Failed to write merged store index AND failed to remove lock file");
+    }
+    SAFE_DISPOSE_API(remote_storage_api);
+    return err;
+  }
+
+  err = Longtail_Storage_RemoveFile(remote_storage_api, LockFilePath.c_str());
+  if (err) {
+    SetHandleStep(handle, "Failed to remove lock file");
+    handle->error = err;
+    handle->completed = 1;
+    SAFE_DISPOSE_API(remote_storage_api);
+    return err;
+  }
+
+  SAFE_DISPOSE_API(remote_storage_api);
+
+  {
+    std::stringstream resultStream;
+    resultStream << "{\"sparseBlocks\":" << sparse_block_count
+                 << ",\"newBlocks\":" << new_block_count
+                 << ",\"repackedBytes\":" << repacked_bytes << "}";
+    std::string resultStr = resultStream.str();
+    strncpy(handle->result, resultStr.c_str(), sizeof(handle->result) - 1);
+    handle->result[sizeof(handle->result) - 1] = '\0';
+  }
+
+  SetHandleStep(handle, "Completed");
+  handle->error = 0;
+  handle->completed = 1;
+
+  return 0;
+}
+
+DLL_EXPORT WrapperAsyncHandle*
+RepackAsync(
+    const char* RemoteBasePath,
+    const char* StorageType,
+    const char* LocalStoragePath,
+    const char* S3Endpoint,
+    const char* S3Region,
+    const char* S3Bucket,
+    const char* S3AccessKeyId,
+    const char* S3SecretAccessKey,
+    const char* S3SessionToken,
+    uint32_t NumVersionIndexes,
+    const char** VersionIndexNames,
+    uint32_t MinBlockUsagePercent,
+    uint32_t TargetBlockSize,
+    uint32_t MaxChunksPerBlock,
+    int LogLevel = 4) {
+  SetLogging(LogLevel);
+
+  WrapperAsyncHandle* handle = (WrapperAsyncHandle*)Longtail_Alloc(0, sizeof(WrapperAsyncHandle));
+  if (!handle) {
+    return 0;
+  }
+
+  memset(handle, 0, sizeof(WrapperAsyncHandle));
+
+  SetHandleStep(handle, "Initializing");
+
+  std::thread repack_thread([=]() {
+    int32_t err = Repack(
+        RemoteBasePath,
+        StorageType,
+        LocalStoragePath,
+        S3Endpoint,
+        S3Region,
+        S3Bucket,
+        S3AccessKeyId,
+        S3SecretAccessKey,
+        S3SessionToken,
+        NumVersionIndexes,
+        VersionIndexNames,
+        MinBlockUsagePercent,
+        TargetBlockSize,
+        MaxChunksPerBlock,
+        handle);
+
+    if (err) {
+      std::cerr << "Failed to repack blocks, " << err << ": " << handle->currentStep << std::endl;
+    }
+  });
+
+  repack_thread.detach();
+
+  return handle;
+}
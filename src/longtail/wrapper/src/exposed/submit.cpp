@@ -1,7 +1,11 @@
+#include "../util/asset-policy.h"
 #include "../util/cancel.h"
 #include "../util/existing-content.h"
 #include "../util/flush.h"
+#include "../util/link-estimate.h"
 #include "../util/progress.h"
+#include "../util/read-cache-storage.h"
+#include "../util/zstd-dictionary.h"
 #include "main.h"
 
 #include <string>
@@ -15,10 +19,15 @@ int32_t SubmitSync(
     const char* Message,
     uint32_t TargetChunkSize,
     uint32_t TargetBlockSize,
+    uint32_t MinTargetBlockSize,
+    uint32_t MaxTargetBlockSize,
     uint32_t MaxChunksPerBlock,
     uint32_t MinBlockUsagePercent,
     const char* HashingAlgo,
+    const char* ChunkingAlgo,
     const char* CompressionAlgo,
+    uint32_t MinCompressionSavingPercent,
+    uint64_t ReadCacheSize,
     bool EnableMmapIndexing,
     bool EnableMmapBlockStore,
     const char* LocalRootPath,
@@ -39,18 +48,28 @@ int32_t SubmitSync(
     const char* WorkspaceId,
     uint32_t NumModifications,
     const Checkpoint::Modification* Modifications,
+    uint32_t NumAssetPolicies,
+    const Checkpoint::AssetPolicy* AssetPolicies,
     WrapperAsyncHandle* handle) {
   struct Longtail_HashRegistryAPI* hash_registry = Longtail_CreateFullHashRegistry();
   struct Longtail_JobAPI* job_api = Longtail_CreateBikeshedJobAPI(Longtail_GetCPUCount(), 0);
   struct Longtail_CompressionRegistryAPI* compression_registry = Longtail_CreateFullCompressionRegistry();
 
-  struct Longtail_StorageAPI* file_storage_api = Longtail_CreateFSStorageAPI();
+  // Files read for indexing are read once, keep huge ones out of the page cache
+  struct Longtail_StorageAPI* file_storage_api = Longtail_CreateFSStorageAPIWithIOUring(32, 1024ull * 1024ull * 1024ull);
+  if (file_storage_api == 0) {
+    file_storage_api = Longtail_CreateFSStorageAPI();
+  }
   struct Longtail_StorageAPI* remote_storage_api;
   if (StorageType && strcmp(StorageType, "gateway") == 0) {
     remote_storage_api = CreateGatewayStorageAPI(GatewayUrl, JWT, handle, JWTExpirationMs);
   } else {
     remote_storage_api = CreateS3StorageAPI(S3Endpoint, S3Region, S3Bucket, S3AccessKeyId, S3SecretAccessKey, S3SessionToken, handle, JWTExpirationMs);
   }
+  remote_storage_api = CreateLinkEstimateStorageAPI(
+      remote_storage_api,
+      GetLinkEstimatesPath(LocalRootPath),
+      GetLinkBackendKey(StorageType, GatewayUrl, S3Endpoint, S3Bucket));
 
   struct Longtail_BlockStoreAPI* store_block_fsstore_api = Longtail_CreateFSBlockStoreAPI(
       job_api,
@@ -59,9 +78,28 @@ int32_t SubmitSync(
       0,
       EnableMmapBlockStore);
 
-  struct Longtail_BlockStoreAPI* store_block_store_api = Longtail_CreateCompressBlockStoreAPI(
+  // The job API workers that build the blocks wait while the compression queue is full so the
+  // compression workers share the CPU with them, half as many as there are job API workers.
+  // Large blocks are compressed on several of the compression workers, see Longtail_CompressionAPI_CompressWithWorkers
+  uint32_t compression_worker_count = Longtail_Job_GetWorkerCount(job_api) / 2;
+  struct Longtail_BlockStoreAPI* store_block_store_api = Longtail_CreateAdaptiveCompressBlockStoreAPI(
       store_block_fsstore_api,
-      compression_registry);
+      compression_registry,
+      compression_worker_count > 0 ? compression_worker_count : 1,
+      MinCompressionSavingPercent);
+  if (!store_block_store_api) {
+    int err = MinCompressionSavingPercent >= 100 ? EINVAL : ENOMEM;
+    SetHandleStep(handle, err == EINVAL ? "Invalid minimum compression saving percent" : "Failed to create compress block store API");
+    handle->error = err;
+    handle->completed = 1;
+    SAFE_DISPOSE_API(store_block_fsstore_api);
+    SAFE_DISPOSE_API(file_storage_api);
+    SAFE_DISPOSE_API(remote_storage_api);
+    SAFE_DISPOSE_API(compression_registry);
+    SAFE_DISPOSE_API(hash_registry);
+    SAFE_DISPOSE_API(job_api);
+    return err;
+  }
 
   CheckpointCancelAPI cancel_api(handle);
   Longtail_CancelAPI_HCancelToken cancel_token = Longtail_CancelAPI_HCancelToken();
@@ -88,10 +126,12 @@ int32_t SubmitSync(
     return err;
   }
 
-  struct Longtail_ChunkerAPI* chunker_api = Longtail_CreateHPCDCChunkerAPI();
+  uint32_t ChunkingType = ParseChunkingType(ChunkingAlgo);
+  struct Longtail_ChunkerAPI* chunker_api = CreateChunkerAPI(ChunkingType);
   if (!chunker_api) {
-    SetHandleStep(handle, "Failed to allocate memory for chunker API");
-    handle->error = ENOMEM;
+    err = ChunkingType == 0xffffffff ? EINVAL : ENOMEM;
+    SetHandleStep(handle, err == EINVAL ? "Unknown chunking algorithm" : "Failed to allocate memory for chunker API");
+    handle->error = err;
     handle->completed = 1;
     Longtail_Free(source_version_index);
     SAFE_DISPOSE_API(store_block_store_api);
@@ -101,7 +141,7 @@ int32_t SubmitSync(
     SAFE_DISPOSE_API(compression_registry);
     SAFE_DISPOSE_API(hash_registry);
     SAFE_DISPOSE_API(job_api);
-    return ENOMEM;
+    return err;
   }
 
   uint32_t path_data_size = 0;
@@ -248,11 +288,30 @@ int32_t SubmitSync(
   uint32_t CompressionType = ParseCompressionType(CompressionAlgo);
 
   uint32_t* tags = (uint32_t*)Longtail_Alloc(0, sizeof(uint32_t) * file_infos->m_Count);
-  for (uint32_t i = 0; i < file_infos->m_Count; ++i) {
-    tags[i] = CompressionType;
+  uint32_t* chunk_sizes = (uint32_t*)Longtail_Alloc(0, sizeof(uint32_t) * file_infos->m_Count);
+  err = ResolveAssetPolicies(file_infos, CompressionType, NumAssetPolicies, AssetPolicies, tags, chunk_sizes);
+  if (err) {
+    SetHandleStep(handle, "Invalid compression algorithm in asset policies");
+    handle->error = err;
+    handle->completed = 1;
+    Longtail_Free(chunk_sizes);
+    Longtail_Free(tags);
+    Longtail_Free(file_infos);
+    SAFE_DISPOSE_API(chunker_api);
+    SAFE_DISPOSE_API(store_block_store_api);
+    SAFE_DISPOSE_API(store_block_fsstore_api);
+    SAFE_DISPOSE_API(file_storage_api);
+    SAFE_DISPOSE_API(remote_storage_api);
+    SAFE_DISPOSE_API(compression_registry);
+    SAFE_DISPOSE_API(hash_registry);
+    SAFE_DISPOSE_API(job_api);
+    return err;
   }
 
+  ResolveZStdDictionaryTags(remote_storage_api, RemoteBasePath, compression_registry, file_storage_api, LocalRootPath, file_infos, tags);
+
   if (IsHandleCanceled(handle)) {
+    Longtail_Free(chunk_sizes);
     Longtail_Free(tags);
     Longtail_Free(file_infos);
     Longtail_Free(source_version_index);
@@ -267,11 +326,21 @@ int32_t SubmitSync(
     return ECANCELED;
   }
 
+  // Keeps up to ReadCacheSize bytes of the data read while indexing so the blocks
+  // with new chunks can be written without reading the source files again, the
+  // files are read again if ReadCacheSize is 0 or the cache can not be created
+  struct Longtail_StorageAPI* read_cache_storage_api = ReadCacheSize > 0 ? CreateReadCacheStorageAPI(file_storage_api, ReadCacheSize) : 0;
+  struct Longtail_StorageAPI* source_storage_api = read_cache_storage_api ? read_cache_storage_api : file_storage_api;
+
+  // Download the remote store index while the local files are indexed
+  struct StoreIndexPrefetch store_index_prefetch;
+  StartStoreIndexPrefetch(&store_index_prefetch, store_block_fsstore_api);
+
   struct Longtail_ProgressAPI* progress = MakeProgressAPI("Indexing version", handle);
   if (progress) {
     SetHandleStep(handle, "Indexing version");
-    err = Longtail_CreateVersionIndex(
-        file_storage_api,
+    err = Longtail_CreateVersionIndexWithChunkSizes(
+        source_storage_api,
         hash_api,
         chunker_api,
         job_api,
@@ -281,6 +350,8 @@ int32_t SubmitSync(
         LocalRootPath,
         file_infos,
         tags,
+        chunk_sizes,
+        LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS,
         TargetChunkSize,
         EnableMmapIndexing,
         &source_version_index);
@@ -290,6 +361,7 @@ int32_t SubmitSync(
     err = ENOMEM;
   }
 
+  Longtail_Free(chunk_sizes);
   Longtail_Free(tags);
   Longtail_Free(file_infos);
 
@@ -297,6 +369,8 @@ int32_t SubmitSync(
     SetHandleStep(handle, "Failed to create version index");
     handle->error = err;
     handle->completed = 1;
+    WaitStoreIndexPrefetch(&store_index_prefetch);
+    SAFE_DISPOSE_API(read_cache_storage_api);
     SAFE_DISPOSE_API(chunker_api);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(store_block_fsstore_api);
@@ -310,6 +384,8 @@ int32_t SubmitSync(
 
   SetHandleStep(handle, "Getting existing content");
 
+  WaitStoreIndexPrefetch(&store_index_prefetch);
+
   struct Longtail_StoreIndex* existing_remote_store_index;
   err = SyncGetExistingContent(
       store_block_store_api,
@@ -323,6 +399,7 @@ int32_t SubmitSync(
     handle->error = err;
     handle->completed = 1;
     Longtail_Free(source_version_index);
+    SAFE_DISPOSE_API(read_cache_storage_api);
     SAFE_DISPOSE_API(chunker_api);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(store_block_fsstore_api);
@@ -336,13 +413,19 @@ int32_t SubmitSync(
 
   SetHandleStep(handle, "Create missing store index");
 
+  // The store index has been fetched by now, so the estimate includes this session's requests
+  LinkEstimate link_estimate;
+  GetLinkEstimate(remote_storage_api, &link_estimate);
+  uint32_t block_size = ChooseTargetBlockSize(link_estimate, TargetBlockSize, MinTargetBlockSize, MaxTargetBlockSize);
+
   struct Longtail_StoreIndex* remote_missing_store_index;
-  err = Longtail_CreateMissingContent(
+  err = Longtail_CreateMissingContentWithPacking(
       hash_api,
       existing_remote_store_index,
       source_version_index,
-      TargetBlockSize,
+      block_size,
       MaxChunksPerBlock,
+      LONGTAIL_BLOCK_PACKING_LOCALITY,
       &remote_missing_store_index);
 
   if (err) {
@@ -351,6 +434,7 @@ int32_t SubmitSync(
     handle->completed = 1;
     Longtail_Free(existing_remote_store_index);
     Longtail_Free(source_version_index);
+    SAFE_DISPOSE_API(read_cache_storage_api);
     SAFE_DISPOSE_API(chunker_api);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(store_block_fsstore_api);
@@ -362,12 +446,17 @@ int32_t SubmitSync(
     return err;
   }
 
+  if (read_cache_storage_api) {
+    // Only the new chunks are read again by Longtail_WriteContent
+    KeepReadCacheChunks(read_cache_storage_api, LocalRootPath, source_version_index, remote_missing_store_index);
+  }
+
   SetHandleStep(handle, "Creating store blocks");
 
   progress = MakeProgressAPI("Writing blocks", handle);
   if (progress) {
     err = Longtail_WriteContent(
-        file_storage_api,
+        source_storage_api,
         store_block_store_api,
         job_api,
         progress,
@@ -388,6 +477,7 @@ int32_t SubmitSync(
     handle->completed = 1;
     Longtail_Free(existing_remote_store_index);
     Longtail_Free(source_version_index);
+    SAFE_DISPOSE_API(read_cache_storage_api);
     SAFE_DISPOSE_API(chunker_api);
     SAFE_DISPOSE_API(store_block_store_api);
     SAFE_DISPOSE_API(store_block_fsstore_api);
@@ -399,6 +489,8 @@ int32_t SubmitSync(
     return err;
   }
 
+  SAFE_DISPOSE_API(read_cache_storage_api);
+
   SetHandleStep(handle, "Flushing uploads");
 
   struct SyncFlush flushCB;
@@ -745,10 +837,15 @@ SubmitAsync(
     const char* Message,
     uint32_t TargetChunkSize,
     uint32_t TargetBlockSize,
+    uint32_t MinTargetBlockSize,
+    uint32_t MaxTargetBlockSize,
     uint32_t MaxChunksPerBlock,
     uint32_t MinBlockUsagePercent,
     const char* HashingAlgo,
+    const char* ChunkingAlgo,
     const char* CompressionAlgo,
+    uint32_t MinCompressionSavingPercent,
+    uint64_t ReadCacheSize,
     bool EnableMmapIndexing,
     bool EnableMmapBlockStore,
     const char* LocalRootPath,
@@ -769,6 +866,8 @@ SubmitAsync(
     const char* WorkspaceId,
     uint32_t NumModifications,
     const Checkpoint::Modification* Modifications,
+    uint32_t NumAssetPolicies,
+    const Checkpoint::AssetPolicy* AssetPolicies,
     int LogLevel = 4) {
   SetLogging(LogLevel);
 
@@ -789,10 +888,15 @@ SubmitAsync(
         Message,
         TargetChunkSize,
         TargetBlockSize,
+        MinTargetBlockSize,
+        MaxTargetBlockSize,
         MaxChunksPerBlock,
         MinBlockUsagePercent,
         HashingAlgo,
+        ChunkingAlgo,
         CompressionAlgo,
+        MinCompressionSavingPercent,
+        ReadCacheSize,
         EnableMmapIndexing,
         EnableMmapBlockStore,
         LocalRootPath,
@@ -813,6 +917,8 @@ SubmitAsync(
         WorkspaceId,
         NumModifications,
         Modifications,
+        NumAssetPolicies,
+        AssetPolicies,
         handle);
 
     if (err) {
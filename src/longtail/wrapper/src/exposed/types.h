@@ -11,4 +11,13 @@ struct Modification {
   const char* OldPath;
 };
 
+// Overrides the compression algorithm and/or target chunk size for files
+// whose path matches Pattern. A null CompressionAlgo or a zero
+// TargetChunkSize keeps the version wide setting.
+struct AssetPolicy {
+  const char* Pattern;
+  const char* CompressionAlgo;
+  uint32_t TargetChunkSize;
+};
+
 }  // namespace Checkpoint
@@ -0,0 +1,136 @@
+#include "asset-policy.h"
+
+#include <cctype>
+#include <cstring>
+#include <unordered_map>
+
+static bool GlobMatch(const char* pattern, const char* str) {
+  while (*pattern) {
+    if (pattern[0] == '*' && pattern[1] == '*') {
+      pattern += 2;
+      if (*pattern == '/') {
+        // "**/" also matches zero directories
+        if (GlobMatch(pattern + 1, str)) {
+          return true;
+        }
+      }
+      for (const char* s = str;; ++s) {
+        if (GlobMatch(pattern, s)) {
+          return true;
+        }
+        if (!*s) {
+          return false;
+        }
+      }
+    }
+    if (*pattern == '*') {
+      ++pattern;
+      for (const char* s = str;; ++s) {
+        if (GlobMatch(pattern, s)) {
+          return true;
+        }
+        if (!*s || *s == '/') {
+          return false;
+        }
+      }
+    }
+    if (!*str) {
+      return false;
+    }
+    if (*pattern == '?') {
+      if (*str == '/') {
+        return false;
+      }
+    } else if (tolower((unsigned char)*pattern) != tolower((unsigned char)*str)) {
+      return false;
+    }
+    ++pattern;
+    ++str;
+  }
+  return *str == 0;
+}
+
+static bool AssetPolicyMatches(const char* pattern, const char* path) {
+  if (!pattern || !*pattern) {
+    return false;
+  }
+  if (strchr(pattern, '/')) {
+    return GlobMatch(pattern, path);
+  }
+  const char* name = strrchr(path, '/');
+  name = name ? name + 1 : path;
+  if (pattern[0] == '.' && !strpbrk(pattern, "*?")) {
+    size_t name_length = strlen(name);
+    size_t pattern_length = strlen(pattern);
+    return name_length > pattern_length && GlobMatch(pattern, &name[name_length - pattern_length]);
+  }
+  return GlobMatch(pattern, name);
+}
+
+const Checkpoint::AssetPolicy* FindAssetPolicy(const char* path, uint32_t num_asset_policies, const Checkpoint::AssetPolicy* asset_policies) {
+  for (uint32_t i = 0; i < num_asset_policies; ++i) {
+    if (AssetPolicyMatches(asset_policies[i].Pattern, path)) {
+      return &asset_policies[i];
+    }
+  }
+  return nullptr;
+}
+
+int ResolveAssetPolicies(const struct Longtail_FileInfos* file_infos, uint32_t default_compression_type, uint32_t num_asset_policies, const Checkpoint::AssetPolicy* asset_policies, uint32_t* optional_out_tags, uint32_t* optional_out_chunk_sizes) {
+  for (uint32_t i = 0; i < file_infos->m_Count; ++i) {
+    const char* path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[i]];
+    const Checkpoint::AssetPolicy* policy = FindAssetPolicy(path, num_asset_policies, asset_policies);
+
+    if (optional_out_tags) {
+      uint32_t compression_type = default_compression_type;
+      if (policy && policy->CompressionAlgo) {
+        compression_type = ParseCompressionType(policy->CompressionAlgo);
+        if (compression_type == 0xffffffff) {
+          return EINVAL;
+        }
+      }
+      optional_out_tags[i] = compression_type;
+    }
+    if (optional_out_chunk_sizes) {
+      optional_out_chunk_sizes[i] = policy ? policy->TargetChunkSize : 0;
+    }
+  }
+  return 0;
+}
+
+uint32_t GetVersionAssetChunkSize(const struct Longtail_VersionIndex* version_index, uint32_t asset_index, uint32_t num_asset_policies, const Checkpoint::AssetPolicy* asset_policies) {
+  const uint32_t* asset_chunk_sizes = Longtail_VersionIndex_GetAssetTargetChunkSizes(version_index);
+  if (asset_chunk_sizes) {
+    return asset_chunk_sizes[asset_index];
+  }
+  const char* path = &version_index->m_NameData[version_index->m_NameOffsets[asset_index]];
+  const Checkpoint::AssetPolicy* policy = FindAssetPolicy(path, num_asset_policies, asset_policies);
+  return policy ? policy->TargetChunkSize : 0;
+}
+
+int ResolveVersionChunkSizes(struct Longtail_HashAPI* hash_api, const struct Longtail_VersionIndex* version_index, const struct Longtail_FileInfos* file_infos, uint32_t num_asset_policies, const Checkpoint::AssetPolicy* asset_policies, uint32_t* out_chunk_sizes) {
+  int err = ResolveAssetPolicies(file_infos, 0, num_asset_policies, asset_policies, nullptr, out_chunk_sizes);
+  const uint32_t* asset_chunk_sizes = Longtail_VersionIndex_GetAssetTargetChunkSizes(version_index);
+  if (err || !asset_chunk_sizes) {
+    return err;
+  }
+  uint32_t asset_count = *version_index->m_AssetCount;
+  std::unordered_map<TLongtail_Hash, uint32_t> asset_indexes;
+  asset_indexes.reserve(asset_count);
+  for (uint32_t a = 0; a < asset_count; ++a) {
+    asset_indexes[version_index->m_PathHashes[a]] = a;
+  }
+  for (uint32_t i = 0; i < file_infos->m_Count; ++i) {
+    const char* path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[i]];
+    TLongtail_Hash path_hash;
+    err = Longtail_GetPathHash(hash_api, path, &path_hash);
+    if (err) {
+      return err;
+    }
+    auto it = asset_indexes.find(path_hash);
+    if (it != asset_indexes.end()) {
+      out_chunk_sizes[i] = asset_chunk_sizes[it->second];
+    }
+  }
+  return 0;
+}
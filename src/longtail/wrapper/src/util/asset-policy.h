@@ -0,0 +1,22 @@
+#pragma once
+
+#include "../exposed/main.h"
+
+// Patterns are case-insensitive globs where `*` and `?` do not match '/' and
+// `**` matches anything. A pattern without '/' matches the file name only and
+// a bare extension such as ".png" is treated as "*.png". First match wins.
+const Checkpoint::AssetPolicy* FindAssetPolicy(const char* path, uint32_t num_asset_policies, const Checkpoint::AssetPolicy* asset_policies);
+
+// Fills optional_out_tags with the compression tag and optional_out_chunk_sizes
+// with the target chunk size (zero for the default) of each file. Returns
+// EINVAL if a matching policy names an unknown compression algorithm.
+int ResolveAssetPolicies(const struct Longtail_FileInfos* file_infos, uint32_t default_compression_type, uint32_t num_asset_policies, const Checkpoint::AssetPolicy* asset_policies, uint32_t* optional_out_tags, uint32_t* optional_out_chunk_sizes);
+
+// Returns the target chunk size (zero for the default) asset_index of version_index
+// was chunked with, versions that do not record it use the matching policy.
+uint32_t GetVersionAssetChunkSize(const struct Longtail_VersionIndex* version_index, uint32_t asset_index, uint32_t num_asset_policies, const Checkpoint::AssetPolicy* asset_policies);
+
+// Fills out_chunk_sizes with the target chunk size (zero for the default) each file
+// was chunked with in version_index so local files can be chunked the same way.
+// Files that are not part of version_index use the matching policy.
+int ResolveVersionChunkSizes(struct Longtail_HashAPI* hash_api, const struct Longtail_VersionIndex* version_index, const struct Longtail_FileInfos* file_infos, uint32_t num_asset_policies, const Checkpoint::AssetPolicy* asset_policies, uint32_t* out_chunk_sizes);
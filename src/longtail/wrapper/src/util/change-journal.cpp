@@ -0,0 +1,394 @@
+#include "change-journal.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <unordered_map>
+
+static const uint32_t ChangeJournalMagic = 0x4a43434c;  // "LCCJ"
+static const uint32_t ChangeJournalVersion = 1;
+
+// Cursors are handed to JavaScript as numbers so session and sequence together
+// have to fit in 53 bits
+static const uint32_t MaxChangeJournalSession = (1u << 21) - 1;
+
+static const uint32_t ChangeJournalWatchMask =
+    IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF |
+    IN_DONT_FOLLOW | IN_EXCL_UNLINK | IN_ONLYDIR;
+
+struct ChangeJournalHeader {
+  uint32_t m_Magic;
+  uint32_t m_Version;
+  uint32_t m_Session;
+  uint32_t m_Reserved;
+};
+
+struct ChangeJournal {
+  std::string m_RootPath;
+  int m_InotifyFd = -1;
+  int m_WakeFd = -1;
+  std::thread m_Thread;
+
+  // Only accessed by the journal thread
+  std::unordered_map<int, std::string> m_WatchPaths;
+
+  std::mutex m_Lock;
+  std::unordered_map<std::string, uint32_t> m_Changes;
+  uint32_t m_Session = 0;
+  uint32_t m_Sequence = 0;
+  // Cursors with a lower sequence predate a gap in the journal, zero until
+  // every directory is watched
+  uint32_t m_ValidFrom = 0;
+  int m_Err = 0;
+};
+
+static bool IsExcludedPath(const std::string& path) {
+  return path == ".checkpoint" || path.compare(0, 12, ".checkpoint/") == 0;
+}
+
+static std::string GetFullPath(const ChangeJournal* journal, const std::string& path) {
+  return path.empty() ? journal->m_RootPath : journal->m_RootPath + "/" + path;
+}
+
+static std::string JoinPath(const std::string& parent, const char* name) {
+  return parent.empty() ? std::string(name) : parent + "/" + name;
+}
+
+static int NextChangeJournalSession(const std::string& root_path, uint32_t* out_session) {
+  std::string dir = root_path + "/.checkpoint";
+  std::string path = dir + "/change-journal.lccj";
+  std::string tmp_path = path + ".tmp";
+
+  ChangeJournalHeader header;
+  memset(&header, 0, sizeof(header));
+  uint32_t session = 0;
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd != -1) {
+    if (read(fd, &header, sizeof(header)) == (ssize_t)sizeof(header) && header.m_Magic == ChangeJournalMagic && header.m_Version == ChangeJournalVersion) {
+      session = header.m_Session;
+    }
+    close(fd);
+  }
+  session = (session % MaxChangeJournalSession) + 1;
+
+  if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    return errno;
+  }
+  memset(&header, 0, sizeof(header));
+  header.m_Magic = ChangeJournalMagic;
+  header.m_Version = ChangeJournalVersion;
+  header.m_Session = session;
+  fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd == -1) {
+    return errno;
+  }
+  int err = 0;
+  if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+    err = errno ? errno : EIO;
+  }
+  close(fd);
+  if (!err && rename(tmp_path.c_str(), path.c_str()) != 0) {
+    err = errno;
+  }
+  if (err) {
+    unlink(tmp_path.c_str());
+    return err;
+  }
+  *out_session = session;
+  return 0;
+}
+
+static void InvalidateCursors(ChangeJournal* journal) {
+  std::lock_guard<std::mutex> lock(journal->m_Lock);
+  journal->m_ValidFrom = ++journal->m_Sequence;
+}
+
+static void SetJournalError(ChangeJournal* journal, int err) {
+  std::lock_guard<std::mutex> lock(journal->m_Lock);
+  if (!journal->m_Err) {
+    journal->m_Err = err;
+  }
+}
+
+// Watches directory_path and every directory below it. A directory is watched
+// before it is listed so entries created while it is listed are not missed, if
+// record_entries is set every entry found is added to changed_paths.
+static int AddWatches(ChangeJournal* journal, const std::string& directory_path, bool record_entries, std::vector<std::string>& changed_paths) {
+  MAKE_LOG_CONTEXT(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+  std::vector<std::string> pending(1, directory_path);
+  while (!pending.empty()) {
+    std::string path = std::move(pending.back());
+    pending.pop_back();
+
+    std::string full_path = GetFullPath(journal, path);
+    int wd = inotify_add_watch(journal->m_InotifyFd, full_path.c_str(), ChangeJournalWatchMask);
+    if (wd == -1) {
+      int err = errno;
+      if (err == ENOENT || err == ENOTDIR) {
+        // Removed or replaced before we got to it, the parent reports that
+        continue;
+      }
+      LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "inotify_add_watch() failed with %d for `%s`", err, full_path.c_str())
+      return err;
+    }
+    journal->m_WatchPaths[wd] = path;
+
+    DIR* dir = opendir(full_path.c_str());
+    if (!dir) {
+      continue;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+        continue;
+      }
+      std::string entry_path = JoinPath(path, entry->d_name);
+      if (IsExcludedPath(entry_path)) {
+        continue;
+      }
+      if (record_entries) {
+        changed_paths.push_back(entry_path);
+      }
+      bool is_dir = entry->d_type == DT_DIR;
+      if (entry->d_type == DT_UNKNOWN) {
+        struct stat st;
+        is_dir = fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+      }
+      if (is_dir) {
+        pending.push_back(entry_path);
+      }
+    }
+    closedir(dir);
+  }
+  return 0;
+}
+
+// Stops watching directory_path and every directory below it, used when a
+// directory is moved since the watches would keep reporting the old paths
+static void RemoveWatches(ChangeJournal* journal, const std::string& directory_path) {
+  std::string prefix = directory_path + "/";
+  for (auto it = journal->m_WatchPaths.begin(); it != journal->m_WatchPaths.end();) {
+    if (it->second == directory_path || it->second.compare(0, prefix.size(), prefix) == 0) {
+      inotify_rm_watch(journal->m_InotifyFd, it->first);
+      it = journal->m_WatchPaths.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+static void RunChangeJournal(ChangeJournal* journal) {
+  MAKE_LOG_CONTEXT(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+  std::vector<std::string> changed_paths;
+  int err = AddWatches(journal, std::string(), false, changed_paths);
+  if (err) {
+    SetJournalError(journal, err);
+    return;
+  }
+  InvalidateCursors(journal);
+  LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "Change journal for `%s` is watching %u directories", journal->m_RootPath.c_str(), (uint32_t)journal->m_WatchPaths.size())
+
+  alignas(struct inotify_event) char buffer[65536];
+  while (true) {
+    struct pollfd fds[2];
+    fds[0].fd = journal->m_InotifyFd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = journal->m_WakeFd;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+    if (poll(fds, 2, -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      SetJournalError(journal, errno);
+      return;
+    }
+    if (fds[1].revents) {
+      return;
+    }
+    ssize_t length = read(journal->m_InotifyFd, buffer, sizeof(buffer));
+    if (length <= 0) {
+      if (length == -1 && (errno == EAGAIN || errno == EINTR)) {
+        continue;
+      }
+      SetJournalError(journal, length == 0 ? EIO : errno);
+      return;
+    }
+
+    bool overflow = false;
+    changed_paths.clear();
+    for (char* p = buffer; p < buffer + length;) {
+      const struct inotify_event* event = (const struct inotify_event*)p;
+      p += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        overflow = true;
+        continue;
+      }
+      auto it = journal->m_WatchPaths.find(event->wd);
+      if (it == journal->m_WatchPaths.end()) {
+        continue;
+      }
+      if (event->mask & IN_IGNORED) {
+        journal->m_WatchPaths.erase(it);
+        continue;
+      }
+      if (event->len == 0) {
+        if ((event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) && it->second.empty()) {
+          LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Workspace root `%s` was removed or moved", journal->m_RootPath.c_str())
+          SetJournalError(journal, ENOENT);
+          return;
+        }
+        continue;
+      }
+      std::string path = JoinPath(it->second, event->name);
+      if (IsExcludedPath(path)) {
+        continue;
+      }
+      changed_paths.push_back(path);
+      if (event->mask & IN_ISDIR) {
+        if (event->mask & IN_MOVED_FROM) {
+          RemoveWatches(journal, path);
+        } else if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+          err = AddWatches(journal, path, true, changed_paths);
+          if (err) {
+            SetJournalError(journal, err);
+            return;
+          }
+        }
+      }
+    }
+
+    if (overflow) {
+      LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "Change journal for `%s` overflowed", journal->m_RootPath.c_str())
+      InvalidateCursors(journal);
+    }
+    if (!changed_paths.empty()) {
+      std::lock_guard<std::mutex> lock(journal->m_Lock);
+      for (const std::string& path : changed_paths) {
+        journal->m_Changes[path] = ++journal->m_Sequence;
+      }
+    }
+  }
+}
+
+int CreateChangeJournal(const char* local_root_path, ChangeJournal** out_journal) {
+  MAKE_LOG_CONTEXT_FIELDS(ctx)
+    LONGTAIL_LOGFIELD(local_root_path, "%s")
+  MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+  std::string root_path(local_root_path);
+  while (root_path.size() > 1 && root_path.back() == '/') {
+    root_path.pop_back();
+  }
+
+  uint32_t session = 0;
+  int err = NextChangeJournalSession(root_path, &session);
+  if (err) {
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to persist change journal session, %d", err)
+    return err;
+  }
+
+  ChangeJournal* journal = new ChangeJournal();
+  journal->m_RootPath = root_path;
+  journal->m_Session = session;
+  journal->m_InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (journal->m_InotifyFd == -1) {
+    err = errno;
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "inotify_init1() failed with %d", err)
+    delete journal;
+    return err;
+  }
+  journal->m_WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (journal->m_WakeFd == -1) {
+    err = errno;
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "eventfd() failed with %d", err)
+    close(journal->m_InotifyFd);
+    delete journal;
+    return err;
+  }
+  journal->m_Thread = std::thread(RunChangeJournal, journal);
+  *out_journal = journal;
+  return 0;
+}
+
+int ReadChangeJournal(
+    ChangeJournal* journal,
+    uint64_t cursor,
+    uint64_t* out_cursor,
+    bool* out_full_scan_required,
+    std::vector<std::string>& out_paths) {
+  uint32_t cursor_session = (uint32_t)(cursor >> 32);
+  uint32_t cursor_sequence = (uint32_t)cursor;
+
+  std::lock_guard<std::mutex> lock(journal->m_Lock);
+  bool full_scan_required = journal->m_Err != 0 ||
+                            journal->m_ValidFrom == 0 ||
+                            cursor_session != journal->m_Session ||
+                            cursor_sequence < journal->m_ValidFrom;
+  for (auto it = journal->m_Changes.begin(); it != journal->m_Changes.end();) {
+    if (full_scan_required || it->second <= cursor_sequence) {
+      it = journal->m_Changes.erase(it);
+    } else {
+      out_paths.push_back(it->first);
+      ++it;
+    }
+  }
+  std::sort(out_paths.begin(), out_paths.end());
+
+  // A journal that is not watching everything yet hands out cursors that
+  // always require a full scan
+  uint32_t sequence = (journal->m_ValidFrom != 0 && journal->m_Err == 0) ? journal->m_Sequence : 0;
+  *out_cursor = ((uint64_t)journal->m_Session << 32) | sequence;
+  *out_full_scan_required = full_scan_required;
+  return 0;
+}
+
+void DisposeChangeJournal(ChangeJournal* journal) {
+  if (!journal) {
+    return;
+  }
+  uint64_t wake = 1;
+  ssize_t written = write(journal->m_WakeFd, &wake, sizeof(wake));
+  (void)written;
+  journal->m_Thread.join();
+  close(journal->m_WakeFd);
+  close(journal->m_InotifyFd);
+  delete journal;
+}
+
+#else
+
+struct ChangeJournal {
+};
+
+int CreateChangeJournal(const char* local_root_path, ChangeJournal** out_journal) {
+  return ENOTSUP;
+}
+
+int ReadChangeJournal(
+    ChangeJournal* journal,
+    uint64_t cursor,
+    uint64_t* out_cursor,
+    bool* out_full_scan_required,
+    std::vector<std::string>& out_paths) {
+  return ENOTSUP;
+}
+
+void DisposeChangeJournal(ChangeJournal* journal) {
+}
+
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../exposed/main.h"
+
+#include <string>
+#include <vector>
+
+// A change journal records the paths below a workspace root that are created,
+// modified, renamed or deleted while it is open, so finding the changes of a
+// workspace does not require comparing every file in it. Only implemented on
+// Linux where it is backed by inotify, fanotify would need CAP_SYS_ADMIN to
+// report file names.
+//
+// A cursor is a session number in the upper 32 bits and a sequence number in
+// the lower 32 bits. The session number is persisted in
+// <LocalRootPath>/.checkpoint/change-journal.lccj and increases every time a
+// journal is created for the workspace, so a cursor from an earlier journal is
+// never mistaken for one of the current journal.
+struct ChangeJournal;
+
+// Starts journaling the changes below local_root_path. Directories are watched
+// on a background thread and the journal reports that a full scan is required
+// until all of them are watched. Returns ENOTSUP on platforms without a change
+// journal implementation.
+int CreateChangeJournal(const char* local_root_path, ChangeJournal** out_journal);
+
+// Gets the paths, relative to the workspace root, that changed after cursor
+// and the cursor to pass in the next call. Paths at or before cursor are
+// dropped from the journal. If out_full_scan_required is set the journal does
+// not cover everything since cursor (cursor is from another session, the
+// kernel event queue overflowed or the journal has not started yet) and the
+// caller has to compare the whole workspace, out_paths is then empty.
+int ReadChangeJournal(
+    ChangeJournal* journal,
+    uint64_t cursor,
+    uint64_t* out_cursor,
+    bool* out_full_scan_required,
+    std::vector<std::string>& out_paths);
+
+void DisposeChangeJournal(ChangeJournal* journal);
@@ -41,3 +41,19 @@ int SyncGetExistingContent(struct Longtail_BlockStoreAPI* block_store, uint32_t
   *out_store_index = store_index;
   return 0;
 }
+
+void StartStoreIndexPrefetch(struct StoreIndexPrefetch* prefetch, struct Longtail_BlockStoreAPI* block_store) {
+  prefetch->m_Thread = std::thread([block_store]() {
+    struct Longtail_StoreIndex* store_index = 0;
+    int err = SyncGetExistingContent(block_store, 0, 0, 0, &store_index);
+    if (err == 0) {
+      Longtail_Free(store_index);
+    }
+  });
+}
+
+void WaitStoreIndexPrefetch(struct StoreIndexPrefetch* prefetch) {
+  if (prefetch->m_Thread.joinable()) {
+    prefetch->m_Thread.join();
+  }
+}
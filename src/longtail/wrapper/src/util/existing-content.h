@@ -2,6 +2,8 @@
 
 #include "../exposed/main.h"
 
+#include <thread>
+
 struct AsyncGetExistingContentComplete {
   struct Longtail_AsyncGetExistingContentAPI m_API;
   HLongtail_Sema m_NotifySema;
@@ -14,3 +16,15 @@ void AsyncGetExistingContentComplete_Wait(struct AsyncGetExistingContentComplete
 void AsyncGetExistingContentComplete_Init(struct AsyncGetExistingContentComplete* api);
 void AsyncGetExistingContentComplete_Dispose(struct AsyncGetExistingContentComplete* api);
 int SyncGetExistingContent(struct Longtail_BlockStoreAPI* block_store, uint32_t chunk_count, const TLongtail_Hash* chunk_hashes, uint32_t min_block_usage_percent, struct Longtail_StoreIndex** out_store_index);
+
+// Asks block_store for existing content on a separate thread so a block store
+// that loads its store index on first use (FSBlockStore) downloads it while the
+// caller indexes local files. Call WaitStoreIndexPrefetch before using or
+// disposing block_store, errors are left for the following
+// SyncGetExistingContent to report.
+struct StoreIndexPrefetch {
+  std::thread m_Thread;
+};
+
+void StartStoreIndexPrefetch(struct StoreIndexPrefetch* prefetch, struct Longtail_BlockStoreAPI* block_store);
+void WaitStoreIndexPrefetch(struct StoreIndexPrefetch* prefetch);
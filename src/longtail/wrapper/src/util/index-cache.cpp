@@ -0,0 +1,578 @@
+#include "index-cache.h"
+
+#include "asset-policy.h"
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+static const uint32_t IndexCacheMagic = 0x5849434c;  // "LCIX"
+static const uint32_t IndexCacheVersion = 2;
+
+// A file modified this close to when the cache was written may have been
+// modified again without its modification time changing
+static const int64_t RacyIntervalNs = 2000000000ll;
+
+struct IndexCacheHeader {
+  uint32_t m_Magic;
+  uint32_t m_Version;
+  uint32_t m_EntryCount;
+  uint32_t m_Reserved;
+  int64_t m_WrittenAtNs;
+};
+
+struct IndexCacheEntry {
+  TLongtail_Hash m_PathHash;
+  uint64_t m_Size;
+  int64_t m_ModificationTimeNs;
+  uint64_t m_Inode;
+  uint32_t m_TargetChunkSize;
+  uint32_t m_Reserved;
+  // Longtail_GetFileFingerprints() of the file as it is in the cached version index, zero if unknown
+  TLongtail_Hash m_Fingerprint;
+};
+
+struct IndexCache {
+  struct Longtail_VersionIndex* m_VersionIndex = nullptr;
+  int64_t m_WrittenAtNs = 0;
+  std::unordered_map<TLongtail_Hash, IndexCacheEntry> m_Entries;
+
+  ~IndexCache() {
+    Longtail_Free(m_VersionIndex);
+  }
+};
+
+struct FileStat {
+  uint64_t m_Size;
+  int64_t m_ModificationTimeNs;
+  uint64_t m_Inode;
+};
+
+static bool GetFileStat(const char* path, FileStat& out_stat) {
+#ifdef _WIN32
+  int length = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+  if (length <= 0) {
+    return false;
+  }
+  std::wstring wide_path((size_t)length, L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, path, -1, &wide_path[0], length);
+  HANDLE file = CreateFileW(wide_path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  BY_HANDLE_FILE_INFORMATION info;
+  BOOL ok = GetFileInformationByHandle(file, &info);
+  CloseHandle(file);
+  if (!ok) {
+    return false;
+  }
+  // FILETIME counts 100ns intervals since 1601-01-01
+  uint64_t write_time = ((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+  out_stat.m_Size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+  out_stat.m_ModificationTimeNs = ((int64_t)write_time - 116444736000000000ll) * 100;
+  out_stat.m_Inode = ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+#else
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    return false;
+  }
+  out_stat.m_Size = (uint64_t)st.st_size;
+#ifdef __APPLE__
+  out_stat.m_ModificationTimeNs = (int64_t)st.st_mtimespec.tv_sec * 1000000000ll + st.st_mtimespec.tv_nsec;
+#else
+  out_stat.m_ModificationTimeNs = (int64_t)st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+#endif
+  out_stat.m_Inode = (uint64_t)st.st_ino;
+#endif
+  return true;
+}
+
+static std::string GetIndexCacheDir(struct Longtail_StorageAPI* file_storage_api, const char* local_root_path) {
+  char* checkpoint_path = file_storage_api->ConcatPath(file_storage_api, local_root_path, ".checkpoint");
+  char* cache_path = file_storage_api->ConcatPath(file_storage_api, checkpoint_path, "index-cache");
+  std::string result(cache_path);
+  Longtail_Free(cache_path);
+  Longtail_Free(checkpoint_path);
+  return result;
+}
+
+static std::string GetIndexCachePath(struct Longtail_StorageAPI* file_storage_api, const char* local_root_path, const char* name) {
+  std::string cache_dir = GetIndexCacheDir(file_storage_api, local_root_path);
+  char* path = file_storage_api->ConcatPath(file_storage_api, cache_dir.c_str(), name);
+  std::string result(path);
+  Longtail_Free(path);
+  return result;
+}
+
+static bool GetAssetFileStat(struct Longtail_StorageAPI* file_storage_api, const char* local_root_path, const char* asset_path, FileStat& out_stat) {
+  char* full_path = file_storage_api->ConcatPath(file_storage_api, local_root_path, asset_path);
+  bool ok = GetFileStat(full_path, out_stat);
+  Longtail_Free(full_path);
+  return ok;
+}
+
+static bool IsUnchanged(const IndexCacheEntry& entry, int64_t written_at_ns, const FileStat& stat, uint32_t target_chunk_size) {
+  return entry.m_Size == stat.m_Size &&
+         entry.m_ModificationTimeNs == stat.m_ModificationTimeNs &&
+         entry.m_Inode == stat.m_Inode &&
+         entry.m_TargetChunkSize == target_chunk_size &&
+         entry.m_ModificationTimeNs < written_at_ns - RacyIntervalNs;
+}
+
+static int ReadIndexCache(struct Longtail_StorageAPI* file_storage_api, struct Longtail_HashAPI* hash_api, const char* local_root_path, IndexCache& out_cache) {
+  std::string cache_path = GetIndexCachePath(file_storage_api, local_root_path, "index.lcix");
+  if (!file_storage_api->IsFile(file_storage_api, cache_path.c_str())) {
+    return ENOENT;
+  }
+  Longtail_StorageAPI_HOpenFile file;
+  int err = file_storage_api->OpenReadFile(file_storage_api, cache_path.c_str(), &file);
+  if (err) {
+    return err;
+  }
+  uint64_t size = 0;
+  std::vector<uint8_t> data;
+  err = file_storage_api->GetSize(file_storage_api, file, &size);
+  if (!err) {
+    data.resize((size_t)size);
+    err = size == 0 ? EBADF : file_storage_api->Read(file_storage_api, file, 0, size, data.data());
+  }
+  file_storage_api->CloseFile(file_storage_api, file);
+  if (err) {
+    return err;
+  }
+
+  IndexCacheHeader header;
+  if (data.size() < sizeof(header)) {
+    return EBADF;
+  }
+  memcpy(&header, data.data(), sizeof(header));
+  size_t entries_size = sizeof(IndexCacheEntry) * (size_t)header.m_EntryCount;
+  if (header.m_Magic != IndexCacheMagic || header.m_Version != IndexCacheVersion || data.size() < sizeof(header) + entries_size) {
+    return EBADF;
+  }
+  const uint8_t* entries = data.data() + sizeof(header);
+  for (uint32_t i = 0; i < header.m_EntryCount; ++i) {
+    IndexCacheEntry entry;
+    memcpy(&entry, entries + sizeof(IndexCacheEntry) * i, sizeof(entry));
+    out_cache.m_Entries[entry.m_PathHash] = entry;
+  }
+  size_t version_index_offset = sizeof(header) + entries_size;
+  err = Longtail_ReadVersionIndexFromBuffer(data.data() + version_index_offset, data.size() - version_index_offset, &out_cache.m_VersionIndex);
+  if (err) {
+    return err;
+  }
+  if (*out_cache.m_VersionIndex->m_HashIdentifier != hash_api->GetIdentifier(hash_api)) {
+    return EBADF;
+  }
+  out_cache.m_WrittenAtNs = header.m_WrittenAtNs;
+  return 0;
+}
+
+static int WriteIndexCache(struct Longtail_StorageAPI* file_storage_api, const char* local_root_path, const struct Longtail_VersionIndex* version_index, const std::vector<IndexCacheEntry>& entries, int64_t written_at_ns) {
+  void* version_index_buffer = 0;
+  size_t version_index_size = 0;
+  int err = Longtail_WriteVersionIndexToBuffer(version_index, &version_index_buffer, &version_index_size);
+  if (err) {
+    return err;
+  }
+
+  IndexCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  header.m_Magic = IndexCacheMagic;
+  header.m_Version = IndexCacheVersion;
+  header.m_EntryCount = (uint32_t)entries.size();
+  header.m_WrittenAtNs = written_at_ns;
+  size_t entries_size = sizeof(IndexCacheEntry) * entries.size();
+
+  std::string cache_dir = GetIndexCacheDir(file_storage_api, local_root_path);
+  std::string cache_path = GetIndexCachePath(file_storage_api, local_root_path, "index.lcix");
+  std::string tmp_path = GetIndexCachePath(file_storage_api, local_root_path, "index.lcix.tmp");
+  if (!file_storage_api->IsDir(file_storage_api, cache_dir.c_str())) {
+    err = file_storage_api->CreateDir(file_storage_api, cache_dir.c_str());
+    if (err == EEXIST) {
+      err = 0;
+    }
+  }
+
+  Longtail_StorageAPI_HOpenFile file;
+  uint64_t size = sizeof(header) + entries_size + version_index_size;
+  if (!err) {
+    err = file_storage_api->OpenWriteFile(file_storage_api, tmp_path.c_str(), size, &file);
+  }
+  if (!err) {
+    err = file_storage_api->Write(file_storage_api, file, 0, sizeof(header), &header);
+    if (!err && entries_size > 0) {
+      err = file_storage_api->Write(file_storage_api, file, sizeof(header), entries_size, entries.data());
+    }
+    if (!err) {
+      err = file_storage_api->Write(file_storage_api, file, sizeof(header) + entries_size, version_index_size, version_index_buffer);
+    }
+    file_storage_api->CloseFile(file_storage_api, file);
+  }
+  Longtail_Free(version_index_buffer);
+
+  // Replace the previous cache only once the new one is completely written
+  if (!err) {
+    if (file_storage_api->IsFile(file_storage_api, cache_path.c_str())) {
+      err = file_storage_api->RemoveFile(file_storage_api, cache_path.c_str());
+    }
+    if (!err) {
+      err = file_storage_api->RenameFile(file_storage_api, tmp_path.c_str(), cache_path.c_str());
+    }
+  }
+  if (err) {
+    file_storage_api->RemoveFile(file_storage_api, tmp_path.c_str());
+  }
+  return err;
+}
+
+static int64_t GetCurrentTimeNs() {
+  return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int CreateCachedLocalVersionIndex(
+    struct Longtail_StorageAPI* file_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    const char* local_root_path,
+    const struct Longtail_FileInfos* file_infos,
+    const uint32_t* tags,
+    const uint32_t* chunk_sizes,
+    uint32_t flags,
+    uint32_t target_chunk_size,
+    bool enable_file_map,
+    struct Longtail_VersionIndex** out_version_index,
+    LocalFileFingerprints* out_fingerprints) {
+  IndexCache cache;
+  if (ReadIndexCache(file_storage_api, hash_api, local_root_path, cache) != 0 ||
+      *cache.m_VersionIndex->m_TargetChunkSize != target_chunk_size ||
+      Longtail_VersionIndex_GetChunkerIdentifier(cache.m_VersionIndex) != Longtail_Chunker_GetIdentifier(chunker_api) ||
+      (Longtail_VersionIndex_GetFlags(cache.m_VersionIndex) & LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS) != (flags & LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS)) {
+    return Longtail_CreateVersionIndexWithChunkSizes(
+        file_storage_api,
+        hash_api,
+        chunker_api,
+        job_api,
+        progress_api,
+        0,
+        0,
+        local_root_path,
+        file_infos,
+        tags,
+        chunk_sizes,
+        flags,
+        target_chunk_size,
+        enable_file_map,
+        out_version_index);
+  }
+
+  const struct Longtail_VersionIndex* cached_version_index = cache.m_VersionIndex;
+  uint32_t cached_asset_count = *cached_version_index->m_AssetCount;
+  std::unordered_map<TLongtail_Hash, uint32_t> cached_asset_indexes;
+  cached_asset_indexes.reserve(cached_asset_count);
+  for (uint32_t a = 0; a < cached_asset_count; ++a) {
+    cached_asset_indexes[cached_version_index->m_PathHashes[a]] = a;
+  }
+
+  std::vector<bool> keep_cached_asset(cached_asset_count, false);
+  std::vector<uint32_t> touched_files;
+  std::vector<uint32_t> touched_cached_assets;
+  std::vector<TLongtail_Hash> touched_path_hashes;
+  std::vector<TLongtail_Hash> touched_fingerprints;
+  std::vector<const char*> dirty_paths;
+  std::vector<uint64_t> dirty_sizes;
+  std::vector<uint16_t> dirty_permissions;
+  std::vector<uint32_t> dirty_tags;
+  std::vector<uint32_t> dirty_chunk_sizes;
+  for (uint32_t i = 0; i < file_infos->m_Count; ++i) {
+    const char* path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[i]];
+    uint32_t file_chunk_size = chunk_sizes ? chunk_sizes[i] : 0;
+    TLongtail_Hash path_hash = 0;
+    auto cached_asset_it = cached_asset_indexes.end();
+    auto entry_it = cache.m_Entries.end();
+    if (Longtail_GetPathHash(hash_api, path, &path_hash) == 0) {
+      cached_asset_it = cached_asset_indexes.find(path_hash);
+      entry_it = cache.m_Entries.find(path_hash);
+    }
+    if (cached_asset_it != cached_asset_indexes.end() && entry_it != cache.m_Entries.end()) {
+      uint32_t a = cached_asset_it->second;
+      FileStat stat;
+      if (cached_version_index->m_AssetSizes[a] == file_infos->m_Sizes[i] &&
+          cached_version_index->m_Permissions[a] == file_infos->m_Permissions[i] &&
+          GetAssetFileStat(file_storage_api, local_root_path, path, stat) &&
+          stat.m_Size == file_infos->m_Sizes[i] &&
+          entry_it->second.m_TargetChunkSize == file_chunk_size) {
+        if (IsUnchanged(entry_it->second, cache.m_WrittenAtNs, stat, file_chunk_size)) {
+          keep_cached_asset[a] = true;
+          continue;
+        }
+        // Touched but possibly unchanged, decided by the fingerprint below
+        touched_files.push_back(i);
+        touched_cached_assets.push_back(a);
+        touched_path_hashes.push_back(path_hash);
+        touched_fingerprints.push_back(entry_it->second.m_Fingerprint);
+        continue;
+      }
+    }
+    dirty_paths.push_back(path);
+    dirty_sizes.push_back(file_infos->m_Sizes[i]);
+    dirty_permissions.push_back(file_infos->m_Permissions[i]);
+    dirty_tags.push_back(tags ? tags[i] : 0);
+    dirty_chunk_sizes.push_back(file_chunk_size);
+  }
+
+  // Reading and hashing a whole file is much cheaper than chunking it, files whose
+  // fingerprint matches the cached one keep their cached chunks. Files without a
+  // cached fingerprint are fingerprinted too so the next touch can be skipped.
+  uint32_t fingerprint_match_count = 0;
+  if (!touched_files.empty()) {
+    std::vector<const char*> touched_paths;
+    std::vector<uint64_t> touched_sizes;
+    std::vector<uint16_t> touched_permissions;
+    for (uint32_t i : touched_files) {
+      touched_paths.push_back(&file_infos->m_PathData[file_infos->m_PathStartOffsets[i]]);
+      touched_sizes.push_back(file_infos->m_Sizes[i]);
+      touched_permissions.push_back(file_infos->m_Permissions[i]);
+    }
+    std::vector<TLongtail_Hash> fingerprints(touched_files.size(), 0);
+    struct Longtail_FileInfos* touched_file_infos = 0;
+    int err = Longtail_MakeFileInfos(
+        (uint32_t)touched_files.size(),
+        touched_paths.data(),
+        touched_sizes.data(),
+        touched_permissions.data(),
+        &touched_file_infos);
+    if (!err) {
+      err = Longtail_GetFileFingerprints(
+          file_storage_api,
+          hash_api,
+          job_api,
+          0,
+          0,
+          0,
+          local_root_path,
+          touched_file_infos,
+          fingerprints.data());
+      Longtail_Free(touched_file_infos);
+    }
+    for (size_t t = 0; t < touched_files.size(); ++t) {
+      uint32_t i = touched_files[t];
+      if (!err) {
+        if (touched_fingerprints[t] != 0 && touched_fingerprints[t] == fingerprints[t]) {
+          keep_cached_asset[touched_cached_assets[t]] = true;
+          ++fingerprint_match_count;
+        }
+        if (out_fingerprints) {
+          // The content hash is filled in once the version index is built
+          (*out_fingerprints)[touched_path_hashes[t]] = LocalFileFingerprint{0, fingerprints[t]};
+        }
+        if (keep_cached_asset[touched_cached_assets[t]]) {
+          continue;
+        }
+      }
+      dirty_paths.push_back(touched_paths[t]);
+      dirty_sizes.push_back(file_infos->m_Sizes[i]);
+      dirty_permissions.push_back(file_infos->m_Permissions[i]);
+      dirty_tags.push_back(tags ? tags[i] : 0);
+      dirty_chunk_sizes.push_back(chunk_sizes ? chunk_sizes[i] : 0);
+    }
+  }
+
+  struct Longtail_FileInfos* dirty_file_infos = 0;
+  int err = Longtail_MakeFileInfos(
+      (uint32_t)dirty_paths.size(),
+      dirty_paths.empty() ? nullptr : dirty_paths.data(),
+      dirty_sizes.empty() ? nullptr : dirty_sizes.data(),
+      dirty_permissions.empty() ? nullptr : dirty_permissions.data(),
+      &dirty_file_infos);
+  if (err) {
+    return err;
+  }
+
+  struct Longtail_VersionIndex* dirty_version_index = 0;
+  err = Longtail_CreateVersionIndexWithChunkSizes(
+      file_storage_api,
+      hash_api,
+      chunker_api,
+      job_api,
+      progress_api,
+      0,
+      0,
+      local_root_path,
+      dirty_file_infos,
+      dirty_tags.empty() ? nullptr : dirty_tags.data(),
+      dirty_chunk_sizes.empty() ? nullptr : dirty_chunk_sizes.data(),
+      flags,
+      target_chunk_size,
+      enable_file_map,
+      &dirty_version_index);
+  Longtail_Free(dirty_file_infos);
+  if (err) {
+    return err;
+  }
+
+  std::vector<TLongtail_Hash> removed_path_hashes;
+  for (uint32_t a = 0; a < cached_asset_count; ++a) {
+    if (!keep_cached_asset[a]) {
+      removed_path_hashes.push_back(cached_version_index->m_PathHashes[a]);
+    }
+  }
+
+  struct Longtail_LogContextFmt_Private* ctx = 0;
+  LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "Reused cached index of %u files (%u by fingerprint), indexed %u files", file_infos->m_Count - (uint32_t)dirty_paths.size(), fingerprint_match_count, (uint32_t)dirty_paths.size())
+
+  err = Longtail_MergeVersionIndex(
+      cached_version_index,
+      dirty_version_index,
+      removed_path_hashes.empty() ? nullptr : removed_path_hashes.data(),
+      removed_path_hashes.size(),
+      out_version_index);
+  Longtail_Free(dirty_version_index);
+  if (err) {
+    // The cache can not be combined with the new index, index everything from scratch
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to merge local index cache, %d", err)
+    if (out_fingerprints) {
+      out_fingerprints->clear();
+    }
+    return Longtail_CreateVersionIndexWithChunkSizes(
+        file_storage_api,
+        hash_api,
+        chunker_api,
+        job_api,
+        progress_api,
+        0,
+        0,
+        local_root_path,
+        file_infos,
+        tags,
+        chunk_sizes,
+        flags,
+        target_chunk_size,
+        enable_file_map,
+        out_version_index);
+  }
+  if (!out_fingerprints || out_fingerprints->empty()) {
+    return 0;
+  }
+
+  const struct Longtail_VersionIndex* version_index = *out_version_index;
+  for (uint32_t a = 0; a < *version_index->m_AssetCount; ++a) {
+    auto it = out_fingerprints->find(version_index->m_PathHashes[a]);
+    if (it != out_fingerprints->end()) {
+      it->second.m_ContentHash = version_index->m_ContentHashes[a];
+    }
+  }
+  return 0;
+}
+
+void UpdateLocalIndexCache(
+    struct Longtail_StorageAPI* file_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    const char* local_root_path,
+    const struct Longtail_VersionIndex* version_index,
+    const LocalFileFingerprints* fingerprints,
+    uint32_t num_asset_policies,
+    const Checkpoint::AssetPolicy* asset_policies) {
+  struct Longtail_LogContextFmt_Private* ctx = 0;
+
+  // Take the time before looking at the files so a file changed while the cache
+  // is written is treated as racy rather than clean
+  int64_t written_at_ns = GetCurrentTimeNs();
+
+  IndexCache cache;
+  bool has_cache = ReadIndexCache(file_storage_api, hash_api, local_root_path, cache) == 0 &&
+                   *cache.m_VersionIndex->m_TargetChunkSize == *version_index->m_TargetChunkSize &&
+                   Longtail_VersionIndex_GetChunkerIdentifier(cache.m_VersionIndex) == Longtail_VersionIndex_GetChunkerIdentifier(version_index) &&
+                   (Longtail_VersionIndex_GetFlags(cache.m_VersionIndex) & LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS) == (Longtail_VersionIndex_GetFlags(version_index) & LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS);
+  std::unordered_map<TLongtail_Hash, TLongtail_Hash> cached_content_hashes;
+  if (has_cache) {
+    const struct Longtail_VersionIndex* cached_version_index = cache.m_VersionIndex;
+    cached_content_hashes.reserve(*cached_version_index->m_AssetCount);
+    for (uint32_t a = 0; a < *cached_version_index->m_AssetCount; ++a) {
+      cached_content_hashes[cached_version_index->m_PathHashes[a]] = cached_version_index->m_ContentHashes[a];
+    }
+  }
+
+  std::vector<IndexCacheEntry> entries;
+  std::unordered_set<TLongtail_Hash> version_path_hashes;
+  uint32_t asset_count = *version_index->m_AssetCount;
+  entries.reserve(asset_count);
+  version_path_hashes.reserve(asset_count);
+  for (uint32_t a = 0; a < asset_count; ++a) {
+    const char* path = &version_index->m_NameData[version_index->m_NameOffsets[a]];
+    version_path_hashes.insert(version_index->m_PathHashes[a]);
+    FileStat stat;
+    if (!GetAssetFileStat(file_storage_api, local_root_path, path, stat) || stat.m_Size != version_index->m_AssetSizes[a]) {
+      continue;
+    }
+    IndexCacheEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.m_PathHash = version_index->m_PathHashes[a];
+    entry.m_Size = stat.m_Size;
+    entry.m_ModificationTimeNs = stat.m_ModificationTimeNs;
+    entry.m_Inode = stat.m_Inode;
+    entry.m_TargetChunkSize = GetVersionAssetChunkSize(version_index, a, num_asset_policies, asset_policies);
+    // A fingerprint stays valid as long as the file has the content it was taken of
+    TLongtail_Hash content_hash = version_index->m_ContentHashes[a];
+    auto fingerprint_it = fingerprints ? fingerprints->find(entry.m_PathHash) : LocalFileFingerprints::const_iterator();
+    auto entry_it = cache.m_Entries.find(entry.m_PathHash);
+    auto cached_content_it = cached_content_hashes.find(entry.m_PathHash);
+    if (fingerprints && fingerprint_it != fingerprints->end() && fingerprint_it->second.m_ContentHash == content_hash) {
+      entry.m_Fingerprint = fingerprint_it->second.m_Fingerprint;
+    } else if (entry_it != cache.m_Entries.end() && cached_content_it != cached_content_hashes.end() && cached_content_it->second == content_hash) {
+      entry.m_Fingerprint = entry_it->second.m_Fingerprint;
+    }
+    entries.push_back(entry);
+  }
+
+  // Keep still valid entries for files outside version_index so pulls of other
+  // parts of the workspace keep benefitting from them
+  struct Longtail_VersionIndex* merged_version_index = 0;
+  if (has_cache) {
+    size_t version_entry_count = entries.size();
+    const struct Longtail_VersionIndex* cached_version_index = cache.m_VersionIndex;
+    std::vector<TLongtail_Hash> removed_path_hashes;
+    for (uint32_t a = 0; a < *cached_version_index->m_AssetCount; ++a) {
+      TLongtail_Hash path_hash = cached_version_index->m_PathHashes[a];
+      if (version_path_hashes.count(path_hash) != 0) {
+        continue;
+      }
+      auto entry_it = cache.m_Entries.find(path_hash);
+      const char* path = &cached_version_index->m_NameData[cached_version_index->m_NameOffsets[a]];
+      FileStat stat;
+      if (entry_it != cache.m_Entries.end() &&
+          GetAssetFileStat(file_storage_api, local_root_path, path, stat) &&
+          IsUnchanged(entry_it->second, cache.m_WrittenAtNs, stat, entry_it->second.m_TargetChunkSize)) {
+        entries.push_back(entry_it->second);
+      } else {
+        removed_path_hashes.push_back(path_hash);
+      }
+    }
+    int err = Longtail_MergeVersionIndex(
+        cached_version_index,
+        version_index,
+        removed_path_hashes.empty() ? nullptr : removed_path_hashes.data(),
+        removed_path_hashes.size(),
+        &merged_version_index);
+    if (err) {
+      // Start the cache over from version_index alone
+      LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to merge local index cache, %d", err)
+      merged_version_index = 0;
+      entries.resize(version_entry_count);
+    }
+  }
+
+  int err = WriteIndexCache(file_storage_api, local_root_path, merged_version_index ? merged_version_index : version_index, entries, written_at_ns);
+  if (err) {
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to write local index cache, %d", err)
+  }
+  Longtail_Free(merged_version_index);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../exposed/main.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+// The local index cache lives in <LocalRootPath>/.checkpoint/index-cache and
+// holds the version index of the workspace as of the last pull together with
+// the size, modification time and inode each file had when it was indexed.
+
+// Whole-file fingerprint of a file together with the content hash the file had
+// in the version index when the fingerprint was taken
+struct LocalFileFingerprint {
+  TLongtail_Hash m_ContentHash;
+  TLongtail_Hash m_Fingerprint;
+};
+
+// Fingerprints keyed by path hash
+typedef std::unordered_map<TLongtail_Hash, LocalFileFingerprint> LocalFileFingerprints;
+
+// Creates the version index of file_infos like Longtail_CreateVersionIndexWithChunkSizes
+// but reuses the cached chunks of every file whose size, modification time, inode,
+// permissions and target chunk size are unchanged, only the remaining files are read.
+// The cache is only used if its zero chunks match LONGTAIL_VERSION_INDEX_FLAG_ZERO_CHUNKS in flags.
+// Files that only had their modification time or inode changed are fingerprinted
+// first and keep their cached chunks if the fingerprint matches the cached one.
+// The fingerprints taken are added to out_fingerprints if it is not null.
+int CreateCachedLocalVersionIndex(
+    struct Longtail_StorageAPI* file_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    struct Longtail_ChunkerAPI* chunker_api,
+    struct Longtail_JobAPI* job_api,
+    struct Longtail_ProgressAPI* progress_api,
+    const char* local_root_path,
+    const struct Longtail_FileInfos* file_infos,
+    const uint32_t* tags,
+    const uint32_t* chunk_sizes,
+    uint32_t flags,
+    uint32_t target_chunk_size,
+    bool enable_file_map,
+    struct Longtail_VersionIndex** out_version_index,
+    LocalFileFingerprints* out_fingerprints);
+
+// Records that the files of version_index on disk now match version_index. Files
+// that are not part of version_index keep their cached entries while they exist.
+// Fingerprints from fingerprints or the previous cache are kept for files whose
+// content hash is unchanged, fingerprints may be null.
+// Files written shortly before the update, including the ones the caller just wrote,
+// are racy and get compared by fingerprint before the cache trusts them again.
+// The target chunk size of each entry is the one recorded in version_index, or the
+// one of the matching asset policy if version_index does not record them.
+// Failing to update the cache only costs a slower next pull so errors are logged
+// and otherwise ignored.
+void UpdateLocalIndexCache(
+    struct Longtail_StorageAPI* file_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    const char* local_root_path,
+    const struct Longtail_VersionIndex* version_index,
+    const LocalFileFingerprints* fingerprints,
+    uint32_t num_asset_policies,
+    const Checkpoint::AssetPolicy* asset_policies);
@@ -0,0 +1,473 @@
+#include "link-estimate.h"
+#include "json.h"
+
+#include <errno.h>
+#include <longtail.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <new>
+
+// Requests up to this size are dominated by the latency, requests from the
+// bandwidth sample size up by the transfer
+static const uint64_t LatencySampleMaxSize = 64 * 1024;
+static const uint64_t BandwidthSampleMinSize = 1024 * 1024;
+// Weight of a new sample in the rolling estimate
+static const double SampleWeight = 0.2;
+// A block should take this many times the request latency to transfer
+static const double BlockTransferLatencyRatio = 4.0;
+static const uint32_t BlockSizeGranularity = 64 * 1024;
+
+struct LinkEstimateStorageAPI_OpenFile {
+  Longtail_StorageAPI_HOpenFile m_BackingFile;
+  uint64_t m_WrittenBytes;
+  int64_t m_WriteNs;
+};
+
+struct LinkEstimateStorageAPI {
+  struct Longtail_StorageAPI m_API;
+  struct Longtail_StorageAPI* m_BackingAPI;
+  std::string m_EstimatesPath;
+  std::string m_BackendKey;
+  std::mutex m_Lock;
+  LinkEstimate m_Estimate;
+};
+
+static int64_t GetNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double Blend(double current, uint32_t sample_count, double sample) {
+  return sample_count == 0 ? sample : current + (sample - current) * SampleWeight;
+}
+
+static void AddSample(struct LinkEstimateStorageAPI* api, uint64_t size, int64_t elapsed_ns) {
+  if (elapsed_ns <= 0) {
+    return;
+  }
+  double elapsed_ms = (double)elapsed_ns / 1000000.0;
+  std::lock_guard<std::mutex> lock(api->m_Lock);
+  LinkEstimate& estimate = api->m_Estimate;
+  if (size <= LatencySampleMaxSize) {
+    estimate.m_LatencyMs = Blend(estimate.m_LatencyMs, estimate.m_LatencySampleCount, elapsed_ms);
+    ++estimate.m_LatencySampleCount;
+  } else if (size >= BandwidthSampleMinSize) {
+    // Never let the latency estimate account for more than most of the request
+    double transfer_ms = elapsed_ms - estimate.m_LatencyMs;
+    if (transfer_ms < elapsed_ms * 0.1) {
+      transfer_ms = elapsed_ms * 0.1;
+    }
+    double bytes_per_second = (double)size * 1000.0 / transfer_ms;
+    estimate.m_BytesPerSecond = Blend(estimate.m_BytesPerSecond, estimate.m_BandwidthSampleCount, bytes_per_second);
+    ++estimate.m_BandwidthSampleCount;
+  }
+}
+
+static void LoadLinkEstimate(const std::string& estimates_path, const std::string& backend_key, LinkEstimate* out_estimate) {
+  memset(out_estimate, 0, sizeof(LinkEstimate));
+  std::ifstream file(estimates_path);
+  if (!file) {
+    return;
+  }
+  json estimates = json::parse(file, nullptr, false);
+  if (!estimates.is_object() || !estimates.contains(backend_key)) {
+    return;
+  }
+  const json& entry = estimates[backend_key];
+  if (!entry.is_object()) {
+    return;
+  }
+  out_estimate->m_LatencyMs = entry.value("latencyMs", 0.0);
+  out_estimate->m_BytesPerSecond = entry.value("bytesPerSecond", 0.0);
+  out_estimate->m_LatencySampleCount = entry.value("latencySamples", 0u);
+  out_estimate->m_BandwidthSampleCount = entry.value("bandwidthSamples", 0u);
+}
+
+// Failing to save the estimate only means the next operation starts from an
+// older one, so errors are ignored
+static void SaveLinkEstimate(const std::string& estimates_path, const std::string& backend_key, const LinkEstimate& estimate) {
+  json estimates = json::object();
+  {
+    std::ifstream file(estimates_path);
+    if (file) {
+      json existing = json::parse(file, nullptr, false);
+      if (existing.is_object()) {
+        estimates = existing;
+      }
+    }
+  }
+  estimates[backend_key] = {
+      {"latencyMs", estimate.m_LatencyMs},
+      {"bytesPerSecond", estimate.m_BytesPerSecond},
+      {"latencySamples", estimate.m_LatencySampleCount},
+      {"bandwidthSamples", estimate.m_BandwidthSampleCount},
+  };
+  std::string tmp_path = estimates_path + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::trunc);
+    if (!file) {
+      return;
+    }
+    file << estimates.dump(2);
+    if (!file) {
+      file.close();
+      remove(tmp_path.c_str());
+      return;
+    }
+  }
+  if (rename(tmp_path.c_str(), estimates_path.c_str()) != 0) {
+    remove(tmp_path.c_str());
+  }
+}
+
+static Longtail_StorageAPI_HOpenFile GetBackingFile(Longtail_StorageAPI_HOpenFile f) {
+  return ((struct LinkEstimateStorageAPI_OpenFile*)f)->m_BackingFile;
+}
+
+static void LinkEstimateStorageAPI_Dispose(struct Longtail_API* storage_api) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  if (api->m_Estimate.m_LatencySampleCount > 0 || api->m_Estimate.m_BandwidthSampleCount > 0) {
+    SaveLinkEstimate(api->m_EstimatesPath, api->m_BackendKey, api->m_Estimate);
+  }
+  SAFE_DISPOSE_API(api->m_BackingAPI);
+  api->~LinkEstimateStorageAPI();
+  Longtail_Free(storage_api);
+}
+
+static int LinkEstimateStorageAPI_OpenFile(
+    struct LinkEstimateStorageAPI* api,
+    Longtail_StorageAPI_HOpenFile backing_file,
+    Longtail_StorageAPI_HOpenFile* out_open_file) {
+  struct LinkEstimateStorageAPI_OpenFile* open_file = (struct LinkEstimateStorageAPI_OpenFile*)Longtail_Alloc(
+      "LinkEstimateStorageAPI_OpenFile",
+      sizeof(struct LinkEstimateStorageAPI_OpenFile));
+  if (!open_file) {
+    api->m_BackingAPI->CloseFile(api->m_BackingAPI, backing_file);
+    return ENOMEM;
+  }
+  open_file->m_BackingFile = backing_file;
+  open_file->m_WrittenBytes = 0;
+  open_file->m_WriteNs = 0;
+  *out_open_file = (Longtail_StorageAPI_HOpenFile)open_file;
+  return 0;
+}
+
+static int LinkEstimateStorageAPI_OpenReadFile(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    Longtail_StorageAPI_HOpenFile* out_open_file) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  Longtail_StorageAPI_HOpenFile backing_file;
+  int err = api->m_BackingAPI->OpenReadFile(api->m_BackingAPI, path, &backing_file);
+  if (err) {
+    return err;
+  }
+  return LinkEstimateStorageAPI_OpenFile(api, backing_file, out_open_file);
+}
+
+static int LinkEstimateStorageAPI_GetSize(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile f,
+    uint64_t* out_size) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  int64_t start_ns = GetNowNs();
+  int err = api->m_BackingAPI->GetSize(api->m_BackingAPI, GetBackingFile(f), out_size);
+  if (!err) {
+    AddSample(api, 0, GetNowNs() - start_ns);
+  }
+  return err;
+}
+
+static int LinkEstimateStorageAPI_Read(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile f,
+    uint64_t offset,
+    uint64_t length,
+    void* output) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  int64_t start_ns = GetNowNs();
+  int err = api->m_BackingAPI->Read(api->m_BackingAPI, GetBackingFile(f), offset, length, output);
+  if (!err) {
+    AddSample(api, length, GetNowNs() - start_ns);
+  }
+  return err;
+}
+
+static int LinkEstimateStorageAPI_OpenWriteFile(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    uint64_t initial_size,
+    Longtail_StorageAPI_HOpenFile* out_open_file) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  Longtail_StorageAPI_HOpenFile backing_file;
+  int err = api->m_BackingAPI->OpenWriteFile(api->m_BackingAPI, path, initial_size, &backing_file);
+  if (err) {
+    return err;
+  }
+  return LinkEstimateStorageAPI_OpenFile(api, backing_file, out_open_file);
+}
+
+// Object stores upload the data when the file is closed, so the time of the
+// writes and the close together is the time of the request
+static int LinkEstimateStorageAPI_Write(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile f,
+    uint64_t offset,
+    uint64_t length,
+    const void* input) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  struct LinkEstimateStorageAPI_OpenFile* open_file = (struct LinkEstimateStorageAPI_OpenFile*)f;
+  int64_t start_ns = GetNowNs();
+  int err = api->m_BackingAPI->Write(api->m_BackingAPI, open_file->m_BackingFile, offset, length, input);
+  open_file->m_WriteNs += GetNowNs() - start_ns;
+  open_file->m_WrittenBytes += length;
+  return err;
+}
+
+static int LinkEstimateStorageAPI_SetSize(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile f,
+    uint64_t length) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->SetSize(api->m_BackingAPI, GetBackingFile(f), length);
+}
+
+static int LinkEstimateStorageAPI_SetPermissions(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    uint16_t permissions) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->SetPermissions(api->m_BackingAPI, path, permissions);
+}
+
+static int LinkEstimateStorageAPI_GetPermissions(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    uint16_t* out_permissions) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->GetPermissions(api->m_BackingAPI, path, out_permissions);
+}
+
+static void LinkEstimateStorageAPI_CloseFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  struct LinkEstimateStorageAPI_OpenFile* open_file = (struct LinkEstimateStorageAPI_OpenFile*)f;
+  int64_t start_ns = GetNowNs();
+  api->m_BackingAPI->CloseFile(api->m_BackingAPI, open_file->m_BackingFile);
+  if (open_file->m_WrittenBytes > 0) {
+    AddSample(api, open_file->m_WrittenBytes, open_file->m_WriteNs + GetNowNs() - start_ns);
+  }
+  Longtail_Free(open_file);
+}
+
+static int LinkEstimateStorageAPI_CreateDir(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->CreateDir(api->m_BackingAPI, path);
+}
+
+static int LinkEstimateStorageAPI_RenameFile(struct Longtail_StorageAPI* storage_api, const char* source_path, const char* target_path) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->RenameFile(api->m_BackingAPI, source_path, target_path);
+}
+
+static char* LinkEstimateStorageAPI_ConcatPath(struct Longtail_StorageAPI* storage_api, const char* root_path, const char* sub_path) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->ConcatPath(api->m_BackingAPI, root_path, sub_path);
+}
+
+static int LinkEstimateStorageAPI_IsDir(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->IsDir(api->m_BackingAPI, path);
+}
+
+static int LinkEstimateStorageAPI_IsFile(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  int64_t start_ns = GetNowNs();
+  int is_file = api->m_BackingAPI->IsFile(api->m_BackingAPI, path);
+  AddSample(api, 0, GetNowNs() - start_ns);
+  return is_file;
+}
+
+static int LinkEstimateStorageAPI_RemoveDir(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->RemoveDir(api->m_BackingAPI, path);
+}
+
+static int LinkEstimateStorageAPI_RemoveFile(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->RemoveFile(api->m_BackingAPI, path);
+}
+
+static int LinkEstimateStorageAPI_StartFind(struct Longtail_StorageAPI* storage_api, const char* path, Longtail_StorageAPI_HIterator* out_iterator) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->StartFind(api->m_BackingAPI, path, out_iterator);
+}
+
+static int LinkEstimateStorageAPI_FindNext(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HIterator iterator) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->FindNext(api->m_BackingAPI, iterator);
+}
+
+static void LinkEstimateStorageAPI_CloseFind(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HIterator iterator) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  api->m_BackingAPI->CloseFind(api->m_BackingAPI, iterator);
+}
+
+static int LinkEstimateStorageAPI_GetEntryProperties(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HIterator iterator,
+    struct Longtail_StorageAPI_EntryProperties* out_properties) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->GetEntryProperties(api->m_BackingAPI, iterator, out_properties);
+}
+
+static int LinkEstimateStorageAPI_LockFile(struct Longtail_StorageAPI* storage_api, const char* path, Longtail_StorageAPI_HLockFile* out_lock_file) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->LockFile(api->m_BackingAPI, path, out_lock_file);
+}
+
+static int LinkEstimateStorageAPI_UnlockFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HLockFile lock_file) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->UnlockFile(api->m_BackingAPI, lock_file);
+}
+
+static char* LinkEstimateStorageAPI_GetParentPath(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->GetParentPath(api->m_BackingAPI, path);
+}
+
+static int LinkEstimateStorageAPI_MapFile(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile f,
+    uint64_t offset,
+    uint64_t length,
+    Longtail_StorageAPI_HFileMap* out_file_map,
+    const void** out_data_ptr) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  return api->m_BackingAPI->MapFile(api->m_BackingAPI, GetBackingFile(f), offset, length, out_file_map, out_data_ptr);
+}
+
+static void LinkEstimateStorageAPI_UnmapFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HFileMap m) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)storage_api;
+  api->m_BackingAPI->UnMapFile(api->m_BackingAPI, m);
+}
+
+struct Longtail_StorageAPI* CreateLinkEstimateStorageAPI(
+    struct Longtail_StorageAPI* backing_storage_api,
+    const std::string& estimates_path,
+    const std::string& backend_key) {
+  MAKE_LOG_CONTEXT_FIELDS(ctx)
+  LONGTAIL_LOGFIELD(backing_storage_api, "%p"),
+      LONGTAIL_LOGFIELD(estimates_path.c_str(), "%s"),
+      LONGTAIL_LOGFIELD(backend_key.c_str(), "%s")
+          MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+  LONGTAIL_VALIDATE_INPUT(ctx, backing_storage_api != 0, return 0);
+
+  void* mem = Longtail_Alloc("LinkEstimateStorageAPI", sizeof(struct LinkEstimateStorageAPI));
+  if (!mem) {
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+    SAFE_DISPOSE_API(backing_storage_api);
+    return 0;
+  }
+  struct LinkEstimateStorageAPI* api = new (mem) LinkEstimateStorageAPI();
+  Longtail_MakeStorageAPI(
+      &api->m_API,
+      LinkEstimateStorageAPI_Dispose,
+      LinkEstimateStorageAPI_OpenReadFile,
+      LinkEstimateStorageAPI_GetSize,
+      LinkEstimateStorageAPI_Read,
+      LinkEstimateStorageAPI_OpenWriteFile,
+      LinkEstimateStorageAPI_Write,
+      LinkEstimateStorageAPI_SetSize,
+      LinkEstimateStorageAPI_SetPermissions,
+      LinkEstimateStorageAPI_GetPermissions,
+      LinkEstimateStorageAPI_CloseFile,
+      LinkEstimateStorageAPI_CreateDir,
+      LinkEstimateStorageAPI_RenameFile,
+      LinkEstimateStorageAPI_ConcatPath,
+      LinkEstimateStorageAPI_IsDir,
+      LinkEstimateStorageAPI_IsFile,
+      LinkEstimateStorageAPI_RemoveDir,
+      LinkEstimateStorageAPI_RemoveFile,
+      LinkEstimateStorageAPI_StartFind,
+      LinkEstimateStorageAPI_FindNext,
+      LinkEstimateStorageAPI_CloseFind,
+      LinkEstimateStorageAPI_GetEntryProperties,
+      LinkEstimateStorageAPI_LockFile,
+      LinkEstimateStorageAPI_UnlockFile,
+      LinkEstimateStorageAPI_GetParentPath,
+      LinkEstimateStorageAPI_MapFile,
+      LinkEstimateStorageAPI_UnmapFile);
+  api->m_API.m_StorageFlags = backing_storage_api->m_StorageFlags;
+  api->m_BackingAPI = backing_storage_api;
+  api->m_EstimatesPath = estimates_path;
+  api->m_BackendKey = backend_key;
+  LoadLinkEstimate(estimates_path, backend_key, &api->m_Estimate);
+  return &api->m_API;
+}
+
+std::string GetLinkEstimatesPath(const char* local_root_path) {
+  return std::string(local_root_path) + "/.checkpoint/link-estimates.json";
+}
+
+std::string GetLinkBackendKey(
+    const char* storage_type,
+    const char* gateway_url,
+    const char* s3_endpoint,
+    const char* s3_bucket) {
+  if (storage_type && strcmp(storage_type, "gateway") == 0) {
+    return std::string("gateway:") + (gateway_url ? gateway_url : "");
+  }
+  return std::string("s3:") + (s3_endpoint ? s3_endpoint : "") + "/" + (s3_bucket ? s3_bucket : "");
+}
+
+void GetLinkEstimate(struct Longtail_StorageAPI* link_estimate_storage_api, LinkEstimate* out_estimate) {
+  struct LinkEstimateStorageAPI* api = (struct LinkEstimateStorageAPI*)link_estimate_storage_api;
+  std::lock_guard<std::mutex> lock(api->m_Lock);
+  *out_estimate = api->m_Estimate;
+}
+
+uint32_t ChooseTargetBlockSize(
+    const LinkEstimate& estimate,
+    uint32_t target_block_size,
+    uint32_t min_block_size,
+    uint32_t max_block_size) {
+  if (min_block_size == 0 && max_block_size == 0) {
+    return target_block_size;
+  }
+  double block_size = target_block_size;
+  if (estimate.m_LatencySampleCount > 0 && estimate.m_BandwidthSampleCount > 0) {
+    block_size = estimate.m_BytesPerSecond * (estimate.m_LatencyMs / 1000.0) * BlockTransferLatencyRatio;
+  }
+  if (block_size < min_block_size) {
+    block_size = min_block_size;
+  }
+  if (max_block_size != 0 && block_size > max_block_size) {
+    block_size = max_block_size;
+  }
+  uint32_t result = ((uint32_t)block_size / BlockSizeGranularity) * BlockSizeGranularity;
+  return result < BlockSizeGranularity ? BlockSizeGranularity : result;
+}
+
+uint32_t ChooseFetchDepth(
+    const LinkEstimate& estimate,
+    uint64_t average_block_size,
+    uint32_t min_depth,
+    uint32_t max_depth) {
+  if (max_depth <= min_depth || average_block_size == 0 ||
+      estimate.m_LatencySampleCount == 0 || estimate.m_BandwidthSampleCount == 0 ||
+      estimate.m_BytesPerSecond <= 0.0) {
+    return min_depth;
+  }
+  // While a block is transferred the requests for the next ones should
+  // already be on their way
+  double transfer_ms = (double)average_block_size * 1000.0 / estimate.m_BytesPerSecond;
+  double depth = (double)min_depth * (1.0 + estimate.m_LatencyMs / transfer_ms);
+  if (depth > max_depth) {
+    return max_depth;
+  }
+  return (uint32_t)depth < min_depth ? min_depth : (uint32_t)depth;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <longtail.h>
+
+#include <string>
+
+// Rolling estimate of the link to a remote store, from the time its requests
+// take. Requests that move little data measure the latency, large ones the
+// bandwidth left after the latency.
+struct LinkEstimate {
+  double m_LatencyMs;
+  double m_BytesPerSecond;
+  uint32_t m_LatencySampleCount;
+  uint32_t m_BandwidthSampleCount;
+};
+
+// Storage API that forwards to backing_storage_api, which it takes ownership
+// of, and times the reads and writes to keep a LinkEstimate of the store. The
+// estimate of backend_key is loaded from estimates_path when created and
+// written back when disposed so it carries over between submits and pulls.
+struct Longtail_StorageAPI* CreateLinkEstimateStorageAPI(
+    struct Longtail_StorageAPI* backing_storage_api,
+    const std::string& estimates_path,
+    const std::string& backend_key);
+
+// Path of the file the estimates of a workspace are kept in
+std::string GetLinkEstimatesPath(const char* local_root_path);
+
+// Key that identifies the remote store in the estimates file
+std::string GetLinkBackendKey(
+    const char* storage_type,
+    const char* gateway_url,
+    const char* s3_endpoint,
+    const char* s3_bucket);
+
+// Gets the current estimate of a storage API created by CreateLinkEstimateStorageAPI
+void GetLinkEstimate(struct Longtail_StorageAPI* link_estimate_storage_api, LinkEstimate* out_estimate);
+
+// Picks a block size that takes a few times the request latency to transfer,
+// so high latency links get bigger blocks and fast local stores smaller ones
+// for finer dedup. Returns target_block_size if min and max are both zero or
+// there is no estimate yet, clamped to [min_block_size, max_block_size].
+uint32_t ChooseTargetBlockSize(
+    const LinkEstimate& estimate,
+    uint32_t target_block_size,
+    uint32_t min_block_size,
+    uint32_t max_block_size);
+
+// Picks how many blocks to fetch at once so the request latency is hidden
+// behind the transfers of other blocks, clamped to [min_depth, max_depth].
+uint32_t ChooseFetchDepth(
+    const LinkEstimate& estimate,
+    uint64_t average_block_size,
+    uint32_t min_depth,
+    uint32_t max_depth);
@@ -0,0 +1,270 @@
+#include "materialized-version.h"
+#include "json.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static std::string GetMaterializedVersionPath(struct Longtail_StorageAPI* file_storage_api, const char* local_root_path, const char* name) {
+  char* checkpoint_path = file_storage_api->ConcatPath(file_storage_api, local_root_path, ".checkpoint");
+  char* path = file_storage_api->ConcatPath(file_storage_api, checkpoint_path, name);
+  std::string result(path);
+  Longtail_Free(path);
+  Longtail_Free(checkpoint_path);
+  return result;
+}
+
+static int ReadTextFile(struct Longtail_StorageAPI* file_storage_api, const char* path, std::string& out_text) {
+  Longtail_StorageAPI_HOpenFile file;
+  int err = file_storage_api->OpenReadFile(file_storage_api, path, &file);
+  if (err) {
+    return err;
+  }
+  uint64_t size = 0;
+  err = file_storage_api->GetSize(file_storage_api, file, &size);
+  if (!err) {
+    out_text.resize((size_t)size);
+    err = size == 0 ? EBADF : file_storage_api->Read(file_storage_api, file, 0, size, &out_text[0]);
+  }
+  file_storage_api->CloseFile(file_storage_api, file);
+  return err;
+}
+
+static int WriteTextFile(struct Longtail_StorageAPI* file_storage_api, const char* path, const std::string& text) {
+  Longtail_StorageAPI_HOpenFile file;
+  int err = file_storage_api->OpenWriteFile(file_storage_api, path, text.size(), &file);
+  if (err) {
+    return err;
+  }
+  err = file_storage_api->Write(file_storage_api, file, 0, text.size(), text.data());
+  file_storage_api->CloseFile(file_storage_api, file);
+  return err;
+}
+
+// Replaces path with the completely written tmp_path
+static int ReplaceFile(struct Longtail_StorageAPI* file_storage_api, const char* tmp_path, const char* path) {
+  int err = 0;
+  if (file_storage_api->IsFile(file_storage_api, path)) {
+    err = file_storage_api->RemoveFile(file_storage_api, path);
+  }
+  if (!err) {
+    err = file_storage_api->RenameFile(file_storage_api, tmp_path, path);
+  }
+  if (err) {
+    file_storage_api->RemoveFile(file_storage_api, tmp_path);
+  }
+  return err;
+}
+
+int ReadMaterializedVersion(
+    struct Longtail_StorageAPI* file_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    const char* local_root_path,
+    int32_t changelist,
+    struct Longtail_VersionIndex** out_version_index) {
+  *out_version_index = 0;
+  if (changelist == 0) {
+    return 0;
+  }
+  std::string info_path = GetMaterializedVersionPath(file_storage_api, local_root_path, "materialized-version.json");
+  std::string version_path = GetMaterializedVersionPath(file_storage_api, local_root_path, "materialized-version.lvi");
+  if (!file_storage_api->IsFile(file_storage_api, info_path.c_str()) ||
+      !file_storage_api->IsFile(file_storage_api, version_path.c_str())) {
+    return ENOENT;
+  }
+  std::string info_text;
+  int err = ReadTextFile(file_storage_api, info_path.c_str(), info_text);
+  if (err) {
+    return err;
+  }
+  json info = json::parse(info_text, nullptr, false);
+  if (!info.is_object() || info.value("changelist", -1) != changelist) {
+    return ENOENT;
+  }
+  struct Longtail_VersionIndex* version_index = 0;
+  err = Longtail_ReadVersionIndex(file_storage_api, version_path.c_str(), &version_index);
+  if (err) {
+    return err;
+  }
+  if (*version_index->m_HashIdentifier != hash_api->GetIdentifier(hash_api)) {
+    Longtail_Free(version_index);
+    return EBADF;
+  }
+  *out_version_index = version_index;
+  return 0;
+}
+
+void WriteMaterializedVersion(
+    struct Longtail_StorageAPI* file_storage_api,
+    const char* local_root_path,
+    int32_t changelist,
+    struct Longtail_VersionIndex* version_index) {
+  struct Longtail_LogContextFmt_Private* ctx = 0;
+  char* checkpoint_path = file_storage_api->ConcatPath(file_storage_api, local_root_path, ".checkpoint");
+  std::string info_path = GetMaterializedVersionPath(file_storage_api, local_root_path, "materialized-version.json");
+  std::string version_path = GetMaterializedVersionPath(file_storage_api, local_root_path, "materialized-version.lvi");
+  std::string tmp_path = version_path + ".tmp";
+
+  int err = 0;
+  if (file_storage_api->IsFile(file_storage_api, info_path.c_str())) {
+    err = file_storage_api->RemoveFile(file_storage_api, info_path.c_str());
+  }
+  if (!err && !file_storage_api->IsDir(file_storage_api, checkpoint_path)) {
+    err = file_storage_api->CreateDir(file_storage_api, checkpoint_path);
+    if (err == EEXIST) {
+      err = 0;
+    }
+  }
+  Longtail_Free(checkpoint_path);
+  if (!err) {
+    err = Longtail_WriteVersionIndex(file_storage_api, version_index, tmp_path.c_str());
+    if (err) {
+      file_storage_api->RemoveFile(file_storage_api, tmp_path.c_str());
+    }
+  }
+  if (!err) {
+    err = ReplaceFile(file_storage_api, tmp_path.c_str(), version_path.c_str());
+  }
+  if (!err) {
+    json info = {{"changelist", changelist}};
+    std::string info_tmp_path = info_path + ".tmp";
+    err = WriteTextFile(file_storage_api, info_tmp_path.c_str(), info.dump());
+    if (err) {
+      file_storage_api->RemoveFile(file_storage_api, info_tmp_path.c_str());
+    } else {
+      err = ReplaceFile(file_storage_api, info_tmp_path.c_str(), info_path.c_str());
+    }
+  }
+  if (err) {
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to write materialized version of changelist %d, %d", changelist, err)
+  }
+}
+
+int FoldVersionIndex(
+    struct Longtail_HashAPI* hash_api,
+    const struct Longtail_VersionIndex* base_version_index,
+    const struct Longtail_VersionIndex* version_index,
+    uint32_t num_removed_paths,
+    const char* const* removed_paths,
+    struct Longtail_VersionIndex** out_version_index) {
+  if (!base_version_index) {
+    return Longtail_MergeVersionIndex(version_index, version_index, nullptr, 0, out_version_index);
+  }
+
+  // Removed paths come from the server, which may use backslashes and a leading slash
+  std::vector<TLongtail_Hash> removed_path_hashes;
+  removed_path_hashes.reserve(num_removed_paths);
+  for (uint32_t i = 0; i < num_removed_paths; ++i) {
+    std::string path(removed_paths[i]);
+    for (char& c : path) {
+      if (c == '\\') {
+        c = '/';
+      }
+    }
+    size_t start = path.find_first_not_of('/');
+    if (start == std::string::npos) {
+      continue;
+    }
+    TLongtail_Hash path_hash;
+    int err = Longtail_GetPathHash(hash_api, path.c_str() + start, &path_hash);
+    if (err) {
+      return err;
+    }
+    removed_path_hashes.push_back(path_hash);
+  }
+
+  // A repository that switched chunker still has the files chunked before the switch,
+  // their chunks stay valid for writing so the base is taken over by the new chunker
+  // instead of refusing the merge. Those files no longer match a local index of them
+  // and are rechunked the next time a version changes them.
+  struct Longtail_VersionIndex rechunked_base_version_index;
+  uint32_t rechunked_chunker_identifier = Longtail_VersionIndex_GetChunkerIdentifier(version_index);
+  if (Longtail_VersionIndex_GetChunkerIdentifier(base_version_index) != Longtail_VersionIndex_GetChunkerIdentifier(version_index)) {
+    struct Longtail_LogContextFmt_Private* ctx = 0;
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "Materialized version was chunked with chunker %u, version with chunker %u", Longtail_VersionIndex_GetChunkerIdentifier(base_version_index), Longtail_VersionIndex_GetChunkerIdentifier(version_index))
+    rechunked_base_version_index = *base_version_index;
+    rechunked_base_version_index.m_ChunkerIdentifier = &rechunked_chunker_identifier;
+    base_version_index = &rechunked_base_version_index;
+  }
+
+  return Longtail_MergeVersionIndex(
+      base_version_index,
+      version_index,
+      removed_path_hashes.empty() ? nullptr : removed_path_hashes.data(),
+      removed_path_hashes.size(),
+      out_version_index);
+}
+
+std::unordered_set<TLongtail_Hash> GetUnchangedAssets(
+    const struct Longtail_VersionIndex* base_version_index,
+    const struct Longtail_VersionIndex* version_index) {
+  std::unordered_map<TLongtail_Hash, uint32_t> base_asset_indexes;
+  uint32_t base_asset_count = *base_version_index->m_AssetCount;
+  base_asset_indexes.reserve(base_asset_count);
+  for (uint32_t a = 0; a < base_asset_count; ++a) {
+    base_asset_indexes[base_version_index->m_PathHashes[a]] = a;
+  }
+
+  std::unordered_set<TLongtail_Hash> unchanged_path_hashes;
+  for (uint32_t a = 0; a < *version_index->m_AssetCount; ++a) {
+    auto it = base_asset_indexes.find(version_index->m_PathHashes[a]);
+    if (it != base_asset_indexes.end() &&
+        base_version_index->m_ContentHashes[it->second] == version_index->m_ContentHashes[a] &&
+        base_version_index->m_Permissions[it->second] == version_index->m_Permissions[a]) {
+      unchanged_path_hashes.insert(version_index->m_PathHashes[a]);
+    }
+  }
+  return unchanged_path_hashes;
+}
+
+int FilterVersionIndex(
+    const struct Longtail_VersionIndex* version_index,
+    const std::unordered_set<TLongtail_Hash>& removed_path_hashes,
+    struct Longtail_VersionIndex** out_version_index) {
+  // Merging onto an empty overlay keeps the base assets that are not removed
+  size_t empty_version_index_size = Longtail_GetVersionIndexSizeWithFormat(
+      0,
+      0,
+      0,
+      0,
+      Longtail_VersionIndex_GetChunkerIdentifier(version_index),
+      Longtail_VersionIndex_GetFlags(version_index));
+  void* empty_version_index_mem = Longtail_Alloc("FilterVersionIndex", empty_version_index_size);
+  if (!empty_version_index_mem) {
+    return ENOMEM;
+  }
+  struct Longtail_VersionIndex* empty_version_index = 0;
+  int err = Longtail_BuildVersionIndexWithChunkSizes(
+      empty_version_index_mem,
+      empty_version_index_size,
+      0,
+      0,
+      0,
+      0,
+      0,
+      0,
+      0,
+      0,
+      0,
+      0,
+      0,
+      0,
+      *version_index->m_HashIdentifier,
+      Longtail_VersionIndex_GetChunkerIdentifier(version_index),
+      Longtail_VersionIndex_GetFlags(version_index),
+      *version_index->m_TargetChunkSize,
+      &empty_version_index);
+  if (err) {
+    Longtail_Free(empty_version_index_mem);
+    return err;
+  }
+  std::vector<TLongtail_Hash> removed(removed_path_hashes.begin(), removed_path_hashes.end());
+  err = Longtail_MergeVersionIndex(
+      version_index,
+      empty_version_index,
+      removed.empty() ? nullptr : removed.data(),
+      removed.size(),
+      out_version_index);
+  Longtail_Free(empty_version_index_mem);
+  return err;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../exposed/main.h"
+
+#include <unordered_set>
+
+// The materialized version lives in <LocalRootPath>/.checkpoint/materialized-version.lvi
+// and is the full version index of the changelist recorded next to it in
+// materialized-version.json. Remote versions only hold the files their changelist
+// touched, a pull folds the version it syncs on top of the materialized version
+// of the changelist the workspace was synced to.
+
+// Reads the materialized version of changelist. Changelist 0 has no files so
+// out_version_index is set to null without reading anything. Returns ENOENT if
+// there is no materialized version of changelist.
+int ReadMaterializedVersion(
+    struct Longtail_StorageAPI* file_storage_api,
+    struct Longtail_HashAPI* hash_api,
+    const char* local_root_path,
+    int32_t changelist,
+    struct Longtail_VersionIndex** out_version_index);
+
+// Records version_index as the materialized version of changelist. The previous
+// materialized version is dropped before the new one is written so a failed
+// write leaves no materialized version rather than one for the wrong changelist.
+// Failing to write it only costs a slower next pull so errors are logged and
+// otherwise ignored.
+void WriteMaterializedVersion(
+    struct Longtail_StorageAPI* file_storage_api,
+    const char* local_root_path,
+    int32_t changelist,
+    struct Longtail_VersionIndex* version_index);
+
+// Folds version_index on top of base_version_index, which may be null for an
+// empty base, after removing removed_paths from the base
+int FoldVersionIndex(
+    struct Longtail_HashAPI* hash_api,
+    const struct Longtail_VersionIndex* base_version_index,
+    const struct Longtail_VersionIndex* version_index,
+    uint32_t num_removed_paths,
+    const char* const* removed_paths,
+    struct Longtail_VersionIndex** out_version_index);
+
+// Path hashes of the assets of version_index that have the same content and
+// permissions in base_version_index
+std::unordered_set<TLongtail_Hash> GetUnchangedAssets(
+    const struct Longtail_VersionIndex* base_version_index,
+    const struct Longtail_VersionIndex* version_index);
+
+// Copy of version_index without the assets in removed_path_hashes
+int FilterVersionIndex(
+    const struct Longtail_VersionIndex* version_index,
+    const std::unordered_set<TLongtail_Hash>& removed_path_hashes,
+    struct Longtail_VersionIndex** out_version_index);
@@ -0,0 +1,493 @@
+#include "read-cache-storage.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <longtail.h>
+#include <string.h>
+
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Cached data of one file, keyed by the file offset it was read from. The
+// segments never overlap.
+struct ReadCacheStorageAPI_File {
+  std::map<uint64_t, std::vector<char>> m_Segments;
+};
+
+struct ReadCacheStorageAPI_OpenFile {
+  Longtail_StorageAPI_HOpenFile m_BackingFile;
+  // Null for files opened for writing
+  std::string* m_Path;
+};
+
+struct ReadCacheStorageAPI {
+  struct Longtail_StorageAPI m_API;
+  struct Longtail_StorageAPI* m_BackingAPI;
+  uint64_t m_MaxCacheSize;
+  uint64_t m_CacheSize;
+  std::mutex m_Lock;
+  std::unordered_map<std::string, ReadCacheStorageAPI_File> m_Files;
+};
+
+static Longtail_StorageAPI_HOpenFile GetBackingFile(Longtail_StorageAPI_HOpenFile f) {
+  return ((struct ReadCacheStorageAPI_OpenFile*)f)->m_BackingFile;
+}
+
+// Copies [offset, offset + length) to output if the cached segments of the
+// file cover all of it. Must be called with m_Lock held.
+static bool ReadCacheStorageAPI_ReadCached(
+    struct ReadCacheStorageAPI* api,
+    const std::string& path,
+    uint64_t offset,
+    uint64_t length,
+    char* output) {
+  auto file_it = api->m_Files.find(path);
+  if (file_it == api->m_Files.end()) {
+    return false;
+  }
+  const std::map<uint64_t, std::vector<char>>& segments = file_it->second.m_Segments;
+  auto it = segments.upper_bound(offset);
+  if (it == segments.begin()) {
+    return false;
+  }
+  --it;
+
+  // The range may span several segments if they follow each other without gaps
+  uint64_t pos = offset;
+  uint64_t end = offset + length;
+  auto check_it = it;
+  while (pos < end) {
+    if (check_it == segments.end() || check_it->first > pos) {
+      return false;
+    }
+    uint64_t segment_end = check_it->first + check_it->second.size();
+    if (segment_end <= pos) {
+      return false;
+    }
+    pos = segment_end;
+    ++check_it;
+  }
+
+  pos = offset;
+  while (pos < end) {
+    uint64_t segment_offset = pos - it->first;
+    uint64_t copy_size = it->second.size() - segment_offset;
+    if (copy_size > end - pos) {
+      copy_size = end - pos;
+    }
+    memcpy(&output[pos - offset], &it->second[segment_offset], copy_size);
+    pos += copy_size;
+    ++it;
+  }
+  return true;
+}
+
+// Keeps a copy of data if it fits in the cache and does not overlap data that
+// is already cached
+static void ReadCacheStorageAPI_AddCached(
+    struct ReadCacheStorageAPI* api,
+    const std::string& path,
+    uint64_t offset,
+    uint64_t length,
+    const void* data) {
+  if (length == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(api->m_Lock);
+  if (api->m_CacheSize + length > api->m_MaxCacheSize) {
+    return;
+  }
+  std::map<uint64_t, std::vector<char>>& segments = api->m_Files[path].m_Segments;
+  auto next_it = segments.lower_bound(offset);
+  if (next_it != segments.end() && next_it->first < offset + length) {
+    return;
+  }
+  if (next_it != segments.begin()) {
+    auto prev_it = std::prev(next_it);
+    if (prev_it->first + prev_it->second.size() > offset) {
+      return;
+    }
+  }
+  const char* p = (const char*)data;
+  segments.emplace_hint(next_it, offset, std::vector<char>(p, p + length));
+  api->m_CacheSize += length;
+}
+
+static void ReadCacheStorageAPI_DropCached(struct ReadCacheStorageAPI* api, const char* path) {
+  std::lock_guard<std::mutex> lock(api->m_Lock);
+  auto file_it = api->m_Files.find(path);
+  if (file_it == api->m_Files.end()) {
+    return;
+  }
+  for (const auto& segment : file_it->second.m_Segments) {
+    api->m_CacheSize -= segment.second.size();
+  }
+  api->m_Files.erase(file_it);
+}
+
+static void ReadCacheStorageAPI_Dispose(struct Longtail_API* storage_api) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  api->~ReadCacheStorageAPI();
+  Longtail_Free(storage_api);
+}
+
+static int ReadCacheStorageAPI_OpenFile(
+    struct ReadCacheStorageAPI* api,
+    Longtail_StorageAPI_HOpenFile backing_file,
+    const char* read_path,
+    Longtail_StorageAPI_HOpenFile* out_open_file) {
+  struct ReadCacheStorageAPI_OpenFile* open_file = (struct ReadCacheStorageAPI_OpenFile*)Longtail_Alloc(
+      "ReadCacheStorageAPI_OpenFile",
+      sizeof(struct ReadCacheStorageAPI_OpenFile));
+  if (!open_file) {
+    api->m_BackingAPI->CloseFile(api->m_BackingAPI, backing_file);
+    return ENOMEM;
+  }
+  open_file->m_BackingFile = backing_file;
+  open_file->m_Path = read_path ? new std::string(read_path) : nullptr;
+  *out_open_file = (Longtail_StorageAPI_HOpenFile)open_file;
+  return 0;
+}
+
+static int ReadCacheStorageAPI_OpenReadFile(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    Longtail_StorageAPI_HOpenFile* out_open_file) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  Longtail_StorageAPI_HOpenFile backing_file;
+  int err = api->m_BackingAPI->OpenReadFile(api->m_BackingAPI, path, &backing_file);
+  if (err) {
+    return err;
+  }
+  return ReadCacheStorageAPI_OpenFile(api, backing_file, path, out_open_file);
+}
+
+static int ReadCacheStorageAPI_GetSize(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile f,
+    uint64_t* out_size) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->GetSize(api->m_BackingAPI, GetBackingFile(f), out_size);
+}
+
+static int ReadCacheStorageAPI_Read(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile f,
+    uint64_t offset,
+    uint64_t length,
+    void* output) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  struct ReadCacheStorageAPI_OpenFile* open_file = (struct ReadCacheStorageAPI_OpenFile*)f;
+  if (open_file->m_Path) {
+    std::lock_guard<std::mutex> lock(api->m_Lock);
+    if (ReadCacheStorageAPI_ReadCached(api, *open_file->m_Path, offset, length, (char*)output)) {
+      return 0;
+    }
+  }
+  int err = api->m_BackingAPI->Read(api->m_BackingAPI, open_file->m_BackingFile, offset, length, output);
+  if (err) {
+    return err;
+  }
+  if (open_file->m_Path) {
+    ReadCacheStorageAPI_AddCached(api, *open_file->m_Path, offset, length, output);
+  }
+  return 0;
+}
+
+static int ReadCacheStorageAPI_OpenWriteFile(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    uint64_t initial_size,
+    Longtail_StorageAPI_HOpenFile* out_open_file) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  ReadCacheStorageAPI_DropCached(api, path);
+  Longtail_StorageAPI_HOpenFile backing_file;
+  int err = api->m_BackingAPI->OpenWriteFile(api->m_BackingAPI, path, initial_size, &backing_file);
+  if (err) {
+    return err;
+  }
+  return ReadCacheStorageAPI_OpenFile(api, backing_file, nullptr, out_open_file);
+}
+
+static int ReadCacheStorageAPI_Write(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile f,
+    uint64_t offset,
+    uint64_t length,
+    const void* input) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->Write(api->m_BackingAPI, GetBackingFile(f), offset, length, input);
+}
+
+static int ReadCacheStorageAPI_SetSize(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile f,
+    uint64_t length) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->SetSize(api->m_BackingAPI, GetBackingFile(f), length);
+}
+
+static int ReadCacheStorageAPI_SetPermissions(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    uint16_t permissions) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->SetPermissions(api->m_BackingAPI, path, permissions);
+}
+
+static int ReadCacheStorageAPI_GetPermissions(
+    struct Longtail_StorageAPI* storage_api,
+    const char* path,
+    uint16_t* out_permissions) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->GetPermissions(api->m_BackingAPI, path, out_permissions);
+}
+
+static void ReadCacheStorageAPI_CloseFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HOpenFile f) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  struct ReadCacheStorageAPI_OpenFile* open_file = (struct ReadCacheStorageAPI_OpenFile*)f;
+  api->m_BackingAPI->CloseFile(api->m_BackingAPI, open_file->m_BackingFile);
+  delete open_file->m_Path;
+  Longtail_Free(open_file);
+}
+
+static int ReadCacheStorageAPI_CreateDir(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->CreateDir(api->m_BackingAPI, path);
+}
+
+static int ReadCacheStorageAPI_RenameFile(struct Longtail_StorageAPI* storage_api, const char* source_path, const char* target_path) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  ReadCacheStorageAPI_DropCached(api, source_path);
+  ReadCacheStorageAPI_DropCached(api, target_path);
+  return api->m_BackingAPI->RenameFile(api->m_BackingAPI, source_path, target_path);
+}
+
+static char* ReadCacheStorageAPI_ConcatPath(struct Longtail_StorageAPI* storage_api, const char* root_path, const char* sub_path) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->ConcatPath(api->m_BackingAPI, root_path, sub_path);
+}
+
+static int ReadCacheStorageAPI_IsDir(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->IsDir(api->m_BackingAPI, path);
+}
+
+static int ReadCacheStorageAPI_IsFile(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->IsFile(api->m_BackingAPI, path);
+}
+
+static int ReadCacheStorageAPI_RemoveDir(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->RemoveDir(api->m_BackingAPI, path);
+}
+
+static int ReadCacheStorageAPI_RemoveFile(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  ReadCacheStorageAPI_DropCached(api, path);
+  return api->m_BackingAPI->RemoveFile(api->m_BackingAPI, path);
+}
+
+static int ReadCacheStorageAPI_StartFind(struct Longtail_StorageAPI* storage_api, const char* path, Longtail_StorageAPI_HIterator* out_iterator) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->StartFind(api->m_BackingAPI, path, out_iterator);
+}
+
+static int ReadCacheStorageAPI_FindNext(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HIterator iterator) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->FindNext(api->m_BackingAPI, iterator);
+}
+
+static void ReadCacheStorageAPI_CloseFind(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HIterator iterator) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  api->m_BackingAPI->CloseFind(api->m_BackingAPI, iterator);
+}
+
+static int ReadCacheStorageAPI_GetEntryProperties(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HIterator iterator,
+    struct Longtail_StorageAPI_EntryProperties* out_properties) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->GetEntryProperties(api->m_BackingAPI, iterator, out_properties);
+}
+
+static int ReadCacheStorageAPI_LockFile(struct Longtail_StorageAPI* storage_api, const char* path, Longtail_StorageAPI_HLockFile* out_lock_file) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->LockFile(api->m_BackingAPI, path, out_lock_file);
+}
+
+static int ReadCacheStorageAPI_UnlockFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HLockFile lock_file) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->UnlockFile(api->m_BackingAPI, lock_file);
+}
+
+static char* ReadCacheStorageAPI_GetParentPath(struct Longtail_StorageAPI* storage_api, const char* path) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  return api->m_BackingAPI->GetParentPath(api->m_BackingAPI, path);
+}
+
+static int ReadCacheStorageAPI_MapFile(
+    struct Longtail_StorageAPI* storage_api,
+    Longtail_StorageAPI_HOpenFile f,
+    uint64_t offset,
+    uint64_t length,
+    Longtail_StorageAPI_HFileMap* out_file_map,
+    const void** out_data_ptr) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  struct ReadCacheStorageAPI_OpenFile* open_file = (struct ReadCacheStorageAPI_OpenFile*)f;
+  int err = api->m_BackingAPI->MapFile(api->m_BackingAPI, open_file->m_BackingFile, offset, length, out_file_map, out_data_ptr);
+  if (err) {
+    return err;
+  }
+  // Mapped data is read by the caller, keep a copy so it can be served by Read later
+  if (open_file->m_Path) {
+    ReadCacheStorageAPI_AddCached(api, *open_file->m_Path, offset, length, *out_data_ptr);
+  }
+  return 0;
+}
+
+static void ReadCacheStorageAPI_UnmapFile(struct Longtail_StorageAPI* storage_api, Longtail_StorageAPI_HFileMap m) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)storage_api;
+  api->m_BackingAPI->UnMapFile(api->m_BackingAPI, m);
+}
+
+// Copies the parts of segments that overlap the sorted, non-overlapping ranges
+// to kept_segments and returns the number of bytes copied
+static uint64_t ReadCacheStorageAPI_KeepRanges(
+    const std::map<uint64_t, std::vector<char>>& segments,
+    const std::vector<std::pair<uint64_t, uint64_t>>& ranges,
+    std::map<uint64_t, std::vector<char>>& kept_segments) {
+  uint64_t kept_size = 0;
+  for (const auto& range : ranges) {
+    auto it = segments.upper_bound(range.first);
+    if (it != segments.begin()) {
+      --it;
+    }
+    for (; it != segments.end() && it->first < range.second; ++it) {
+      uint64_t start = it->first > range.first ? it->first : range.first;
+      uint64_t segment_end = it->first + it->second.size();
+      uint64_t end = segment_end < range.second ? segment_end : range.second;
+      if (start >= end) {
+        continue;
+      }
+      const char* p = &it->second[start - it->first];
+      kept_segments.emplace(start, std::vector<char>(p, p + (end - start)));
+      kept_size += end - start;
+    }
+  }
+  return kept_size;
+}
+
+void KeepReadCacheChunks(
+    struct Longtail_StorageAPI* read_cache_storage_api,
+    const char* root_path,
+    const struct Longtail_VersionIndex* version_index,
+    const struct Longtail_StoreIndex* missing_store_index) {
+  struct ReadCacheStorageAPI* api = (struct ReadCacheStorageAPI*)read_cache_storage_api;
+  std::unordered_set<TLongtail_Hash> missing_chunk_hashes(
+      missing_store_index->m_ChunkHashes,
+      missing_store_index->m_ChunkHashes + *missing_store_index->m_ChunkCount);
+
+  std::lock_guard<std::mutex> lock(api->m_Lock);
+  std::unordered_map<std::string, ReadCacheStorageAPI_File> kept_files;
+  uint64_t kept_size = 0;
+  uint32_t asset_count = *version_index->m_AssetCount;
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  for (uint32_t a = 0; a < asset_count && !api->m_Files.empty(); ++a) {
+    const char* asset_path = &version_index->m_NameData[version_index->m_NameOffsets[a]];
+    char* full_path = api->m_BackingAPI->ConcatPath(api->m_BackingAPI, root_path, asset_path);
+    if (!full_path) {
+      continue;
+    }
+    auto file_it = api->m_Files.find(full_path);
+    if (file_it == api->m_Files.end()) {
+      Longtail_Free(full_path);
+      continue;
+    }
+
+    // File ranges of the new chunks, adjacent chunks are merged
+    ranges.clear();
+    uint64_t offset = 0;
+    uint32_t chunk_index_start = version_index->m_AssetChunkIndexStarts[a];
+    uint32_t chunk_count = version_index->m_AssetChunkCounts[a];
+    for (uint32_t c = 0; c < chunk_count; ++c) {
+      uint32_t chunk_index = version_index->m_AssetChunkIndexes[chunk_index_start + c];
+      uint32_t chunk_size = version_index->m_ChunkSizes[chunk_index];
+      if (missing_chunk_hashes.count(version_index->m_ChunkHashes[chunk_index]) != 0) {
+        if (!ranges.empty() && ranges.back().second == offset) {
+          ranges.back().second = offset + chunk_size;
+        } else {
+          ranges.emplace_back(offset, offset + chunk_size);
+        }
+      }
+      offset += chunk_size;
+    }
+    if (!ranges.empty()) {
+      ReadCacheStorageAPI_File& kept_file = kept_files[full_path];
+      kept_size += ReadCacheStorageAPI_KeepRanges(file_it->second.m_Segments, ranges, kept_file.m_Segments);
+    }
+    // Frees the segments of the file as soon as they have been trimmed
+    api->m_Files.erase(file_it);
+    Longtail_Free(full_path);
+  }
+  api->m_Files.swap(kept_files);
+  api->m_CacheSize = kept_size;
+  api->m_MaxCacheSize = 0;
+}
+
+struct Longtail_StorageAPI* CreateReadCacheStorageAPI(
+    struct Longtail_StorageAPI* backing_storage_api,
+    uint64_t max_cache_size) {
+  MAKE_LOG_CONTEXT_FIELDS(ctx)
+  LONGTAIL_LOGFIELD(backing_storage_api, "%p"),
+      LONGTAIL_LOGFIELD(max_cache_size, "%" PRIu64)
+          MAKE_LOG_CONTEXT_WITH_FIELDS(ctx, 0, LONGTAIL_LOG_LEVEL_DEBUG)
+
+  LONGTAIL_VALIDATE_INPUT(ctx, backing_storage_api != 0, return 0);
+
+  void* mem = Longtail_Alloc("ReadCacheStorageAPI", sizeof(struct ReadCacheStorageAPI));
+  if (!mem) {
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Longtail_Alloc() failed with %d", ENOMEM)
+    return 0;
+  }
+  struct ReadCacheStorageAPI* api = new (mem) ReadCacheStorageAPI();
+  Longtail_MakeStorageAPI(
+      &api->m_API,
+      ReadCacheStorageAPI_Dispose,
+      ReadCacheStorageAPI_OpenReadFile,
+      ReadCacheStorageAPI_GetSize,
+      ReadCacheStorageAPI_Read,
+      ReadCacheStorageAPI_OpenWriteFile,
+      ReadCacheStorageAPI_Write,
+      ReadCacheStorageAPI_SetSize,
+      ReadCacheStorageAPI_SetPermissions,
+      ReadCacheStorageAPI_GetPermissions,
+      ReadCacheStorageAPI_CloseFile,
+      ReadCacheStorageAPI_CreateDir,
+      ReadCacheStorageAPI_RenameFile,
+      ReadCacheStorageAPI_ConcatPath,
+      ReadCacheStorageAPI_IsDir,
+      ReadCacheStorageAPI_IsFile,
+      ReadCacheStorageAPI_RemoveDir,
+      ReadCacheStorageAPI_RemoveFile,
+      ReadCacheStorageAPI_StartFind,
+      ReadCacheStorageAPI_FindNext,
+      ReadCacheStorageAPI_CloseFind,
+      ReadCacheStorageAPI_GetEntryProperties,
+      ReadCacheStorageAPI_LockFile,
+      ReadCacheStorageAPI_UnlockFile,
+      ReadCacheStorageAPI_GetParentPath,
+      ReadCacheStorageAPI_MapFile,
+      ReadCacheStorageAPI_UnmapFile);
+  api->m_API.m_StorageFlags = backing_storage_api->m_StorageFlags;
+  api->m_BackingAPI = backing_storage_api;
+  api->m_MaxCacheSize = max_cache_size;
+  api->m_CacheSize = 0;
+  return &api->m_API;
+}
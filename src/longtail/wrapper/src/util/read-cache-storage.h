@@ -0,0 +1,23 @@
+#pragma once
+
+#include <longtail.h>
+
+// Storage API that forwards to backing_storage_api and keeps a copy of the
+// data read from files, up to max_cache_size bytes. Later reads of a range
+// that was read before are served from memory instead of the backing storage.
+//
+// Submit uses this so the chunk data read while indexing can be put in blocks
+// by Longtail_WriteContent without reading the source files a second time.
+// Opening a file for writing, renaming or removing it drops its cached data.
+struct Longtail_StorageAPI* CreateReadCacheStorageAPI(
+    struct Longtail_StorageAPI* backing_storage_api,
+    uint64_t max_cache_size);
+
+// Drops the cached data of every chunk of version_index under root_path that is
+// not in missing_store_index so only the data of the chunks that will be put in
+// new blocks is kept. Data read after this is no longer cached.
+void KeepReadCacheChunks(
+    struct Longtail_StorageAPI* read_cache_storage_api,
+    const char* root_path,
+    const struct Longtail_VersionIndex* version_index,
+    const struct Longtail_StoreIndex* missing_store_index);
@@ -0,0 +1,190 @@
+#include "zstd-dictionary.h"
+
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+static const size_t MaxDictionarySize = 64 * 1024;
+static const uint64_t MaxSampleSize = 128 * 1024;
+static const uint64_t MaxTotalSampleSize = 8 * 1024 * 1024;
+static const uint32_t MinSampleCount = 32;
+static const uint32_t MaxDictionaryIdProbes = 16;
+
+static std::string DictionariesPath(const char* remote_base_path) {
+  return std::string(remote_base_path) + "/dictionaries";
+}
+
+static std::string DictionaryPath(const char* remote_base_path, uint32_t dictionary_id) {
+  char name[32];
+  snprintf(name, sizeof(name), "/0x%08x.zdict", dictionary_id);
+  return DictionariesPath(remote_base_path) + name;
+}
+
+static int ReadStorageFile(struct Longtail_StorageAPI* storage_api, const char* path, uint64_t max_size, std::vector<uint8_t>& out_data) {
+  Longtail_StorageAPI_HOpenFile file;
+  int err = storage_api->OpenReadFile(storage_api, path, &file);
+  if (err) {
+    return err;
+  }
+  uint64_t size = 0;
+  err = storage_api->GetSize(storage_api, file, &size);
+  if (!err) {
+    out_data.resize((size_t)(size < max_size ? size : max_size));
+    if (!out_data.empty()) {
+      err = storage_api->Read(storage_api, file, 0, out_data.size(), out_data.data());
+    }
+  }
+  storage_api->CloseFile(storage_api, file);
+  return err;
+}
+
+static int WriteStorageFile(struct Longtail_StorageAPI* storage_api, const char* path, const void* data, uint64_t size) {
+  Longtail_StorageAPI_HOpenFile file;
+  int err = storage_api->OpenWriteFile(storage_api, path, size, &file);
+  if (err) {
+    return err;
+  }
+  err = storage_api->Write(storage_api, file, 0, size, data);
+  storage_api->CloseFile(storage_api, file);
+  return err;
+}
+
+static int AddZStdDictionaryFromStorage(struct Longtail_StorageAPI* remote_storage_api, const char* remote_base_path, struct Longtail_CompressionRegistryAPI* compression_registry, uint32_t dictionary_id) {
+  if (Longtail_HasZStdDictionary(compression_registry, dictionary_id)) {
+    return 0;
+  }
+  std::vector<uint8_t> dictionary;
+  int err = ReadStorageFile(remote_storage_api, DictionaryPath(remote_base_path, dictionary_id).c_str(), UINT64_MAX, dictionary);
+  if (err) {
+    return err;
+  }
+  uint32_t added_id = 0;
+  err = Longtail_AddZStdDictionary(compression_registry, dictionary.data(), dictionary.size(), &added_id);
+  if (!err && added_id != dictionary_id) {
+    err = EINVAL;
+  }
+  return err;
+}
+
+int LoadZStdDictionaries(struct Longtail_StorageAPI* remote_storage_api, const char* remote_base_path, struct Longtail_CompressionRegistryAPI* compression_registry, const struct Longtail_VersionIndex* version_index) {
+  std::set<uint32_t> dictionary_ids;
+  for (uint32_t c = 0; c < *version_index->m_ChunkCount; ++c) {
+    uint32_t dictionary_id = Longtail_GetZStdDictionaryCompressionTypeID(version_index->m_ChunkTags[c]);
+    if (dictionary_id != 0) {
+      dictionary_ids.insert(dictionary_id);
+    }
+  }
+  for (uint32_t dictionary_id : dictionary_ids) {
+    int err = AddZStdDictionaryFromStorage(remote_storage_api, remote_base_path, compression_registry, dictionary_id);
+    if (err) {
+      struct Longtail_LogContextFmt_Private* ctx = 0;
+      LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_ERROR, "Failed to load zstd dictionary 0x%08x, %d", dictionary_id, err)
+      return err;
+    }
+  }
+  return 0;
+}
+
+static uint32_t TrainZStdDictionary(struct Longtail_StorageAPI* remote_storage_api, const char* remote_base_path, struct Longtail_CompressionRegistryAPI* compression_registry, struct Longtail_StorageAPI* file_storage_api, const char* local_root_path, const struct Longtail_FileInfos* file_infos, const uint32_t* tags) {
+  struct Longtail_LogContextFmt_Private* ctx = 0;
+
+  // The start of each file carries most of the structure shared between assets of a type
+  std::vector<uint8_t> samples;
+  std::vector<size_t> sample_sizes;
+  for (uint32_t i = 0; i < file_infos->m_Count && samples.size() < MaxTotalSampleSize; ++i) {
+    if (Longtail_GetZStdDictionaryCompressionTypeQuality(tags[i]) == 0 || file_infos->m_Sizes[i] == 0) {
+      continue;
+    }
+    const char* path = &file_infos->m_PathData[file_infos->m_PathStartOffsets[i]];
+    char* full_path = file_storage_api->ConcatPath(file_storage_api, local_root_path, path);
+    std::vector<uint8_t> sample;
+    int err = ReadStorageFile(file_storage_api, full_path, MaxSampleSize, sample);
+    Longtail_Free(full_path);
+    if (err || sample.empty()) {
+      continue;
+    }
+    samples.insert(samples.end(), sample.begin(), sample.end());
+    sample_sizes.push_back(sample.size());
+  }
+  if (sample_sizes.size() < MinSampleCount) {
+    return 0;
+  }
+
+  void* dictionary = 0;
+  size_t dictionary_size = 0;
+  int err = Longtail_TrainZStdDictionary(samples.data(), sample_sizes.data(), (uint32_t)sample_sizes.size(), MaxDictionarySize, &dictionary, &dictionary_size);
+  if (err) {
+    return 0;
+  }
+
+  // Never replace a different dictionary that blocks of the repository, or of other
+  // repositories sharing the registry, were compressed with, move on to the next candidate id
+  uint32_t dictionary_id = 0;
+  for (uint32_t probe = 0; probe < MaxDictionaryIdProbes; ++probe) {
+    err = Longtail_ProbeZStdDictionaryID(dictionary, dictionary_size, probe, &dictionary_id);
+    if (err) {
+      break;
+    }
+    std::string dictionary_path = DictionaryPath(remote_base_path, dictionary_id);
+    std::vector<uint8_t> existing;
+    int read_err = ReadStorageFile(remote_storage_api, dictionary_path.c_str(), UINT64_MAX, existing);
+    if (read_err == 0 && (existing.size() != dictionary_size || memcmp(existing.data(), dictionary, dictionary_size) != 0)) {
+      LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Trained zstd dictionary id 0x%08x is used by a different dictionary in the repository, probing the next id", dictionary_id)
+      err = EEXIST;
+      continue;
+    }
+    err = Longtail_AddZStdDictionary(compression_registry, dictionary, dictionary_size, &dictionary_id);
+    if (err == EEXIST) {
+      LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Trained zstd dictionary id 0x%08x is used by a different dictionary in the registry, probing the next id", dictionary_id)
+      continue;
+    }
+    if (!err && read_err != 0) {
+      // Upload the dictionary before pointing at it so readers never see a missing dictionary
+      remote_storage_api->CreateDir(remote_storage_api, DictionariesPath(remote_base_path).c_str());
+      err = WriteStorageFile(remote_storage_api, dictionary_path.c_str(), dictionary, dictionary_size);
+    }
+    break;
+  }
+  if (!err) {
+    char current[16];
+    int length = snprintf(current, sizeof(current), "0x%08x", dictionary_id);
+    err = WriteStorageFile(remote_storage_api, (DictionariesPath(remote_base_path) + "/current").c_str(), current, (uint64_t)length);
+  }
+  Longtail_Free(dictionary);
+  if (err) {
+    LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_WARNING, "Failed to store trained zstd dictionary, %d", err)
+    return 0;
+  }
+  LONGTAIL_LOG(ctx, LONGTAIL_LOG_LEVEL_INFO, "Trained zstd dictionary 0x%08x from %u samples", dictionary_id, (uint32_t)sample_sizes.size())
+  return dictionary_id;
+}
+
+void ResolveZStdDictionaryTags(struct Longtail_StorageAPI* remote_storage_api, const char* remote_base_path, struct Longtail_CompressionRegistryAPI* compression_registry, struct Longtail_StorageAPI* file_storage_api, const char* local_root_path, const struct Longtail_FileInfos* file_infos, uint32_t* tags) {
+  bool uses_dictionary = false;
+  for (uint32_t i = 0; i < file_infos->m_Count && !uses_dictionary; ++i) {
+    uses_dictionary = Longtail_GetZStdDictionaryCompressionTypeQuality(tags[i]) != 0;
+  }
+  if (!uses_dictionary) {
+    return;
+  }
+
+  uint32_t dictionary_id = 0;
+  std::vector<uint8_t> current;
+  int err = ReadStorageFile(remote_storage_api, (DictionariesPath(remote_base_path) + "/current").c_str(), 32, current);
+  if (!err) {
+    dictionary_id = (uint32_t)strtoul(std::string(current.begin(), current.end()).c_str(), nullptr, 16);
+    if (dictionary_id == 0 || AddZStdDictionaryFromStorage(remote_storage_api, remote_base_path, compression_registry, dictionary_id) != 0) {
+      dictionary_id = 0;
+    }
+  } else if (err == ENOENT) {
+    dictionary_id = TrainZStdDictionary(remote_storage_api, remote_base_path, compression_registry, file_storage_api, local_root_path, file_infos, tags);
+  }
+
+  for (uint32_t i = 0; i < file_infos->m_Count; ++i) {
+    uint32_t quality = Longtail_GetZStdDictionaryCompressionTypeQuality(tags[i]);
+    if (quality != 0) {
+      tags[i] = dictionary_id ? Longtail_GetZStdDictionaryCompressionType(dictionary_id, quality) : quality;
+    }
+  }
+}
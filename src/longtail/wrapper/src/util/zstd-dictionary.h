@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../exposed/main.h"
+
+// Trained zstd dictionaries are stored content addressed next to the blocks as
+// <RemoteBasePath>/dictionaries/0x<id>.zdict, <RemoteBasePath>/dictionaries/current
+// names the dictionary new submits compress with. Dictionaries are added to the
+// compression registry of the operation (Longtail_CreateFullCompressionRegistry)
+// and released with it.
+
+// Adds every dictionary referenced by the chunk tags of version_index that has
+// not already been added to compression_registry.
+int LoadZStdDictionaries(struct Longtail_StorageAPI* remote_storage_api, const char* remote_base_path, struct Longtail_CompressionRegistryAPI* compression_registry, const struct Longtail_VersionIndex* version_index);
+
+// Replaces the dictionary placeholder tags (dictionary id zero) in tags with the
+// repository's current dictionary, training and uploading one from the files
+// being submitted if there is none. Falls back to plain zstd if no dictionary
+// can be used.
+void ResolveZStdDictionaryTags(struct Longtail_StorageAPI* remote_storage_api, const char* remote_base_path, struct Longtail_CompressionRegistryAPI* compression_registry, struct Longtail_StorageAPI* file_storage_api, const char* local_root_path, const struct Longtail_FileInfos* file_infos, uint32_t* tags);